@@ -8,10 +8,13 @@
 
 #include "ztypes.h"
 
+#include <string.h>
+
 namespace LibChaos {
 
-/*! Defines an interface for c
- *  The ZStorage abstract class defines an interface
+/*! Interface for byte storage that may be larger than memory.
+ *  Implemented by ZMemoryStorage (heap buffer), ZMappedStorage (memory-mapped file)
+ *  and ZPagedStorage (file with a fixed-size page cache). ZStorageArray accesses any of them as an array of POD values.
  */
 
 // Implementations are expected to behave as follows.
@@ -20,12 +23,20 @@ namespace LibChaos {
 
 // 1. A ZStorage object *may* represent more data than can be stored in memory
 // 2. Implementations should only call copy constructors of stored objects if the method requires it
-// 2. getBlock() may allocate <size> bytes in order to map data to memory
-// 3. freeBlock() and commitBlock() may invalidate a pointer returned from getBlock
-// 4. getType() and setType() implicity call copy constructors for
-// 5. this pointers for stored non-POD types should not be considered constant during the object's lifetime
+// 3. getBlock() may allocate <size> bytes in order to map data to memory
+// 4. freeBlock() and commitBlock() may invalidate a pointer returned from getBlock
+// 5. resize() may invalidate any pointer returned from getBlock
+// 6. this pointers for stored non-POD types should not be considered constant during the object's lifetime
 
 class ZStorage {
+public:
+    //! Values returned by storageType().
+    enum storagetype {
+        MEMORY  = 1,    //!< ZMemoryStorage
+        MAPPED  = 2,    //!< ZMappedStorage
+        PAGED   = 3,    //!< ZPagedStorage
+    };
+
 public:
     virtual ~ZStorage(){}
 
@@ -35,8 +46,11 @@ public:
     //template <typename T>
     //virtual void copyType(const ZStorage *other) = 0;
 
+    // Copy size bytes from data to index, growing the storage if needed
     virtual void copyToBlock(const zbyte *data, zu64 index, zu64 size) = 0;
+    // Copy size bytes at index to data
     virtual void copyBlockTo(zu64 index, zu64 size, zbyte *data) const = 0;
+    // Get a new storage with a copy of the contents, caller takes ownership
     virtual ZStorage *newCopy() const = 0;
 
     // Get byte at index
@@ -59,6 +73,7 @@ public:
     // Commit changes to a pointer returned by getBlock
     virtual void commitBlock(zbyte *ptr) = 0;
 
+    // Check if the contents of other are byte-for-byte equal
     virtual bool compare(const ZStorage *other) const = 0;
 
     // Set a new container size
@@ -74,6 +89,39 @@ public:
     virtual zu16 storageType() const = 0;
     // Return string describing container
     virtual const char *storageTypeStr() const = 0;
+
+protected:
+    //! Bytes copied at a time between storages.
+    enum { CHUNK_SIZE = 4096 };
+
+    //! Replace the contents of \a dest with the contents of \a src, a chunk at a time.
+    static void copyStorage(ZStorage *dest, const ZStorage *src){
+        zu64 size = src->size();
+        dest->resize(size);
+        zbyte buffer[CHUNK_SIZE];
+        for(zu64 pos = 0; pos < size; pos += CHUNK_SIZE){
+            zu64 len = MIN((zu64)CHUNK_SIZE, size - pos);
+            src->copyBlockTo(pos, len, buffer);
+            dest->copyToBlock(buffer, pos, len);
+        }
+    }
+
+    //! Compare the contents of \a a and \a b, a chunk at a time.
+    static bool compareStorage(const ZStorage *a, const ZStorage *b){
+        zu64 size = a->size();
+        if(size != b->size())
+            return false;
+        zbyte abuf[CHUNK_SIZE];
+        zbyte bbuf[CHUNK_SIZE];
+        for(zu64 pos = 0; pos < size; pos += CHUNK_SIZE){
+            zu64 len = MIN((zu64)CHUNK_SIZE, size - pos);
+            a->copyBlockTo(pos, len, abuf);
+            b->copyBlockTo(pos, len, bbuf);
+            if(::memcmp(abuf, bbuf, len) != 0)
+                return false;
+        }
+        return true;
+    }
 };
 
 }
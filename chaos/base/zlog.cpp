@@ -31,7 +31,7 @@ ZLog::ZLog(zlog_level source, ZString prefile, ZString preline, ZString prefunc)
 }
 
 ZLog::~ZLog(){
-    if(job && !job->log.isEmpty()){
+    if(job && !buffer.isEmpty()){
         flushLog(true);
     }
 }
@@ -43,7 +43,7 @@ void ZLog::flushLog(bool final){
     job->stdio = stdiolog;
     job->newln = newline;
     job->raw = rawlog;
-    //job->log = buffer;
+    job->log = (final ? buffer.take() : buffer.str());
 
     // Transfer job ownership
     LogJob *jobptr = job;
@@ -80,27 +80,20 @@ ZLog &ZLog::operator<<(zlog_flag flag){
 }
 
 ZLog &ZLog::log(ZString logtext){
-    if(job)
-        job->log.append(logtext);
-    return *this;
+    return append(logtext);
 }
 
 ZLog &ZLog::operator<<(ZBinary bin){
-    ZString text;
-    for(zu64 i = 0; i < bin.size(); ++i){
-        unsigned char tmp = bin[i];
-        // Log in hexadecimal pairs
-        text += ZString::ItoS(tmp, 16, 2);
-    }
-    return log(text);
+    // Log in hexadecimal pairs
+    if(job)
+        buffer.appendHex(bin.raw(), bin.size());
+    return *this;
 }
 
 ZString ZLog::pullBuffer(){
     if(!job)
         return ZString();
-    ZString tmp = job->log;
-    job->log.clear();
-    return tmp;
+    return buffer.take();
 }
 
 ZString ZLog::genLogFileName(ZString prefix){
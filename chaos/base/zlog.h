@@ -8,6 +8,7 @@
 
 #include "zlogworker.h"
 #include "zexception.h"
+#include "zstringbuilder.h"
 #include <atomic>
 
 #define ZLOG_PREFILE LibChaos::ZPath(__FILE__).last()
@@ -81,23 +82,24 @@ public:
     ZLog &log(ZString logtext);
 
     inline ZLog &operator<<(ZString text){ return log(text); } // Base overload
-    inline ZLog &operator<<(const char *text){ return log(text); }
+    inline ZLog &operator<<(const char *text){ return append(text); }
     inline ZLog &operator<<(ZPath text){ return log(text.str()); }
-    inline ZLog &operator<<(ZException e){ return log(ZString(e.code()) + ": " + e.what()); }
+    inline ZLog &operator<<(ZException e){ return append(e.code()).append(": ").append(e.what()); }
     ZLog &operator<<(ZBinary text);
 
-    inline ZLog &operator<<(char text){ return log(ZString(text)); }
-    inline ZLog &operator<<(unsigned char text){ return log(ZString(text)); }
-    inline ZLog &operator<<(zus num){ return log(ZString(num)); }
-    inline ZLog &operator<<(zss num){ return log(ZString(num)); }
-    inline ZLog &operator<<(zuint num){ return log(ZString(num)); }
-    inline ZLog &operator<<(zint num){ return log(ZString(num)); }
-    inline ZLog &operator<<(zul num){ return log(ZString(num)); }
-    inline ZLog &operator<<(zsl num){ return log(ZString(num)); }
-    inline ZLog &operator<<(zull num){ return log(ZString(num)); }
-    inline ZLog &operator<<(zsll num){ return log(ZString(num)); }
-    inline ZLog &operator<<(double num){ return log(ZString(num)); }
-    inline ZLog &operator<<(bool tf){ return log(tf ? "true" : "false"); }
+    // Characters and numbers are formatted straight into the buffer
+    inline ZLog &operator<<(char text){ return append(text); }
+    inline ZLog &operator<<(unsigned char text){ return append(text); }
+    inline ZLog &operator<<(zus num){ return append(num); }
+    inline ZLog &operator<<(zss num){ return append(num); }
+    inline ZLog &operator<<(zuint num){ return append(num); }
+    inline ZLog &operator<<(zint num){ return append(num); }
+    inline ZLog &operator<<(zul num){ return append(num); }
+    inline ZLog &operator<<(zsl num){ return append(num); }
+    inline ZLog &operator<<(zull num){ return append(num); }
+    inline ZLog &operator<<(zsll num){ return append(num); }
+    inline ZLog &operator<<(double num){ return append(num); }
+    inline ZLog &operator<<(bool tf){ return append(tf ? "true" : "false"); }
 
     //! Concat \a text to buffer with prepended space.
     inline ZLog &operator,(ZString text){ return log(" ").log(text); } // Base overload
@@ -121,6 +123,13 @@ public:
 private:
     void flushLog(bool final);
 
+    //! Append \a value to buffer, if the log has not been flushed for the last time.
+    template <typename T> inline ZLog &append(const T &value){
+        if(job)
+            buffer.append(value);
+        return *this;
+    }
+
     static std::atomic<bool> _init;
     static ZLogWorker *worker;
     static ZClock clock;
@@ -130,6 +139,8 @@ private:
     bool newline;
     bool rawlog;
     bool noqueue;
+    //! Log text, copied into the job when flushed.
+    ZStringBuilder buffer;
 };
 
 } // namespace LibChaos
@@ -8,6 +8,7 @@
 #include "zfile.h"
 #include "zqueue.h"
 #include "zmap.h"
+#include "zmultisearcher.h"
 
 #include <iostream>
 #include <fstream>
@@ -20,6 +21,7 @@ namespace LibChaos {
 
 ZMutex jobmutex;
 ZCondition jobcondition;
+// Ring buffers are swapped along with the queues, so the worker reuses both buffers without allocating
 ZQueue<ZLogWorker::LogJob*> jobs;
 
 //ZMutex writemutex;
@@ -127,17 +129,15 @@ ZString ZLogWorker::getThread(ztid thread){
 
 ZString ZLogWorker::makeLog(const LogJob *job, ZString fmt){
     if(!job->raw){
-        fmt.replace("%log%", job->log);
-
-        fmt.replace("%clock%", job->clock.str());
-        fmt.replace("%date%", job->time.dateStr());
-        fmt.replace("%time%", job->time.timeStr());
-        fmt.replace("%datetime%", job->time.dateStr() + " " + job->time.timeStr());
-        fmt.replace("%thread%", getThread(job->thread));
-
-        fmt.replace("%file%", job->file);
-        fmt.replace("%line%", job->line);
-        fmt.replace("%function%", job->func);
+        // Placeholders are replaced in one pass, so placeholders in the substituted text are left alone
+        static const ZMultiSearcher placeholders({
+            "%log%", "%clock%", "%date%", "%time%", "%datetime%", "%thread%", "%file%", "%line%", "%function%"
+        });
+        ZString date = job->time.dateStr();
+        ZString time = job->time.timeStr();
+        fmt.replaceAll(placeholders, {
+            job->log, job->clock.str(), date, time, date + " " + time, getThread(job->thread), job->file, job->line, job->func
+        });
 
         if(job->newln && fmt.last() != '\n')
             fmt += '\n';
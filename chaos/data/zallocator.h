@@ -12,6 +12,14 @@
 #include <string.h>
 // For std::nothrow
 #include <new>
+// For std::move, std::forward
+#include <utility>
+// For std::is_trivially_copyable
+#include <type_traits>
+// For typeid
+#include <typeinfo>
+// For std::atomic
+#include <atomic>
 
 namespace LibChaos {
 
@@ -20,6 +28,114 @@ struct zallocator_exception {
     const char *what;
 };
 
+/*! Trait for types that can be relocated with a raw byte copy.
+ *  A relocatable object does not hold pointers into itself, so moving its bytes and
+ *  forgetting the original is equivalent to move-constructing and destroying it.
+ *  Containers specialize this for themselves.
+ */
+template <typename T> struct ZRelocatable {
+    enum { value = std::is_trivially_copyable<T>::value };
+};
+
+//! Declare \a TYPE relocatable with a raw byte copy.
+#define ZRELOCATABLE(TYPE) template <> struct ZRelocatable<TYPE> { enum { value = true }; };
+
+/*! Hook for counting allocations made through ZDefaultAllocator.
+ *  Implemented by ZAllocRegistry in ztrackingallocator.h. The hook is only called while tracking
+ *  is enabled, so the default allocation path costs one relaxed load when tracking is off.
+ */
+class ZAllocatorHook {
+public:
+    //! True while ZAllocRegistry is tracking default allocations.
+    static inline bool enabled(){ return _enabled.load(std::memory_order_relaxed) > 0; }
+    //! Record an allocation of \p bytes for \p type.
+    static void alloc(const char *type, zu64 bytes);
+    //! Record a deallocation for \p type. The size is not known to the default allocator.
+    static void dealloc(const char *type);
+
+private:
+    friend class ZAllocRegistry;
+    //! Number of active enable requests.
+    static std::atomic<int> _enabled;
+};
+
+/*! Stateless default allocator operations.
+ *  Every method is static and non-virtual, so containers using the default allocation path
+ *  need no allocator object and pay no virtual dispatch.
+ */
+template <class T> class ZDefaultAllocator {
+public:
+    //! Allocates memory to hold \p count T's.
+    static inline T *alloc(zu64 count = 1){
+        T *ptr = (T*)::operator new(sizeof(T) * count, std::nothrow);
+        if(ptr == nullptr)
+            throw zallocator_exception("Failed to alloc()");
+        if(ZAllocatorHook::enabled())
+            ZAllocatorHook::alloc(typeid(T).name(), sizeof(T) * count);
+        return ptr;
+    }
+
+    //! Deallocate memory from alloc().
+    static inline void dealloc(T *ptr){
+        if(ptr != nullptr && ZAllocatorHook::enabled())
+            ZAllocatorHook::dealloc(typeid(T).name());
+        ::operator delete(ptr);
+    }
+
+    //! Copy construct \p count T's from \p obj at \p ptr.
+    static inline T *construct(T *ptr, const T &obj, zu64 count = 1){
+        for(zu64 i = 0; i < count; ++i){
+            new (ptr + i) T(obj);
+        }
+        return ptr;
+    }
+
+    //! Destroy \p count T's at \p ptr.
+    static inline void destroy(T *ptr, zu64 count = 1){
+        for(zu64 i = 0; i < count; ++i){
+            (ptr + i)->~T();
+        }
+    }
+
+    static inline void rawcopy(const T *src, T *dest, zu64 count = 1){
+        ::memcpy((void *)dest, (const void *)src, sizeof(T) * count);
+    }
+    static inline void rawmove(const T *src, T *dest, zu64 count = 1){
+        ::memmove((void *)dest, (const void *)src, sizeof(T) * count);
+    }
+
+    //! Copy construct \p count T's from \p src at \p dest.
+    static inline void copy(const T *src, T *dest, zu64 count = 1){
+        for(zu64 i = 0; i < count; ++i){
+            new (dest + i) T(src[i]);
+        }
+    }
+
+    /*! Move \p count T's from \p src to \p dest, destroying the originals.
+     *  The ranges may overlap. Relocatable types are moved with rawmove().
+     */
+    static inline void move(T *src, T *dest, zu64 count = 1){
+        if(ZRelocatable<T>::value){
+            rawmove(src, dest, count);
+        } else if(dest < src){
+            for(zu64 i = 0; i < count; ++i){
+                new (dest + i) T(std::move(src[i]));
+                (src + i)->~T();
+            }
+        } else if(dest > src){
+            for(zu64 i = count; i > 0; --i){
+                new (dest + i - 1) T(std::move(src[i - 1]));
+                (src + i - 1)->~T();
+            }
+        }
+    }
+
+    //! Construct a T at \p ptr with \p args.
+    template <typename ... Args> static inline T *emplace(T *ptr, Args&& ... args){
+        return new (ptr) T(std::forward<Args>(args)...);
+    }
+};
+
 template <class T = void> class ZAllocator {
 public:
     virtual ~ZAllocator(){}
@@ -28,10 +144,7 @@ public:
      * Does not construct objects.
      */
     virtual T *alloc(zu64 count = 1){
-        T *ptr = (T*)::operator new(sizeof(T) * count, std::nothrow);
-        if(ptr == nullptr)
-            throw zallocator_exception("Failed to alloc()");
-        return ptr;
+        return ZDefaultAllocator<T>::alloc(count);
     }
 
     /*! Deallocate memory.
@@ -39,7 +152,7 @@ public:
      *  Objects should be destroy()ed first.
      */
     virtual void dealloc(T *ptr){
-        ::operator delete(ptr);
+        ZDefaultAllocator<T>::dealloc(ptr);
     }
 
     /*! Expects \p ptr originally returned by alloc().
@@ -47,31 +160,27 @@ public:
      *  \p ptr must point to memory large enough to hold \p count T's.
      */
     virtual T *construct(T *ptr, const T &obj = T(), zu64 count = 1){
-        T *tmp = ptr;
-        for(zu64 i = 0; i < count; ++i){
-//            new (tmp++) T(obj);
-//            new (&(tmp[i])) T(obj);
-            new (tmp + i) T(obj);
-        }
-        return ptr;
+        return ZDefaultAllocator<T>::construct(ptr, obj, count);
+    }
+    /*! Expects \p ptr originally returned by alloc().
+     *  Move constructs a T at \p ptr from \p obj.
+     */
+    virtual T *construct(T *ptr, T &&obj){
+        return ZDefaultAllocator<T>::emplace(ptr, std::move(obj));
     }
 
     /*! Expects \p ptr originally returned by alloc() and construct()ed.
      *  Does not dealloc()ate memory.
      */
     virtual void destroy(T *ptr, zu64 count = 1){
-        for(zu64 i = 0; i < count; ++i){
-            //(ptr++)->~T();
-            //(&(ptr[i]))->~T();
-            (ptr + i)->~T();
-        }
+        ZDefaultAllocator<T>::destroy(ptr, count);
     }
 
     virtual void rawcopy(const T *src, T *dest, zu64 count = 1){
-        ::memcpy((void *)dest, (const void *)src, sizeof(T) * count);
+        ZDefaultAllocator<T>::rawcopy(src, dest, count);
     }
     virtual void rawmove(const T *src, T *dest, zu64 count = 1){
-        ::memmove((void *)dest, (const void *)src, sizeof(T) * count);
+        ZDefaultAllocator<T>::rawmove(src, dest, count);
     }
 
     /*! Expects \p src originally returned by alloc() and construct()ed.
@@ -81,21 +190,15 @@ public:
      *  \param count is the number of T's to copy, default 1.
      */
     virtual void copy(const T *src, T *dest, zu64 count = 1){
-        for(zu64 i = 0; i < count; ++i){
-//            new (dest++) T(*++);
-//            new (&(dest[i])) T(src[i]);
-            new (dest + i) T(src[i]);
-        }
+        ZDefaultAllocator<T>::copy(src, dest, count);
     }
 
-    // TODO: ZAllocator move
+    /*! Expects \p src originally returned by alloc() and construct()ed.
+     *  Move constructs \p count T's at \p dest from \p src, and destroys the T's at \p src.
+     *  The ranges may overlap.
+     */
     virtual void move(T *src, T *dest, zu64 count = 1){
-        for(zu64 i = 0; i < count; ++i){
-//            new (dest++) T(*src++);
-//            new (&(dest[i])) T(src[i]);
-            new (dest + i) T(src[i]);
-            destroy(src);
-        }
+        ZDefaultAllocator<T>::move(src, dest, count);
     }
 
     //! Zero the bytes of \p dest.
@@ -137,6 +240,74 @@ public:
     };
 };
 
+/*! Allocator handle held by containers.
+ *  An empty handle uses ZDefaultAllocator directly, so default-constructed containers
+ *  never allocate an allocator object and element operations are not virtual calls.
+ *  A handle given a user ZAllocator takes ownership of it and forwards every call to it.
+ */
+template <class T> class ZAllocatorHandle {
+public:
+    ZAllocatorHandle(ZAllocator<T> *alloc = nullptr) : _alloc(alloc){}
+    ZAllocatorHandle(const ZAllocatorHandle &) = delete;
+    ~ZAllocatorHandle(){
+        delete _alloc;
+    }
+
+    ZAllocatorHandle &operator=(const ZAllocatorHandle &) = delete;
+
+    inline T *alloc(zu64 count = 1){
+        return (_alloc ? _alloc->alloc(count) : ZDefaultAllocator<T>::alloc(count));
+    }
+    inline void dealloc(T *ptr){
+        if(_alloc) _alloc->dealloc(ptr);
+        else ZDefaultAllocator<T>::dealloc(ptr);
+    }
+    inline T *construct(T *ptr, const T &obj = T(), zu64 count = 1){
+        return (_alloc ? _alloc->construct(ptr, obj, count) : ZDefaultAllocator<T>::construct(ptr, obj, count));
+    }
+    //! Construct a T at \p ptr with \p args. A user allocator move constructs it from a temporary.
+    template <typename ... Args> inline T *emplace(T *ptr, Args&& ... args){
+        if(_alloc)
+            return _alloc->construct(ptr, T(std::forward<Args>(args)...));
+        return ZDefaultAllocator<T>::emplace(ptr, std::forward<Args>(args)...);
+    }
+    inline void destroy(T *ptr, zu64 count = 1){
+        if(_alloc) _alloc->destroy(ptr, count);
+        else ZDefaultAllocator<T>::destroy(ptr, count);
+    }
+    inline void rawcopy(const T *src, T *dest, zu64 count = 1){
+        if(_alloc) _alloc->rawcopy(src, dest, count);
+        else ZDefaultAllocator<T>::rawcopy(src, dest, count);
+    }
+    inline void rawmove(const T *src, T *dest, zu64 count = 1){
+        if(_alloc) _alloc->rawmove(src, dest, count);
+        else ZDefaultAllocator<T>::rawmove(src, dest, count);
+    }
+    inline void copy(const T *src, T *dest, zu64 count = 1){
+        if(_alloc) _alloc->copy(src, dest, count);
+        else ZDefaultAllocator<T>::copy(src, dest, count);
+    }
+    inline void move(T *src, T *dest, zu64 count = 1){
+        if(_alloc) _alloc->move(src, dest, count);
+        else ZDefaultAllocator<T>::move(src, dest, count);
+    }
+
+    //! Swap allocators with \p other.
+    void swap(ZAllocatorHandle &other){
+        ZAllocator<T> *tmp = _alloc;
+        _alloc = other._alloc;
+        other._alloc = tmp;
+    }
+
+    //! Get the user allocator, nullptr if using the default allocator.
+    ZAllocator<T> *get() const { return _alloc; }
+    //! True if using the default allocator.
+    bool isDefault() const { return (_alloc == nullptr); }
+
+private:
+    ZAllocator<T> *_alloc;
+};
+
 template <> class ZAllocator<void> {
 public:
     void *alloc(zu64 count){
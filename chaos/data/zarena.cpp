@@ -0,0 +1,107 @@
+#include "zarena.h"
+
+namespace LibChaos {
+
+ZArena::ZArena(zu64 blocksize) : _blocksize(blocksize), _head(nullptr), _current(nullptr){
+
+}
+
+ZArena::~ZArena(){
+    Block *block = _head;
+    while(block != nullptr){
+        Block *next = block->next;
+        ::operator delete(block);
+        block = next;
+    }
+}
+
+void *ZArena::alloc(zu64 size, zu64 align){
+    if(_current != nullptr){
+        // Try to fit the allocation in the current block, then in any following blocks
+        while(true){
+            zu64 addr = (zu64)(_current->data() + _current->used);
+            zu64 pad = (align - (addr & (align - 1))) & (align - 1);
+            if(_current->used + pad + size <= _current->size){
+                _current->used += pad + size;
+                return _current->data() + _current->used - size;
+            }
+            // Reuse the next block if it is large enough
+            if(_current->next == nullptr || _current->next->size < size + align)
+                break;
+            _current = _current->next;
+            _current->used = 0;
+        }
+    }
+
+    // Chain a new block after the current block
+    Block *block = _newBlock(MAX(_blocksize, size + align));
+    if(_current == nullptr){
+        block->next = _head;
+        _head = block;
+    } else {
+        block->next = _current->next;
+        _current->next = block;
+    }
+    _current = block;
+
+    zu64 addr = (zu64)block->data();
+    zu64 pad = (align - (addr & (align - 1))) & (align - 1);
+    block->used = pad + size;
+    return block->data() + pad;
+}
+
+ZArena::Marker ZArena::mark() const {
+    Marker marker;
+    marker.block = _current;
+    marker.used = (_current ? _current->used : 0);
+    return marker;
+}
+
+void ZArena::rewind(ZArena::Marker marker){
+    if(marker.block == nullptr){
+        reset();
+    } else {
+        _current = marker.block;
+        _current->used = marker.used;
+    }
+}
+
+void ZArena::reset(){
+    _current = _head;
+    if(_current)
+        _current->used = 0;
+}
+
+zu64 ZArena::used() const {
+    zu64 total = 0;
+    for(Block *block = _head; block != nullptr; block = block->next){
+        total += block->used;
+        if(block == _current)
+            break;
+    }
+    return total;
+}
+
+zu64 ZArena::capacity() const {
+    zu64 total = 0;
+    for(Block *block = _head; block != nullptr; block = block->next)
+        total += block->size;
+    return total;
+}
+
+zu64 ZArena::blockCount() const {
+    zu64 count = 0;
+    for(Block *block = _head; block != nullptr; block = block->next)
+        ++count;
+    return count;
+}
+
+ZArena::Block *ZArena::_newBlock(zu64 size){
+    Block *block = (Block *)::operator new(sizeof(Block) + size);
+    block->next = nullptr;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+}
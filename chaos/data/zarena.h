@@ -0,0 +1,130 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                                  zarena.h                                  **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZARENA_H
+#define ZARENA_H
+
+#include "ztypes.h"
+#include "zallocator.h"
+
+#define ZARENA_DEFAULT_BLOCK_SIZE   0x10000 // 64K
+#define ZARENA_DEFAULT_ALIGN        16
+
+namespace LibChaos {
+
+template <typename T> class ZArenaAllocator;
+
+/*! Monotonic bump-pointer memory region.
+ *  Memory is carved out of a chain of blocks and is never freed individually.
+ *  All allocations are released at once by reset(), or back to a mark() with rewind().
+ *  Blocks are kept and reused after a reset, and only freed when the arena is destroyed.
+ *  \warning Not thread safe.
+ */
+class ZArena {
+private:
+    struct Block {
+        Block *next;
+        zu64 size;
+        zu64 used;
+        zbyte *data(){ return (zbyte *)(this + 1); }
+    };
+
+public:
+    //! Position in the arena that can be returned to with rewind().
+    struct Marker {
+        Block *block;
+        zu64 used;
+    };
+
+    /*! Rewinds the arena to where it was on construction when destroyed.
+     *  Objects allocated from the arena in the scope must be destroyed first.
+     */
+    class Scope {
+    public:
+        Scope(ZArena *arena) : _arena(arena), _mark(arena->mark()){}
+        Scope(const Scope &) = delete;
+        ~Scope(){ _arena->rewind(_mark); }
+        Scope &operator=(const Scope &) = delete;
+    private:
+        ZArena *_arena;
+        Marker _mark;
+    };
+
+public:
+    //! Create an empty arena. Blocks of \a blocksize bytes are allocated on demand.
+    ZArena(zu64 blocksize = ZARENA_DEFAULT_BLOCK_SIZE);
+    ZArena(const ZArena &) = delete;
+    ~ZArena();
+
+    ZArena &operator=(const ZArena &) = delete;
+
+    /*! Allocate \a size bytes aligned to \a align, which must be a power of two.
+     *  Requests larger than the block size get a dedicated block.
+     */
+    void *alloc(zu64 size, zu64 align = ZARENA_DEFAULT_ALIGN);
+
+    /*! Get an allocator for containers of T that allocates from this arena.
+     *  The allocator object itself lives in the arena, so a container can take ownership of it as usual.
+     */
+    template <typename T> ZArenaAllocator<T> *allocator(){
+        return new (this) ZArenaAllocator<T>(this);
+    }
+
+    //! Get the current position in the arena.
+    Marker mark() const;
+    //! Release everything allocated after \a marker.
+    void rewind(Marker marker);
+    //! Release all allocations. Blocks are kept for reuse.
+    void reset();
+
+    //! Get the number of bytes in use, including alignment padding.
+    zu64 used() const;
+    //! Get the total size of all blocks.
+    zu64 capacity() const;
+    //! Get the number of blocks.
+    zu64 blockCount() const;
+
+private:
+    Block *_newBlock(zu64 size);
+
+private:
+    //! Default size of each block.
+    zu64 _blocksize;
+    //! First block in the chain.
+    Block *_head;
+    //! Block currently being allocated from.
+    Block *_current;
+};
+
+/*! Allocator for any LibChaos container that allocates from a ZArena.
+ *  dealloc() does nothing, memory is released with the arena.
+ *  Create with ZArena::allocator(). The arena must outlive every container using it.
+ */
+template <typename T> class ZArenaAllocator : public ZAllocator<T> {
+public:
+    ZArenaAllocator(ZArena *arena) : _arena(arena){}
+
+    T *alloc(zu64 count = 1) override {
+        return (T *)_arena->alloc(sizeof(T) * count, alignof(T));
+    }
+    void dealloc(T *) override {}
+
+    ZArena *arena() const { return _arena; }
+
+    //! Allocate the allocator object in \a arena.
+    static void *operator new(size_t size, ZArena *arena){
+        return arena->alloc(size, alignof(ZArenaAllocator));
+    }
+    //! Allocator objects are released with the arena.
+    static void operator delete(void *){}
+    static void operator delete(void *, ZArena *){}
+
+private:
+    ZArena *_arena;
+};
+
+}
+
+#endif // ZARENA_H
@@ -11,6 +11,7 @@
 #include "yindexedaccess.h"
 #include "ypushpopaccess.h"
 #include "ziterator.h"
+#include "zsort.h"
 //#include "zhash.h"
 
 #include <initializer_list>
@@ -30,9 +31,11 @@ public:
     class ZArrayConstIterator;
 
 public:
-    //! ZArray default constructor, optional user allocator.
-    ZArray(ZAllocator<T> *alloc = new ZAllocator<T>) : _alloc(alloc), _data(nullptr), _size(0), _realsize(0){
-        reserve(ZARRAY_INITIAL_CAPACITY);
+    /*! ZArray default constructor, optional user allocator.
+     *  ZArray takes ownership of \a alloc. If no allocator is given, the stateless default is used.
+     */
+    ZArray(ZAllocator<T> *alloc = nullptr) : _alloc(alloc), _data(nullptr), _size(0), _realsize(0), _inline(nullptr), _inlinesize(0){
+        // Buffer is allocated on first insertion
     }
 
     //! ZArray initializer list constructor.
@@ -40,7 +43,7 @@ public:
         reserve(ls.size());
         zu64 i = 0;
         for(auto item = ls.begin(); item < ls.end(); ++item){
-            _alloc->construct(&_data[i], *item);
+            _alloc.construct(&_data[i], *item);
             ++i;
         }
         _size = ls.size();
@@ -55,7 +58,7 @@ public:
     ZArray(const T *raw, zu64 size) : ZArray(){
         reserve(size);
         for(zu64 i = 0; i < size; ++i)
-            _alloc->construct(&_data[i], raw[i]);
+            _alloc.construct(&_data[i], raw[i]);
         _size = size;
     }
 
@@ -63,22 +66,39 @@ public:
     ZArray(const ZArray<T> &other) : ZArray(){
         reserve(other._size);
         for(zu64 i = 0; i < other._size; ++i)
-            _alloc->construct(&_data[i], other[i]);
+            _alloc.construct(&_data[i], other[i]);
         _size = other._size;
     }
 
+    //! ZArray move constructor. Takes the buffer and allocator of \a other, leaving it empty.
+    ZArray(ZArray<T> &&other) : ZArray(){
+        if(other.isInline()){
+            // Inline buffer cannot be taken, move the elements
+            _moveElements(other);
+        } else {
+            _alloc.swap(other._alloc);
+            _data = other._data;
+            _size = other._size;
+            _realsize = other._realsize;
+            other._data = other._inline;
+            other._size = 0;
+            other._realsize = other._inlinesize;
+        }
+    }
+
     //! ZArray destructor.
     ~ZArray(){
         clear();
-        delete _alloc;
     }
 
-    //! Destroy all elements in array.
+    //! Destroy all elements in array and free the heap buffer.
     void clear(){
-        _alloc->destroy(_data, _size); // Destroy objects
+        _alloc.destroy(_data, _size); // Destroy objects
         _size = 0;
-        _alloc->dealloc(_data); // Delete memory
-        _data = nullptr;
+        if(_data != _inline)
+            _alloc.dealloc(_data); // Delete memory
+        _data = _inline;
+        _realsize = _inlinesize;
     }
 
     //
@@ -86,27 +106,44 @@ public:
     //
 
     ZArray<T> &assign(const ZArray<T> &other){
-        _alloc->destroy(_data, _size); // Destroy contents
+        if(this == &other)
+            return *this;
+        _alloc.destroy(_data, _size); // Destroy contents
+        _size = 0;
         reserve(other.size()); // Make space
         for(zu64 i = 0; i < other.size(); ++i)
-            _alloc->construct(&_data[i], other[i]); // Copy objects
+            _alloc.construct(&_data[i], other[i]); // Copy objects
         _size = other.size();
         return *this;
     }
     inline ZArray<T> &operator=(const ZArray<T> &other){ return assign(other); }
 
+    //! Move assignment, swaps contents and allocators with \a other.
+    inline ZArray<T> &operator=(ZArray<T> &&other){
+        swap(other);
+        return *this;
+    }
+
+    /*! Swap contents and allocators with \a other.
+     *  If either array uses an inline buffer, the elements are moved instead and allocators are kept.
+     */
     void swap(ZArray<T>& other){
-        ZAllocator<T> *alloc = _alloc;
+        if(isInline() || other.isInline()){
+            ZArray<T> tmp;
+            tmp._moveElements(*this);
+            _moveElements(other);
+            other._moveElements(tmp);
+            return;
+        }
         zu64 size =_size;
         zu64 realsize = _realsize;
         T *data = _data;
 
-        _alloc = alloc;
+        _alloc.swap(other._alloc);
         _size = other._size;
         _realsize = other._realsize;
         _data = other._data;
 
-        other._alloc = alloc;
         other._size = size;
         other._realsize = realsize;
         other._data = data;
@@ -136,23 +173,39 @@ public:
     //! Add \a value to the back (end) of the array.
     ZArray<T> &pushBack(const T &value){
         reserve(_size + 1);
-        _alloc->construct(_data + _size, value);
+        _alloc.construct(_data + _size, value);
         ++_size;
         return *this;
     }
 
+    //! Move \a value to the back (end) of the array.
+    ZArray<T> &pushBack(T &&value){
+        reserve(_size + 1);
+        _alloc.emplace(_data + _size, std::move(value));
+        ++_size;
+        return *this;
+    }
+
+    //! Construct a new element at the back (end) of the array with \a args.
+    template <typename ... Args> T &emplace(Args&& ... args){
+        reserve(_size + 1);
+        _alloc.emplace(_data + _size, std::forward<Args>(args)...);
+        return _data[_size++];
+    }
+
     //! Add \a value to the front (begin) of the array.
     ZArray<T> &pushFront(const T &value){
         return insert(0, value);
     }
 
     inline void push(const T &value){ pushBack(value); }
+    inline void push(T &&value){ pushBack(std::move(value)); }
 
     //! Insert \a value at \a pos, shifting subsequent elements.
     ZArray<T> &insert(zu64 pos, const T &value){
         reserve(_size + 1);
-        _alloc->rawmove(_data + pos, _data + pos + 1, _size - pos);
-        _alloc->construct(_data + pos, value);
+        _alloc.move(_data + pos, _data + pos + 1, _size - pos);
+        _alloc.construct(_data + pos, value);
         ++_size;
         return *this;
     }
@@ -161,7 +214,7 @@ public:
     ZArray<T> &append(const ZArray<T> &in){
         reserve(_size + in.size());
         for(zu64 i = 0; i < in.size(); ++i)
-            _alloc->construct(_data + _size + i, in[i]);
+            _alloc.construct(_data + _size + i, in[i]);
         _size += in.size();
         return *this;
     }
@@ -178,8 +231,8 @@ public:
     //
 
     ZArray<T> &erase(zu64 index, zu64 count = 1){
-        _alloc->destroy(_data + index, count);
-        _alloc->rawmove(_data + index + count, _data + index, _size - index - count);
+        _alloc.destroy(_data + index, count);
+        _alloc.move(_data + index + count, _data + index, _size - index - count);
         _size -= count;
         return *this;
     }
@@ -247,6 +300,57 @@ public:
         return NONE;
     }
 
+    //
+    // Sorting and Searching, see ZSort
+    //
+
+    //! Sort the array in place with introsort. Not stable.
+    template <typename L = ZLess<T>> ZArray<T> &sort(L less = L()){
+        ZSort::sort(_data, _size, less);
+        return *this;
+    }
+    //! Sort the array, keeping the order of equal elements.
+    template <typename L = ZLess<T>> ZArray<T> &stableSort(L less = L()){
+        ZSort::stableSort(_data, _size, less);
+        return *this;
+    }
+    //! Sort an array of numbers or byte strings by radix. Stable.
+    ZArray<T> &radixSort(){
+        ZSort::radixSort(_data, _size);
+        return *this;
+    }
+    //! Sort by the integer or floating point key \a key returns for each element, by radix. Stable.
+    template <typename K> ZArray<T> &radixSort(K key){
+        ZSort::radixSort(_data, _size, key);
+        return *this;
+    }
+    //! Move the \a count smallest elements to the front, in order.
+    template <typename L = ZLess<T>> ZArray<T> &partialSort(zu64 count, L less = L()){
+        ZSort::partialSort(_data, _size, count, less);
+        return *this;
+    }
+    //! Move the element that would be at \a nth if sorted there, with no greater elements before it and no lesser after.
+    template <typename L = ZLess<T>> ZArray<T> &nthElement(zu64 nth, L less = L()){
+        ZSort::nthElement(_data, _size, nth, less);
+        return *this;
+    }
+    template <typename L = ZLess<T>> bool isSorted(L less = L()) const {
+        return ZSort::isSorted(_data, _size, less);
+    }
+
+    //! Index of the first element not less than \a value in a sorted array, size() if none.
+    template <typename V, typename L = ZLess<T>> zu64 lowerBound(const V &value, L less = L()) const {
+        return ZSort::lowerBound(_data, _size, value, less);
+    }
+    //! Index of the first element greater than \a value in a sorted array, size() if none.
+    template <typename V, typename L = ZLess<T>> zu64 upperBound(const V &value, L less = L()) const {
+        return ZSort::upperBound(_data, _size, value, less);
+    }
+    //! Index of an element equal to \a value in a sorted array, NONE if not found.
+    template <typename V, typename L = ZLess<T>> zu64 binarySearch(const V &value, L less = L()) const {
+        return ZSort::binarySearch(_data, _size, value, less);
+    }
+
     //
     // Array Operations
     //
@@ -268,9 +372,9 @@ public:
     ZArray<T> &resize(zu64 size, const T &value = T()){
         reserve(size);
         if(size > _size){
-            _alloc->construct(_data + _size, value, size - _size); // Construct new objects
+            _alloc.construct(_data + _size, value, size - _size); // Construct new objects
         } else if(size < _size){
-            _alloc->destroy(_data + size, _size - size); // Destroy extra objects
+            _alloc.destroy(_data + size, _size - size); // Destroy extra objects
         }
         _size = size;
         return *this;
@@ -284,9 +388,12 @@ public:
     void reserve(zu64 size){
         if(size > _realsize){
             zu64 newsize = MAX(_size * 2, size);
-            T *data = _alloc->alloc(newsize);
-            _alloc->rawcopy(_data, data, _size); // Copy data to new buffer
-            _alloc->dealloc(_data); // Delete old buffer without calling destructors
+            if(_realsize == 0)
+                newsize = MAX(newsize, (zu64)ZARRAY_INITIAL_CAPACITY);
+            T *data = _alloc.alloc(newsize);
+            _alloc.move(_data, data, _size); // Move data to new buffer
+            if(_data != _inline)
+                _alloc.dealloc(_data); // Delete old buffer, objects were moved out
             _data = data;
             _realsize = newsize;
         }
@@ -329,6 +436,22 @@ public:
     inline T *ptr() const { return _data; }
     inline T *raw() const { return ptr(); }
 
+    //! Check if the elements are in an inline buffer (see ZSmallArray).
+    inline bool isInline() const { return (_inline != nullptr && _data == _inline); }
+
+protected:
+    //! Construct using an inline buffer of \a count elements, owned by a subclass.
+    ZArray(T *buffer, zu64 count, ZAllocator<T> *alloc) : _alloc(alloc), _data(buffer), _size(0), _realsize(count), _inline(buffer), _inlinesize(count){}
+
+private:
+    //! Move all elements of \a other to the end of this array.
+    void _moveElements(ZArray<T> &other){
+        reserve(_size + other._size);
+        _alloc.move(other._data, _data + _size, other._size);
+        _size += other._size;
+        other._size = 0;
+    }
+
 public:
     class ZArrayConstIterator : public ZRandomConstIterator<T> {
     public:
@@ -418,12 +541,19 @@ public:
 
 private:
     //! Buffer memory allocator.
-    ZAllocator<T> *_alloc;
+    ZAllocatorHandle<T> _alloc;
     T *_data;
     zu64 _size;
     zu64 _realsize;
+    //! Inline buffer of a subclass, not allocated by ZArray.
+    T *_inline;
+    //! Size of inline buffer.
+    zu64 _inlinesize;
 };
 
+//! ZArray holds no pointers into itself. ZSmallArray is not relocatable.
+template <typename T> struct ZRelocatable<ZArray<T>> { enum { value = true }; };
+
 //ZHASH_USER_SPECIALIAZATION(ZArray<T>, (ZArray<T> array), (), {})
 
 //template <typename T, ZHashBase::hashMethod M> class ZHash<ZArray<T>, M> : public ZHashMethod<M> {
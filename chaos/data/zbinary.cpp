@@ -1,5 +1,7 @@
 #include "zbinary.h"
 #include "zerror.h"
+#include "zlargeallocator.h"
+#include "zsearcher.h"
 //#include "zlog.h"
 
 namespace LibChaos {
@@ -17,7 +19,7 @@ ZBinary &ZBinary::fill(ZBinary::bytetype dat, zu64 size){
 
 ZBinary &ZBinary::concat(const ZBinary &other){
     reserve(_size + other._size);
-    _alloc->rawcopy(other._data, _data + _size, other._size);
+    _alloc.rawcopy(other._data, _data + _size, other._size);
     _size = _size + other._size;
     return *this;
 }
@@ -29,35 +31,16 @@ ZBinary &ZBinary::append(ZBinary::bytetype byte){
 }
 
 void ZBinary::reverse(){
-    bytetype *buffer = _alloc->alloc(_realsize);
-    for(zu64 i = 0; i < _size; ++i){
-        buffer[i] = _data[_size - i - 1];
+    reserve(_size);
+    for(zu64 i = 0; i < _size / 2; ++i){
+        bytetype tmp = _data[i];
+        _data[i] = _data[_size - i - 1];
+        _data[_size - i - 1] = tmp;
     }
-    _alloc->dealloc(buffer);
-    _data = buffer;
 }
 
-zu64 ZBinary::findFirst(const ZBinary &find) const {
-    if(find.size() > _size){
-        return NONE;
-    }
-    zu64 j = 0;
-    zu64 start = NONE;
-    for(zu64 i = 0; i < _size; ++i){
-        if(_data[i] == find[j]){
-            if(j == find.size() - 1)
-                return start;
-            if(j == 0)
-                start = i;
-            ++j;
-        } else {
-            if(j){
-                j = 0;
-                i = start + 1;
-            }
-        }
-    }
-    return start;
+zu64 ZBinary::findFirst(const ZBinary &find, zu64 start) const {
+    return ZSearcher::find(_data, _size, find._data, find._size, start);
 }
 
 ZBinary ZBinary::getSub(zu64 start, zu64 len) const {
@@ -65,7 +48,9 @@ ZBinary ZBinary::getSub(zu64 start, zu64 len) const {
         return ZBinary();
     if(start + len >= _size)
         len = _size - start;
-    return ZBinary(_data + start, len);
+    ZBinary sub;
+    sub._share(*this, start, len);
+    return sub;
 }
 
 zsize ZBinary::subDiff(const ZBinary &in, ZBinary &out){
@@ -151,11 +136,12 @@ ZBinary ZBinary::printable() const {
     ZBinary tmp = *this;
     if(_size){
         tmp.nullTerm();
-        for(zu64 i = 0; i < _size - 1; ++i){
-            if(_data[i] == 0){
-                _data[i] = '0';
-            } else if(_data[i] > 127){
-                _data[i] = '!';
+        bytetype *data = tmp.raw();
+        for(zu64 i = 0; i < tmp.size() - 1; ++i){
+            if(data[i] == 0){
+                data[i] = '0';
+            } else if(data[i] > 127){
+                data[i] = '!';
             }
         }
     }
@@ -228,11 +214,96 @@ zu64 ZBinary::read(ZBinary &dest, zu64 length){
 zu64 ZBinary::write(const zbyte *data, zu64 size){
     if(size > _size - _rwpos)
         resize(_rwpos + size);
-    memcpy(_data + _rwpos, data, size);
+    memcpy(raw() + _rwpos, data, size);
     _rwpos += size;
     return size;
 }
 
+void ZBinary::_reserve(zu64 size){
+    size = MAX(size, _size);
+    if(_alloc.isDefault() && size >= ZLARGE_ALLOC_THRESHOLD){
+        _reserveLarge(size);
+        return;
+    }
+    zu64 newsize = 1;
+    while(newsize < size) newsize <<= 1;
+    // Allocate header and bytes together, with room to align the header
+    zbyte *block = _alloc.alloc(sizeof(Buffer) + alignof(Buffer) - 1 + newsize);
+    zu64 pad = (alignof(Buffer) - ((zu64)block % alignof(Buffer))) % alignof(Buffer);
+    Buffer *buffer = new (block + pad) Buffer;
+    buffer->refs.store(1, std::memory_order_relaxed);
+    buffer->block = block;
+    buffer->capacity = newsize;
+    buffer->large = false;
+    if(_size)
+        _alloc.rawcopy(_data, buffer->data(), _size);
+    _release();
+    _buffer = buffer;
+    _data = buffer->data();
+}
+
+void ZBinary::_reserveLarge(zu64 size){
+    // Grow by half, mapped pages are not committed until they are touched
+    zu64 newsize = MAX(size, _capacity() + _capacity() / 2);
+    if(_buffer != nullptr && _buffer->large && !isShared()){
+        // Resize the mapping, moving pages instead of copying where supported
+        zu64 offset = (zu64)(_data - _buffer->data());
+        zbyte *block = (zbyte *)ZLargeAllocator::realloc(_buffer->block, sizeof(Buffer) + offset + newsize);
+        _buffer = (Buffer *)block;
+        _buffer->block = block;
+        _buffer->capacity = ZLargeAllocator::capacity(block) - sizeof(Buffer);
+        _data = _buffer->data() + offset;
+        return;
+    }
+
+    // Large blocks are aligned for the header
+    zbyte *block = (zbyte *)ZLargeAllocator::alloc(sizeof(Buffer) + newsize);
+    Buffer *buffer = new (block) Buffer;
+    buffer->refs.store(1, std::memory_order_relaxed);
+    buffer->block = block;
+    buffer->capacity = ZLargeAllocator::capacity(block) - sizeof(Buffer);
+    buffer->large = true;
+    if(_size)
+        ::memcpy(buffer->data(), _data, _size);
+    _release();
+    _buffer = buffer;
+    _data = buffer->data();
+}
+
+void ZBinary::_release(){
+    if(_buffer != nullptr){
+        if(_buffer->refs.fetch_sub(1, std::memory_order_acq_rel) == 1){
+            zbyte *block = _buffer->block;
+            bool large = _buffer->large;
+            _buffer->~Buffer();
+            if(large)
+                ZLargeAllocator::dealloc(block);
+            else
+                _alloc.dealloc(block);
+        }
+        _buffer = nullptr;
+    }
+    _data = nullptr;
+}
+
+void ZBinary::_share(const ZBinary &other, zu64 offset, zu64 len){
+    _release();
+    if(other._buffer != nullptr && _alloc.isDefault() && other._alloc.isDefault()){
+        // Both buffers are from the default allocator, share the buffer
+        other._buffer->refs.fetch_add(1, std::memory_order_relaxed);
+        _buffer = other._buffer;
+        _data = other._data + offset;
+        _size = len;
+    } else {
+        _size = 0;
+        if(len){
+            _reserve(len);
+            _alloc.rawcopy(other._data + offset, _data, len);
+        }
+        _size = len;
+    }
+}
+
 zu8 ZBinary::decu8(const zbyte *bin){
     return (zu8)bin[0];
 }
@@ -14,6 +14,9 @@
 //#include "zerror.h"
 //#include "zhash.h"
 
+// For std::atomic
+#include <atomic>
+
 namespace LibChaos {
 
 class ZBinary;
@@ -28,21 +31,20 @@ public:
     enum { NONE = ZU64_MAX };
 
 public:
-    ZBinary(ZAllocator<zbyte> *alloc = new ZAllocator<zbyte>) : _alloc(alloc), _data(nullptr), _size(0), _realsize(0), _rwpos(0){}
+    //! Default constructor, optional user allocator (ZBinary takes ownership).
+    ZBinary(ZAllocator<zbyte> *alloc = nullptr) : _alloc(alloc), _buffer(nullptr), _data(nullptr), _size(0), _rwpos(0){}
 
     ZBinary(zu64 size) : ZBinary(){
         resize(size);
     }
     ZBinary(const void *ptr, zu64 size) : ZBinary(size){
         if(ptr && size){
-            _alloc->rawcopy((const zbyte *)ptr, _data, size);
-            _size = size;
+            _alloc.rawcopy((const zbyte *)ptr, _data, size);
         }
     }
     ZBinary(ZArray<bytetype> arr) : ZBinary(arr.size()){
         if(arr.size()){
-            _alloc->rawcopy(arr.raw(), _data, arr.size());
-            _size = arr.size();
+            _alloc.rawcopy(arr.raw(), _data, arr.size());
         }
     }
     ZBinary(std::initializer_list<bytetype> list) : ZBinary(list.size()){
@@ -53,51 +55,75 @@ public:
     }
     ZBinary(ZString str) : ZBinary((const zbyte *)str.cc(), str.size()){}
 
-    //! Copy constructor.
-    // TODO: Reference-count ZBinary
-    ZBinary(const ZBinary &other) : ZBinary(other._data, other._size){
+    /*! Copy constructor.
+     *  Shares the buffer of \a other until either is modified.
+     *  A binary with a user allocator is copied immediately.
+     */
+    ZBinary(const ZBinary &other) : ZBinary(){
         // _rwpos is not copied
+        _share(other, 0, other._size);
+    }
+
+    //! Move constructor. Takes the buffer and allocator of \a other, leaving it empty.
+    ZBinary(ZBinary &&other) : _buffer(other._buffer), _data(other._data), _size(other._size), _rwpos(other._rwpos){
+        _alloc.swap(other._alloc);
+        other._buffer = nullptr;
+        other._data = nullptr;
+        other._size = 0;
+        other._rwpos = 0;
     }
 
     ~ZBinary(){
         clear();
-        delete _alloc;
     }
 
     void clear(){
+        _release();
         _size = 0;
-        _realsize = 0;
         _rwpos = 0;
-        _alloc->dealloc(_data);
-        _data = nullptr;
     }
 
+    //! Share the buffer of \a other until either is modified.
     ZBinary &operator=(const ZBinary &other){
-        reserve(other._size);
-        _size = other._size;
-        _alloc->rawcopy(other._data, _data, other._size);
+        if(this != &other){
+            if(_alloc.isDefault() && other._alloc.isDefault()){
+                _release();
+                _share(other, 0, other._size);
+            } else {
+                // Copy into this binary's own buffer
+                reserve(other._size);
+                _alloc.rawcopy(other._data, _data, other._size);
+                _size = other._size;
+            }
+        }
+        return *this;
+    }
+
+    //! Move assignment, swaps buffers and allocators with \a other.
+    ZBinary &operator=(ZBinary &&other){
+        _alloc.swap(other._alloc);
+        _swap(_buffer, other._buffer);
+        _swap(_data, other._data);
+        _swap(_size, other._size);
+        _swap(_rwpos, other._rwpos);
         return *this;
     }
 
     bool operator==(const ZBinary &rhs) const {
         if(_size != rhs._size)
             return false;
+        if(_data == rhs._data)
+            return true;
         return (memcmp(_data, rhs._data, _size) == 0);
     }
     bool operator!=(const ZBinary &rhs) const {
         return !operator==(rhs);
     }
 
+    //! Make sure the buffer can hold \a size bytes, and is not shared.
     void reserve(zu64 size){
-        if(size > _realsize){
-            zu64 newsize = 1;
-            while(newsize < size) newsize <<= 1;
-            bytetype *tmp = _alloc->alloc(newsize);
-            _alloc->rawcopy(_data, tmp, _size);
-            _alloc->dealloc(_data);
-            _realsize = newsize;
-            _data = tmp;
-        }
+        if(size > _capacity() || isShared())
+            _reserve(size);
     }
 
     //! Change the logical size of the buffer.
@@ -116,10 +142,23 @@ public:
 
     void reverse();
 
-    zu64 findFirst(const ZBinary &find) const;
+    /*! Get location of first occurrence of \a find after \a start.
+     *  \return Index of first byte of \a find if found, else \ref NONE.
+     */
+    zu64 findFirst(const ZBinary &find, zu64 start = 0) const;
 
     ZBinary getSub(zu64 start) const { return getSub(start, size() - start); }
+    /*! Get a binary of \a len bytes starting at \a start.
+     *  The sub-binary shares this binary's buffer without copying, until either is modified.
+     */
     ZBinary getSub(zu64 start, zu64 len) const;
+    //! Alias for getSub().
+    inline ZBinary slice(zu64 start, zu64 len) const { return getSub(start, len); }
+
+    //! Check if the buffer is shared with other binaries.
+    bool isShared() const {
+        return (_buffer != nullptr && _buffer->refs.load(std::memory_order_acquire) > 1);
+    }
 
     zsize subDiff(const ZBinary &in, ZBinary &out);
 
@@ -166,15 +205,18 @@ public:
     }
 
     zu64 realSize() const {
-        return _realsize;
+        return _capacity();
     }
 
     // ZAccessor interface
+    //! Non-const access unshares the buffer.
     bytetype &at(zu64 i){
 #if LIBCHAOS_BUILD != LIBCHAOS_RELEASE
         if(i >= size())
             throw zexception("ZBinary: Index out of range");
 #endif
+        if(isShared())
+            _reserve(_size);
         return _data[i];
     }
     const bytetype &at(zu64 i) const {
@@ -185,7 +227,12 @@ public:
         return _data[i];
     }
 
-    bytetype *raw(){ return _data; }
+    //! Get a writable pointer to the bytes, unsharing the buffer.
+    bytetype *raw(){
+        if(isShared())
+            _reserve(_size);
+        return _data;
+    }
     const bytetype *raw() const { return _data; }
     zu64 size() const { return _size; }
 
@@ -196,9 +243,11 @@ public:
     zu64 read(zbyte *dest, zu64 length);
     zu64 read(ZBinary &dest, zu64 length);
 
+    //! Read \a length bytes into a sub-binary sharing this buffer.
     ZBinary readSub(zu64 length){
-        ZBinary bin(length);
-        return read(bin.raw(), length);
+        ZBinary bin = getSub(_rwpos, length);
+        _rwpos += bin.size();
+        return bin;
     }
 
     // ZPosition interface
@@ -274,13 +323,53 @@ public:
     static void enczu64(zbyte *bin, zu64 num){ encbeu64(bin, num); }
 
 private:
-    ZAllocator<bytetype> *_alloc;
+    //! Reference-counted buffer header, followed by the bytes.
+    struct Buffer {
+        //! Number of binaries sharing the buffer.
+        std::atomic<zu64> refs;
+        //! Block returned by the allocator.
+        zbyte *block;
+        //! Number of bytes after the header.
+        zu64 capacity;
+        //! Block is from ZLargeAllocator instead of the binary's allocator.
+        bool large;
+
+        zbyte *data(){ return (zbyte *)(this + 1); }
+    };
+
+    //! Get the number of bytes that fit from _data to the end of the buffer.
+    zu64 _capacity() const {
+        return (_buffer ? _buffer->capacity - (zu64)(_data - _buffer->data()) : 0);
+    }
+    /*! Move the bytes to a new, unshared buffer that holds at least \a size bytes.
+     *  With the default allocator, buffers of ZLARGE_ALLOC_THRESHOLD bytes or more come from ZLargeAllocator.
+     */
+    void _reserve(zu64 size);
+    //! Grow into, or resize, a ZLargeAllocator buffer.
+    void _reserveLarge(zu64 size);
+    //! Drop this binary's reference to its buffer.
+    void _release();
+    //! Refer to \a len bytes at \a offset in the buffer of \a other, or copy them if the buffer can't be shared.
+    void _share(const ZBinary &other, zu64 offset, zu64 len);
+
+    template <typename V> static void _swap(V &a, V &b){
+        V tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+private:
+    ZAllocatorHandle<bytetype> _alloc;
+    //! Shared buffer, null when nothing is allocated.
+    Buffer *_buffer;
+    //! First byte of this binary in the buffer.
     bytetype *_data;
     zu64 _size;
-    zu64 _realsize;
     zu64 _rwpos;
 };
 
+ZRELOCATABLE(ZBinary)
+
 }
 
 #endif // ZBINARY_H
@@ -0,0 +1,191 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                              zconcurrentmap.h                              **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZCONCURRENTMAP_H
+#define ZCONCURRENTMAP_H
+
+#include "zmap.h"
+#include "zlock.h"
+#include "zshardarray.h"
+
+#define ZCONCURRENTMAP_DEFAULT_SHARDS   16
+
+namespace LibChaos {
+
+/*! Thread safe hash map, for caches and tables shared between threads.
+ *  Entries are split between shards by hash, each a ZMap behind its own mutex,
+ *  so threads working on different keys rarely wait on each other.
+ *  Keys are hashed once, and the hash both picks the shard and is reused for the lookup in it.
+ *
+ *  Values are copied in and out, since a reference into a shard would outlive its lock.
+ *  Use update() to modify a value in place.
+ *  \note Iteration with forEach() and snapshot() locks one shard at a time, so it is not an atomic view of the whole map.
+ */
+template <typename K, typename T> class ZConcurrentMap {
+public:
+    typedef typename ZMap<K, T>::maphash maphash;
+
+private:
+    //! One lock and map per shard. ZShardArray keeps each shard on its own cache lines.
+    struct Shard {
+        ZMutex mutex;
+        ZMap<K, T> map;
+    };
+
+public:
+    //! Create a map with \a shards shards, rounded up to a power of two.
+    ZConcurrentMap(zu64 shards = ZCONCURRENTMAP_DEFAULT_SHARDS) : _shards(shards){}
+
+    ZConcurrentMap(const ZConcurrentMap &) = delete;
+    ZConcurrentMap &operator=(const ZConcurrentMap &) = delete;
+
+    /*! Copy the value of the entry equal to \a key into \a value.
+     *  \a key may be a \a K or a type that is ZHashEquivalent with \a K.
+     *  \return False if there is no such entry, \a value is not changed.
+     */
+    template <typename Q> bool get(const Q &key, T &value) const {
+        maphash hash = ZMap<K, T>::hashKey(key);
+        Shard &shard = _shard(hash);
+        ZLock lock(shard.mutex);
+        const T *found = shard.map.find(hash, key);
+        if(found == nullptr)
+            return false;
+        value = *found;
+        return true;
+    }
+
+    //! Get a copy of the value of the entry equal to \a key, or \a fallback if there is none.
+    template <typename Q> T get(const Q &key, const T &fallback) const {
+        T value = fallback;
+        get(key, value);
+        return value;
+    }
+
+    //! Check if the map contains a key equal to \a key.
+    template <typename Q> bool contains(const Q &key) const {
+        maphash hash = ZMap<K, T>::hashKey(key);
+        Shard &shard = _shard(hash);
+        ZLock lock(shard.mutex);
+        return shard.map.contains(hash, key);
+    }
+
+    /*! Add an entry with \a key and \a value, if there is no entry with \a key.
+     *  \return True if the entry was added.
+     */
+    bool insert(const K &key, const T &value){
+        maphash hash = ZMap<K, T>::hashKey(key);
+        Shard &shard = _shard(hash);
+        ZLock lock(shard.mutex);
+        if(shard.map.contains(hash, key))
+            return false;
+        shard.map.add(hash, key, value);
+        return true;
+    }
+
+    //! Get a copy of the value of the entry with \a key, adding an entry with \a value first if there is none.
+    T getOrInsert(const K &key, const T &value){
+        maphash hash = ZMap<K, T>::hashKey(key);
+        Shard &shard = _shard(hash);
+        ZLock lock(shard.mutex);
+        const T *found = shard.map.find(hash, key);
+        if(found != nullptr)
+            return *found;
+        return shard.map.add(hash, key, value);
+    }
+
+    /*! Add an entry with \a key and \a value, or replace the value of the entry with \a key.
+     *  \return True if the entry was added, false if it was replaced.
+     */
+    bool upsert(const K &key, const T &value){
+        maphash hash = ZMap<K, T>::hashKey(key);
+        Shard &shard = _shard(hash);
+        ZLock lock(shard.mutex);
+        T *found = shard.map.find(hash, key);
+        if(found != nullptr){
+            *found = value;
+            return false;
+        }
+        shard.map.add(hash, key, value);
+        return true;
+    }
+
+    /*! Call \a func with a reference to the value of the entry with \a key, while its shard is locked.
+     *  A default constructed value is added first if there is no entry with \a key.
+     *  \a func must not access this map.
+     */
+    template <typename F> void update(const K &key, F func){
+        maphash hash = ZMap<K, T>::hashKey(key);
+        Shard &shard = _shard(hash);
+        ZLock lock(shard.mutex);
+        T *found = shard.map.find(hash, key);
+        func(found != nullptr ? *found : shard.map.add(hash, key, T()));
+    }
+
+    /*! Remove the entry equal to \a key.
+     *  \return True if an entry was removed.
+     */
+    template <typename Q> bool remove(const Q &key){
+        maphash hash = ZMap<K, T>::hashKey(key);
+        Shard &shard = _shard(hash);
+        ZLock lock(shard.mutex);
+        return shard.map.erase(hash, key);
+    }
+
+    //! Remove all entries.
+    void clear(){
+        for(zu64 i = 0; i < shardCount(); ++i){
+            ZLock lock(_shards[i].mutex);
+            _shards[i].map.clear();
+        }
+    }
+
+    //! Number of entries. Only a hint while other threads modify the map.
+    zu64 size() const {
+        zu64 size = 0;
+        for(zu64 i = 0; i < shardCount(); ++i){
+            ZLock lock(_shards[i].mutex);
+            size += _shards[i].map.size();
+        }
+        return size;
+    }
+
+    bool isEmpty() const {
+        return size() == 0;
+    }
+
+    /*! Call \a func with each key and value, one shard at a time, while the shard is locked.
+     *  \a func must not access this map.
+     */
+    template <typename F> void forEach(F func) const {
+        for(zu64 i = 0; i < shardCount(); ++i){
+            ZLock lock(_shards[i].mutex);
+            const ZMap<K, T> &map = _shards[i].map;
+            for(auto it = map.begin(); it.more(); ++it)
+                func(*it, map.get(*it));
+        }
+    }
+
+    //! Get a copy of the entries, for iterating without holding locks.
+    ZMap<K, T> snapshot() const {
+        ZMap<K, T> out;
+        forEach([&](const K &key, const T &value){ out.add(key, value); });
+        return out;
+    }
+
+    zu64 shardCount() const { return _shards.size(); }
+
+private:
+    //! Pick a shard with the top bits of \a hash, the shard's map indexes with the low bits.
+    Shard &_shard(maphash hash) const {
+        return _shards.forHash(hash);
+    }
+
+private:
+    ZShardArray<Shard> _shards;
+};
+
+}
+
+#endif // ZCONCURRENTMAP_H
@@ -0,0 +1,404 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                                 zcsrgraph.h                                **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZCSRGRAPH_H
+#define ZCSRGRAPH_H
+
+#include "ztypes.h"
+#include "zarray.h"
+#include "zmap.h"
+#include "zgraph.h"
+#include "zexception.h"
+#include "zthread.h"
+
+#include <atomic>
+#include <thread>
+
+//! Frontiers smaller than this are expanded on the calling thread by parallelBfs().
+#define ZCSRGRAPH_PARALLEL_FRONTIER 4096
+
+namespace LibChaos {
+
+/*! Immutable weighted, directed graph in compressed sparse row form.
+ *  Each vertex is mapped once to a dense id in [0, vertexCount()), in the order vertices were given.
+ *  The children of vertex \a i are targets [offsets[i], offsets[i + 1]), with their edge weights alongside,
+ *  so traversals read three flat arrays instead of chasing maps.
+ *
+ *  Algorithms work on ids and return arrays indexed by id. Use id() and vertex() to convert.
+ *  \a E must be a number type for dijkstra().
+ */
+template <typename V, typename E> class ZCSRGraph {
+public:
+    enum { NONE = ZU64_MAX };
+
+    typedef typename ZGraph<V, E>::Edge Edge;
+
+public:
+    //! Build from the vertices and edges of \a graph.
+    ZCSRGraph(const ZGraph<V, E> &graph){
+        _build(graph.vertices(), graph.edges());
+    }
+
+    /*! Bulk build from \a vertices and \a edges.
+     *  Vertices only named by edges are added after \a vertices, in the order they are first seen.
+     */
+    ZCSRGraph(const ZArray<V> &vertices, const ZArray<Edge> &edges){
+        _build(vertices, edges);
+    }
+
+    zu64 vertexCount() const { return _vertices.size(); }
+    zu64 edgeCount() const { return _targets.size(); }
+
+    //! Get the id of \a vertex, NONE if it is not in the graph.
+    zu64 id(const V &vertex) const {
+        const zu64 *found = _ids.find(vertex);
+        return (found != nullptr ? *found : (zu64)NONE);
+    }
+    //! Get the vertex with \a id.
+    const V &vertex(zu64 id) const {
+        return _vertices[id];
+    }
+
+    //! Number of edges from vertex \a id.
+    zu64 degree(zu64 id) const {
+        return _offsets[id + 1] - _offsets[id];
+    }
+    //! Ids of the children of vertex \a id, degree() of them.
+    const zu64 *children(zu64 id) const {
+        return _targets.raw() + _offsets[id];
+    }
+    //! Weights of the edges from vertex \a id, degree() of them.
+    const E *weights(zu64 id) const {
+        return _weights.raw() + _offsets[id];
+    }
+
+    /*! Breadth first search from vertex \a source.
+     *  \return Number of edges on the shortest path to each vertex, NONE if unreachable.
+     *  If \a parents is not null, it is filled with the previous vertex on a shortest path to each vertex, NONE for none.
+     *  \throws Throws an exception if \a source is not a vertex id.
+     */
+    ZArray<zu64> bfs(zu64 source, ZArray<zu64> *parents = nullptr) const {
+        if(source >= vertexCount())
+            throw ZException("ZCSRGraph bfs: Source is not a vertex");
+        ZArray<zu64> dist;
+        dist.resize(vertexCount(), (zu64)NONE);
+        if(parents)
+            parents->resize(0).resize(vertexCount(), (zu64)NONE);
+        ZArray<zu64> queue;
+        queue.reserve(vertexCount());
+        dist[source] = 0;
+        queue.push(source);
+        for(zu64 head = 0; head < queue.size(); ++head){
+            zu64 u = queue[head];
+            for(zu64 e = _offsets[u]; e < _offsets[u + 1]; ++e){
+                zu64 v = _targets[e];
+                if(dist[v] == NONE){
+                    dist[v] = dist[u] + 1;
+                    if(parents)
+                        (*parents)[v] = u;
+                    queue.push(v);
+                }
+            }
+        }
+        return dist;
+    }
+
+    /*! Breadth first search from vertex \a source, expanding each large frontier with \a threads threads.
+     *  \a threads of zero uses one thread per hardware thread.
+     *  \return Same distances as bfs().
+     *  \throws Throws an exception if \a source is not a vertex id.
+     */
+    ZArray<zu64> parallelBfs(zu64 source, zu64 threads = 0) const {
+        if(source >= vertexCount())
+            throw ZException("ZCSRGraph parallelBfs: Source is not a vertex");
+        if(threads == 0)
+            threads = std::thread::hardware_concurrency();
+        const zu64 count = vertexCount();
+        std::atomic<zu64> *dist = new std::atomic<zu64>[count];
+        for(zu64 i = 0; i < count; ++i)
+            dist[i].store(NONE, std::memory_order_relaxed);
+        dist[source].store(0, std::memory_order_relaxed);
+
+        ZArray<zu64> frontier = { source };
+        for(zu64 level = 1; frontier.size(); ++level){
+            zu64 parts = (frontier.size() < ZCSRGRAPH_PARALLEL_FRONTIER ? 1 : MIN(threads, frontier.size() / (ZCSRGRAPH_PARALLEL_FRONTIER / 4)));
+            ZArray<BfsTask> tasks;
+            tasks.resize(MAX(parts, (zu64)1));
+            for(zu64 i = 0; i < tasks.size(); ++i){
+                tasks[i].graph = this;
+                tasks[i].dist = dist;
+                tasks[i].frontier = frontier.raw() + frontier.size() * i / tasks.size();
+                tasks[i].size = frontier.size() * (i + 1) / tasks.size() - frontier.size() * i / tasks.size();
+                tasks[i].level = level;
+            }
+            if(tasks.size() == 1){
+                _expand(tasks[0]);
+            } else {
+                ZArray<ZThread *> running;
+                for(zu64 i = 0; i < tasks.size(); ++i){
+                    ZThread *thread = new ZThread(_bfsTask);
+                    thread->exec(&tasks[i]);
+                    running.push(thread);
+                }
+                for(zu64 i = 0; i < running.size(); ++i){
+                    running[i]->join();
+                    delete running[i];
+                }
+            }
+            frontier.clear();
+            for(zu64 i = 0; i < tasks.size(); ++i)
+                frontier.append(tasks[i].next);
+        }
+
+        ZArray<zu64> out;
+        out.reserve(count);
+        for(zu64 i = 0; i < count; ++i)
+            out.push(dist[i].load(std::memory_order_relaxed));
+        delete[] dist;
+        return out;
+    }
+
+    /*! Shortest paths from vertex \a source by Dijkstra's algorithm, with a binary heap.
+     *  Edge weights must not be negative.
+     *  \return Distance to each vertex. Unreachable vertices have distance \a infinity.
+     *  If \a parents is not null, it is filled with the previous vertex on a shortest path to each vertex, NONE for none.
+     *  \throws Throws an exception if \a source is not a vertex id.
+     */
+    ZArray<E> dijkstra(zu64 source, E infinity, ZArray<zu64> *parents = nullptr) const {
+        if(source >= vertexCount())
+            throw ZException("ZCSRGraph dijkstra: Source is not a vertex");
+        ZArray<E> dist;
+        dist.resize(vertexCount(), infinity);
+        if(parents)
+            parents->resize(0).resize(vertexCount(), (zu64)NONE);
+        ZArray<bool> done;
+        done.resize(vertexCount(), false);
+
+        // Vertices may be in the heap more than once, stale entries are skipped when popped
+        ZArray<HeapEntry> heap;
+        dist[source] = E();
+        _heapPush(heap, { E(), source });
+        while(heap.size()){
+            HeapEntry top = _heapPop(heap);
+            zu64 u = top.id;
+            if(done[u])
+                continue;
+            done[u] = true;
+            for(zu64 e = _offsets[u]; e < _offsets[u + 1]; ++e){
+                zu64 v = _targets[e];
+                E d = dist[u] + _weights[e];
+                if(!done[v] && d < dist[v]){
+                    dist[v] = d;
+                    if(parents)
+                        (*parents)[v] = u;
+                    _heapPush(heap, { d, v });
+                }
+            }
+        }
+        return dist;
+    }
+
+    /*! Find the weakly connected components, treating edges as undirected.
+     *  \return Component number of each vertex, numbered from zero in order of their first vertex.
+     *  If \a count is not null, it is set to the number of components.
+     */
+    ZArray<zu64> components(zu64 *count = nullptr) const {
+        // Union-find with path halving and union by size
+        ZArray<zu64> parent;
+        ZArray<zu64> size;
+        parent.reserve(vertexCount());
+        for(zu64 i = 0; i < vertexCount(); ++i)
+            parent.push(i);
+        size.resize(vertexCount(), 1);
+        for(zu64 u = 0; u < vertexCount(); ++u){
+            for(zu64 e = _offsets[u]; e < _offsets[u + 1]; ++e){
+                zu64 a = _find(parent, u);
+                zu64 b = _find(parent, _targets[e]);
+                if(a == b)
+                    continue;
+                if(size[a] < size[b]){
+                    zu64 tmp = a;
+                    a = b;
+                    b = tmp;
+                }
+                parent[b] = a;
+                size[a] += size[b];
+            }
+        }
+
+        // Renumber roots densely
+        ZArray<zu64> comp;
+        comp.resize(vertexCount(), (zu64)NONE);
+        zu64 next = 0;
+        for(zu64 i = 0; i < vertexCount(); ++i){
+            zu64 root = _find(parent, i);
+            if(comp[root] == NONE)
+                comp[root] = next++;
+            comp[i] = comp[root];
+        }
+        if(count)
+            *count = next;
+        return comp;
+    }
+
+    /*! Order the vertices so every edge goes from an earlier vertex to a later one, by Kahn's algorithm.
+     *  Vertices with no ordering between them keep their id order.
+     *  \throws ZException if the graph has a cycle.
+     */
+    ZArray<zu64> topologicalSort() const {
+        ZArray<zu64> indegree;
+        indegree.resize(vertexCount(), 0);
+        for(zu64 e = 0; e < _targets.size(); ++e)
+            ++indegree[_targets[e]];
+        ZArray<zu64> order;
+        order.reserve(vertexCount());
+        for(zu64 i = 0; i < vertexCount(); ++i){
+            if(indegree[i] == 0)
+                order.push(i);
+        }
+        for(zu64 head = 0; head < order.size(); ++head){
+            zu64 u = order[head];
+            for(zu64 e = _offsets[u]; e < _offsets[u + 1]; ++e){
+                if(--indegree[_targets[e]] == 0)
+                    order.push(_targets[e]);
+            }
+        }
+        if(order.size() != vertexCount())
+            throw ZException("ZCSRGraph topologicalSort: Graph has a cycle");
+        return order;
+    }
+
+private:
+    struct HeapEntry {
+        E dist;
+        zu64 id;
+    };
+
+    struct BfsTask {
+        const ZCSRGraph *graph;
+        std::atomic<zu64> *dist;
+        const zu64 *frontier;
+        zu64 size;
+        zu64 level;
+        //! Vertices this task claimed for the next level.
+        ZArray<zu64> next;
+    };
+
+    void _build(const ZArray<V> &vertices, const ZArray<Edge> &edges){
+        for(zu64 i = 0; i < vertices.size(); ++i)
+            _addVertex(vertices[i]);
+
+        // Count edges per parent, then place each edge in its parent's range
+        ZArray<zu64> parents;
+        ZArray<zu64> children;
+        parents.reserve(edges.size());
+        children.reserve(edges.size());
+        for(zu64 i = 0; i < edges.size(); ++i){
+            parents.push(_addVertex(edges[i].parent));
+            children.push(_addVertex(edges[i].child));
+        }
+        _offsets.resize(vertexCount() + 1, 0);
+        for(zu64 i = 0; i < edges.size(); ++i)
+            ++_offsets[parents[i] + 1];
+        for(zu64 i = 0; i < vertexCount(); ++i)
+            _offsets[i + 1] += _offsets[i];
+        ZArray<zu64> next = _offsets;
+        _targets.resize(edges.size(), 0);
+        _weights.resize(edges.size(), E());
+        for(zu64 i = 0; i < edges.size(); ++i){
+            zu64 e = next[parents[i]]++;
+            _targets[e] = children[i];
+            _weights[e] = edges[i].edge;
+        }
+    }
+
+    zu64 _addVertex(const V &vertex){
+        const zu64 *found = _ids.find(vertex);
+        if(found != nullptr)
+            return *found;
+        zu64 id = _vertices.size();
+        _vertices.push(vertex);
+        _ids.add(vertex, id);
+        return id;
+    }
+
+    //! Find the root of \a i, halving the path on the way.
+    static zu64 _find(ZArray<zu64> &parent, zu64 i){
+        while(parent[i] != i){
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    //! Add \a entry to a min-heap ordered by distance.
+    static void _heapPush(ZArray<HeapEntry> &heap, HeapEntry entry){
+        zu64 i = heap.size();
+        heap.push(entry);
+        while(i > 0){
+            zu64 up = (i - 1) / 2;
+            if(!(heap[i].dist < heap[up].dist))
+                break;
+            HeapEntry tmp = heap[i];
+            heap[i] = heap[up];
+            heap[up] = tmp;
+            i = up;
+        }
+    }
+    //! Remove and return the entry with the smallest distance.
+    static HeapEntry _heapPop(ZArray<HeapEntry> &heap){
+        HeapEntry top = heap[0];
+        heap[0] = heap[heap.size() - 1];
+        heap.popBack();
+        zu64 i = 0;
+        while(true){
+            zu64 child = i * 2 + 1;
+            if(child >= heap.size())
+                break;
+            if(child + 1 < heap.size() && heap[child + 1].dist < heap[child].dist)
+                ++child;
+            if(!(heap[child].dist < heap[i].dist))
+                break;
+            HeapEntry tmp = heap[i];
+            heap[i] = heap[child];
+            heap[child] = tmp;
+            i = child;
+        }
+        return top;
+    }
+
+    //! Claim unvisited children of a slice of the frontier for the next level.
+    static void _expand(BfsTask &task){
+        const ZCSRGraph *graph = task.graph;
+        for(zu64 i = 0; i < task.size; ++i){
+            zu64 u = task.frontier[i];
+            for(zu64 e = graph->_offsets[u]; e < graph->_offsets[u + 1]; ++e){
+                zu64 v = graph->_targets[e];
+                zu64 expect = NONE;
+                // Check before the exchange, most children are already visited
+                if(task.dist[v].load(std::memory_order_relaxed) == NONE &&
+                        task.dist[v].compare_exchange_strong(expect, task.level, std::memory_order_relaxed))
+                    task.next.push(v);
+            }
+        }
+    }
+    static void *_bfsTask(ZThread::ZThreadArg arg){
+        _expand(*(BfsTask *)arg.arg);
+        return nullptr;
+    }
+
+private:
+    ZArray<V> _vertices;
+    //! Vertex to id, only used to convert.
+    ZMap<V, zu64> _ids;
+    //! vertexCount() + 1 offsets into \a _targets and \a _weights.
+    ZArray<zu64> _offsets;
+    ZArray<zu64> _targets;
+    ZArray<E> _weights;
+};
+
+}
+
+#endif // ZCSRGRAPH_H
@@ -0,0 +1,265 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                                  zdeque.h                                  **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZDEQUE_H
+#define ZDEQUE_H
+
+#include "ztypes.h"
+#include "zallocator.h"
+#include "zexception.h"
+#include "ziterator.h"
+#include "yindexedaccess.h"
+#include "ypushpopaccess.h"
+
+#include <initializer_list>
+
+//! Capacity of a ZDeque's first buffer.
+#define ZDEQUE_MIN_CAPACITY 8
+
+namespace LibChaos {
+
+/*! Double-ended queue container.
+ *  Implemented as a ring buffer in one contiguous block, with a power of two capacity,
+ *  so indexing is a mask instead of a division.
+ *  Pushing and popping at either end is amortized O(1) and only allocates when the buffer grows.
+ *  ZDeque push/pop paradigm is FIFO, like ZList.
+ *  \note Pushing or growing invalidates references to elements.
+ */
+template <typename T> class ZDeque : public YIndexedAccess<T>, public YPushPopAccess<T> {
+public:
+    class ZDequeIterator;
+
+public:
+    //! Create an empty deque, optional user allocator (ZDeque takes ownership). No memory is allocated until the first push.
+    ZDeque(ZAllocator<T> *alloc = nullptr) : _alloc(alloc), _data(nullptr), _capacity(0), _head(0), _size(0){}
+
+    ZDeque(std::initializer_list<T> ls) : ZDeque(){
+        reserve(ls.size());
+        for(auto item = ls.begin(); item < ls.end(); ++item)
+            pushBack(*item);
+    }
+
+    ZDeque(const ZDeque &other) : ZDeque(){
+        _copy(other);
+    }
+
+    //! Move constructor. Takes the buffer and allocator of \a other, leaving it empty.
+    ZDeque(ZDeque &&other) : ZDeque(){
+        swap(other);
+    }
+
+    ~ZDeque(){
+        clear();
+        _alloc.dealloc(_data);
+    }
+
+    ZDeque &operator=(const ZDeque &other){
+        if(this != &other){
+            clear();
+            _copy(other);
+        }
+        return *this;
+    }
+
+    //! Move assignment, swaps contents and allocators with \a other.
+    ZDeque &operator=(ZDeque &&other){
+        swap(other);
+        return *this;
+    }
+
+    //! Add \a data to the back of the deque.
+    void pushBack(const T &data){
+        emplaceBack(data);
+    }
+    //! Move \a data to the back of the deque.
+    void pushBack(T &&data){
+        emplaceBack(std::move(data));
+    }
+    //! Construct a new element at the back of the deque with \a args.
+    template <typename ... Args> T &emplaceBack(Args&& ... args){
+        if(_size == _capacity)
+            _grow(_size + 1);
+        T *slot = _data + ((_head + _size) & (_capacity - 1));
+        _alloc.emplace(slot, std::forward<Args>(args)...);
+        ++_size;
+        return *slot;
+    }
+
+    //! Add \a data to the front of the deque.
+    void pushFront(const T &data){
+        emplaceFront(data);
+    }
+    //! Move \a data to the front of the deque.
+    void pushFront(T &&data){
+        emplaceFront(std::move(data));
+    }
+    //! Construct a new element at the front of the deque with \a args.
+    template <typename ... Args> T &emplaceFront(Args&& ... args){
+        if(_size == _capacity)
+            _grow(_size + 1);
+        zu64 head = (_head - 1) & (_capacity - 1);
+        _alloc.emplace(_data + head, std::forward<Args>(args)...);
+        _head = head;
+        ++_size;
+        return _data[head];
+    }
+
+    inline void push(const T &data){ pushBack(data); }
+    inline void push(T &&data){ pushBack(std::move(data)); }
+
+    //! Remove an element from the front of the deque.
+    void popFront(){
+        if(_size){
+            _alloc.destroy(_data + _head);
+            _head = (_head + 1) & (_capacity - 1);
+            --_size;
+        }
+    }
+    //! Remove an element from the back of the deque.
+    void popBack(){
+        if(_size){
+            _alloc.destroy(_data + ((_head + _size - 1) & (_capacity - 1)));
+            --_size;
+        }
+    }
+    inline void pop(){ popFront(); }
+
+    inline T &peek(){ return front(); }
+    inline const T &peek() const { return front(); }
+
+    inline T &front(){
+        if(_size == 0)
+            throw ZException("ZDeque: Cannot reference front of empty ZDeque");
+        return _data[_head];
+    }
+    inline const T &front() const {
+        if(_size == 0)
+            throw ZException("ZDeque: Cannot reference front of empty ZDeque");
+        return _data[_head];
+    }
+    inline T &back(){
+        if(_size == 0)
+            throw ZException("ZDeque: Cannot reference back of empty ZDeque");
+        return _data[(_head + _size - 1) & (_capacity - 1)];
+    }
+    inline const T &back() const {
+        if(_size == 0)
+            throw ZException("ZDeque: Cannot reference back of empty ZDeque");
+        return _data[(_head + _size - 1) & (_capacity - 1)];
+    }
+
+    //! Get the element \a index from the front. Not bounds checked.
+    inline T &operator[](zu64 index){ return _data[(_head + index) & (_capacity - 1)]; }
+    inline const T &operator[](zu64 index) const { return _data[(_head + index) & (_capacity - 1)]; }
+
+    //! Get the element \a index from the front. \throws ZException if \a index is out of range.
+    T &at(zu64 index){
+        if(index >= _size)
+            throw ZException("ZDeque: Index out of range");
+        return operator[](index);
+    }
+    const T &at(zu64 index) const {
+        if(index >= _size)
+            throw ZException("ZDeque: Index out of range");
+        return operator[](index);
+    }
+
+    //! Remove all elements. Keeps the buffer.
+    void clear(){
+        while(_size)
+            popBack();
+        _head = 0;
+    }
+
+    //! Make room for at least \a size elements.
+    void reserve(zu64 size){
+        if(size > _capacity)
+            _grow(size);
+    }
+
+    //! Swap contents and allocators with \a other.
+    void swap(ZDeque &other){
+        _alloc.swap(other._alloc);
+        _swap(_data, other._data);
+        _swap(_capacity, other._capacity);
+        _swap(_head, other._head);
+        _swap(_size, other._size);
+    }
+
+    //! Get an iterator from the front of the deque.
+    ZDequeIterator begin() const {
+        return ZDequeIterator(this, 0);
+    }
+
+    inline bool isEmpty() const { return (_size == 0); }
+    inline zu64 size() const { return _size; }
+    //! Number of elements that fit before the buffer grows.
+    inline zu64 capacity() const { return _capacity; }
+
+private:
+    //! Move the elements to a new buffer of at least \a size, straightening the ring.
+    void _grow(zu64 size){
+        zu64 capacity = (_capacity ? _capacity : ZDEQUE_MIN_CAPACITY);
+        while(capacity < size)
+            capacity <<= 1;
+        T *data = _alloc.alloc(capacity);
+        if(_size){
+            // Move the part from the head to the end of the buffer, then the part wrapped to the start
+            zu64 first = MIN(_size, _capacity - _head);
+            _alloc.move(_data + _head, data, first);
+            _alloc.move(_data, data + first, _size - first);
+        }
+        _alloc.dealloc(_data);
+        _data = data;
+        _capacity = capacity;
+        _head = 0;
+    }
+
+    void _copy(const ZDeque &other){
+        reserve(other._size);
+        for(zu64 i = 0; i < other._size; ++i)
+            pushBack(other[i]);
+    }
+
+    template <typename V> static void _swap(V &a, V &b){
+        V tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+public:
+    class ZDequeIterator : public ZSimplexConstIterator<T> {
+    public:
+        ZDequeIterator(const ZDeque *deque, zu64 index) : _deque(deque), _index(index){}
+
+        const T &get() const override {
+            return (*_deque)[_index];
+        }
+        bool more() const override {
+            return _index < _deque->size();
+        }
+        void advance() override {
+            ++_index;
+        }
+
+    private:
+        const ZDeque *_deque;
+        zu64 _index;
+    };
+
+private:
+    ZAllocatorHandle<T> _alloc;
+    //! Ring buffer, \a _capacity elements.
+    T *_data;
+    //! Always zero or a power of two.
+    zu64 _capacity;
+    //! Index of the front element in the buffer.
+    zu64 _head;
+    zu64 _size;
+};
+
+}
+
+#endif // ZDEQUE_H
@@ -5,13 +5,13 @@
 #include "zlist.h"
 #include "zmap.h"
 
-#define ZGRAPH_EDGE_EXISTS 0x01
-
 namespace LibChaos {
 
 /*! Generic weighted, directed graph implementation.
  *  Effectively an unweighted graph when every edge has the same weight.
  *  Effectively an undirected graph when every edge has a complement edge.
+ *  Stored as adjacency lists, so memory is O(V + E) and adding a vertex is O(1).
+ *  For traversals and path finding on large graphs, build a ZCSRGraph from it.
  */
 template <typename V, typename E> class ZGraph {
 public:
@@ -29,14 +29,8 @@ public:
 
     //! Construct a graph with a list of \a vertices.
     ZGraph(ZList<V> vertices){
-        ZMap<V, EdgeWeight> inner;
-        // Add vertices to inner map
-        for(auto i = vertices.begin(); i.more(); ++i){
-            inner.add(*i, { 0, E() });
-        }
-        // Map each vertex to another identical map
         for(auto i = vertices.begin(); i.more(); ++i){
-            _adjmap.add(*i, inner);
+            add(*i);
         }
     }
 
@@ -48,40 +42,39 @@ public:
         }
     }
 
-    //! Add \a vertex to the graph.
+    //! Add \a vertex to the graph, if it is not already in the graph.
     void add(V vertex){
-        ZMap<V, EdgeWeight> inner;
-        // Add vertices to inner map
-        for(auto i = _adjmap.begin(); i.more(); ++i){
-            inner.add(*i, { 0, E() });
-        }
-        // Add outer vertex with inner map
-        _adjmap.add(vertex, inner);
-        // Add inner vertices
-        for(auto i = _adjmap.begin(); i.more(); ++i){
-            _adjmap[*i].add(vertex, { 0, E() });
-        }
+        if(!_adjmap.contains(vertex))
+            _adjmap.add(vertex, ZMap<V, E>());
     }
 
-    //! Remove \a vertex from the graph.
+    //! Remove \a vertex and every edge to or from it from the graph.
     void remove(V vertex){
-        // Remove outer vertx
+        // Remove outer vertex
         _adjmap.remove(vertex);
-        // Remove innter vertices
+        // Remove edges to the vertex
         for(auto i = _adjmap.begin(); i.more(); ++i){
             _adjmap[*i].remove(vertex);
         }
     }
 
-    //! Connect a \a parent vertex to \a child vertex with an \a edge.
+    //! Connect a \a parent vertex to \a child vertex with an \a edge. Adds either vertex if it is not in the graph.
     void connect(V parent, V child, E edge = E()){
-        _adjmap[parent][child].flags = ZGRAPH_EDGE_EXISTS;
-        _adjmap[parent][child].edge = edge;
+        add(child);
+        _adjmap[parent][child] = edge;
+    }
+
+    //! Remove the edge from \a parent to \a child, if there is one.
+    void disconnect(V parent, V child){
+        ZMap<V, E> *edges = _adjmap.find(parent);
+        if(edges != nullptr)
+            edges->remove(child);
     }
 
     //! Determine if two vertices are directly connected.
     bool connected(V parent, V child) const {
-        return (_adjmap.contains(parent) && _adjmap.contains(child) && _adjmap[parent][child].flags == ZGRAPH_EDGE_EXISTS);
+        const ZMap<V, E> *edges = _adjmap.find(parent);
+        return (edges != nullptr && edges->contains(child));
     }
 
     /*! Get the weight of the edge between two vertices.
@@ -90,7 +83,7 @@ public:
     E weight(V parent, V child, E edge) const {
         if(!connected(parent, child))
             throw ZException("Vertices are not connected");
-        return _adjmap[parent][child].edge;
+        return _adjmap[parent][child];
     }
 
     //! Get an array of the vertices in the graph.
@@ -102,15 +95,37 @@ public:
         return verts;
     }
 
-private:
-    struct EdgeWeight {
-        zbyte flags;
-        E edge;
-    };
+    //! Get an array of the edges in the graph, grouped by parent vertex.
+    ZArray<Edge> edges() const {
+        ZArray<Edge> list;
+        for(auto i = _adjmap.begin(); i.more(); ++i){
+            const ZMap<V, E> &children = _adjmap[*i];
+            for(auto j = children.begin(); j.more(); ++j)
+                list.push({ *i, *j, children[*j] });
+        }
+        return list;
+    }
+
+    //! Get an array of the vertices \a parent has an edge to.
+    ZArray<V> children(V parent) const {
+        const ZMap<V, E> *edges = _adjmap.find(parent);
+        return (edges != nullptr ? edges->keys() : ZArray<V>());
+    }
+
+    zu64 vertexCount() const {
+        return _adjmap.size();
+    }
+
+    zu64 edgeCount() const {
+        zu64 count = 0;
+        for(auto i = _adjmap.begin(); i.more(); ++i)
+            count += _adjmap[*i].size();
+        return count;
+    }
 
 private:
-    //! Graph adjacency map.
-    ZMap<V, ZMap<V, EdgeWeight>> _adjmap;
+    //! Graph adjacency lists, each vertex maps to the vertices it has edges to.
+    ZMap<V, ZMap<V, E>> _adjmap;
 };
 
 }
@@ -0,0 +1,497 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                                zhashtable.h                                **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZHASHTABLE_H
+#define ZHASHTABLE_H
+
+#include "ztypes.h"
+#include "zallocator.h"
+#include "zexception.h"
+#include "zpointer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define ZHASHTABLE_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define ZHASHTABLE_NEON
+    #include <arm_neon.h>
+#endif
+
+#if LIBCHAOS_COMPILER == _COMPILER_MSVC
+    // For _BitScanForward64
+    #include <intrin.h>
+#endif
+
+#if LIBCHAOS_COMPILER == _COMPILER_GCC || LIBCHAOS_COMPILER == _COMPILER_CLANG || LIBCHAOS_COMPILER == _COMPILER_MINGW
+    #define ZHASHTABLE_PREFETCH(PTR) __builtin_prefetch(PTR)
+#elif defined(ZHASHTABLE_SSE2)
+    #define ZHASHTABLE_PREFETCH(PTR) _mm_prefetch((const char *)(PTR), _MM_HINT_T0)
+#else
+    #define ZHASHTABLE_PREFETCH(PTR)
+#endif
+
+//! Number of control bytes probed at once.
+#define ZHASHTABLE_GROUP    16
+//! Control byte of an empty slot.
+#define ZHASHTABLE_EMPTY    0x80
+//! Control byte of a slot whose entry was removed.
+#define ZHASHTABLE_DELETED  0xFE
+//! Hash stored in removed entries.
+#define ZHASHTABLE_REMOVED  ZU64_MAX
+//! Number of keys hashed and prefetched ahead in batch lookups.
+#define ZHASHTABLE_BATCH    16
+
+namespace LibChaos {
+
+/*! One group of hash table control bytes, matched in parallel.
+ *  Uses SSE2 or NEON where available, and a scalar loop otherwise.
+ *  Match masks should only be read with next().
+ */
+class ZHashGroup {
+public:
+    //! Load the group of ZHASHTABLE_GROUP control bytes at \a ctrl.
+    ZHashGroup(const zbyte *ctrl){
+#if defined(ZHASHTABLE_SSE2)
+        _ctrl = _mm_loadu_si128((const __m128i *)ctrl);
+#elif defined(ZHASHTABLE_NEON)
+        _ctrl = vld1q_u8(ctrl);
+#else
+        _ctrl = ctrl;
+#endif
+    }
+
+    //! Mask of the slots with control byte \a h2.
+    zu64 match(zbyte h2) const {
+#if defined(ZHASHTABLE_SSE2)
+        return (zu64)_mm_movemask_epi8(_mm_cmpeq_epi8(_ctrl, _mm_set1_epi8((char)h2)));
+#elif defined(ZHASHTABLE_NEON)
+        return _mask(vceqq_u8(_ctrl, vdupq_n_u8(h2)));
+#else
+        zu64 mask = 0;
+        for(zu64 i = 0; i < ZHASHTABLE_GROUP; ++i)
+            mask |= (zu64)(_ctrl[i] == h2) << i;
+        return mask;
+#endif
+    }
+
+    //! Mask of the empty slots.
+    zu64 matchEmpty() const {
+        return match(ZHASHTABLE_EMPTY);
+    }
+
+    //! Mask of the empty or deleted slots.
+    zu64 matchFree() const {
+#if defined(ZHASHTABLE_SSE2)
+        // Only empty and deleted control bytes have the high bit set
+        return (zu64)_mm_movemask_epi8(_ctrl);
+#elif defined(ZHASHTABLE_NEON)
+        return _mask(vcltq_s8(vreinterpretq_s8_u8(_ctrl), vdupq_n_s8(0)));
+#else
+        zu64 mask = 0;
+        for(zu64 i = 0; i < ZHASHTABLE_GROUP; ++i)
+            mask |= (zu64)(_ctrl[i] >> 7) << i;
+        return mask;
+#endif
+    }
+
+    //! Get the offset of the first slot in \a mask and remove it from \a mask. \a mask must not be zero.
+    static inline zu64 next(zu64 &mask){
+#if LIBCHAOS_COMPILER == _COMPILER_MSVC
+        unsigned long bit;
+        _BitScanForward64(&bit, mask);
+#else
+        zu64 bit = (zu64)__builtin_ctzll(mask);
+#endif
+        mask &= mask - 1;
+#if defined(ZHASHTABLE_NEON)
+        // Four bits per slot
+        return (zu64)bit >> 2;
+#else
+        return (zu64)bit;
+#endif
+    }
+
+private:
+#if defined(ZHASHTABLE_NEON)
+    //! Narrow a byte comparison to a mask with the high bit of each nibble set for matching slots.
+    static inline zu64 _mask(uint8x16_t cmp){
+        uint8x8_t narrow = vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(narrow), 0) & 0x8888888888888888ULL;
+    }
+#endif
+
+private:
+#if defined(ZHASHTABLE_SSE2)
+    __m128i _ctrl;
+#elif defined(ZHASHTABLE_NEON)
+    uint8x16_t _ctrl;
+#else
+    const zbyte *_ctrl;
+#endif
+};
+
+/*! Open addressing hash table core shared by ZMap and ZSet.
+ *  Entries are stored densely in insertion order. Each slot of the table holds the index of an entry,
+ *  and a control byte holding 7 bits of the entry's hash, so lookups probe ZHASHTABLE_GROUP slots
+ *  at a time and only compare keys on a control byte match.
+ *  Removed entries leave a hole in the entry array until the next rehash, which preserves iteration order.
+ *  Entries, control bytes and slots share one block from the allocator.
+ *
+ *  \a E must have a zu64 member \a hash and a member \a key comparable with \a operator==.
+ *  The table does not construct entries: insert() reserves an entry, and the owner constructs its fields in place,
+ *  or constructs the whole entry with construct() when the table has a user allocator.
+ *  Hashes passed to the table must first be mixed with mixHash().
+ */
+template <typename E> class ZHashTable {
+public:
+    //! Create an empty table. Nothing is allocated until the first insert.
+    ZHashTable(float factor, ZAllocator<E> *alloc = nullptr) :
+            _alloc(alloc), _entries(nullptr), _ctrl(nullptr), _index(nullptr),
+            _slots(0), _capacity(0), _used(0), _size(0), _factor(factor){
+        _checkFactor(factor);
+    }
+
+    //! Copy the entries of \a other. The allocator is shared with \a other.
+    ZHashTable(const ZHashTable &other) :
+            _alloc(other._alloc), _entries(nullptr), _ctrl(nullptr), _index(nullptr),
+            _slots(0), _capacity(0), _used(0), _size(0), _factor(other._factor){
+        _copy(other);
+    }
+
+    //! Take the block and allocator of \a other, leaving it empty.
+    ZHashTable(ZHashTable &&other) :
+            _entries(other._entries), _ctrl(other._ctrl), _index(other._index),
+            _slots(other._slots), _capacity(other._capacity), _used(other._used), _size(other._size), _factor(other._factor){
+        _alloc.swap(other._alloc);
+        other._entries = nullptr;
+        other._ctrl = nullptr;
+        other._index = nullptr;
+        other._slots = 0;
+        other._capacity = 0;
+        other._used = 0;
+        other._size = 0;
+    }
+
+    ~ZHashTable(){
+        clear();
+    }
+
+    //! Replace the entries with copies of the entries of \a other. Keeps this table's allocator.
+    ZHashTable &operator=(const ZHashTable &other){
+        if(this != &other){
+            clear();
+            _factor = other._factor;
+            _copy(other);
+        }
+        return *this;
+    }
+
+    //! Swap contents and allocators with \a other.
+    ZHashTable &operator=(ZHashTable &&other){
+        _alloc.swap(other._alloc);
+        _swap(_entries, other._entries);
+        _swap(_ctrl, other._ctrl);
+        _swap(_index, other._index);
+        _swap(_slots, other._slots);
+        _swap(_capacity, other._capacity);
+        _swap(_used, other._used);
+        _swap(_size, other._size);
+        _swap(_factor, other._factor);
+        return *this;
+    }
+
+    //! Mix a ZHash value into the hash stored in entries, so weak hashes like integers spread over the table.
+    static inline zu64 mixHash(zu64 hash){
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ULL;
+        hash ^= hash >> 33;
+        // Reserved for removed entries
+        return (hash == ZHASHTABLE_REMOVED ? hash - 1 : hash);
+    }
+
+    //! Find the entry with mixed \a hash and a key equal to \a key, null if there is none.
+    template <typename Q> E *find(zu64 hash, const Q &key) const {
+        if(_size == 0)
+            return nullptr;
+        const zu64 mask = _slots - 1;
+        const zbyte h2 = _h2(hash);
+        zu64 pos = _h1(hash) & mask;
+        for(zu64 probe = 1; probe <= _slots / ZHASHTABLE_GROUP; ++probe){
+            ZHashGroup group(_ctrl + pos);
+            zu64 match = group.match(h2);
+            while(match){
+                E *entry = _entries + _index[(pos + ZHashGroup::next(match)) & mask];
+                // Compare hash, then the actual key - may be non-trivial
+                if(entry->hash == hash && entry->key == key)
+                    return entry;
+            }
+            // An empty slot ends the probe sequence
+            if(group.matchEmpty())
+                return nullptr;
+            pos = (pos + probe * ZHASHTABLE_GROUP) & mask;
+        }
+        return nullptr;
+    }
+
+    //! Prefetch the first probe group and slots for mixed \a hash, ahead of a find().
+    void prefetch(zu64 hash) const {
+        if(_slots == 0)
+            return;
+        zu64 pos = _h1(hash) & (_slots - 1);
+        ZHASHTABLE_PREFETCH(_ctrl + pos);
+        ZHASHTABLE_PREFETCH(_index + pos);
+    }
+
+    /*! Reserve a new entry for mixed \a hash and return it, unconstructed.
+     *  The caller must set the entry's hash and construct its other fields.
+     *  Must only be called when find() returns null for the key. Entry pointers are invalidated if the table grows.
+     */
+    E *insert(zu64 hash){
+        if(_used >= _capacity)
+            _grow();
+        zu64 slot = _findFree(hash);
+        _setCtrl(slot, _h2(hash));
+        _index[slot] = (zu32)_used;
+        ++_size;
+        return _entries + _used++;
+    }
+
+    //! Move construct \a value into \a entry from insert() through the user allocator, or in place without one.
+    void construct(E *entry, E &&value){
+        if(_alloc.get()) _alloc->construct(entry, std::move(value));
+        else ZDefaultAllocator<E>::emplace(entry, std::move(value));
+    }
+    //! Destroy \a entry through the user allocator, or in place without one. Does not remove it from the table.
+    void destroy(E *entry){
+        if(_alloc.get()) _alloc->destroy(entry);
+        else ZDefaultAllocator<E>::destroy(entry);
+    }
+
+    //! Get the user allocator, nullptr if using the default allocator.
+    ZAllocator<E> *allocator() const { return _alloc.get(); }
+
+    //! Destroy \a entry and remove it from the table.
+    void erase(E *entry){
+        const zu64 mask = _slots - 1;
+        const zu64 idx = (zu64)(entry - _entries);
+        zu64 pos = _h1(entry->hash) & mask;
+        for(zu64 probe = 1; probe <= _slots / ZHASHTABLE_GROUP; ++probe){
+            zu64 match = ZHashGroup(_ctrl + pos).match(_h2(entry->hash));
+            while(match){
+                zu64 slot = (pos + ZHashGroup::next(match)) & mask;
+                if(_index[slot] == idx){
+                    _setCtrl(slot, ZHASHTABLE_DELETED);
+                    destroy(entry);
+                    entry->hash = ZHASHTABLE_REMOVED;
+                    if(--_size == 0){
+                        // Nothing left, drop the deleted slots
+                        ::memset(_ctrl, ZHASHTABLE_EMPTY, _slots + ZHASHTABLE_GROUP);
+                        _used = 0;
+                    }
+                    return;
+                }
+            }
+            pos = (pos + probe * ZHASHTABLE_GROUP) & mask;
+        }
+        throw ZException("ZHashTable erase: Entry not in table");
+    }
+
+    //! Destroy all entries and free the table.
+    void clear(){
+        for(zu64 i = 0; i < _used; ++i){
+            if(_entries[i].hash != ZHASHTABLE_REMOVED)
+                destroy(_entries + i);
+        }
+        _deallocBlock(_entries);
+        _entries = nullptr;
+        _ctrl = nullptr;
+        _index = nullptr;
+        _slots = 0;
+        _capacity = 0;
+        _used = 0;
+        _size = 0;
+    }
+
+    //! Make room for at least \a count entries without growing. The table is never made smaller.
+    void reserve(zu64 count){
+        if(count > _capacity)
+            _rehash(_slotsFor(count));
+    }
+
+    //! Get the first entry in insertion order, null if the table is empty.
+    E *first() const {
+        return _live(0);
+    }
+    //! Get the entry inserted after \a entry, null if there is none.
+    E *next(const E *entry) const {
+        return _live((zu64)(entry - _entries) + 1);
+    }
+
+    //! Number of entries.
+    zu64 size() const { return _size; }
+    //! Number of slots in the table.
+    zu64 slots() const { return _slots; }
+    //! Number of entries that fit before the table grows.
+    zu64 capacity() const { return _capacity; }
+
+    float factor() const { return _factor; }
+    //! Set the max ratio of entries to slots, in (0, 1]. Takes effect when the table next grows.
+    void setFactor(float factor){
+        _checkFactor(factor);
+        _factor = factor;
+    }
+
+private:
+    static inline zu64 _h1(zu64 hash){ return hash >> 7; }
+    static inline zbyte _h2(zu64 hash){ return (zbyte)(hash & 0x7F); }
+
+    static void _checkFactor(float factor){
+        if(!(factor > 0.0f && factor <= 1.0f))
+            throw ZException("ZHashTable: Invalid load factor");
+    }
+
+    //! Number of entries allowed in \a slots slots. At least one slot is always left empty.
+    zu64 _capacityFor(zu64 slots) const {
+        zu64 capacity = (zu64)((double)slots * _factor);
+        return MAX(MIN(capacity, slots - 1), (zu64)1);
+    }
+    //! Smallest number of slots that holds \a count entries.
+    zu64 _slotsFor(zu64 count) const {
+        zu64 slots = ZHASHTABLE_GROUP;
+        while(_capacityFor(slots) < count)
+            slots <<= 1;
+        return slots;
+    }
+
+    //! Set the control byte of \a slot, and its copy after the table for groups that wrap around.
+    void _setCtrl(zu64 slot, zbyte ctrl){
+        _ctrl[slot] = ctrl;
+        if(slot < ZHASHTABLE_GROUP)
+            _ctrl[_slots + slot] = ctrl;
+    }
+
+    //! Find the first empty or deleted slot for \a hash. There is always an empty slot.
+    zu64 _findFree(zu64 hash) const {
+        const zu64 mask = _slots - 1;
+        zu64 pos = _h1(hash) & mask;
+        for(zu64 probe = 1; ; ++probe){
+            zu64 free = ZHashGroup(_ctrl + pos).matchFree();
+            if(free)
+                return (pos + ZHashGroup::next(free)) & mask;
+            pos = (pos + probe * ZHASHTABLE_GROUP) & mask;
+        }
+    }
+
+    //! Get the first live entry at or after index \a i.
+    E *_live(zu64 i) const {
+        for(; i < _used; ++i){
+            if(_entries[i].hash != ZHASHTABLE_REMOVED)
+                return _entries + i;
+        }
+        return nullptr;
+    }
+
+    //! Make room for one more entry.
+    void _grow(){
+        if(_slots && _size < _capacity / 2){
+            // Mostly removed entries, compact in place
+            _rehash(_slots);
+        } else {
+            _rehash(_slotsFor(MAX(_size + 1, _capacity * 2)));
+        }
+    }
+
+    //! Move the live entries to a new table of \a slots slots, dropping removed entries.
+    void _rehash(zu64 slots){
+        zu64 capacity = _capacityFor(slots);
+        if(capacity > ZU32_MAX)
+            throw ZException("ZHashTable: Too many entries");
+
+        E *oldentries = _entries;
+        zu64 oldused = _used;
+
+        _entries = _allocBlock(slots, capacity);
+        _ctrl = (zbyte *)(_entries + capacity);
+        _index = (zu32 *)(_ctrl + slots + ZHASHTABLE_GROUP);
+        _slots = slots;
+        _capacity = capacity;
+        _used = 0;
+        ::memset(_ctrl, ZHASHTABLE_EMPTY, _slots + ZHASHTABLE_GROUP);
+
+        for(zu64 i = 0; i < oldused; ++i){
+            E *entry = oldentries + i;
+            if(entry->hash == ZHASHTABLE_REMOVED)
+                continue;
+            zu64 slot = _findFree(entry->hash);
+            _setCtrl(slot, _h2(entry->hash));
+            _index[slot] = (zu32)_used;
+            // Relocate entries, raw move if possible
+            if(_alloc.get()) _alloc->move(entry, _entries + _used);
+            else ZDefaultAllocator<E>::move(entry, _entries + _used);
+            ++_used;
+        }
+        _deallocBlock(oldentries);
+    }
+
+    void _copy(const ZHashTable &other){
+        if(other._size == 0)
+            return;
+        reserve(other._size);
+        for(const E *entry = other.first(); entry != nullptr; entry = other.next(entry)){
+            E *copy = insert(entry->hash);
+            if(_alloc.get()) _alloc->copy(entry, copy);
+            else ZDefaultAllocator<E>::copy(entry, copy);
+        }
+    }
+
+    //! Allocate a block for \a capacity entries followed by the control bytes and slots of \a slots slots.
+    E *_allocBlock(zu64 slots, zu64 capacity){
+        zu64 bytes = capacity * sizeof(E) + slots + ZHASHTABLE_GROUP + slots * sizeof(zu32);
+        zu64 count = (bytes + sizeof(E) - 1) / sizeof(E);
+        return (_alloc.get() ? _alloc->alloc(count) : ZDefaultAllocator<E>::alloc(count));
+    }
+    void _deallocBlock(E *ptr){
+        if(ptr == nullptr)
+            return;
+        if(_alloc.get()) _alloc->dealloc(ptr);
+        else ZDefaultAllocator<E>::dealloc(ptr);
+    }
+
+    template <typename V> static void _swap(V &a, V &b){
+        V tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+private:
+    //! User memory allocator, shared with copies. Null uses ZDefaultAllocator.
+    ZPointer<ZAllocator<E>> _alloc;
+
+    //! Entries in insertion order, start of the table block.
+    E *_entries;
+    //! Control byte of each slot, followed by a copy of the first group.
+    zbyte *_ctrl;
+    //! Entry index of each slot.
+    zu32 *_index;
+    //! Number of slots, a power of two.
+    zu64 _slots;
+    //! Number of entries that fit in the block.
+    zu64 _capacity;
+    //! Number of entries used in the block, including removed entries.
+    zu64 _used;
+    //! Number of live entries.
+    zu64 _size;
+    //! Max load factor (capacity / slots ratio).
+    float _factor;
+};
+
+//! ZHashTable only points into its own block.
+template <typename E> struct ZRelocatable<ZHashTable<E>> { enum { value = true }; };
+
+}
+
+#endif // ZHASHTABLE_H
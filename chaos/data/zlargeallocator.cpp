@@ -0,0 +1,151 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                             zlargeallocator.cpp                            **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#include "zlargeallocator.h"
+#include "zallocator.h"
+
+#if LIBCHAOS_PLATFORM == _PLATFORM_WINDOWS || LIBCHAOS_PLATFORM == _PLATFORM_CYGWIN
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace LibChaos {
+
+namespace {
+
+//! Block header, padded so the bytes after a mapped block's header are cache line aligned.
+struct Header {
+    //! Usable bytes after the header.
+    zu64 capacity;
+    //! Length of the mapping, zero for heap blocks.
+    zu64 mapped;
+    zbyte pad[48];
+};
+
+}
+
+static inline Header *headerOf(void *ptr){
+    return (Header *)ptr - 1;
+}
+static inline const Header *headerOf(const void *ptr){
+    return (const Header *)ptr - 1;
+}
+
+//! Round \a size up to a multiple of the page size.
+static inline zu64 roundPages(zu64 size){
+    zu64 page = ZLargeAllocator::pageSize();
+    return (size + page - 1) / page * page;
+}
+
+//! Map \a length bytes, null on failure.
+static void *mapPages(zu64 length){
+#if LIBCHAOS_PLATFORM == _PLATFORM_WINDOWS || LIBCHAOS_PLATFORM == _PLATFORM_CYGWIN
+    return VirtualAlloc(NULL, length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    void *ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(ptr == MAP_FAILED)
+        return nullptr;
+    #ifdef MADV_HUGEPAGE
+    if(length >= ZLARGE_ALLOC_HUGEPAGE)
+        madvise(ptr, length, MADV_HUGEPAGE);
+    #endif
+    return ptr;
+#endif
+}
+
+//! Unmap \a length bytes at \a ptr.
+static void unmapPages(void *ptr, zu64 length){
+#if LIBCHAOS_PLATFORM == _PLATFORM_WINDOWS || LIBCHAOS_PLATFORM == _PLATFORM_CYGWIN
+    (void)length;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, length);
+#endif
+}
+
+void *ZLargeAllocator::alloc(zu64 size){
+    Header *header;
+    if(size + sizeof(Header) >= ZLARGE_ALLOC_THRESHOLD){
+        zu64 length = roundPages(size + sizeof(Header));
+        header = (Header *)mapPages(length);
+        if(header == nullptr)
+            throw zallocator_exception("Failed to alloc()");
+        header->capacity = length - sizeof(Header);
+        header->mapped = length;
+    } else {
+        header = (Header *)::operator new(sizeof(Header) + size, std::nothrow);
+        if(header == nullptr)
+            throw zallocator_exception("Failed to alloc()");
+        header->capacity = size;
+        header->mapped = 0;
+    }
+    return header + 1;
+}
+
+void *ZLargeAllocator::realloc(void *ptr, zu64 size){
+    if(ptr == nullptr)
+        return alloc(size);
+    Header *header = headerOf(ptr);
+    if(size <= header->capacity && (header->mapped || size + sizeof(Header) < ZLARGE_ALLOC_THRESHOLD))
+        return ptr;
+
+#ifdef MREMAP_MAYMOVE
+    if(header->mapped){
+        // Move the page mappings instead of copying
+        zu64 length = roundPages(size + sizeof(Header));
+        void *remapped = mremap(header, header->mapped, length, MREMAP_MAYMOVE);
+        if(remapped == MAP_FAILED)
+            throw zallocator_exception("Failed to realloc()");
+        header = (Header *)remapped;
+    #ifdef MADV_HUGEPAGE
+        if(length >= ZLARGE_ALLOC_HUGEPAGE)
+            madvise(header, length, MADV_HUGEPAGE);
+    #endif
+        header->capacity = length - sizeof(Header);
+        header->mapped = length;
+        return header + 1;
+    }
+#endif
+
+    void *block = alloc(size);
+    ::memcpy(block, ptr, MIN(size, header->capacity));
+    dealloc(ptr);
+    return block;
+}
+
+void ZLargeAllocator::dealloc(void *ptr){
+    if(ptr == nullptr)
+        return;
+    Header *header = headerOf(ptr);
+    if(header->mapped)
+        unmapPages(header, header->mapped);
+    else
+        ::operator delete(header);
+}
+
+zu64 ZLargeAllocator::capacity(const void *ptr){
+    return headerOf(ptr)->capacity;
+}
+
+bool ZLargeAllocator::isMapped(const void *ptr){
+    return headerOf(ptr)->mapped != 0;
+}
+
+zu64 ZLargeAllocator::pageSize(){
+#if LIBCHAOS_PLATFORM == _PLATFORM_WINDOWS || LIBCHAOS_PLATFORM == _PLATFORM_CYGWIN
+    static const zu64 size = [](){
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return (zu64)info.dwPageSize;
+    }();
+#else
+    static const zu64 size = (zu64)sysconf(_SC_PAGESIZE);
+#endif
+    return size;
+}
+
+}
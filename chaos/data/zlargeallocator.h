@@ -0,0 +1,54 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                              zlargeallocator.h                             **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZLARGEALLOCATOR_H
+#define ZLARGEALLOCATOR_H
+
+#include "ztypes.h"
+
+//! Blocks of at least this many bytes are mapped directly from the system.
+#define ZLARGE_ALLOC_THRESHOLD  ((zu64)1 << 22)
+//! Mapped blocks of at least this many bytes are advised to use transparent huge pages.
+#define ZLARGE_ALLOC_HUGEPAGE   ((zu64)1 << 21)
+
+namespace LibChaos {
+
+/*! Allocator for large byte buffers, like image frames and big binaries.
+ *  Blocks of at least ZLARGE_ALLOC_THRESHOLD bytes are mapped from the system with mmap (VirtualAlloc on Windows),
+ *  so they are returned to the system when freed and pages are only committed when touched.
+ *  Mapped blocks are advised to use huge pages where supported, and on Linux realloc() grows them with mremap,
+ *  which moves page mappings instead of copying bytes.
+ *  Smaller blocks use ::operator new. Every block records its own size, so dealloc() and realloc() only need the pointer.
+ *  \note Thread safe. Blocks must only be freed with dealloc().
+ */
+class ZLargeAllocator {
+public:
+    /*! Allocate a block of at least \a size bytes.
+     *  \throws zallocator_exception if the allocation fails.
+     */
+    static void *alloc(zu64 size);
+
+    /*! Resize the block at \a ptr to at least \a size bytes, preserving its contents up to the smaller size.
+     *  May return a different pointer. A null \a ptr allocates a new block.
+     *  \throws zallocator_exception if the allocation fails, \a ptr is still valid.
+     */
+    static void *realloc(void *ptr, zu64 size);
+
+    //! Free the block at \a ptr. Does nothing if \a ptr is null.
+    static void dealloc(void *ptr);
+
+    //! Get the usable size of the block at \a ptr, at least the size requested.
+    static zu64 capacity(const void *ptr);
+
+    //! Check if the block at \a ptr is mapped from the system.
+    static bool isMapped(const void *ptr);
+
+    //! Get the system page size.
+    static zu64 pageSize();
+};
+
+}
+
+#endif // ZLARGEALLOCATOR_H
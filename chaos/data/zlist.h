@@ -28,6 +28,7 @@ template <typename T> class ZList : public YIndexedAccess<T>, public YPushPopAcc
     friend class ZIterator<ZList<T>>;
 public:
     struct Node {
+        template <typename ... Args> Node(Args&& ... args) : prev(nullptr), next(nullptr), data(std::forward<Args>(args)...){}
         Node *prev;
         Node *next;
         T data;
@@ -37,8 +38,8 @@ public:
     class ZListConstIterator;
 
 public:
-    //! ZList default constructor.
-    ZList(ZAllocator<Node> *alloc = new ZAllocator<Node>()) : _alloc(alloc), _size(0), _head(nullptr){}
+    //! ZList default constructor, optional user node allocator (ZList takes ownership).
+    ZList(ZAllocator<Node> *alloc = nullptr) : _alloc(alloc), _size(0), _head(nullptr){}
 
     //! ZList initializer list constructor.
     ZList(std::initializer_list<T> ls) : ZList(){
@@ -64,56 +65,87 @@ public:
         }
     }
 
+    //! ZList move constructor. Takes the nodes and allocator of \a other, leaving it empty.
+    ZList(ZList<T> &&other) : _alloc(nullptr), _size(other._size), _head(other._head){
+        _alloc.swap(other._alloc);
+        other._size = 0;
+        other._head = nullptr;
+    }
+
     ~ZList(){
+        clear();
+    }
+
+    //! Copy assignment.
+    ZList<T> &operator=(const ZList<T> &other){
+        if(this != &other){
+            clear();
+            Node *current = other._head;
+            for(zu64 i = 0; current != nullptr && i < other.size(); ++i){
+                pushBack(current->data);
+                current = current->next;
+            }
+        }
+        return *this;
+    }
+
+    //! Move assignment, swaps contents and allocators with \a other.
+    ZList<T> &operator=(ZList<T> &&other){
+        swap(other);
+        return *this;
+    }
+
+    //! Remove all elements from the list.
+    void clear(){
         if(_head != nullptr){
             _head->prev->next = nullptr; // Break circular link
             Node *current = _head;
             while(current != nullptr){
                 Node* next = current->next;
-                _talloc.destroy(&(current->data));
-                _alloc->dealloc(current);
+                _alloc.destroy(current);
+                _alloc.dealloc(current);
                 current = next;
             }
         }
-        delete _alloc;
+        _head = nullptr;
+        _size = 0;
     }
 
     /*! Insert \a data before \a node.
      *  Will not update head.
      */
     Node *insert(const T &data, Node *node){
-        Node *newnode = newNode(data);
-        newnode->next = node;
-        newnode->prev = node->prev;
-        node->prev->next = newnode;
-        node->prev = newnode;
-        ++_size;
-        return newnode;
+        return _link(newNode(data), node);
     }
 
     //! Add \a data to the front of the list.
     void pushFront(const T &data){
-        if(_head == nullptr){
-            _head = newNode(data);
-            _head->prev = _head;
-            _head->next = _head;
-            ++_size;
-        } else {
-            _head = insert(data, _head);
-        }
+        _linkFront(newNode(data));
+    }
+    //! Move \a data to the front of the list.
+    void pushFront(T &&data){
+        _linkFront(newNode(std::move(data)));
     }
+    //! Construct a new element at the front of the list with \a args.
+    template <typename ... Args> T &emplaceFront(Args&& ... args){
+        return _linkFront(newNode(std::forward<Args>(args)...))->data;
+    }
+
     //! Add \a data to the back of the list.
     void pushBack(const T &data){
-        if(_head == nullptr){
-            _head = newNode(data);
-            _head->prev = _head;
-            _head->next = _head;
-            ++_size;
-        } else {
-            insert(data, _head);
-        }
+        _linkBack(newNode(data));
     }
+    //! Move \a data to the back of the list.
+    void pushBack(T &&data){
+        _linkBack(newNode(std::move(data)));
+    }
+    //! Construct a new element at the back of the list with \a args.
+    template <typename ... Args> T &emplaceBack(Args&& ... args){
+        return _linkBack(newNode(std::forward<Args>(args)...))->data;
+    }
+
     inline void push(const T &data){ pushBack(data); }
+    inline void push(T &&data){ pushBack(std::move(data)); }
 
     //! Add each element in \a list to the back of the list.
     void append(const ZList<T> &list){
@@ -129,8 +161,8 @@ public:
         node->prev->next = node->next;
         node->next->prev = node->prev;
         --_size;
-        _talloc.destroy(&(node->data));
-        _alloc->dealloc(node);
+        _alloc.destroy(node);
+        _alloc.dealloc(node);
     }
 
     //! Remove an element from the front of the list.
@@ -171,8 +203,9 @@ public:
     inline T &peek(){ return peekFront(); }
     inline const T &peek() const { return peekFront(); }
 
-    //! Swap data but not allocators of two lists.
+    //! Swap contents and allocators with \a other.
     void swap(ZList &other){
+        _alloc.swap(other._alloc);
         zu64 tmpsize = _size;
         Node *tmphead = _head;
         _size = other._size;
@@ -240,14 +273,39 @@ public:
     inline zu64 size() const { return _size; }
 
 private:
-    Node *newNode(const T &data){
-       Node *node = _alloc->alloc();
-       node->prev = nullptr;
-       node->next = nullptr;
-       _talloc.construct(&(node->data), data);
+    template <typename ... Args> Node *newNode(Args&& ... args){
+       Node *node = _alloc.alloc();
+       _alloc.emplace(node, std::forward<Args>(args)...);
        return node;
     }
 
+    //! Link \a newnode before \a node.
+    Node *_link(Node *newnode, Node *node){
+        newnode->next = node;
+        newnode->prev = node->prev;
+        node->prev->next = newnode;
+        node->prev = newnode;
+        ++_size;
+        return newnode;
+    }
+    //! Link \a newnode as the new head.
+    Node *_linkFront(Node *newnode){
+        _linkBack(newnode);
+        _head = newnode;
+        return newnode;
+    }
+    //! Link \a newnode before the head.
+    Node *_linkBack(Node *newnode){
+        if(_head == nullptr){
+            newnode->prev = newnode;
+            newnode->next = newnode;
+            _head = newnode;
+            ++_size;
+            return newnode;
+        }
+        return _link(newnode, _head);
+    }
+
     Node *getNode(zu64 index) const {
         Node *current = _head;
         for(zu64 i = 0; i < index; ++i){
@@ -347,15 +405,16 @@ public:
 
 private:
     //! Node memory allocator.
-    ZAllocator<Node> *_alloc;
-    //! Allocator only for constructing T inside nodes.
-    ZAllocator<T> _talloc;
+    ZAllocatorHandle<Node> _alloc;
     //! Number of nodes in list.
     zu64 _size;
     //! Pointer to first node in list.
     Node *_head;
 };
 
+//! ZList nodes do not point back into the list object.
+template <typename T> struct ZRelocatable<ZList<T>> { enum { value = true }; };
+
 }
 
 #endif // ZLIST_H
@@ -0,0 +1,399 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                                 zlrucache.h                                **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZLRUCACHE_H
+#define ZLRUCACHE_H
+
+#include "zmap.h"
+#include "zpoolallocator.h"
+#include "zlock.h"
+#include "zshardarray.h"
+
+#define ZLRUCACHE_DEFAULT_SHARDS    16
+
+namespace LibChaos {
+
+/*! Least recently used cache.
+ *  Entries are nodes on a doubly linked list in order of use, indexed by a ZMap from key to node,
+ *  so a lookup and moving the entry to the front of the list is one hash lookup and a few pointer writes.
+ *  Nodes come from a ZPoolAllocator, so replacing evicted entries does not call the system allocator.
+ *
+ *  The cache is bounded by a number of entries, a total cost, or both. Each entry has a cost given
+ *  when it is added, like its size in bytes. When a bound is exceeded, the least recently used entries
+ *  are evicted and passed to the eviction callback, if there is one.
+ *  \warning Not thread safe, see ZConcurrentLRUCache.
+ */
+template <typename K, typename T> class ZLRUCache {
+public:
+    typedef zu64 maphash;
+    //! Called with each evicted entry, and the user pointer given with the callback.
+    typedef void (*evictFunc)(const K &key, T &value, void *user);
+
+private:
+    struct Node {
+        K key;
+        T value;
+        maphash hash;
+        zu64 cost;
+        //! Next more recently used entry.
+        Node *prev;
+        //! Next less recently used entry.
+        Node *next;
+    };
+
+public:
+    /*! Create a cache of at most \a maxcount entries with a total cost of at most \a maxcost.
+     *  A bound of zero is unbounded.
+     */
+    ZLRUCache(zu64 maxcount = 0, zu64 maxcost = 0) :
+            _maxcount(maxcount), _maxcost(maxcost), _cost(0), _head(nullptr), _tail(nullptr),
+            _evict(nullptr), _user(nullptr), _hits(0), _misses(0), _evictions(0){}
+
+    ~ZLRUCache(){
+        clear();
+    }
+
+    ZLRUCache(const ZLRUCache &) = delete;
+    ZLRUCache &operator=(const ZLRUCache &) = delete;
+
+    /*! Get a pointer to the value of the entry equal to \a key and make it the most recently used, null if there is none.
+     *  \a key may be a \a K or a type that is ZHashEquivalent with \a K. Counts a hit or miss.
+     *  The pointer is valid until the entry is removed or evicted.
+     */
+    template <typename Q> T *get(const Q &key){
+        return get(hashKey(key), key);
+    }
+    //! Get the value of the entry equal to \a key, with \a hash from hashKey().
+    template <typename Q> T *get(maphash hash, const Q &key){
+        Node *const *found = _map.find(hash, key);
+        if(found == nullptr){
+            ++_misses;
+            return nullptr;
+        }
+        ++_hits;
+        _touch(*found);
+        return &((*found)->value);
+    }
+
+    //! Get a pointer to the value of the entry equal to \a key, without changing its use or the counters.
+    template <typename Q> const T *peek(const Q &key) const {
+        Node *const *found = _map.find(key);
+        return (found != nullptr ? &((*found)->value) : nullptr);
+    }
+
+    //! Check if the cache contains an entry equal to \a key, without changing its use or the counters.
+    template <typename Q> bool contains(const Q &key) const {
+        return (peek(key) != nullptr);
+    }
+
+    /*! Add an entry with \a key, \a value and \a cost as the most recently used, replacing any entry with \a key.
+     *  Least recently used entries are evicted until the cache is within its bounds.
+     *  \return A pointer to the value in the cache, or null if \a cost alone is over the max cost.
+     *  An existing entry with \a key is removed in that case.
+     */
+    T *put(const K &key, const T &value, zu64 cost = 1){
+        return put(hashKey(key), key, value, cost);
+    }
+    //! Add an entry with \a key, \a value and \a cost, with \a hash from hashKey().
+    T *put(maphash hash, const K &key, const T &value, zu64 cost = 1){
+        Node **found = _map.find(hash, key);
+        if(_maxcost && cost > _maxcost){
+            if(found != nullptr)
+                _remove(*found);
+            return nullptr;
+        }
+
+        Node *node;
+        if(found != nullptr){
+            node = *found;
+            node->value = value;
+            _cost -= node->cost;
+            _unlink(node);
+        } else {
+            node = _pool.alloc();
+            ZDefaultAllocator<K>::construct(&(node->key), key);
+            ZDefaultAllocator<T>::construct(&(node->value), value);
+            node->hash = hash;
+            _map.add(hash, key, node);
+        }
+        node->cost = cost;
+        _cost += cost;
+        _pushFront(node);
+
+        // The new entry is never least recently used while others are left
+        _shrink();
+        return &(node->value);
+    }
+
+    /*! Remove the entry equal to \a key. The eviction callback is not called.
+     *  \return True if an entry was removed.
+     */
+    template <typename Q> bool remove(const Q &key){
+        return remove(hashKey(key), key);
+    }
+    //! Remove the entry equal to \a key, with \a hash from hashKey().
+    template <typename Q> bool remove(maphash hash, const Q &key){
+        Node **found = _map.find(hash, key);
+        if(found == nullptr)
+            return false;
+        _remove(*found);
+        return true;
+    }
+
+    //! Remove all entries. The eviction callback is not called.
+    void clear(){
+        while(_head != nullptr)
+            _remove(_head);
+    }
+
+    /*! Change the bounds to \a maxcount entries and \a maxcost total cost, zero for unbounded.
+     *  Entries over the new bounds are evicted.
+     */
+    void setCapacity(zu64 maxcount, zu64 maxcost = 0){
+        _maxcount = maxcount;
+        _maxcost = maxcost;
+        _shrink();
+    }
+
+    //! Set the function called with each evicted entry, null for none. \a user is passed to \a func.
+    void setEvictCallback(evictFunc func, void *user = nullptr){
+        _evict = func;
+        _user = user;
+    }
+
+    //! Call \a func with each key and value, from most to least recently used.
+    template <typename F> void forEach(F func) const {
+        for(const Node *node = _head; node != nullptr; node = node->next)
+            func(node->key, node->value);
+    }
+
+    //! Get the hash of \a key, for the functions that take a precomputed hash.
+    template <typename Q> static maphash hashKey(const Q &key){
+        return ZMap<K, Node *>::hashKey(key);
+    }
+
+    //! Number of entries.
+    zu64 size() const { return _map.size(); }
+    bool isEmpty() const { return _map.size() == 0; }
+    //! Total cost of the entries.
+    zu64 cost() const { return _cost; }
+    zu64 maxCount() const { return _maxcount; }
+    zu64 maxCost() const { return _maxcost; }
+
+    //! Number of get() calls that found an entry.
+    zu64 hits() const { return _hits; }
+    //! Number of get() calls that found no entry.
+    zu64 misses() const { return _misses; }
+    //! Number of entries evicted to stay within the bounds.
+    zu64 evictions() const { return _evictions; }
+    //! Reset the hit, miss and eviction counters.
+    void resetStats(){
+        _hits = 0;
+        _misses = 0;
+        _evictions = 0;
+    }
+
+private:
+    void _unlink(Node *node){
+        if(node->prev != nullptr)
+            node->prev->next = node->next;
+        else
+            _head = node->next;
+        if(node->next != nullptr)
+            node->next->prev = node->prev;
+        else
+            _tail = node->prev;
+    }
+    void _pushFront(Node *node){
+        node->prev = nullptr;
+        node->next = _head;
+        if(_head != nullptr)
+            _head->prev = node;
+        else
+            _tail = node;
+        _head = node;
+    }
+    void _touch(Node *node){
+        if(node == _head)
+            return;
+        _unlink(node);
+        _pushFront(node);
+    }
+    //! Evict least recently used entries until the cache is within its bounds.
+    void _shrink(){
+        while(_tail != nullptr && ((_maxcount && _map.size() > _maxcount) || (_maxcost && _cost > _maxcost))){
+            ++_evictions;
+            if(_evict != nullptr)
+                _evict(_tail->key, _tail->value, _user);
+            _remove(_tail);
+        }
+    }
+    //! Unlink \a node, remove it from the map, then destroy and free it.
+    void _remove(Node *node){
+        _unlink(node);
+        _map.erase(node->hash, node->key);
+        _cost -= node->cost;
+        ZDefaultAllocator<K>::destroy(&(node->key));
+        ZDefaultAllocator<T>::destroy(&(node->value));
+        _pool.dealloc(node);
+    }
+
+private:
+    //! Map of keys to nodes.
+    ZMap<K, Node *> _map;
+    //! Node storage.
+    ZPoolAllocator<Node> _pool;
+    zu64 _maxcount;
+    zu64 _maxcost;
+    zu64 _cost;
+    //! Most recently used entry.
+    Node *_head;
+    //! Least recently used entry.
+    Node *_tail;
+    evictFunc _evict;
+    void *_user;
+    zu64 _hits;
+    zu64 _misses;
+    zu64 _evictions;
+};
+
+/*! Thread safe least recently used cache.
+ *  Entries are split between shards by hash like ZConcurrentMap, each shard a ZLRUCache behind its own mutex.
+ *  The bounds are split evenly between the shards, so each shard evicts its own least recently used entries,
+ *  which is close to least recently used over the whole cache when keys spread evenly.
+ *
+ *  Values are copied in and out, since a reference into a shard would outlive its lock.
+ *  The eviction callback is called while the evicting shard is locked, and must not access the cache.
+ */
+template <typename K, typename T> class ZConcurrentLRUCache {
+public:
+    typedef typename ZLRUCache<K, T>::maphash maphash;
+    typedef typename ZLRUCache<K, T>::evictFunc evictFunc;
+
+private:
+    //! Lock and cache of one shard.
+    struct Shard {
+        ZMutex mutex;
+        ZLRUCache<K, T> cache;
+    };
+
+public:
+    /*! Create a cache of at most \a maxcount entries with a total cost of at most \a maxcost, zero for unbounded,
+     *  with \a shards shards, rounded up to a power of two.
+     */
+    ZConcurrentLRUCache(zu64 maxcount, zu64 maxcost = 0, zu64 shards = ZLRUCACHE_DEFAULT_SHARDS) : _shards(shards){
+        setCapacity(maxcount, maxcost);
+    }
+
+    ZConcurrentLRUCache(const ZConcurrentLRUCache &) = delete;
+    ZConcurrentLRUCache &operator=(const ZConcurrentLRUCache &) = delete;
+
+    /*! Copy the value of the entry equal to \a key into \a value and make it the most recently used.
+     *  \return False if there is no such entry, \a value is not changed.
+     */
+    template <typename Q> bool get(const Q &key, T &value){
+        maphash hash = ZLRUCache<K, T>::hashKey(key);
+        Shard &shard = _shard(hash);
+        ZLock lock(shard.mutex);
+        T *found = shard.cache.get(hash, key);
+        if(found == nullptr)
+            return false;
+        value = *found;
+        return true;
+    }
+
+    //! Get a copy of the value of the entry equal to \a key, or \a fallback if there is none.
+    template <typename Q> T get(const Q &key, const T &fallback){
+        T value = fallback;
+        get(key, value);
+        return value;
+    }
+
+    //! Check if the cache contains an entry equal to \a key, without changing its use.
+    template <typename Q> bool contains(const Q &key) const {
+        maphash hash = ZLRUCache<K, T>::hashKey(key);
+        Shard &shard = _shard(hash);
+        ZLock lock(shard.mutex);
+        return shard.cache.contains(key);
+    }
+
+    /*! Add an entry with \a key, \a value and \a cost, replacing any entry with \a key.
+     *  \return False if \a cost alone is over the max cost of a shard, and the entry was not added.
+     */
+    bool put(const K &key, const T &value, zu64 cost = 1){
+        maphash hash = ZLRUCache<K, T>::hashKey(key);
+        Shard &shard = _shard(hash);
+        ZLock lock(shard.mutex);
+        return (shard.cache.put(hash, key, value, cost) != nullptr);
+    }
+
+    //! Remove the entry equal to \a key. \return True if an entry was removed.
+    template <typename Q> bool remove(const Q &key){
+        maphash hash = ZLRUCache<K, T>::hashKey(key);
+        Shard &shard = _shard(hash);
+        ZLock lock(shard.mutex);
+        return shard.cache.remove(hash, key);
+    }
+
+    //! Remove all entries.
+    void clear(){
+        for(zu64 i = 0; i < shardCount(); ++i){
+            ZLock lock(_shards[i].mutex);
+            _shards[i].cache.clear();
+        }
+    }
+
+    /*! Change the bounds to \a maxcount entries and \a maxcost total cost, zero for unbounded.
+     *  Each shard gets an equal part of the bounds, rounded up.
+     */
+    void setCapacity(zu64 maxcount, zu64 maxcost = 0){
+        const zu64 shards = shardCount();
+        for(zu64 i = 0; i < shards; ++i){
+            ZLock lock(_shards[i].mutex);
+            _shards[i].cache.setCapacity((maxcount + shards - 1) / shards, (maxcost + shards - 1) / shards);
+        }
+    }
+
+    //! Set the function called with each evicted entry, null for none.
+    void setEvictCallback(evictFunc func, void *user = nullptr){
+        for(zu64 i = 0; i < shardCount(); ++i){
+            ZLock lock(_shards[i].mutex);
+            _shards[i].cache.setEvictCallback(func, user);
+        }
+    }
+
+    //! Number of entries. Only a hint while other threads modify the cache.
+    zu64 size() const { return _sum(&ZLRUCache<K, T>::size); }
+    //! Total cost of the entries.
+    zu64 cost() const { return _sum(&ZLRUCache<K, T>::cost); }
+    zu64 hits() const { return _sum(&ZLRUCache<K, T>::hits); }
+    zu64 misses() const { return _sum(&ZLRUCache<K, T>::misses); }
+    zu64 evictions() const { return _sum(&ZLRUCache<K, T>::evictions); }
+
+    zu64 shardCount() const { return _shards.size(); }
+
+private:
+    //! Pick a shard with the top bits of \a hash, the shard's map indexes with the low bits.
+    Shard &_shard(maphash hash) const {
+        return _shards.forHash(hash);
+    }
+
+    //! Sum \a func over the shards, locking one shard at a time.
+    zu64 _sum(zu64 (ZLRUCache<K, T>::*func)() const) const {
+        zu64 total = 0;
+        for(zu64 i = 0; i < shardCount(); ++i){
+            ZLock lock(_shards[i].mutex);
+            total += (_shards[i].cache.*func)();
+        }
+        return total;
+    }
+
+private:
+    ZShardArray<Shard> _shards;
+};
+
+}
+
+#endif // ZLRUCACHE_H
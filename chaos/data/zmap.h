@@ -7,6 +7,7 @@
 #define ZMAP_H
 
 #include "zallocator.h"
+#include "zhashtable.h"
 #include "zhashable.h"
 #include "zhash.h"
 #include "zexception.h"
@@ -15,21 +16,29 @@
 
 #include <initializer_list>
 
-#define ZMAP_DEFAULT_LOAD_FACTOR    0.5
+#define ZMAP_DEFAULT_LOAD_FACTOR    0.875
 #define ZMAP_INITIAL_CAPACITY       16
 
-// MapData flags:
-//#define ENTRY_EMPTY     0x00 // empty entry
-#define ZMAP_ENTRY_VALID     0x01 // valid data in entry
-#define ZMAP_ENTRY_DELETED   0x02 // previously deleted entry
-// If ENTRY_VALID is set, ENTRY_DELETED is ignored
-
 namespace LibChaos {
 
+//! ZMap entry.
+template <typename K, typename T> struct ZMapElement {
+    //! Mixed hash of the key, ZHASHTABLE_REMOVED once removed.
+    zu64 hash;
+    K key;
+    T value;
+};
+
+//! ZMap entries are relocatable if the key and value are.
+template <typename K, typename T> struct ZRelocatable<ZMapElement<K, T>> {
+    enum { value = ZRelocatable<K>::value && ZRelocatable<T>::value };
+};
+
 /*! Hash Map container.
- *  Unsequenced.
+ *  Iterates in insertion order.
  *  Keys must be hashable and comparable.
  *  Keys that evaluate equal must have the same hashes, and vice-versa.
+ *  Backed by a ZHashTable, see there for the layout.
  */
 template <typename K, typename T> class ZMap {
 public:
@@ -42,22 +51,18 @@ public:
         T value;
     };
 
-    struct MapElement {
-        zbyte flags;    // Some flags for unset and deleted
-        MapElement *next;
-        MapElement *prev;
-        zu64 hash;
-        K key;
-        T value;
-    };
+    typedef ZMapElement<K, T> MapElement;
+
+    //! Type a \a Q is converted to for lookups, only for types ZHashEquivalent with \a K.
+    template <typename Q> using Lookup = typename ZHashEquivalent<K, typename std::decay<Q>::type>::type;
 
     class ZMapIterator;
 
 public:
-    ZMap(float loadfactor = ZMAP_DEFAULT_LOAD_FACTOR, ZAllocator<MapElement> *alloc = new ZAllocator<MapElement>) :
-            _alloc(alloc), _data(nullptr), _head(nullptr), _tail(nullptr), _size(0), _realsize(0), _factor(loadfactor){
-        resize(ZMAP_INITIAL_CAPACITY);
-    }
+    /*! Create an empty map. No memory is allocated until the first entry is added.
+     *  \a loadfactor is the max ratio of entries to table slots, \a alloc allocates the table.
+     */
+    ZMap(float loadfactor = ZMAP_DEFAULT_LOAD_FACTOR, ZAllocator<MapElement> *alloc = nullptr) : _table(loadfactor, alloc){}
 
     ZMap(std::initializer_list<MapPair> list) : ZMap(){
         resize(list.size());
@@ -66,121 +71,65 @@ public:
         }
     }
 
-    ZMap(const ZMap &other) :
-            _alloc(other._alloc), _data(nullptr), _head(nullptr), _tail(nullptr), _size(0), _realsize(0), _factor(other._factor){
-        if(other._data != nullptr && other._size > 0){
-            resize(other._size);
-            for(auto it = other.begin(); it.more(); ++it){
-                add(*it, other.get(*it));
-            }
-        }
+    //! Copy constructor. Shares the allocator of \a other.
+    ZMap(const ZMap &other) : _table(other._table){}
+
+    //! Move constructor. Takes the table and allocator of \a other, leaving it empty.
+    ZMap(ZMap &&other) : _table(std::move(other._table)){}
+
+    //! Copy assignment. Keeps this map's allocator.
+    ZMap &operator=(const ZMap &other){
+        _table = other._table;
+        return *this;
     }
 
-    ~ZMap(){
-        MapElement *current = _head;
-        while(current != nullptr){
-            _kalloc.destroy(&(current->key));
-            _talloc.destroy(&(current->value));
-            current = current->next;
-        }
-        _alloc->dealloc(_data);
+    //! Move assignment, swaps contents and allocators with \a other.
+    ZMap &operator=(ZMap &&other){
+        _table = std::move(other._table);
+        return *this;
     }
 
     //! Add entry with \a key and \a value to map, or change value of existing entry with \a key.
-    T &add(const K &key, const T &value){
-        // Ensure enough space
-        resize(_size + 1);
-
-        zu64 hash = _getHash(key);
-        for(zu64 i = 0; i < _realsize; ++i){
-            zu64 pos = _getPos(hash, i);
-            // Look for the key
-            if(!(_data[pos].flags & ZMAP_ENTRY_VALID)){
-                // Entry is unset or deleted, insert new entry
-                _data[pos].hash = hash;
-                _kalloc.construct(&(_data[pos].key), key);
-                _talloc.construct(&(_data[pos].value), value);
-                _data[pos].flags |= ZMAP_ENTRY_VALID; // Set valid bit
-                _data[pos].flags &= ~ZMAP_ENTRY_DELETED; // Unset deleted bit
-                _data[pos].prev = _tail;
-                _data[pos].next = nullptr;
-                if(!_head) _head = _data + pos; // Set head if unset
-                if(_tail) _tail->next = _data + pos; // Point prev element to this element
-                _tail = _data + pos; // Update tail
-                ++_size;
-                return _data[pos].value;
-            } else if(_data[pos].hash == hash){
-                // Compare the actual key - may be non-trivial
-                if(_data[pos].key == key){
-                    // Reassign key and value in existing entry
-                    _kalloc.destroy(&(_data[pos].key));
-                    _kalloc.construct(&(_data[pos].key), key);
-                    _talloc.destroy(&(_data[pos].value));
-                    _talloc.construct(&(_data[pos].value), value);
-                    return _data[pos].value;
-                }
-            }
-        }
-        // Should only ever fail if resize failed and the map is full
-        throw ZException(ZString("ZMap add: Unable to add element to map ") + hash);
+    inline T &add(const K &key, const T &value){ return emplace(key, value); }
+    //! Add entry with \a key and moved \a value to map, or change value of existing entry with \a key.
+    inline T &add(const K &key, T &&value){ return emplace(key, std::move(value)); }
+    //! Add entry with \a key and \a value to map, with \a hash from hashKey().
+    inline T &add(maphash hash, const K &key, const T &value){ return _emplace(hash, key, value); }
+    inline T &add(maphash hash, const K &key, T &&value){ return _emplace(hash, key, std::move(value)); }
+
+    /*! Construct the value of the entry with \a key in place with \a args.
+     *  An existing value with \a key is destroyed and replaced, like add().
+     */
+    template <typename ... Args> T &emplace(const K &key, Args&& ... args){
+        return _emplace(_getHash(key), key, std::forward<Args>(args)...);
     }
     inline T &push(const K &key, const T &value){ return add(key, value); }
+    inline T &push(const K &key, T &&value){ return add(key, std::move(value)); }
 
     //! Remove entry with \a key from map, if it exists.
     void remove(const K &key){
-        zu64 hash = _getHash(key);
-        for(zu64 i = 0; i < _realsize; ++i){
-            zu64 pos = _getPos(hash, i);
-            if(_data[pos].flags & ZMAP_ENTRY_VALID){
-                // Valid data, compare hash
-                if(_data[pos].hash == hash){
-                    // Compare the actual key - may be non-trivial
-                    if(_data[pos].key == key){
-                        // Found it, delete it
-                        _kalloc.destroy(&(_data[pos].key));
-                        _talloc.destroy(&(_data[pos].value));
-                        _data[pos].flags &= ~ZMAP_ENTRY_VALID; // Unset valid bit
-                        _data[pos].flags |= ZMAP_ENTRY_DELETED; // Set deleted bit
-                        if(_data[pos].prev)
-                            _data[pos].prev->next = _data[pos].next; // Point prev element to next
-                        if(_data[pos].next)
-                            _data[pos].next->prev = _data[pos].prev; // Point next element to prev
-                        if(_head == _data + pos)
-                            _head = _data[pos].next; // Move head if necessary
-                        if(_tail == _data + pos)
-                            _tail = _data[pos].prev; // Move tail if necessary
-                        --_size;
-                        break;
-                    }
-                }
-            } else if(!(_data[pos].flags & ZMAP_ENTRY_DELETED)){
-                // If this is not a deleted entry, it is the end of the chain
-                break;
-            }
-        }
+        erase(key);
+    }
+
+    /*! Remove the entry equal to \a key from map.
+     *  \a key may be a \a K or a type that is ZHashEquivalent with \a K.
+     *  \return True if an entry was removed.
+     */
+    template <typename Q> bool erase(const Q &key){
+        return _erase(_find(_lookup(key)));
+    }
+    //! Remove the entry equal to \a key, with \a hash from hashKey().
+    template <typename Q> bool erase(maphash hash, const Q &key){
+        return _erase(_table.find(hash, _lookup(key)));
     }
 
     //! Get a reference to the entry with \a key, create entry if it doesn't exitst.
     T &get(const K &key){
-        zu64 hash = _getHash(key);
-        for(zu64 i = 0; i < _realsize; ++i){
-            zu64 pos = _getPos(hash, i);
-            if(_data[pos].flags & ZMAP_ENTRY_VALID){
-                // Look for the key
-                if(_data[pos].hash == hash){
-                    // Compare the actual key - may be non-trivial
-                    if(_data[pos].key == key){
-                        // Found it
-                        return _data[pos].value;
-                    }
-                }
-            } else if(!(_data[pos].flags & ZMAP_ENTRY_DELETED)){
-                // If this is not a deleted entry, it is the end of the chain
-                break;
-            }
-        }
+        MapElement *elem = _find(key);
+        if(elem != nullptr)
+            return elem->value;
         // Create a new, default constructed object
-        return add(key, T());
+        return emplace(key);
     }
     inline T &operator[](const K &key){ return get(key); }
 
@@ -188,137 +137,126 @@ public:
      *  \throws Throws an exception if the entry doesn't exist
      */
     const T &get(const K &key) const {
-        zu64 hash = _getHash(key);
-        for(zu64 i = 0; i < _realsize; ++i){
-            zu64 pos = _getPos(hash, i);
-            if(_data[pos].flags & ZMAP_ENTRY_VALID){
-                // Look for the key
-                if(_data[pos].hash == hash){
-                    // Compare the actual key - may be non-trivial
-                    if(_data[pos].key == key){
-                        // Found it
-                        return _data[pos].value;
-                    }
-                }
-            } else {
-                if(!(_data[pos].flags & ZMAP_ENTRY_DELETED)){
-                    // If this is not a deleted entry, it is the end of the chain
-                    break;
-                }
-            }
-        }
-        throw ZException("ZMap get: Key does not exist", __LINE__);
+        MapElement *elem = _find(key);
+        if(elem == nullptr)
+            throw ZException("ZMap get: Key does not exist", __LINE__);
+        return elem->value;
     }
     inline const T &operator[](const K &key) const { return get(key); }
 
     //! Check if map contains \a key.
     bool contains(const K &key) const {
-        zu64 hash = _getHash(key);
-        for(zu64 i = 0; i < _realsize; ++i){
-            zu64 pos = _getPos(hash, i);
-            if(_data[pos].flags & ZMAP_ENTRY_VALID){
-                // Valid data, compare hash
-                if(_data[pos].hash == hash){
-                    // Compare the actual key - may be non-trivial
-                    if(_data[pos].key == key){
-                        // Found key
-                        return true;
-                    }
-                }
-            } else if(!(_data[pos].flags & ZMAP_ENTRY_DELETED)){
-                // If this is not a deleted entry, it is the end of the chain
-                break;
-            }
-        }
-        // Did not find key
-        return false;
+        return (_find(key) != nullptr);
+    }
+
+    /*! Get a reference to the entry equal to \a key, without constructing a key first.
+     *  A key is only constructed from \a key to create a new entry, and the entry is found or added by that key.
+     *  Enabled for key types that are ZHashEquivalent with \a K, like a ZStringView or C string for ZString keys.
+     */
+    template <typename Q, typename L = Lookup<Q>> T &get(const Q &key){
+        L lookup(key);
+        MapElement *elem = _table.find(_getHash(lookup), lookup);
+        if(elem != nullptr)
+            return elem->value;
+        // The new key may not equal the lookup, like a ZString dropping invalid UTF-8
+        K newkey(lookup);
+        zu64 hash = _getHash(newkey);
+        elem = _table.find(hash, newkey);
+        if(elem != nullptr)
+            return elem->value;
+        return _emplace(hash, newkey);
+    }
+    template <typename Q, typename = Lookup<Q>> inline T &operator[](const Q &key){ return get(key); }
+
+    /*! Get a reference to the entry equal to \a key, without constructing a key.
+     *  \throws Throws an exception if the entry doesn't exist
+     */
+    template <typename Q, typename L = Lookup<Q>> const T &get(const Q &key) const {
+        MapElement *elem = _find(L(key));
+        if(elem == nullptr)
+            throw ZException("ZMap get: Key does not exist", __LINE__);
+        return elem->value;
+    }
+    template <typename Q, typename = Lookup<Q>> inline const T &operator[](const Q &key) const { return get(key); }
+
+    //! Check if map contains a key equal to \a key, without constructing a key.
+    template <typename Q, typename L = Lookup<Q>> bool contains(const Q &key) const {
+        return (_find(L(key)) != nullptr);
+    }
+
+    /*! Get the hash of \a key, for the lookups that take a precomputed hash.
+     *  \a key may be a \a K or a type that is ZHashEquivalent with \a K. Equal keys give the same hash.
+     */
+    template <typename Q> static maphash hashKey(const Q &key){
+        return _getHash(_lookup(key));
+    }
+
+    /*! Get a pointer to the value of the entry equal to \a key, null if there is none.
+     *  \a key may be a \a K or a type that is ZHashEquivalent with \a K.
+     */
+    template <typename Q> T *find(const Q &key){
+        return _value(_find(_lookup(key)));
+    }
+    template <typename Q> const T *find(const Q &key) const {
+        return _value(_find(_lookup(key)));
+    }
+    //! Get a pointer to the value of the entry equal to \a key, with \a hash from hashKey().
+    template <typename Q> T *find(maphash hash, const Q &key){
+        return _value(_table.find(hash, _lookup(key)));
+    }
+    template <typename Q> const T *find(maphash hash, const Q &key) const {
+        return _value(_table.find(hash, _lookup(key)));
+    }
+    //! Check if map contains a key equal to \a key, with \a hash from hashKey().
+    template <typename Q> bool contains(maphash hash, const Q &key) const {
+        return (_table.find(hash, _lookup(key)) != nullptr);
+    }
+
+    /*! Look up every key in \a keys, and get pointers to their values, null for missing keys.
+     *  Keys are hashed and their table slots prefetched in batches, so the memory accesses
+     *  of many lookups overlap. Faster than separate lookups for large maps.
+     */
+    template <typename Q> ZArray<T *> getMany(const ZArray<Q> &keys){
+        ZArray<T *> out;
+        out.reserve(keys.size());
+        _findMany(keys, [&](MapElement *elem){ out.push(_value(elem)); });
+        return out;
+    }
+    template <typename Q> ZArray<const T *> getMany(const ZArray<Q> &keys) const {
+        ZArray<const T *> out;
+        out.reserve(keys.size());
+        _findMany(keys, [&](MapElement *elem){ out.push(_value(elem)); });
+        return out;
+    }
+    //! Check if the map contains each key in \a keys, batched like getMany().
+    template <typename Q> ZArray<bool> containsMany(const ZArray<Q> &keys) const {
+        ZArray<bool> out;
+        out.reserve(keys.size());
+        _findMany(keys, [&](MapElement *elem){ out.push(elem != nullptr); });
+        return out;
     }
 
     zu64 getPosition(const K &key){
         return 0;
     }
 
-    /*! Resize the buffer (this is the only place buffer memory is allocated)
-     *  Buffer is resized to the next power of two that will hold \a size elements
-     *  The buffer is never made smaller
+    /*! Make room for \a size entries without growing.
+     *  The table is resized to the next power of two that will hold \a size entries.
+     *  The table is never made smaller.
      */
     void resize(zu64 size){
-        // Check if resize needed
-        if(size > _realsize || ((float)size / (float)_realsize) >= _factor){
-            zu64 newsize = 1;
-            // Get a new buffer size that can hold <size> entries, staying under the load factor
-            while(newsize < size || ((float)size / (float)newsize) >= _factor)
-                newsize <<= 1;
-
-            MapElement *olddata = _data;
-            // Create new table
-            _realsize = newsize;
-            _data = _alloc->alloc(_realsize);
-
-            // Clear new entries
-            for(zu64 i = 0; i < _realsize; ++i){
-                _data[i].flags = 0; // Clean flags
-            }
-
-            MapElement *current = _head;
-            _head = nullptr;
-            _tail = nullptr;
-            // Re-map old entries
-            while(current != nullptr){
-                // Find first empty slot
-                bool next = false;
-                for(zu64 j = 0; j < _realsize; ++j){
-                    zu64 pos = _getPos(current->hash, j);
-                    if(!(_data[pos].flags & ZMAP_ENTRY_VALID)){
-                        _data[pos].flags |= ZMAP_ENTRY_VALID;
-                        _data[pos].hash = current->hash;
-                        _data[pos].next = nullptr;
-                        _data[pos].prev = _tail;
-                        if(_tail) _tail->next = _data + pos;
-                        if(!_head) _head = _data + pos;
-                        _tail = _data + pos;
-                        // Move elements without copy constructors
-                        _kalloc.rawmove(&(current->key), &(_data[pos].key));
-                        _talloc.rawmove(&(current->value), &(_data[pos].value));
-                        current = current->next;
-                        next = true;
-                        break;
-                    }
-                }
-                if(!next)
-                    throw ZException("ZMap resize: Could not add entry in hash table resize");
-            }
-            // Destroy old table
-            _alloc->dealloc(olddata);
-        }
+        _table.reserve(size);
     }
 
-    // TODO: ZMap erase
-    void erase(K test){
-        throw ZException("ZMap erase: Unimplemented");
-    }
-    
-    //! Clear all entries and delete buffer.
+    //! Clear all entries and delete the table.
     void clear(){
-        MapElement *current = _head;
-        while(current != nullptr){
-            _kalloc.destroy(&(current->key));
-            _talloc.destroy(&(current->value));
-            current = current->next;
-        }
-        _alloc->dealloc(_data);
-        _data = nullptr;
-        _head = nullptr;
-        _tail = nullptr;
-        _size = 0;
-        _realsize = 0;
-        // force resize
-        resize(ZMAP_INITIAL_CAPACITY);
+        _table.clear();
     }
 
     //! Get an array of the keys in the map.
     ZArray<K> keys() const {
         ZArray<K> keys;
+        keys.reserve(size());
         for(auto it = begin(); it.more(); ++it){
             keys.push(*it);
         }
@@ -326,34 +264,83 @@ public:
     }
 
     bool isEmpty() const {
-        return (_data == nullptr) || _size == 0;
+        return _table.size() == 0;
     }
 
-    zu64 size() const { return _size; }
-    zu64 realSize() const { return _realsize; }
+    zu64 size() const { return _table.size(); }
+    //! Number of slots in the table.
+    zu64 realSize() const { return _table.slots(); }
 
-    float factor() const { return _factor; }
+    float factor() const { return _table.factor(); }
+    //! Set the max load factor, in (0, 1]. Takes effect when the table next grows.
     void setFactor(float factor){
-        if(factor > 1.0f)
-            throw ZException("ZMap setFactor: Invalid load factor");
-        _factor = factor;
+        _table.setFactor(factor);
     }
 
     ZMapIterator begin() const {
-        return ZMapIterator(this, _head);
+        return ZMapIterator(this, _table.first());
     }
 
-    // For debugging
-    MapElement &position(zu64 i){
-        return _data[i];
+private:
+    //! Keys are looked up as themselves.
+    static inline const K &_lookup(const K &key){ return key; }
+    //! Equivalent keys are looked up as their lookup type.
+    template <typename Q> static inline Lookup<Q> _lookup(const Q &key){ return Lookup<Q>(key); }
+
+    template <typename Q> static zu64 _getHash(const Q &key){
+        return ZHashTable<MapElement>::mixHash(ZHash<Q>(key).hash());
+    }
+    //! Find the entry with a key equal to \a key, null if there is none.
+    template <typename Q> MapElement *_find(const Q &key) const {
+        return _table.find(_getHash(key), key);
+    }
+    //! Find the entry for each of \a keys in order, calling \a func with each result.
+    template <typename Q, typename F> void _findMany(const ZArray<Q> &keys, F func) const {
+        zu64 hashes[ZHASHTABLE_BATCH];
+        for(zu64 base = 0; base < keys.size(); base += ZHASHTABLE_BATCH){
+            const zu64 count = MIN((zu64)ZHASHTABLE_BATCH, keys.size() - base);
+            // Hash the batch and start loading its slots, then probe
+            for(zu64 i = 0; i < count; ++i){
+                hashes[i] = _getHash(_lookup(keys[base + i]));
+                _table.prefetch(hashes[i]);
+            }
+            for(zu64 i = 0; i < count; ++i)
+                func(_table.find(hashes[i], _lookup(keys[base + i])));
+        }
     }
 
-private:
-    static zu64 _getHash(const K &key){
-        return ZHash<K>(key).hash();
+    template <typename ... Args> T &_emplace(zu64 hash, const K &key, Args&& ... args){
+        MapElement *elem = _table.find(hash, key);
+        if(_table.allocator() != nullptr){
+            // Construct whole entries through the user allocator
+            MapElement entry = { hash, key, T(std::forward<Args>(args)...) };
+            if(elem != nullptr)
+                _table.destroy(elem);
+            else
+                elem = _table.insert(hash);
+            _table.construct(elem, std::move(entry));
+            return elem->value;
+        }
+        if(elem != nullptr){
+            // Replace value in existing entry
+            ZDefaultAllocator<T>::destroy(&(elem->value));
+            ZDefaultAllocator<T>::emplace(&(elem->value), std::forward<Args>(args)...);
+            return elem->value;
+        }
+        elem = _table.insert(hash);
+        elem->hash = hash;
+        ZDefaultAllocator<K>::construct(&(elem->key), key);
+        ZDefaultAllocator<T>::emplace(&(elem->value), std::forward<Args>(args)...);
+        return elem->value;
+    }
+    bool _erase(MapElement *elem){
+        if(elem == nullptr)
+            return false;
+        _table.erase(elem);
+        return true;
     }
-    zu64 _getPos(zu64 hash, zu64 i) const {
-        return ((hash % _realsize) + i) % _realsize;
+    static inline T *_value(MapElement *elem){
+        return (elem != nullptr ? &(elem->value) : nullptr);
     }
 
 public:
@@ -369,7 +356,7 @@ public:
             return (_elem != nullptr);
         }
         void advance(){
-            _elem = _elem->next;
+            _elem = _map->_table.next(_elem);
         }
 
     private:
@@ -378,30 +365,13 @@ public:
     };
 
 private:
-    //! Memory allocator
-    ZPointer<ZAllocator<MapElement>> _alloc;
-    //! Used to construct and destroy keys
-    ZAllocator<K> _kalloc;
-    //! Used to construct and destroy values
-    ZAllocator<T> _talloc;
-
-    //! Actual data buffer.
-    MapElement *_data;
-    //! Pointer to first inserted element.
-    MapElement *_head;
-    //! Pointer to last inserted element.
-    MapElement *_tail;
-    //! Number of entries
-    zu64 _size;
-    //! Size of buffer
-    zu64 _realsize;
-    //! Max load factor (size / realsize ratio)
-    float _factor;
+    //! Hash table of entries.
+    ZHashTable<MapElement> _table;
 };
 
-}
+//! ZMap entries only point into the table block.
+template <typename K, typename T> struct ZRelocatable<ZMap<K, T>> { enum { value = true }; };
 
-//#undef ZMAP_ENTRTY_VALID
-#undef ZMAP_ENTRTY_DELETED
+}
 
 #endif // ZMAP_H
@@ -0,0 +1,99 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                             zmemorystorage.cpp                             **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#include "zmemorystorage.h"
+#include "zexception.h"
+
+#include <string.h>
+
+namespace LibChaos {
+
+ZMemoryStorage::ZMemoryStorage(){
+
+}
+
+ZMemoryStorage::ZMemoryStorage(const zbyte *data, zu64 size){
+    copyToBlock(data, 0, size);
+}
+
+void ZMemoryStorage::copy(const ZStorage *other){
+    if(other == this)
+        return;
+    if(other->storageType() == MEMORY){
+        _data = static_cast<const ZMemoryStorage *>(other)->_data;
+        return;
+    }
+    copyStorage(this, other);
+}
+
+void ZMemoryStorage::copyToBlock(const zbyte *data, zu64 index, zu64 size){
+    if(index + size > _data.size())
+        _data.resize(index + size, 0);
+    if(size)
+        ::memcpy(_data.raw() + index, data, size);
+}
+
+void ZMemoryStorage::copyBlockTo(zu64 index, zu64 size, zbyte *data) const {
+    if(index + size > _data.size())
+        throw ZException("ZMemoryStorage copyBlockTo: Block out of range");
+    if(size)
+        ::memcpy(data, _data.raw() + index, size);
+}
+
+ZStorage *ZMemoryStorage::newCopy() const {
+    return new ZMemoryStorage(_data.raw(), _data.size());
+}
+
+zbyte ZMemoryStorage::get(zu64 index) const {
+    return _data[index];
+}
+
+void ZMemoryStorage::set(zu64 index, zbyte byte){
+    _data[index] = byte;
+}
+
+zbyte *ZMemoryStorage::getBlock(zu64 index, zu64 size){
+    if(index + size > _data.size())
+        throw ZException("ZMemoryStorage getBlock: Block out of range");
+    return _data.raw() + index;
+}
+
+void ZMemoryStorage::freeBlock(zbyte *ptr){
+    // Blocks point into the buffer
+}
+
+void ZMemoryStorage::commitBlock(zbyte *ptr){
+    // Blocks point into the buffer
+}
+
+bool ZMemoryStorage::compare(const ZStorage *other) const {
+    if(other->storageType() == MEMORY){
+        const ZMemoryStorage *mem = static_cast<const ZMemoryStorage *>(other);
+        return _data.size() == mem->_data.size() && (_data.size() == 0 || ::memcmp(_data.raw(), mem->_data.raw(), _data.size()) == 0);
+    }
+    return compareStorage(this, other);
+}
+
+void ZMemoryStorage::resize(zu64 size){
+    _data.resize(size, 0);
+}
+
+void ZMemoryStorage::clear(){
+    _data.clear();
+}
+
+zu64 ZMemoryStorage::size() const {
+    return _data.size();
+}
+
+zu16 ZMemoryStorage::storageType() const {
+    return MEMORY;
+}
+
+const char *ZMemoryStorage::storageTypeStr() const {
+    return "memory";
+}
+
+}
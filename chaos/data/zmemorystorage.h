@@ -0,0 +1,55 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                              zmemorystorage.h                              **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZMEMORYSTORAGE_H
+#define ZMEMORYSTORAGE_H
+
+#include "zstorage.h"
+#include "zarray.h"
+
+namespace LibChaos {
+
+/*! ZStorage in a heap buffer.
+ *  Blocks are pointers straight into the buffer, so freeBlock() and commitBlock() do nothing.
+ */
+class ZMemoryStorage : public ZStorage {
+public:
+    ZMemoryStorage();
+    //! Construct with a copy of \a size bytes at \a data.
+    ZMemoryStorage(const zbyte *data, zu64 size);
+
+    void copy(const ZStorage *other) override;
+    void copyToBlock(const zbyte *data, zu64 index, zu64 size) override;
+    void copyBlockTo(zu64 index, zu64 size, zbyte *data) const override;
+    ZStorage *newCopy() const override;
+
+    zbyte get(zu64 index) const override;
+    void set(zu64 index, zbyte byte) override;
+
+    zbyte *getBlock(zu64 index, zu64 size) override;
+    void freeBlock(zbyte *ptr) override;
+    void commitBlock(zbyte *ptr) override;
+
+    bool compare(const ZStorage *other) const override;
+
+    //! New bytes are zero.
+    void resize(zu64 size) override;
+    void clear() override;
+    zu64 size() const override;
+
+    zu16 storageType() const override;
+    const char *storageTypeStr() const override;
+
+    //! Get the buffer.
+    zbyte *raw(){ return _data.raw(); }
+    const zbyte *raw() const { return _data.raw(); }
+
+private:
+    ZArray<zbyte> _data;
+};
+
+}
+
+#endif // ZMEMORYSTORAGE_H
@@ -7,6 +7,7 @@
 #define ZPOINTER_H
 
 #include "ztypes.h"
+#include "zallocator.h"
 
 namespace LibChaos {
 
@@ -55,6 +56,17 @@ public:
         return *this;
     }
 
+    //! Take shared ownership from \a other without touching the reference count.
+    ZPointer(ZPointer &&other) : _data(other._data){
+        other._data = nullptr;
+    }
+
+    //! Swap shared ownership with \a other, which releases the old pointer on destruction.
+    ZPointer &operator=(ZPointer &&other){
+        swap(other);
+        return *this;
+    }
+
     ~ZPointer(){
         release();
     }
@@ -151,6 +163,9 @@ private:
     PointerData *_data;
 };
 
+//! ZPointer only holds a pointer to the shared data.
+template <typename T> struct ZRelocatable<ZPointer<T>> { enum { value = true }; };
+
 }
 
 #endif // ZPOINTER_H
@@ -0,0 +1,125 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                              zpoolallocator.h                              **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZPOOLALLOCATOR_H
+#define ZPOOLALLOCATOR_H
+
+#include "ztypes.h"
+#include "zallocator.h"
+
+#define ZPOOL_DEFAULT_SLAB_SIZE 64
+
+namespace LibChaos {
+
+/*! Fixed-size object pool allocator for node-based containers like ZList.
+ *  Objects are carved out of slabs of \a slabsize objects, and deallocated objects are kept on
+ *  a free list for reuse, so a container that pushes and pops at a steady rate never calls the system allocator.
+ *  Only single objects can be allocated. Slabs are freed when the pool is destroyed.
+ *  \warning Not thread safe. A pool belongs to the container that owns it,
+ *  and swapping containers swaps their pools.
+ */
+template <typename T> class ZPoolAllocator : public ZAllocator<T> {
+private:
+    union Slot {
+        Slot *next;
+        alignas(T) zbyte data[sizeof(T)];
+    };
+
+public:
+    /*! Create an empty pool.
+     *  If \a maxcount is not zero, at most \a maxcount objects can be allocated at once.
+     */
+    ZPoolAllocator(zu64 slabsize = ZPOOL_DEFAULT_SLAB_SIZE, zu64 maxcount = 0) :
+            _slabsize(slabsize ? slabsize : 1), _maxcount(maxcount), _count(0), _capacity(0),
+            _slabs(nullptr), _free(nullptr), _next(nullptr), _end(nullptr){
+        if(_maxcount && _slabsize > _maxcount)
+            _slabsize = _maxcount;
+    }
+    ZPoolAllocator(const ZPoolAllocator &) = delete;
+
+    ~ZPoolAllocator(){
+        while(_slabs != nullptr){
+            Slot *next = _slabs->next;
+            ::operator delete(_slabs);
+            _slabs = next;
+        }
+    }
+
+    ZPoolAllocator &operator=(const ZPoolAllocator &) = delete;
+
+    T *alloc(zu64 count = 1) override {
+        if(count != 1)
+            throw zallocator_exception("ZPoolAllocator can only alloc() one object");
+        if(_maxcount && _count >= _maxcount)
+            throw zallocator_exception("ZPoolAllocator capacity exceeded");
+
+        Slot *slot;
+        if(_free != nullptr){
+            // Reuse a freed slot
+            slot = _free;
+            _free = slot->next;
+        } else {
+            if(_next == _end)
+                _newSlab();
+            slot = _next++;
+        }
+        ++_count;
+        return (T *)slot->data;
+    }
+
+    void dealloc(T *ptr) override {
+        if(ptr == nullptr)
+            return;
+        Slot *slot = (Slot *)ptr;
+        slot->next = _free;
+        _free = slot;
+        --_count;
+    }
+
+    //! Get the number of allocated objects.
+    zu64 count() const { return _count; }
+    //! Get the number of objects that fit in the allocated slabs.
+    zu64 capacity() const { return _capacity; }
+    //! Get the maximum number of objects, zero if unbounded.
+    zu64 maxCount() const { return _maxcount; }
+
+private:
+    void _newSlab(){
+        zu64 size = _slabsize;
+        if(_maxcount && _capacity + size > _maxcount)
+            size = _maxcount - _capacity;
+        // The first slot of each slab links to the previous slab
+        Slot *slab = (Slot *)::operator new(sizeof(Slot) * (size + 1), std::nothrow);
+        if(slab == nullptr)
+            throw zallocator_exception("Failed to alloc()");
+        slab->next = _slabs;
+        _slabs = slab;
+        _next = slab + 1;
+        _end = _next + size;
+        _capacity += size;
+    }
+
+private:
+    //! Objects per slab.
+    zu64 _slabsize;
+    //! Maximum allocated objects, zero for unbounded.
+    zu64 _maxcount;
+    //! Allocated objects.
+    zu64 _count;
+    //! Total objects in all slabs.
+    zu64 _capacity;
+    //! Chain of slabs.
+    Slot *_slabs;
+    //! Free list of deallocated slots.
+    Slot *_free;
+    //! Next never-used slot in the newest slab.
+    Slot *_next;
+    //! End of the newest slab.
+    Slot *_end;
+};
+
+}
+
+#endif // ZPOOLALLOCATOR_H
@@ -7,20 +7,31 @@
 #define ZQUEUE_H
 
 #include "ztypes.h"
-#include "zlist.h"
+#include "zdeque.h"
 
 #include "ypushpopaccess.h"
 
 namespace LibChaos {
 
-//! FIFO queue ZList wrapper.
-template <typename T> class ZQueue : public YPushPopAccess<T> {
+/*! FIFO queue container wrapper.
+ *  Backed by a ZDeque ring buffer by default, which only allocates when it grows.
+ *  \a C may be any container with pushBack(), front(), popFront() and swap(), like ZList.
+ */
+template <typename T, typename C = ZDeque<T>> class ZQueue : public YPushPopAccess<T> {
 public:
-    ZQueue() : _data(){}
+    typedef C Container;
+
+public:
+    ZQueue(){}
+    //! Construct with a user allocator for the container (ZQueue takes ownership), e.g. a ZPoolAllocator for a ZList.
+    template <typename A> ZQueue(ZAllocator<A> *alloc) : _data(alloc){}
 
     void push(const T &data){
         _data.pushBack(data);
     }
+    void push(T &&data){
+        _data.pushBack(std::move(data));
+    }
 
     T &peek(){
         return _data.front();
@@ -46,7 +57,7 @@ public:
     }
 
 private:
-    ZList<T> _data;
+    C _data;
 };
 
 }
@@ -3,37 +3,48 @@
 
 #include "ztypes.h"
 #include "zhash.h"
-#include "zpointer.h"
+#include "zhashtable.h"
 #include "ziterator.h"
 
-#define ZSET_DEFAULT_LOAD_FACTOR  0.5
+#define ZSET_DEFAULT_LOAD_FACTOR  0.875
 #define ZSET_INITIAL_CAPACITY     16
-#define ZSET_ENTRY_VALID          0x01 // valid data in entry
-#define ZSET_ENTRY_DELETED        0x02 // previously deleted entry
 
 namespace LibChaos {
 
+//! ZSet entry.
+template <typename T> struct ZSetElement {
+    //! Mixed hash of the value, ZHASHTABLE_REMOVED once removed.
+    zu64 hash;
+    //! The value.
+    T key;
+};
+
+//! ZSet entries are relocatable if the value is.
+template <typename T> struct ZRelocatable<ZSetElement<T>> { enum { value = ZRelocatable<T>::value }; };
+
+/*! Hash Set container.
+ *  Iterates in insertion order.
+ *  Values must be hashable and comparable.
+ *  Backed by a ZHashTable, see there for the layout.
+ */
 template <typename T> class ZSet {
 public:
     enum { NONE = ZU64_MAX };
 
-    struct SetElement {
-        zbyte flags; // Some flags for unset and deleted
-        SetElement *next;
-        SetElement *prev;
-        zu64 hash;
-        T value;
-    };
+    typedef ZSetElement<T> SetElement;
+
+    //! Type a \a Q is converted to for lookups, only for types ZHashEquivalent with \a T.
+    template <typename Q> using Lookup = typename ZHashEquivalent<T, typename std::decay<Q>::type>::type;
 
     typedef zu64 maphash;
 
     class ZSetIterator;
 
 public:
-    ZSet(float loadfactor = ZSET_DEFAULT_LOAD_FACTOR, ZAllocator<SetElement> *alloc = new ZAllocator<SetElement>) :
-            _alloc(alloc), _data(nullptr), _head(nullptr), _tail(nullptr), _size(0), _realsize(0), _factor(loadfactor){
-        resize(ZSET_INITIAL_CAPACITY);
-    }
+    /*! Create an empty set. No memory is allocated until the first value is added.
+     *  \a loadfactor is the max ratio of values to table slots, \a alloc allocates the table.
+     */
+    ZSet(float loadfactor = ZSET_DEFAULT_LOAD_FACTOR, ZAllocator<SetElement> *alloc = nullptr) : _table(loadfactor, alloc){}
 
     ZSet(std::initializer_list<T> list) : ZSet(){
         resize(list.size());
@@ -42,189 +53,129 @@ public:
         }
     }
 
-    ZSet(const ZSet &other) :
-            _alloc(other._alloc), _data(nullptr), _head(nullptr), _tail(nullptr), _size(0), _realsize(0), _factor(other._factor){
-        if(other._data != nullptr && other._size > 0){
-            resize(other._size);
-            for(auto it = other.begin(); it.more(); ++it){
-                add(*it);
-            }
-        }
+    //! Copy constructor. Shares the allocator of \a other.
+    ZSet(const ZSet &other) : _table(other._table){}
+
+    //! Move constructor. Takes the table and allocator of \a other, leaving it empty.
+    ZSet(ZSet &&other) : _table(std::move(other._table)){}
+
+    //! Copy assignment. Keeps this set's allocator.
+    ZSet &operator=(const ZSet &other){
+        _table = other._table;
+        return *this;
     }
 
-    ~ZSet(){
-        SetElement *current = _head;
-        while(current != nullptr){
-            _talloc.destroy(&current->value);
-            current = current->next;
-        }
-        _alloc->dealloc(_data);
+    //! Move assignment, swaps contents and allocators with \a other.
+    ZSet &operator=(ZSet &&other){
+        _table = std::move(other._table);
+        return *this;
+    }
+
+    //! Remove all values from the set.
+    void clear(){
+        _table.clear();
     }
 
     //! Add \a value to set. Does nothing if set contains \a value.
     void add(const T &value){
-        // Ensure enough space
-        resize(_size + 1);
-
-        zu64 hash = _getHash(value);
-        for(zu64 i = 0; i < _realsize; ++i){
-            zu64 pos = _getPos(hash, i);
-            if(!(_data[pos].flags & ZSET_ENTRY_VALID)){
-                // Entry is unset or deleted, insert new entry
-                _data[pos].hash = hash;
-                _talloc.construct(&_data[pos].value, value);
-                _data[pos].flags |= ZSET_ENTRY_VALID; // Set valid bit
-                _data[pos].flags &= ~ZSET_ENTRY_DELETED; // Unset deleted bit
-                _data[pos].prev = _tail;
-                _data[pos].next = nullptr;
-                if(!_head) _head = _data + pos; // Set head if unset
-                if(_tail) _tail->next = _data + pos; // Point prev element to this element
-                _tail = _data + pos; // Update tail
-                ++_size;
-                return;
-            } else if(_data[pos].hash == hash){
-                // Compare the actual value - may be non-trivial
-                if(_data[pos].value == value){
-                    // Value already in set
-                    return;
-                }
-            }
+        add(_getHash(value), value);
+    }
+    //! Add \a value to set, with \a hash from hashKey().
+    void add(maphash hash, const T &value){
+        if(_table.find(hash, value) != nullptr)
+            return;
+        SetElement *elem = _table.insert(hash);
+        if(_table.allocator() != nullptr){
+            _table.construct(elem, SetElement{ hash, value });
+            return;
         }
-        // Should only ever fail if resize failed and the set is full
-        throw ZException(ZString("ZSet: Unable to add value to set: ") + hash);
+        elem->hash = hash;
+        ZDefaultAllocator<T>::construct(&elem->key, value);
     }
-    inline T &push(const T &value){ return add(value); }
+    inline void push(const T &value){ add(value); }
 
     //! Remove \a value from set. Does nothing if set does not contain \a value.
     void remove(const T &value){
-        zu64 hash = _getHash(value);
-        for(zu64 i = 0; i < _realsize; ++i){
-            zu64 pos = _getPos(hash, i);
-            if(_data[pos].flags & ZSET_ENTRY_VALID){
-                // Valid data, compare hash
-                if(_data[pos].hash == hash){
-                    // Compare the actual value - may be non-trivial
-                    if(_data[pos].value == value){
-                        // Found value, delete element
-                        _talloc.destroy(&_data[pos].value);
-                        _data[pos].flags &= ~ZSET_ENTRY_VALID; // Unset valid bit
-                        _data[pos].flags |= ZSET_ENTRY_DELETED; // Set deleted bit
-                        if(_data[pos].prev) _data[pos].prev->next = _data[pos].next; // Point prev element to next
-                        if(_data[pos].next) _data[pos].next->prev = _data[pos].prev; // Point next element to prev
-                        if(_head == _data + pos) _head = _data[pos].next; // Move head if necessary
-                        if(_tail == _data + pos) _tail = _data[pos].prev; // Move tail if necessary
-                        --_size;
-                        break;
-                    }
-                }
-            } else if(!(_data[pos].flags & ZSET_ENTRY_DELETED)){
-                // If this is not a deleted entry, it is the end of the chain
-                break;
-            }
-        }
+        SetElement *elem = _table.find(_getHash(value), value);
+        if(elem != nullptr)
+            _table.erase(elem);
     }
 
     //! Check if set contains \a value.
     bool contains(const T &value) const {
-        zu64 hash = _getHash(value);
-        for(zu64 i = 0; i < _realsize; ++i){
-            zu64 pos = _getPos(hash, i);
-            if(_data[pos].flags & ZSET_ENTRY_VALID){
-                // Valid data, compare hash
-                if(_data[pos].hash == hash){
-                    // Compare the actual value - may be non-trivial
-                    if(_data[pos].value == value){
-                        // Found value
-                        return true;
-                    }
-                }
-            } else if(!(_data[pos].flags & ZSET_ENTRY_DELETED)){
-                // If this is not a deleted entry, it is the end of the chain
-                break;
-            }
-        }
-        // Did not find value
-        return false;
+        return (_table.find(_getHash(value), value) != nullptr);
+    }
+    //! Check if set contains a value equal to \a value, without constructing a \a T.
+    template <typename Q, typename L = Lookup<Q>> bool contains(const Q &value) const {
+        L lookup(value);
+        return (_table.find(_getHash(lookup), lookup) != nullptr);
+    }
+    //! Check if set contains a value equal to \a value, with \a hash from hashKey().
+    template <typename Q> bool contains(maphash hash, const Q &value) const {
+        return (_table.find(hash, _lookup(value)) != nullptr);
     }
 
-    /*! Resize the buffer (this is the only place buffer memory is allocated)
-     *  Buffer is resized to the next power of two that will hold \a size elements
-     *  The buffer is never made smaller
+    /*! Get the hash of \a value, for the lookups that take a precomputed hash.
+     *  \a value may be a \a T or a type that is ZHashEquivalent with \a T.
      */
-    void resize(zu64 size){
-        if(size > _realsize || ((float)size / (float)_realsize) >= _factor){
-            zu64 newsize = 1;
-            // Get a new buffer size that can hold <size> entries, staying under the load factor
-            while(newsize < size || ((float)size / (float)newsize) >= _factor)
-                newsize <<= 1;
-
-            SetElement *olddata = _data;
-            zu64 oldsize = _realsize;
-
-            _realsize = newsize;
-            _data = _alloc->alloc(_realsize);
-
-            // Clear new entries
-            for(zu64 i = 0; i < _realsize; ++i){
-                _data[i].flags = 0; // Clean flags
-                //_data[i].next = nullptr;
-            }
+    template <typename Q> static maphash hashKey(const Q &value){
+        return _getHash(_lookup(value));
+    }
 
-            if(olddata != nullptr){
-                //MapData *last = nullptr;
-                // Re-map old entries
-                for(zu64 i = 0; i < oldsize; ++i){
-                    // Map only non-empty entries
-                    if(olddata[i].flags & ZSET_ENTRY_VALID){
-                        for(zu64 j = 0; j < _realsize; ++j){
-                            zu64 pos = _getPos(olddata[i].hash, j);
-                            // Find first empty entry
-                            if(!(_data[pos].flags & ZSET_ENTRY_VALID)){
-                                _data[pos].hash = olddata[i].hash;
-                                // Move elements without copy constructors
-                                _talloc.rawmove(&olddata[i].value, &_data[pos].value);
-                                _data[pos].flags |= ZSET_ENTRY_VALID;
-                                break;
-                            }
-                        }
-                        //throw ZException("Fatal Error in addHashEntry");
-                    }
-                }
-                _alloc->dealloc(olddata);
-//                olddata = nullptr;
+    /*! Check if the set contains each value in \a values.
+     *  Values are hashed and their table slots prefetched in batches, so the memory accesses
+     *  of many lookups overlap.
+     */
+    template <typename Q> ZArray<bool> containsMany(const ZArray<Q> &values) const {
+        ZArray<bool> out;
+        out.reserve(values.size());
+        zu64 hashes[ZHASHTABLE_BATCH];
+        for(zu64 base = 0; base < values.size(); base += ZHASHTABLE_BATCH){
+            const zu64 count = MIN((zu64)ZHASHTABLE_BATCH, values.size() - base);
+            for(zu64 i = 0; i < count; ++i){
+                hashes[i] = _getHash(_lookup(values[base + i]));
+                _table.prefetch(hashes[i]);
             }
+            for(zu64 i = 0; i < count; ++i)
+                out.push(_table.find(hashes[i], _lookup(values[base + i])) != nullptr);
         }
+        return out;
+    }
+
+    /*! Make room for \a size values without growing.
+     *  The table is resized to the next power of two that will hold \a size values.
+     *  The table is never made smaller.
+     */
+    void resize(zu64 size){
+        _table.reserve(size);
     }
 
     bool isEmpty() const {
-        return (_data == nullptr) || _size == 0;
+        return _table.size() == 0;
     }
 
-    zu64 size() const { return _size; }
-    zu64 realSize() const { return _realsize; }
+    zu64 size() const { return _table.size(); }
+    //! Number of slots in the table.
+    zu64 realSize() const { return _table.slots(); }
 
-    float factor() const { return _factor; }
+    float factor() const { return _table.factor(); }
+    //! Set the max load factor, in (0, 1]. Takes effect when the table next grows.
     void setFactor(float factor){
-        if(factor > 1.0f)
-            throw ZException("Invalid ZSet load factor");
-        _factor = factor;
+        _table.setFactor(factor);
     }
 
     ZSetIterator begin() const {
-        return ZSetIterator(this, _head);
-    }
-
-    // For debugging
-    SetElement &position(zu64 i){
-        return _data[i];
+        return ZSetIterator(this, _table.first());
     }
 
 private:
-    static zu64 _getHash(const T &key){
-        return ZHash<T>(key).hash();
-    }
-    zu64 _getPos(zu64 hash, zu64 i) const {
-        return ((hash % _realsize) + i) % _realsize;
+    //! Values are looked up as themselves.
+    static inline const T &_lookup(const T &value){ return value; }
+    //! Equivalent values are looked up as their lookup type.
+    template <typename Q> static inline Lookup<Q> _lookup(const Q &value){ return Lookup<Q>(value); }
+
+    template <typename Q> static zu64 _getHash(const Q &value){
+        return ZHashTable<SetElement>::mixHash(ZHash<Q>(value).hash());
     }
 
 public:
@@ -233,14 +184,14 @@ public:
         ZSetIterator(const ZSet<T> *set, SetElement *start_elem) : _set(set), _elem(start_elem){}
 
         const T &get() const {
-            return _elem->value;
+            return _elem->key;
         }
 
         bool more() const {
             return (_elem != nullptr);
         }
         void advance(){
-            _elem = _elem->next;
+            _elem = _set->_table.next(_elem);
         }
 
     private:
@@ -249,25 +200,13 @@ public:
     };
 
 private:
-    //! Memory allocator.
-    ZPointer<ZAllocator<SetElement>> _alloc;
-    //! Allocator only for constructing T inside nodes.
-    ZAllocator<T> _talloc;
-
-    //! Actual data buffer.
-    SetElement *_data;
-    //! Pointer to first inserted element.
-    SetElement *_head;
-    //! Pointer to last inserted element.
-    SetElement *_tail;
-    //! Number of entries.
-    zu64 _size;
-    //! Size of buffer.
-    zu64 _realsize;
-    //! Max load factor (size / realsize ratio).
-    float _factor;
+    //! Hash table of values.
+    ZHashTable<SetElement> _table;
 };
 
+//! ZSet entries only point into the table block.
+template <typename T> struct ZRelocatable<ZSet<T>> { enum { value = true }; };
+
 }
 
 #endif // ZSET_H
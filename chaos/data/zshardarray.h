@@ -0,0 +1,73 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                                zshardarray.h                               **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZSHARDARRAY_H
+#define ZSHARDARRAY_H
+
+#include "ztypes.h"
+
+#include <new>
+
+//! Size of a cache line, shards never share one.
+#define ZSHARDARRAY_LINE_SIZE 64
+
+namespace LibChaos {
+
+/*! Fixed array of shards for the lock-striped containers, each shard starting on its own cache line.
+ *  Shards are placed in one block at a stride rounded up to the cache line size,
+ *  aligned by hand instead of with alignas, since operator new[] only honors extended alignment from C++17.
+ *  The shard count is a power of two, so a shard can be picked with the top bits of a hash.
+ */
+template <typename T> class ZShardArray {
+public:
+    static_assert(alignof(T) <= ZSHARDARRAY_LINE_SIZE, "ZShardArray: Shard alignment is larger than a cache line");
+
+    //! Default construct \a count shards, rounded up to a power of two, at most 65536.
+    ZShardArray(zu64 count) : _block(nullptr), _data(nullptr), _bits(0){
+        while(((zu64)1 << _bits) < count && _bits < 16)
+            ++_bits;
+        _block = (zbyte *)::operator new(size() * STRIDE + ZSHARDARRAY_LINE_SIZE - 1);
+        _data = _block + ((ZSHARDARRAY_LINE_SIZE - (zu64)_block % ZSHARDARRAY_LINE_SIZE) % ZSHARDARRAY_LINE_SIZE);
+        for(zu64 i = 0; i < size(); ++i)
+            new (_data + i * STRIDE) T();
+    }
+
+    ~ZShardArray(){
+        for(zu64 i = 0; i < size(); ++i)
+            (*this)[i].~T();
+        ::operator delete(_block);
+    }
+
+    ZShardArray(const ZShardArray &) = delete;
+    ZShardArray &operator=(const ZShardArray &) = delete;
+
+    //! Get shard \a i. Shards are shared state, so a const array still gives mutable shards.
+    T &operator[](zu64 i) const {
+        return *(T *)(_data + i * STRIDE);
+    }
+
+    //! Pick a shard with the top bits of \a hash, leaving the low bits for indexing within the shard.
+    T &forHash(zu64 hash) const {
+        return (*this)[_bits ? hash >> (64 - _bits) : 0];
+    }
+
+    //! Number of shards.
+    zu64 size() const { return (zu64)1 << _bits; }
+
+private:
+    //! Distance between shards, a whole number of cache lines.
+    enum : zu64 { STRIDE = (sizeof(T) + ZSHARDARRAY_LINE_SIZE - 1) / ZSHARDARRAY_LINE_SIZE * ZSHARDARRAY_LINE_SIZE };
+
+    //! Block from operator new.
+    zbyte *_block;
+    //! First cache line boundary in the block.
+    zbyte *_data;
+    //! Log2 of the number of shards.
+    zu64 _bits;
+};
+
+}
+
+#endif // ZSHARDARRAY_H
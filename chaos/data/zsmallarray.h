@@ -0,0 +1,79 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                                zsmallarray.h                               **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZSMALLARRAY_H
+#define ZSMALLARRAY_H
+
+#include "ztypes.h"
+#include "zarray.h"
+
+namespace LibChaos {
+
+/*! ZArray that stores up to \a N elements inline, without allocating.
+ *  Spills to a heap buffer when it grows past \a N elements, and returns to the inline buffer on clear().
+ *  Usable anywhere a ZArray is, including through a ZArray reference.
+ */
+template <typename T, zu64 N> class ZSmallArray : public ZArray<T> {
+public:
+    //! Default constructor with optional user allocator, only used after spilling to the heap.
+    ZSmallArray(ZAllocator<T> *alloc = nullptr) : ZArray<T>(reinterpret_cast<T *>(_buffer), N, alloc){}
+
+    //! Initializer list constructor.
+    ZSmallArray(std::initializer_list<T> ls) : ZSmallArray(){
+        this->reserve(ls.size());
+        for(auto item = ls.begin(); item < ls.end(); ++item)
+            this->pushBack(*item);
+    }
+
+    //! Copy constructor.
+    ZSmallArray(const ZSmallArray &other) : ZSmallArray(){
+        this->assign(other);
+    }
+    //! Copy from any ZArray.
+    ZSmallArray(const ZArray<T> &other) : ZSmallArray(){
+        this->assign(other);
+    }
+
+    //! Move constructor. Elements are moved if \a other is inline.
+    ZSmallArray(ZSmallArray &&other) : ZSmallArray(){
+        ZArray<T>::operator=(std::move(other));
+    }
+    //! Move from any ZArray.
+    ZSmallArray(ZArray<T> &&other) : ZSmallArray(){
+        ZArray<T>::operator=(std::move(other));
+    }
+
+    ~ZSmallArray(){
+        // Destroy elements while the inline buffer is alive
+        this->clear();
+    }
+
+    ZSmallArray &operator=(const ZSmallArray &other){
+        this->assign(other);
+        return *this;
+    }
+    ZSmallArray &operator=(const ZArray<T> &other){
+        this->assign(other);
+        return *this;
+    }
+    ZSmallArray &operator=(ZSmallArray &&other){
+        ZArray<T>::operator=(std::move(other));
+        return *this;
+    }
+    ZSmallArray &operator=(ZArray<T> &&other){
+        ZArray<T>::operator=(std::move(other));
+        return *this;
+    }
+
+    //! Get the number of inline elements.
+    static constexpr zu64 inlineSize(){ return N; }
+
+private:
+    alignas(T) zbyte _buffer[sizeof(T) * N];
+};
+
+}
+
+#endif // ZSMALLARRAY_H
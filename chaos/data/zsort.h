@@ -0,0 +1,477 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                                  zsort.h                                   **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZSORT_H
+#define ZSORT_H
+
+#include "ztypes.h"
+#include "zallocator.h"
+
+#include <string.h>
+#include <type_traits>
+#include <utility>
+
+//! Ranges of at most this many elements are insertion sorted.
+#define ZSORT_INSERTION     16
+//! Length of the insertion sorted runs merged by stableSort().
+#define ZSORT_RUN           32
+//! radixSort() of byte strings switches to a comparison sort below this many elements.
+#define ZSORT_RADIX_MIN     64
+
+namespace LibChaos {
+
+//! Default ordering for sorting and searching, uses \a operator<.
+template <typename T> struct ZLess {
+    inline bool operator()(const T &a, const T &b) const { return a < b; }
+};
+
+/*! Unsigned integer key with the same ordering as an arithmetic \a T, for radix sorting.
+ *  Signed integers have their sign bit flipped, negative floats have every bit flipped.
+ */
+template <typename T> struct ZRadixKey {
+    static_assert(std::is_arithmetic<T>::value && sizeof(T) <= 8, "ZRadixKey needs an integer or floating point type of at most 8 bytes");
+
+    typedef typename std::conditional<sizeof(T) <= 1, zu8,
+            typename std::conditional<sizeof(T) <= 2, zu16,
+            typename std::conditional<sizeof(T) <= 4, zu32, zu64>::type>::type>::type type;
+
+    static inline type key(T value){
+        return _key(value, std::integral_constant<int, std::is_floating_point<T>::value ? 2 : (std::is_signed<T>::value ? 1 : 0)>());
+    }
+
+private:
+    static const type SIGN = (type)((type)1 << (sizeof(type) * 8 - 1));
+
+    static inline type _key(T value, std::integral_constant<int, 0>){
+        return (type)value;
+    }
+    static inline type _key(T value, std::integral_constant<int, 1>){
+        return (type)value ^ SIGN;
+    }
+    static inline type _key(T value, std::integral_constant<int, 2>){
+        type bits;
+        ::memcpy(&bits, &value, sizeof(T));
+        return (bits & SIGN) ? (type)~bits : (type)(bits | SIGN);
+    }
+};
+
+/*! Sorting and searching algorithms on contiguous ranges.
+ *  Every algorithm takes a pointer and a count, and an optional \a less function object
+ *  defining a strict weak ordering. ZArray has members wrapping each of these.
+ *  Elements are moved, never copied, so move-only element types work.
+ */
+class ZSort {
+public:
+    enum { NONE = ZU64_MAX };
+
+    /*! Sort \a size elements at \a data in place. Not stable.
+     *  Introsort: quicksort with median of three pivots, heapsort if the recursion gets too deep,
+     *  and insertion sort for short ranges. O(n log n) worst case.
+     */
+    template <typename T, typename L = ZLess<T>> static void sort(T *data, zu64 size, L less = L()){
+        zu64 depth = 0;
+        for(zu64 n = size; n > 1; n >>= 1)
+            depth += 2;
+        _introsort(data, size, depth, less);
+    }
+
+    /*! Sort \a size elements at \a data, keeping the order of equal elements.
+     *  Bottom-up merge sort of insertion sorted runs, allocates a buffer of \a size elements.
+     */
+    template <typename T, typename L = ZLess<T>> static void stableSort(T *data, zu64 size, L less = L()){
+        for(zu64 i = 0; i < size; i += ZSORT_RUN)
+            insertionSort(data + i, MIN((zu64)ZSORT_RUN, size - i), less);
+        if(size <= ZSORT_RUN)
+            return;
+        // The first range of the last merge may be most of the array
+        T *buffer = ZDefaultAllocator<T>::alloc(size);
+        for(zu64 width = ZSORT_RUN; width < size; width *= 2){
+            for(zu64 i = 0; i + width < size; i += width * 2)
+                _merge(data + i, width, MIN(width * 2, size - i), buffer, less);
+        }
+        ZDefaultAllocator<T>::dealloc(buffer);
+    }
+
+    /*! Merge the sorted ranges [0, \a mid) and [\a mid, \a size) at \a data. Stable.
+     *  Allocates a buffer for the first range.
+     */
+    template <typename T, typename L = ZLess<T>> static void merge(T *data, zu64 mid, zu64 size, L less = L()){
+        if(mid == 0 || mid >= size)
+            return;
+        T *buffer = ZDefaultAllocator<T>::alloc(mid);
+        _merge(data, mid, size, buffer, less);
+        ZDefaultAllocator<T>::dealloc(buffer);
+    }
+
+    //! Sort \a size elements at \a data by insertion. Stable, fast for short or nearly sorted ranges.
+    template <typename T, typename L = ZLess<T>> static void insertionSort(T *data, zu64 size, L less = L()){
+        for(zu64 i = 1; i < size; ++i){
+            if(less(data[i], data[i - 1])){
+                T tmp = std::move(data[i]);
+                zu64 j = i;
+                do {
+                    data[j] = std::move(data[j - 1]);
+                    --j;
+                } while(j > 0 && less(tmp, data[j - 1]));
+                data[j] = std::move(tmp);
+            }
+        }
+    }
+
+    //! Sort \a size elements at \a data with heapsort. Not stable, O(n log n) worst case, no allocation.
+    template <typename T, typename L = ZLess<T>> static void heapSort(T *data, zu64 size, L less = L()){
+        _makeHeap(data, size, less);
+        _sortHeap(data, size, less);
+    }
+
+    /*! Move the \a count smallest of \a size elements at \a data to the front, in order.
+     *  The order of the other elements is unspecified.
+     */
+    template <typename T, typename L = ZLess<T>> static void partialSort(T *data, zu64 size, zu64 count, L less = L()){
+        count = MIN(count, size);
+        if(count == 0)
+            return;
+        _makeHeap(data, count, less);
+        for(zu64 i = count; i < size; ++i){
+            if(less(data[i], data[0])){
+                std::swap(data[i], data[0]);
+                _siftDown(data, 0, count, less);
+            }
+        }
+        _sortHeap(data, count, less);
+    }
+
+    /*! Reorder \a size elements at \a data so element \a nth is the one that would be there if sorted,
+     *  no element before it is greater and no element after it is less.
+     *  Quickselect, falls back to partialSort() if partitioning goes badly.
+     */
+    template <typename T, typename L = ZLess<T>> static void nthElement(T *data, zu64 size, zu64 nth, L less = L()){
+        if(nth >= size)
+            return;
+        zu64 depth = 0;
+        for(zu64 n = size; n > 1; n >>= 1)
+            depth += 2;
+        while(size > ZSORT_INSERTION){
+            if(depth == 0){
+                partialSort(data, size, nth + 1, less);
+                return;
+            }
+            --depth;
+            zu64 cut = _partition(data, size, less);
+            if(cut <= nth){
+                data += cut;
+                size -= cut;
+                nth -= cut;
+            } else {
+                size = cut;
+            }
+        }
+        insertionSort(data, size, less);
+    }
+
+    //! Check if \a size elements at \a data are sorted.
+    template <typename T, typename L = ZLess<T>> static bool isSorted(const T *data, zu64 size, L less = L()){
+        for(zu64 i = 1; i < size; ++i){
+            if(less(data[i], data[i - 1]))
+                return false;
+        }
+        return true;
+    }
+
+    //! Index of the first of \a size sorted elements at \a data that is not less than \a value, \a size if none.
+    template <typename T, typename V, typename L = ZLess<T>> static zu64 lowerBound(const T *data, zu64 size, const V &value, L less = L()){
+        zu64 lo = 0;
+        while(size > 0){
+            zu64 half = size / 2;
+            if(less(data[lo + half], value)){
+                lo += half + 1;
+                size -= half + 1;
+            } else {
+                size = half;
+            }
+        }
+        return lo;
+    }
+
+    //! Index of the first of \a size sorted elements at \a data that is greater than \a value, \a size if none.
+    template <typename T, typename V, typename L = ZLess<T>> static zu64 upperBound(const T *data, zu64 size, const V &value, L less = L()){
+        zu64 lo = 0;
+        while(size > 0){
+            zu64 half = size / 2;
+            if(!less(value, data[lo + half])){
+                lo += half + 1;
+                size -= half + 1;
+            } else {
+                size = half;
+            }
+        }
+        return lo;
+    }
+
+    //! Index of an element equal to \a value in \a size sorted elements at \a data, NONE if there is none.
+    template <typename T, typename V, typename L = ZLess<T>> static zu64 binarySearch(const T *data, zu64 size, const V &value, L less = L()){
+        zu64 i = lowerBound(data, size, value, less);
+        return (i < size && !less(value, data[i])) ? i : (zu64)NONE;
+    }
+
+    /*! Sort \a size elements at \a data by radix. Stable.
+     *  Integers and floating point numbers are sorted by LSD radix, one byte per pass,
+     *  skipping passes where every element has the same byte. Allocates a buffer of \a size elements.
+     *  Byte strings (types with size() and bytes(), like ZString and ZBinary) are sorted by MSD radix on their bytes.
+     */
+    template <typename T> static void radixSort(T *data, zu64 size){
+        _radixSort(data, size, std::is_arithmetic<T>());
+    }
+
+    /*! Sort \a size elements at \a data by the integer or floating point key returned by \a key for each element. Stable.
+     *  \a key is called once per element, and the keys are moved along with the elements on each pass.
+     */
+    template <typename T, typename K> static void radixSort(T *data, zu64 size, K key){
+        typedef typename std::decay<decltype(key(*data))>::type KeyType;
+        typedef typename ZRadixKey<KeyType>::type RadixType;
+        if(size < 2)
+            return;
+        RadixType *keys = ZDefaultAllocator<RadixType>::alloc(size * 2);
+        for(zu64 i = 0; i < size; ++i)
+            keys[i] = ZRadixKey<KeyType>::key(key(data[i]));
+        T *buffer = ZDefaultAllocator<T>::alloc(size);
+        _lsdRadix(data, keys, buffer, keys + size, size);
+        ZDefaultAllocator<T>::dealloc(buffer);
+        ZDefaultAllocator<RadixType>::dealloc(keys);
+    }
+
+private:
+    template <typename T, typename L> static void _introsort(T *data, zu64 size, zu64 depth, L &less){
+        while(size > ZSORT_INSERTION){
+            if(depth == 0){
+                heapSort(data, size, less);
+                return;
+            }
+            --depth;
+            zu64 cut = _partition(data, size, less);
+            // Recurse into the smaller side, loop on the larger, so the stack stays O(log n)
+            if(cut < size - cut){
+                _introsort(data, cut, depth, less);
+                data += cut;
+                size -= cut;
+            } else {
+                _introsort(data + cut, size - cut, depth, less);
+                size = cut;
+            }
+        }
+        insertionSort(data, size, less);
+    }
+
+    /*! Partition around the median of three elements, moved to the front.
+     *  \return Index splitting elements not greater than the pivot from elements not less than it, in [1, \a size).
+     */
+    template <typename T, typename L> static zu64 _partition(T *data, zu64 size, L &less){
+        T *a = data + 1;
+        T *b = data + size / 2;
+        T *c = data + size - 1;
+        if(less(*a, *b)){
+            if(less(*b, *c))
+                std::swap(*data, *b);
+            else if(less(*a, *c))
+                std::swap(*data, *c);
+            else
+                std::swap(*data, *a);
+        } else if(less(*a, *c)){
+            std::swap(*data, *a);
+        } else if(less(*b, *c)){
+            std::swap(*data, *c);
+        } else {
+            std::swap(*data, *b);
+        }
+
+        // The other two sampled elements bound both scans, so they need no range checks
+        zu64 i = 1, j = size;
+        while(true){
+            while(less(data[i], *data))
+                ++i;
+            --j;
+            while(less(*data, data[j]))
+                --j;
+            if(i >= j)
+                return i;
+            std::swap(data[i], data[j]);
+            ++i;
+        }
+    }
+
+    //! Merge sorted [0, \a mid) and [\a mid, \a size) at \a data, using \a buffer for \a mid uninitialized elements.
+    template <typename T, typename L> static void _merge(T *data, zu64 mid, zu64 size, T *buffer, L &less){
+        // Already in order
+        if(!less(data[mid], data[mid - 1]))
+            return;
+        for(zu64 i = 0; i < mid; ++i)
+            ZDefaultAllocator<T>::emplace(buffer + i, std::move(data[i]));
+        zu64 i = 0, j = mid, k = 0;
+        while(i < mid && j < size){
+            if(less(data[j], buffer[i]))
+                data[k++] = std::move(data[j++]);
+            else
+                data[k++] = std::move(buffer[i++]);
+        }
+        while(i < mid)
+            data[k++] = std::move(buffer[i++]);
+        ZDefaultAllocator<T>::destroy(buffer, mid);
+    }
+
+    template <typename T, typename L> static void _siftDown(T *data, zu64 i, zu64 size, L &less){
+        while(true){
+            zu64 child = i * 2 + 1;
+            if(child >= size)
+                return;
+            if(child + 1 < size && less(data[child], data[child + 1]))
+                ++child;
+            if(!less(data[i], data[child]))
+                return;
+            std::swap(data[i], data[child]);
+            i = child;
+        }
+    }
+    template <typename T, typename L> static void _makeHeap(T *data, zu64 size, L &less){
+        for(zu64 i = size / 2; i > 0; --i)
+            _siftDown(data, i - 1, size, less);
+    }
+    template <typename T, typename L> static void _sortHeap(T *data, zu64 size, L &less){
+        for(zu64 end = size; end > 1; --end){
+            std::swap(data[0], data[end - 1]);
+            _siftDown(data, 0, end - 1, less);
+        }
+    }
+
+    template <typename T> static void _radixSort(T *data, zu64 size, std::true_type){
+        typedef typename ZRadixKey<T>::type RadixType;
+        if(size < 2)
+            return;
+        // Sort the keys alone, then map them back to values
+        RadixType *keys = ZDefaultAllocator<RadixType>::alloc(size * 2);
+        for(zu64 i = 0; i < size; ++i)
+            keys[i] = ZRadixKey<T>::key(data[i]);
+        _lsdRadix((RadixType *)nullptr, keys, (RadixType *)nullptr, keys + size, size);
+        for(zu64 i = 0; i < size; ++i)
+            data[i] = _fromKey<T>(keys[i]);
+        ZDefaultAllocator<RadixType>::dealloc(keys);
+    }
+
+    template <typename T> static void _radixSort(T *data, zu64 size, std::false_type){
+        if(size < 2)
+            return;
+        T *buffer = ZDefaultAllocator<T>::alloc(size);
+        _msdRadix(data, size, 0, buffer, 0);
+        ZDefaultAllocator<T>::dealloc(buffer);
+    }
+
+    //! Invert ZRadixKey.
+    template <typename T> static T _fromKey(typename ZRadixKey<T>::type key){
+        typedef typename ZRadixKey<T>::type RadixType;
+        const RadixType sign = (RadixType)((RadixType)1 << (sizeof(RadixType) * 8 - 1));
+        if(std::is_floating_point<T>::value){
+            RadixType bits = (key & sign) ? (RadixType)(key & ~sign) : (RadixType)~key;
+            T value;
+            ::memcpy(&value, &bits, sizeof(T));
+            return value;
+        }
+        return (T)(std::is_signed<T>::value ? (RadixType)(key ^ sign) : key);
+    }
+
+    /*! LSD radix sort of \a keys, moving the elements at \a data along with them if \a data is not null.
+     *  \a kbuffer and \a buffer are scratch space for \a size keys and uninitialized elements.
+     */
+    template <typename T, typename K> static void _lsdRadix(T *data, K *keys, T *buffer, K *kbuffer, zu64 size){
+        zu64 counts[sizeof(K)][256];
+        ::memset(counts, 0, sizeof(counts));
+        for(zu64 i = 0; i < size; ++i){
+            for(zu64 b = 0; b < sizeof(K); ++b)
+                ++counts[b][(keys[i] >> (b * 8)) & 0xFF];
+        }
+
+        for(zu64 b = 0; b < sizeof(K); ++b){
+            zu64 *count = counts[b];
+            // Every key has the same byte, nothing moves
+            if(count[(keys[0] >> (b * 8)) & 0xFF] == size)
+                continue;
+            zu64 pos = 0;
+            for(zu64 j = 0; j < 256; ++j){
+                zu64 c = count[j];
+                count[j] = pos;
+                pos += c;
+            }
+            for(zu64 i = 0; i < size; ++i){
+                zu64 dest = count[(keys[i] >> (b * 8)) & 0xFF]++;
+                kbuffer[dest] = keys[i];
+                if(data)
+                    ZDefaultAllocator<T>::move(data + i, buffer + dest);
+            }
+            if(data){
+                ZDefaultAllocator<T>::move(buffer, data, size);
+            }
+            ::memcpy(keys, kbuffer, size * sizeof(K));
+        }
+    }
+
+    //! Byte-wise ordering of byte strings, starting at byte \a depth.
+    template <typename T> struct _ByteLess {
+        _ByteLess(zu64 d) : depth(d){}
+        bool operator()(const T &a, const T &b) const {
+            zu64 as = a.size() - depth, bs = b.size() - depth;
+            int cmp = ::memcmp(a.bytes() + depth, b.bytes() + depth, MIN(as, bs));
+            return (cmp < 0 || (cmp == 0 && as < bs));
+        }
+        zu64 depth;
+    };
+
+    //! Byte of \a str at \a depth plus one, zero past the end.
+    template <typename T> static inline zu64 _bucket(const T &str, zu64 depth){
+        return (depth < str.size() ? (zu64)str.bytes()[depth] + 1 : 0);
+    }
+
+    /*! MSD radix sort of byte strings, which all share the first \a depth bytes.
+     *  Buckets that are small, or too many levels deep, are finished with a comparison sort.
+     */
+    template <typename T> static void _msdRadix(T *data, zu64 size, zu64 depth, T *buffer, zu64 level){
+        while(true){
+            if(size < ZSORT_RADIX_MIN || level > 64){
+                sort(data, size, _ByteLess<T>(depth));
+                return;
+            }
+            zu64 count[257];
+            ::memset(count, 0, sizeof(count));
+            for(zu64 i = 0; i < size; ++i)
+                ++count[_bucket(data[i], depth)];
+            // Every string has the same next byte, skip it without moving anything
+            zu64 first = _bucket(data[0], depth);
+            if(count[first] == size){
+                if(first == 0)
+                    return;
+                ++depth;
+                continue;
+            }
+            zu64 start[257];
+            zu64 pos = 0;
+            for(zu64 j = 0; j < 257; ++j){
+                start[j] = pos;
+                pos += count[j];
+            }
+            zu64 next[257];
+            ::memcpy(next, start, sizeof(next));
+            for(zu64 i = 0; i < size; ++i)
+                ZDefaultAllocator<T>::move(data + i, buffer + next[_bucket(data[i], depth)]++);
+            ZDefaultAllocator<T>::move(buffer, data, size);
+            // Bucket zero holds strings that ended, they are all equal
+            for(zu64 j = 1; j < 257; ++j){
+                if(count[j] > 1)
+                    _msdRadix(data + start[j], count[j], depth + 1, buffer, level + 1);
+            }
+            return;
+        }
+    }
+};
+
+}
+
+#endif // ZSORT_H
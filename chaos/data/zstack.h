@@ -13,14 +13,20 @@
 
 namespace LibChaos {
 
-//! FILO stack ZArray wrapper.
-template <typename T> class ZStack : public YPushPopAccess<T> {
+/*! FILO stack container wrapper.
+ *  Backed by a ZArray by default.
+ *  \a C may be any container with pushBack(), back() and popBack(), like ZDeque.
+ */
+template <typename T, typename C = ZArray<T>> class ZStack : public YPushPopAccess<T> {
 public:
     ZStack() : _data(){}
 
     void push(const T &data){
         _data.pushBack(data);
     }
+    void push(T &&data){
+        _data.pushBack(std::move(data));
+    }
 
     T &peek(){
         return _data.back();
@@ -33,12 +39,16 @@ public:
         _data.popBack();
     }
 
+    bool isEmpty() const {
+        return _data.size() == 0;
+    }
+
     zu64 size() const {
         return _data.size();
     }
 
 private:
-    ZArray<T> _data;
+    C _data;
 };
 
 }
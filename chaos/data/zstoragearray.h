@@ -0,0 +1,174 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                              zstoragearray.h                               **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZSTORAGEARRAY_H
+#define ZSTORAGEARRAY_H
+
+#include "zstorage.h"
+#include "zmemorystorage.h"
+#include "zarray.h"
+#include "zbinary.h"
+
+#include <type_traits>
+
+//! Elements read or updated at a time by forEach() and update().
+#define ZSTORAGEARRAY_CHUNK_BYTES   (64 * 1024)
+
+namespace LibChaos {
+
+/*! Array of POD values in any ZStorage.
+ *  Elements are stored as their bytes, so with a ZMappedStorage or ZPagedStorage the array can be
+ *  larger than memory, and is kept in the file. Elements are copied in and out, like a ZArray
+ *  that never hands out references. Use forEach() and update() to scan a large array a chunk at a time.
+ *  \note The array owns its storage. If the storage is not a multiple of sizeof(T) bytes, the extra bytes are ignored.
+ */
+template <typename T> class ZStorageArray {
+    static_assert(std::is_trivially_copyable<T>::value, "ZStorageArray elements must be trivially copyable");
+
+public:
+    enum { NONE = ZU64_MAX };
+
+public:
+    //! Create an array in \a storage, taking ownership of it. A null \a storage uses a new ZMemoryStorage.
+    ZStorageArray(ZStorage *storage = nullptr) : _storage(storage ? storage : new ZMemoryStorage){}
+
+    //! Move constructor. Takes the storage of \a other, which is left with an empty ZMemoryStorage.
+    ZStorageArray(ZStorageArray &&other) : _storage(other._storage){
+        other._storage = new ZMemoryStorage;
+    }
+
+    ZStorageArray(const ZStorageArray &) = delete;
+    ZStorageArray &operator=(const ZStorageArray &) = delete;
+
+    ~ZStorageArray(){
+        delete _storage;
+    }
+
+    //! Get a copy of element \a index.
+    T get(zu64 index) const {
+        T value;
+        _storage->copyBlockTo(index * sizeof(T), sizeof(T), (zbyte *)&value);
+        return value;
+    }
+    inline T operator[](zu64 index) const { return get(index); }
+
+    //! Set element \a index to \a value. The array grows if \a index is past the end.
+    void set(zu64 index, const T &value){
+        _storage->copyToBlock((const zbyte *)&value, index * sizeof(T), sizeof(T));
+    }
+
+    T front() const { return get(0); }
+    T back() const { return get(size() - 1); }
+
+    //! Add \a value to the end of the array.
+    ZStorageArray &push(const T &value){
+        set(size(), value);
+        return *this;
+    }
+    inline ZStorageArray &pushBack(const T &value){ return push(value); }
+
+    //! Remove the last element and return it.
+    T popBack(){
+        T value = back();
+        resize(size() - 1);
+        return value;
+    }
+
+    //! Add the elements of \a array to the end of the array.
+    ZStorageArray &append(const ZArray<T> &array){
+        write(size(), array.raw(), array.size());
+        return *this;
+    }
+
+    //! Copy \a count elements starting at \a index to \a out.
+    void read(zu64 index, T *out, zu64 count) const {
+        _storage->copyBlockTo(index * sizeof(T), count * sizeof(T), (zbyte *)out);
+    }
+    //! Copy \a count elements from \a data to the array starting at \a index, growing it if needed.
+    void write(zu64 index, const T *data, zu64 count){
+        _storage->copyToBlock((const zbyte *)data, index * sizeof(T), count * sizeof(T));
+    }
+
+    //! Get \a count elements starting at \a index in a ZArray, up to the end of the array.
+    ZArray<T> toArray(zu64 index = 0, zu64 count = NONE) const {
+        count = MIN(count, size() - MIN(index, size()));
+        ZArray<T> out;
+        out.resize(count);
+        if(count)
+            read(index, out.raw(), count);
+        return out;
+    }
+    //! Get the bytes of \a count elements starting at \a index in a ZBinary, up to the end of the array.
+    ZBinary toBinary(zu64 index = 0, zu64 count = NONE) const {
+        count = MIN(count, size() - MIN(index, size()));
+        ZBinary out(count * sizeof(T));
+        if(count)
+            read(index, (T *)out.raw(), count);
+        return out;
+    }
+
+    //! Call \a func with each element in order, reading a chunk of elements at a time.
+    template <typename F> void forEach(F func) const {
+        const zu64 total = size();
+        const zu64 chunk = _chunk();
+        ZArray<T> buffer;
+        buffer.resize(MIN(chunk, total));
+        for(zu64 i = 0; i < total; i += chunk){
+            zu64 count = MIN(chunk, total - i);
+            read(i, buffer.raw(), count);
+            for(zu64 j = 0; j < count; ++j)
+                func(buffer[j]);
+        }
+    }
+
+    /*! Call \a func with a pointer to each chunk of elements and its size, and keep changes it makes.
+     *  Chunks are fetched with ZStorage::getBlock(), so storages that hold the data in memory are modified in place.
+     */
+    template <typename F> void update(F func){
+        const zu64 total = size();
+        const zu64 chunk = _chunk();
+        for(zu64 i = 0; i < total; i += chunk){
+            zu64 count = MIN(chunk, total - i);
+            zbyte *block = _storage->getBlock(i * sizeof(T), count * sizeof(T));
+            try {
+                func((T *)block, count);
+            } catch(...){
+                _storage->freeBlock(block);
+                throw;
+            }
+            _storage->commitBlock(block);
+            _storage->freeBlock(block);
+        }
+    }
+
+    //! Change the number of elements. New elements are zero bytes.
+    void resize(zu64 size){
+        _storage->resize(size * sizeof(T));
+    }
+    void clear(){
+        _storage->clear();
+    }
+
+    zu64 size() const { return _storage->size() / sizeof(T); }
+    bool isEmpty() const { return size() == 0; }
+
+    ZStorage *storage(){ return _storage; }
+    const ZStorage *storage() const { return _storage; }
+
+private:
+    static zu64 _chunk(){
+        return MAX((zu64)ZSTORAGEARRAY_CHUNK_BYTES / sizeof(T), (zu64)1);
+    }
+
+private:
+    ZStorage *_storage;
+};
+
+//! Byte array in any ZStorage.
+typedef ZStorageArray<zbyte> ZStorageBinary;
+
+}
+
+#endif // ZSTORAGEARRAY_H
@@ -1,76 +1,374 @@
 #include "ztable.h"
+#include "znumberformat.h"
+
+#include <string.h>
 
 namespace LibChaos {
 
-ZTable::ZTable(){
+ZTable::Column::Column(ZString name, ColumnType type) : _name(name), _type(type), _size(0){
+
+}
+
+ZString ZTable::Column::toString(zu64 row) const {
+    if(isNull(row))
+        return ZString();
+    switch(_type){
+        case STRING:
+            return _dict[_codes[row]];
+        case INT64:
+            return ZString::ItoS(_ints[row]);
+        case DOUBLE:
+            return ZString(_doubles[row]);
+        case BOOL:
+            return (_bools[row] ? "true" : "false");
+        case BLOB:
+            return ZString((const char *)_blobs.raw() + _bloboffsets[row], _blobsizes[row]);
+        default:
+            break;
+    }
+    return ZString();
+}
+
+void ZTable::Column::_push(){
+    // New fields are null
+    if(_size % 64 == 0)
+        _nulls.push(0);
+    _nulls[_size / 64] |= (zu64)1 << (_size % 64);
+    switch(_type){
+        case STRING:
+            _codes.push(0);
+            break;
+        case INT64:
+            _ints.push(0);
+            break;
+        case DOUBLE:
+            _doubles.push(0);
+            break;
+        case BOOL:
+            _bools.push(0);
+            break;
+        case BLOB:
+            _bloboffsets.push(0);
+            _blobsizes.push(0);
+            break;
+        default:
+            break;
+    }
+    ++_size;
+}
+
+void ZTable::Column::_setNull(zu64 row, bool null){
+    if(null)
+        _nulls[row / 64] |= (zu64)1 << (row % 64);
+    else
+        _nulls[row / 64] &= ~((zu64)1 << (row % 64));
+}
+
+void ZTable::Column::_check(ColumnType type, const char *op) const {
+    if(_type != type)
+        throw ZException(ZString("ZTable ") + op + ": Column " + _name + " has the wrong type");
+}
+
+zu32 ZTable::Column::_code(const ZString &str){
+    const zu32 *found = _lookup.find(str);
+    if(found != nullptr)
+        return *found;
+    zu32 code = (zu32)_dict.size();
+    _dict.push(str);
+    _lookup.add(str, code);
+    return code;
+}
+
+// /////////////////////////////////////////////////////////////////////////////
+
+ZTable::ZTable() : _rows(0){
 
 }
 
 ZTable::ZTable(ZArray<ZString> columns) : ZTable(){
     for(zu64 i = 0; i < columns.size(); ++i){
-        _columns.add(columns[i], i);
+        addColumn(columns[i]);
     }
 }
 
-void ZTable::addColumn(ZString name){
+void ZTable::addColumn(ZString name, ColumnType type){
     if(_columns.contains(name))
         return;
-    zu64 num = _columns.size();
-    _columns[name] = num;
-    for(zu64 i = 0; i < _records.size(); ++i){
-        _records[i].resize(_columns.size());
-    }
+    _columns.add(name, _data.size());
+    _data.push(Column(name, type));
+    Column &col = _data.back();
+    for(zu64 i = 0; i < _rows; ++i)
+        col._push();
 }
 
 void ZTable::addRecord(ZArray<ZString> record){
-    if(record.size() != _columns.size())
+    if(record.size() != _data.size())
         throw ZException("ZTable addRecord: Incorrect number of fields in record");
-    _records.push(record);
+    zu64 row = addRow();
+    for(zu64 i = 0; i < record.size(); ++i)
+        _parseField(i, row, record[i]);
+}
+
+zu64 ZTable::addRow(){
+    for(zu64 i = 0; i < _data.size(); ++i)
+        _data[i]._push();
+    return _rows++;
+}
+
+void ZTable::setColumnType(zu64 column, ColumnType type){
+    if(_data[column]._type == type)
+        return;
+    Column old = std::move(_data[column]);
+    _data[column] = Column(old._name, type);
+    for(zu64 i = 0; i < _rows; ++i)
+        _data[column]._push();
+    for(zu64 i = 0; i < _rows; ++i){
+        if(old.isNull(i))
+            continue;
+        if(old._type == INT64 && type == DOUBLE)
+            setDouble(column, i, (double)old._ints[i]);
+        else if(old._type == BOOL && type == INT64)
+            setInt(column, i, old._bools[i]);
+        else if(old._type == BOOL && type == DOUBLE)
+            setDouble(column, i, old._bools[i]);
+        else
+            _parseField(column, i, old.toString(i));
+    }
 }
 
 void ZTable::clear(){
     _columns.clear();
-    _records.clear();
+    _data.clear();
+    _rows = 0;
+}
+
+void ZTable::setNull(zu64 column, zu64 row){
+    _data[column]._setNull(row, true);
+}
+
+void ZTable::setInt(zu64 column, zu64 row, zs64 value){
+    Column &col = _column(column, INT64, "setInt");
+    col._ints[row] = value;
+    col._setNull(row, false);
+}
+
+void ZTable::setDouble(zu64 column, zu64 row, double value){
+    Column &col = _column(column, DOUBLE, "setDouble");
+    col._doubles[row] = value;
+    col._setNull(row, false);
+}
+
+void ZTable::setBool(zu64 column, zu64 row, bool value){
+    Column &col = _column(column, BOOL, "setBool");
+    col._bools[row] = value;
+    col._setNull(row, false);
+}
+
+void ZTable::setString(zu64 column, zu64 row, const ZString &value){
+    Column &col = _column(column, STRING, "setString");
+    col._codes[row] = col._code(value);
+    col._setNull(row, false);
+}
+
+void ZTable::setBlob(zu64 column, zu64 row, const zbyte *data, zu64 size){
+    Column &col = _column(column, BLOB, "setBlob");
+    // Blob bytes are only appended, replaced blobs are not reclaimed
+    zu64 offset = col._blobs.size();
+    col._blobs.resize(offset + size);
+    if(size)
+        ::memcpy(col._blobs.raw() + offset, data, size);
+    col._bloboffsets[row] = offset;
+    col._blobsizes[row] = size;
+    col._setNull(row, false);
 }
 
-ZString &ZTable::field(zu64 column, zu64 row){
-    return _records[row][column];
+bool ZTable::isNull(zu64 column, zu64 row) const {
+    return _data[column].isNull(row);
 }
 
-ZString &ZTable::field(ZString column, zu64 row){
-    return _records[row][_columns[column]];
+zs64 ZTable::getInt(zu64 column, zu64 row) const {
+    const Column &col = _data[column];
+    if(col._type == BOOL)
+        return col._bools[row];
+    return _column(column, INT64, "getInt")._ints[row];
 }
 
-ZArray<ZString> &ZTable::record(zu64 row){
-    return _records[row];
+double ZTable::getDouble(zu64 column, zu64 row) const {
+    const Column &col = _data[column];
+    if(col._type == INT64)
+        return (double)col._ints[row];
+    if(col._type == BOOL)
+        return col._bools[row];
+    return _column(column, DOUBLE, "getDouble")._doubles[row];
 }
 
-ZArray<ZString> ZTable::getColumnNames(){
-    return _columns.keys();
+bool ZTable::getBool(zu64 column, zu64 row) const {
+    const Column &col = _data[column];
+    if(col._type == INT64)
+        return col._ints[row] != 0;
+    return _column(column, BOOL, "getBool")._bools[row];
 }
 
-ZArray<ZString> ZTable::getColumn(ZString name){
-    ZArray<ZString> column;
-    for(zu64 i = 0; i < _records.size(); ++i){
-        column.push(_records[i][_columns[name]]);
+ZString ZTable::getString(zu64 column, zu64 row) const {
+    return _data[column].toString(row);
+}
+
+ZBinary ZTable::getBlob(zu64 column, zu64 row) const {
+    const Column &col = _column(column, BLOB, "getBlob");
+    return ZBinary(col._blobs.raw() + col._bloboffsets[row], col._blobsizes[row]);
+}
+
+const ZString ZTable::field(zu64 column, zu64 row) const {
+    return getString(column, row);
+}
+
+const ZString ZTable::field(ZString column, zu64 row) const {
+    return getString(_columns[column], row);
+}
+
+const ZArray<ZString> ZTable::record(zu64 row) const {
+    ZArray<ZString> fields;
+    for(zu64 i = 0; i < _data.size(); ++i)
+        fields.push(getString(i, row));
+    return fields;
+}
+
+zu64 ZTable::columnIndex(ZString name) const {
+    const zu64 *found = _columns.find(name);
+    return (found != nullptr ? *found : (zu64)NONE);
+}
+
+ZArray<ZString> ZTable::getColumnNames() const {
+    ZArray<ZString> names;
+    for(zu64 i = 0; i < _data.size(); ++i)
+        names.push(_data[i]._name);
+    return names;
+}
+
+ZArray<ZString> ZTable::getColumn(ZString name) const {
+    zu64 column = _columns[name];
+    ZArray<ZString> fields;
+    fields.reserve(_rows);
+    for(zu64 i = 0; i < _rows; ++i){
+        fields.push(getString(column, i));
     }
-    return column;
+    return fields;
 }
 
-ZMap<ZString, ZString> ZTable::getRecord(zu64 row){
+ZMap<ZString, ZString> ZTable::getRecord(zu64 row) const {
     ZMap<ZString, ZString> map;
-    for(auto it = _columns.begin(); it.more(); ++it){
-        map[*it] = _records[row][_columns[*it]];
+    for(zu64 i = 0; i < _data.size(); ++i){
+        map[_data[i]._name] = getString(i, row);
     }
     return map;
 }
 
-zu64 ZTable::colCount(){
-    return _columns.size();
+ZArray<zu64> ZTable::filterBool(zu64 column, bool value) const {
+    const Column &col = _column(column, BOOL, "filterBool");
+    ZArray<zu64> rows;
+    for(zu64 i = 0; i < col._size; ++i){
+        if(!col.isNull(i) && (col._bools[i] != 0) == value)
+            rows.push(i);
+    }
+    return rows;
+}
+
+ZArray<zu64> ZTable::filterNull(zu64 column) const {
+    const Column &col = _data[column];
+    ZArray<zu64> rows;
+    for(zu64 w = 0; w < col._nulls.size(); ++w){
+        // Skip words with no nulls
+        zu64 bits = col._nulls[w];
+        for(zu64 b = 0; bits; ++b, bits >>= 1){
+            if(bits & 1)
+                rows.push(w * 64 + b);
+        }
+    }
+    return rows;
 }
 
-zu64 ZTable::rowCount(){
-    return _records.size();
+ZTable::Stats ZTable::aggregate(zu64 column) const {
+    const Column &col = _data[column];
+    if(col._type != INT64 && col._type != DOUBLE && col._type != BOOL)
+        throw ZException(ZString("ZTable aggregate: Column ") + col._name + " is not numeric");
+    Stats stats = { 0, 0, 0, 0, 0 };
+    for(zu64 i = 0; i < col._size; ++i)
+        _addStat(stats, col, i);
+    return stats;
+}
+
+ZTable::Stats ZTable::aggregate(zu64 column, const ZArray<zu64> &rows) const {
+    const Column &col = _data[column];
+    if(col._type != INT64 && col._type != DOUBLE && col._type != BOOL)
+        throw ZException(ZString("ZTable aggregate: Column ") + col._name + " is not numeric");
+    Stats stats = { 0, 0, 0, 0, 0 };
+    for(zu64 i = 0; i < rows.size(); ++i)
+        _addStat(stats, col, rows[i]);
+    return stats;
+}
+
+zu64 ZTable::colCount() const {
+    return _data.size();
+}
+
+zu64 ZTable::rowCount() const {
+    return _rows;
+}
+
+const ZTable::Column &ZTable::_column(zu64 column, ColumnType type, const char *op) const {
+    const Column &col = _data[column];
+    col._check(type, op);
+    return col;
+}
+
+ZTable::Column &ZTable::_column(zu64 column, ColumnType type, const char *op){
+    Column &col = _data[column];
+    col._check(type, op);
+    return col;
+}
+
+void ZTable::_parseField(zu64 column, zu64 row, const ZString &field){
+    switch(_data[column]._type){
+        case STRING:
+            setString(column, row, field);
+            break;
+        case INT64:
+            if(field.size() && field.isInteger())
+                setInt(column, row, field.toSint());
+            break;
+        case DOUBLE: {
+            // Same number grammar as ZString and ZJSON, no inf, nan or hex
+            double value;
+            if(field.size() && ZNumberFormat::parseDouble(field.cc(), field.size(), &value, true) == field.size())
+                setDouble(column, row, value);
+            break;
+        }
+        case BOOL:
+            if(field == "1" || field == "true")
+                setBool(column, row, true);
+            else if(field == "0" || field == "false")
+                setBool(column, row, false);
+            break;
+        case BLOB:
+            setBlob(column, row, field.bytes(), field.size());
+            break;
+        default:
+            break;
+    }
+}
+
+void ZTable::_addStat(Stats &stats, const Column &col, zu64 row){
+    if(col.isNull(row)){
+        ++stats.nulls;
+        return;
+    }
+    double value = (col._type == INT64 ? (double)col._ints[row] : col._type == DOUBLE ? col._doubles[row] : (double)col._bools[row]);
+    if(stats.count == 0 || value < stats.min)
+        stats.min = value;
+    if(stats.count == 0 || value > stats.max)
+        stats.max = value;
+    stats.sum += value;
+    ++stats.count;
 }
 
 }
@@ -3,45 +3,248 @@
 
 #include "zarray.h"
 #include "zmap.h"
+#include "zstring.h"
+#include "zbinary.h"
 
 namespace LibChaos {
 
-//! Two-dimensional table container with column names.
+/*! Two-dimensional table container with named, typed columns.
+ *  Stored by column: each column keeps its values in one contiguous array of its type,
+ *  with a bitmap marking null fields. String columns are dictionary encoded,
+ *  each distinct string is stored once and rows hold a 32-bit code.
+ *  Blob columns keep their bytes in one buffer.
+ *
+ *  Scans, filters and aggregates run down a single column array.
+ *  Row views read fields in place without copying the row.
+ */
 class ZTable {
+public:
+    enum ColumnType {
+        STRING,     //!< Dictionary encoded strings.
+        INT64,      //!< Signed 64-bit integers.
+        DOUBLE,     //!< Double precision floating point.
+        BOOL,       //!< Booleans, one byte each.
+        BLOB,       //!< Byte strings.
+    };
+
+    enum { NONE = ZU64_MAX };
+
+    //! Summary of the values of a numeric column.
+    struct Stats {
+        //! Number of non-null values.
+        zu64 count;
+        //! Number of null fields.
+        zu64 nulls;
+        double sum;
+        double min;
+        double max;
+        //! Mean of the non-null values, zero if there are none.
+        double mean() const { return count ? sum / count : 0; }
+    };
+
+    //! One column of a table.
+    class Column {
+        friend class ZTable;
+    public:
+        Column(ZString name = ZString(), ColumnType type = STRING);
+
+        const ZString &name() const { return _name; }
+        ColumnType type() const { return _type; }
+        zu64 size() const { return _size; }
+
+        bool isNull(zu64 row) const { return (_nulls[row / 64] >> (row % 64)) & 1; }
+
+        //! Values of an INT64 column, one per row. Null fields hold zero.
+        const zs64 *ints() const { return _ints.raw(); }
+        //! Values of a DOUBLE column, one per row. Null fields hold zero.
+        const double *doubles() const { return _doubles.raw(); }
+        //! Values of a BOOL column, one byte per row. Null fields hold zero.
+        const zu8 *bools() const { return _bools.raw(); }
+        //! Dictionary codes of a STRING column, one per row, indexes into dictionary(). Null fields hold zero.
+        const zu32 *codes() const { return _codes.raw(); }
+        //! Distinct strings in a STRING column.
+        const ZArray<ZString> &dictionary() const { return _dict; }
+
+        //! Get field \a row as a string. Null fields are empty.
+        ZString toString(zu64 row) const;
+
+    private:
+        void _push();
+        void _setNull(zu64 row, bool null);
+        void _check(ColumnType type, const char *op) const;
+        zu32 _code(const ZString &str);
+
+    private:
+        ZString _name;
+        ColumnType _type;
+        zu64 _size;
+        //! One bit per row, set for null.
+        ZArray<zu64> _nulls;
+        ZArray<zs64> _ints;
+        ZArray<double> _doubles;
+        ZArray<zu8> _bools;
+        ZArray<zu32> _codes;
+        ZArray<ZString> _dict;
+        ZMap<ZString, zu32> _lookup;
+        //! Blob bytes, and the offset and size of each row's blob.
+        ZArray<zbyte> _blobs;
+        ZArray<zu64> _bloboffsets;
+        ZArray<zu64> _blobsizes;
+    };
+
+    //! View of one row of a table. Only valid while the table is not modified.
+    class Row {
+    public:
+        Row(const ZTable *table, zu64 row) : _table(table), _row(row){}
+
+        zu64 index() const { return _row; }
+        bool isNull(zu64 column) const { return _table->isNull(column, _row); }
+        zs64 getInt(zu64 column) const { return _table->getInt(column, _row); }
+        double getDouble(zu64 column) const { return _table->getDouble(column, _row); }
+        bool getBool(zu64 column) const { return _table->getBool(column, _row); }
+        ZString getString(zu64 column) const { return _table->getString(column, _row); }
+        //! Get field in the column named \a column as a string.
+        ZString operator[](ZString column) const { return _table->field(column, _row); }
+
+    private:
+        const ZTable *_table;
+        zu64 _row;
+    };
+
 public:
     ZTable();
+    //! Construct with string columns named \a columns.
     ZTable(ZArray<ZString> columns);
 
-    //! Add a column to the table.
-    void addColumn(ZString name);
-    //! Adda record to the table.
+    //! Add a column to the table, fields in existing rows are null. Does nothing if the column exists.
+    void addColumn(ZString name, ColumnType type = STRING);
+    /*! Add a record to the table, parsing each field as its column's type.
+     *  Fields that do not parse as a number or boolean are null.
+     *  \throws ZException if the record does not have one field per column.
+     */
     void addRecord(ZArray<ZString> record);
-    
+    //! Add a row with every field null. \return The index of the row.
+    zu64 addRow();
+
+    /*! Change the type of \a column, converting its fields.
+     *  INT64 and BOOL fields convert exactly to numbers, other fields are parsed from their string form like addRecord().
+     *  Fields that do not parse as the new type are null.
+     */
+    void setColumnType(zu64 column, ColumnType type);
+
     //! Clear columns and records.
     void clear();
 
-    //! Get reference to field in \a column and \a row.
-    ZString &field(zu64 column, zu64 row);
-    //! Get reference to field in \a column and \a row.
-    ZString &field(ZString column, zu64 row);
-    //! Get reference to record in \a row.
-    ZArray<ZString> &record(zu64 row);
+    //! Set field in \a column and \a row to null.
+    void setNull(zu64 column, zu64 row);
+    //! Set field in INT64 \a column and \a row. \throws ZException if the column has another type.
+    void setInt(zu64 column, zu64 row, zs64 value);
+    //! Set field in DOUBLE \a column and \a row. \throws ZException if the column has another type.
+    void setDouble(zu64 column, zu64 row, double value);
+    //! Set field in BOOL \a column and \a row. \throws ZException if the column has another type.
+    void setBool(zu64 column, zu64 row, bool value);
+    //! Set field in STRING \a column and \a row. \throws ZException if the column has another type.
+    void setString(zu64 column, zu64 row, const ZString &value);
+    //! Set field in BLOB \a column and \a row. \throws ZException if the column has another type.
+    void setBlob(zu64 column, zu64 row, const zbyte *data, zu64 size);
+
+    bool isNull(zu64 column, zu64 row) const;
+    //! Get field in INT64 or BOOL \a column and \a row. \throws ZException for other types.
+    zs64 getInt(zu64 column, zu64 row) const;
+    //! Get field in DOUBLE, INT64 or BOOL \a column and \a row. \throws ZException for other types.
+    double getDouble(zu64 column, zu64 row) const;
+    //! Get field in BOOL or INT64 \a column and \a row. \throws ZException for other types.
+    bool getBool(zu64 column, zu64 row) const;
+    //! Get field in \a column and \a row of any type as a string. Null fields are empty.
+    ZString getString(zu64 column, zu64 row) const;
+    //! Get field in BLOB \a column and \a row. \throws ZException for other types.
+    ZBinary getBlob(zu64 column, zu64 row) const;
+
+    /*! Get field in \a column and \a row as a string.
+     *  Fields are stored typed, so this is a copy and const to keep writes to it from compiling. Use the set functions.
+     */
+    const ZString field(zu64 column, zu64 row) const;
+    //! Get field in \a column and \a row as a string.
+    const ZString field(ZString column, zu64 row) const;
+    //! Get a copy of the fields in \a row as strings.
+    const ZArray<ZString> record(zu64 row) const;
+    //! Get a view of \a row.
+    Row row(zu64 row) const { return Row(this, row); }
+
+    //! Get a column.
+    const Column &column(zu64 column) const { return _data[column]; }
+    //! Get the index of the column named \a name, NONE if there is none.
+    zu64 columnIndex(ZString name) const;
 
     //! Get an array of column names.
-    ZArray<ZString> getColumnNames();
+    ZArray<ZString> getColumnNames() const;
     //! Get an array of fields in \a column.
-    ZArray<ZString> getColumn(ZString name);
+    ZArray<ZString> getColumn(ZString name) const;
     //! Get a map of column names to fields in \a row.
-    ZMap<ZString, ZString> getRecord(zu64 row);
+    ZMap<ZString, ZString> getRecord(zu64 row) const;
+
+    //! Rows of INT64 \a column that are not null and pass \a pred, called with each value.
+    template <typename F> ZArray<zu64> filterInt(zu64 column, F pred) const {
+        const Column &col = _column(column, INT64, "filterInt");
+        ZArray<zu64> rows;
+        for(zu64 i = 0; i < col._size; ++i){
+            if(!col.isNull(i) && pred(col._ints[i]))
+                rows.push(i);
+        }
+        return rows;
+    }
+    //! Rows of DOUBLE \a column that are not null and pass \a pred, called with each value.
+    template <typename F> ZArray<zu64> filterDouble(zu64 column, F pred) const {
+        const Column &col = _column(column, DOUBLE, "filterDouble");
+        ZArray<zu64> rows;
+        for(zu64 i = 0; i < col._size; ++i){
+            if(!col.isNull(i) && pred(col._doubles[i]))
+                rows.push(i);
+        }
+        return rows;
+    }
+    //! Rows of BOOL \a column that are not null and equal \a value.
+    ZArray<zu64> filterBool(zu64 column, bool value) const;
+    /*! Rows of STRING \a column that are not null and pass \a pred, called with a string.
+     *  \a pred is called once per distinct string, not once per row.
+     */
+    template <typename F> ZArray<zu64> filterString(zu64 column, F pred) const {
+        const Column &col = _column(column, STRING, "filterString");
+        ZArray<bool> pass;
+        pass.reserve(col._dict.size());
+        for(zu64 i = 0; i < col._dict.size(); ++i)
+            pass.push(pred(col._dict[i]));
+        ZArray<zu64> rows;
+        for(zu64 i = 0; i < col._size; ++i){
+            if(!col.isNull(i) && pass[col._codes[i]])
+                rows.push(i);
+        }
+        return rows;
+    }
+    //! Rows where \a column is null.
+    ZArray<zu64> filterNull(zu64 column) const;
+
+    //! Summarize the values of INT64, DOUBLE or BOOL \a column. \throws ZException for other types.
+    Stats aggregate(zu64 column) const;
+    //! Summarize the values of INT64, DOUBLE or BOOL \a column in \a rows. \throws ZException for other types.
+    Stats aggregate(zu64 column, const ZArray<zu64> &rows) const;
 
     //! Number of columns.
-    zu64 colCount();
+    zu64 colCount() const;
     //! Number of rows.
-    zu64 rowCount();
+    zu64 rowCount() const;
+
+private:
+    const Column &_column(zu64 column, ColumnType type, const char *op) const;
+    Column &_column(zu64 column, ColumnType type, const char *op);
+    //! Set field in \a column and \a row by parsing \a field as the column's type. Leaves the field null if it does not parse.
+    void _parseField(zu64 column, zu64 row, const ZString &field);
+    static void _addStat(Stats &stats, const Column &col, zu64 row);
 
 private:
     ZMap<ZString, zu64> _columns;
-    ZArray<ZArray<ZString>> _records;
+    ZArray<Column> _data;
+    zu64 _rows;
 };
 
 }
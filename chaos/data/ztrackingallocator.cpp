@@ -0,0 +1,227 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                           ztrackingallocator.cpp                           **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#include "ztrackingallocator.h"
+#include "zmap.h"
+#include "zmutex.h"
+#include "zlog.h"
+
+#if LIBCHAOS_COMPILER == _COMPILER_GCC || LIBCHAOS_COMPILER == _COMPILER_CLANG || LIBCHAOS_COMPILER == _COMPILER_MINGW
+    #define ZALLOC_DEMANGLE
+    // For abi::__cxa_demangle
+    #include <cxxabi.h>
+    // For free
+    #include <stdlib.h>
+#endif
+
+namespace LibChaos {
+
+std::atomic<int> ZAllocatorHook::_enabled(0);
+
+void ZAllocatorHook::alloc(const char *type, zu64 bytes){
+    ZAllocRegistry::recordAlloc(type, bytes, false);
+}
+
+void ZAllocatorHook::dealloc(const char *type){
+    ZAllocRegistry::recordDealloc(type, 0);
+}
+
+zu64 ZAllocStats::bucket(zu64 bytes){
+    zu64 i = 0;
+    while(i < ZALLOC_HISTOGRAM_SIZE - 1 && bytes > ((zu64)16 << i))
+        ++i;
+    return i;
+}
+
+namespace {
+
+struct Registry {
+    ZMutex mutex;
+    ZMap<ZString, ZAllocStats> stats;
+};
+
+//! Set while the current thread is inside the registry, so its own allocations are not recorded.
+thread_local bool inregistry = false;
+//! Allocations recorded by the current thread, for ZAllocRegistry::Scope.
+thread_local zu64 threadallocs = 0;
+thread_local zu64 threadbytes = 0;
+
+//! Get the registry. Never destroyed, so allocations can be recorded during static destruction.
+Registry &registry(){
+    static Registry *reg = new Registry;
+    return *reg;
+}
+
+//! Enter the registry and lock it, unless the current thread is already inside.
+class RegistryLock {
+public:
+    RegistryLock() : _entered(!inregistry){
+        if(_entered){
+            inregistry = true;
+            registry().mutex.lock();
+        }
+    }
+    ~RegistryLock(){
+        if(_entered){
+            registry().mutex.unlock();
+            inregistry = false;
+        }
+    }
+private:
+    bool _entered;
+};
+
+void addStats(ZAllocStats &sum, const ZAllocStats &stats){
+    sum.allocs += stats.allocs;
+    sum.deallocs += stats.deallocs;
+    sum.bytes += stats.bytes;
+    sum.liveBytes += stats.liveBytes;
+    sum.peakBytes += stats.peakBytes;
+    for(zu64 i = 0; i < ZALLOC_HISTOGRAM_SIZE; ++i)
+        sum.histogram[i] += stats.histogram[i];
+}
+
+}
+
+ZAllocRegistry::Scope::Scope(bool track) : _track(track), _allocs(threadallocs), _bytes(threadbytes){
+    if(_track)
+        setTracking(true);
+}
+
+ZAllocRegistry::Scope::~Scope(){
+    if(_track)
+        setTracking(false);
+}
+
+zu64 ZAllocRegistry::Scope::allocs() const {
+    return threadallocs - _allocs;
+}
+
+zu64 ZAllocRegistry::Scope::bytes() const {
+    return threadbytes - _bytes;
+}
+
+void ZAllocRegistry::setTracking(bool enable){
+    if(enable)
+        ++ZAllocatorHook::_enabled;
+    else
+        --ZAllocatorHook::_enabled;
+}
+
+void ZAllocRegistry::recordAlloc(const char *name, zu64 bytes, bool sized){
+    if(inregistry)
+        return;
+    ++threadallocs;
+    threadbytes += bytes;
+
+    RegistryLock lock;
+    ZAllocStats &stats = registry().stats[ZString(name)];
+    ++stats.allocs;
+    stats.bytes += bytes;
+    ++stats.histogram[ZAllocStats::bucket(bytes)];
+    if(sized){
+        stats.liveBytes += bytes;
+        if(stats.liveBytes > stats.peakBytes)
+            stats.peakBytes = stats.liveBytes;
+    }
+}
+
+void ZAllocRegistry::recordDealloc(const char *name, zu64 bytes){
+    if(inregistry)
+        return;
+
+    RegistryLock lock;
+    ZAllocStats &stats = registry().stats[ZString(name)];
+    ++stats.deallocs;
+    stats.liveBytes -= (bytes > stats.liveBytes ? stats.liveBytes : bytes);
+}
+
+ZAllocStats ZAllocRegistry::stats(const ZString &name){
+    ZAllocStats stats = ZAllocStats();
+    RegistryLock lock;
+    if(registry().stats.contains(name))
+        stats = registry().stats.get(name);
+    return stats;
+}
+
+ZAllocStats ZAllocRegistry::total(){
+    ZAllocStats sum = ZAllocStats();
+    RegistryLock lock;
+    const ZMap<ZString, ZAllocStats> &map = registry().stats;
+    for(auto it = map.begin(); it.more(); ++it)
+        addStats(sum, map.get(*it));
+    return sum;
+}
+
+ZArray<ZString> ZAllocRegistry::names(){
+    RegistryLock lock;
+    return registry().stats.keys();
+}
+
+void ZAllocRegistry::reset(){
+    RegistryLock lock;
+    registry().stats.clear();
+}
+
+void ZAllocRegistry::report(){
+    ZArray<ZString> keys;
+    ZArray<ZAllocStats> values;
+    {
+        RegistryLock lock;
+        const ZMap<ZString, ZAllocStats> &map = registry().stats;
+        for(auto it = map.begin(); it.more(); ++it){
+            // Insert sorted by bytes, largest first
+            const ZAllocStats &stats = map.get(*it);
+            zu64 i = 0;
+            while(i < values.size() && values[i].bytes >= stats.bytes)
+                ++i;
+            keys.insert(i, *it);
+            values.insert(i, stats);
+        }
+    }
+
+    LOG("Allocations:" << ZString("allocs").lpad(' ', 12) << ZString("deallocs").lpad(' ', 12)
+        << ZString("bytes").lpad(' ', 14) << ZString("live").lpad(' ', 12) << ZString("peak").lpad(' ', 12));
+    for(zu64 i = 0; i < keys.size(); ++i){
+        const ZAllocStats &stats = values[i];
+        LOG("  " << readableName(keys[i]));
+        LOG(ZString().pad(' ', 12) << ZString(stats.allocs).lpad(' ', 12) << ZString(stats.deallocs).lpad(' ', 12)
+            << ZString(stats.bytes).lpad(' ', 14) << ZString(stats.liveBytes).lpad(' ', 12) << ZString(stats.peakBytes).lpad(' ', 12));
+    }
+}
+
+ZJSON ZAllocRegistry::toJSON(){
+    ZJSON json(ZJSON::OBJECT);
+    RegistryLock lock;
+    const ZMap<ZString, ZAllocStats> &map = registry().stats;
+    for(auto it = map.begin(); it.more(); ++it){
+        const ZAllocStats &stats = map.get(*it);
+        ZJSON &entry = json[readableName(*it)];
+        entry["allocs"] = (double)stats.allocs;
+        entry["deallocs"] = (double)stats.deallocs;
+        entry["bytes"] = (double)stats.bytes;
+        entry["live"] = (double)stats.liveBytes;
+        entry["peak"] = (double)stats.peakBytes;
+        ZJSON &histogram = entry["histogram"];
+        for(zu64 i = 0; i < ZALLOC_HISTOGRAM_SIZE; ++i)
+            histogram << ZJSON((double)stats.histogram[i]);
+    }
+    return json;
+}
+
+ZString ZAllocRegistry::readableName(const ZString &name){
+#ifdef ZALLOC_DEMANGLE
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(name.cc(), nullptr, nullptr, &status);
+    if(demangled != nullptr){
+        ZString out = (status == 0 ? ZString(demangled) : name);
+        free(demangled);
+        return out;
+    }
+#endif
+    return name;
+}
+
+}
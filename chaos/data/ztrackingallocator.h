@@ -0,0 +1,151 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                            ztrackingallocator.h                            **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZTRACKINGALLOCATOR_H
+#define ZTRACKINGALLOCATOR_H
+
+#include "ztypes.h"
+#include "zallocator.h"
+#include "zstring.h"
+#include "zjson.h"
+
+// For std::max_align_t
+#include <cstddef>
+
+//! Number of allocation size histogram buckets.
+#define ZALLOC_HISTOGRAM_SIZE 16
+
+namespace LibChaos {
+
+//! Allocation counters for one tracked name.
+struct ZAllocStats {
+    //! Number of allocations.
+    zu64 allocs;
+    //! Number of deallocations.
+    zu64 deallocs;
+    //! Total bytes allocated.
+    zu64 bytes;
+    //! Bytes currently allocated. Only known for allocations through ZTrackingAllocator.
+    zu64 liveBytes;
+    //! Highest liveBytes.
+    zu64 peakBytes;
+    //! Allocations by size. Bucket \a i counts allocations of up to 16 << \a i bytes, the last bucket counts all larger allocations.
+    zu64 histogram[ZALLOC_HISTOGRAM_SIZE];
+
+    //! Get the histogram bucket for an allocation of \a bytes.
+    static zu64 bucket(zu64 bytes);
+};
+
+/*! Global registry of allocation statistics.
+ *  Allocations made through a ZTrackingAllocator are always recorded, under the allocator's name.
+ *  Allocations made through ZDefaultAllocator are recorded under the mangled name of the allocated type,
+ *  but only while tracking is enabled with setTracking() or a Scope.
+ *  Allocations made by the registry itself are not recorded.
+ *  \note Thread safe.
+ */
+class ZAllocRegistry {
+public:
+    /*! Counts the allocations made by the current thread during the lifetime of the scope,
+     *  for asserting allocation budgets.
+     */
+    class Scope {
+    public:
+        //! Start counting. If \a track, tracking of default allocations is enabled while the scope is alive.
+        Scope(bool track = true);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        //! Number of allocations by this thread in the scope.
+        zu64 allocs() const;
+        //! Number of bytes allocated by this thread in the scope.
+        zu64 bytes() const;
+
+    private:
+        bool _track;
+        zu64 _allocs;
+        zu64 _bytes;
+    };
+
+public:
+    //! Enable or disable tracking of ZDefaultAllocator allocations. Calls nest.
+    static void setTracking(bool enable);
+    //! True if ZDefaultAllocator allocations are being tracked.
+    static bool tracking(){ return ZAllocatorHook::enabled(); }
+
+    /*! Record an allocation of \a bytes under \a name.
+     *  Only \a sized allocations, whose size will be passed to recordDealloc(), count towards live and peak bytes.
+     */
+    static void recordAlloc(const char *name, zu64 bytes, bool sized = true);
+    //! Record a deallocation of \a bytes under \a name. \a bytes is zero if the size is unknown.
+    static void recordDealloc(const char *name, zu64 bytes);
+
+    //! Get the statistics recorded under \a name, zeroed if nothing is recorded.
+    static ZAllocStats stats(const ZString &name);
+    //! Get the sum of all recorded statistics.
+    static ZAllocStats total();
+    //! Get the names with recorded statistics, in first-recorded order.
+    static ZArray<ZString> names();
+
+    //! Discard all recorded statistics.
+    static void reset();
+
+    //! Log a table of the recorded statistics, sorted by bytes allocated.
+    static void report();
+    //! Get the recorded statistics as a JSON object, keyed by readable name.
+    static ZJSON toJSON();
+
+    //! Get a readable name for a name recorded by ZDefaultAllocator, demangled where supported.
+    static ZString readableName(const ZString &name);
+};
+
+/*! Allocator that records its allocations in ZAllocRegistry under a name.
+ *  Each allocation is prefixed with its size, so live and peak bytes are known for the name.
+ *  Give one to a container to measure its memory use:
+ *  \code
+ *  ZArray<Token> tokens(new ZTrackingAllocator<Token>("parser.tokens"));
+ *  \endcode
+ *  \note Allocations are passed to ::operator new.
+ */
+template <typename T> class ZTrackingAllocator : public ZAllocator<T> {
+private:
+    //! Size prefix, padded to keep the allocation aligned.
+    union Header {
+        zu64 bytes;
+        alignas(alignof(std::max_align_t) > alignof(T) ? alignof(std::max_align_t) : alignof(T)) zbyte pad[1];
+    };
+
+public:
+    //! Record allocations under \a name, or the mangled name of \a T by default.
+    ZTrackingAllocator(ZString name = ZString()) : _name(name.isEmpty() ? ZString(typeid(T).name()) : name){}
+
+    T *alloc(zu64 count = 1) override {
+        zu64 bytes = sizeof(T) * count;
+        Header *header = (Header *)::operator new(sizeof(Header) + bytes, std::nothrow);
+        if(header == nullptr)
+            throw zallocator_exception("Failed to alloc()");
+        header->bytes = bytes;
+        ZAllocRegistry::recordAlloc(_name.cc(), bytes);
+        return (T *)(header + 1);
+    }
+
+    void dealloc(T *ptr) override {
+        if(ptr == nullptr)
+            return;
+        Header *header = (Header *)ptr - 1;
+        ZAllocRegistry::recordDealloc(_name.cc(), header->bytes);
+        ::operator delete(header);
+    }
+
+    //! Get the name allocations are recorded under.
+    const ZString &name() const { return _name; }
+
+private:
+    ZString _name;
+};
+
+}
+
+#endif // ZTRACKINGALLOCATOR_H
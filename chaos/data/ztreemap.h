@@ -0,0 +1,767 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                                 ztreemap.h                                 **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZTREEMAP_H
+#define ZTREEMAP_H
+
+#include "zallocator.h"
+#include "zexception.h"
+#include "zarray.h"
+#include "ziterator.h"
+
+#include <initializer_list>
+// For std::aligned_storage
+#include <type_traits>
+
+//! Target size in bytes of the keys and values of one tree node, four cache lines.
+#define ZTREE_NODE_BYTES    256
+//! Smallest number of keys in a tree node.
+#define ZTREE_MIN_NODE      4
+
+namespace LibChaos {
+
+/*! Ordered map container, a B+tree.
+ *  Iterates in key order.
+ *  Keys must be ordered by \a operator<, keys are equal if neither is less than the other.
+ *
+ *  Entries are stored in leaf nodes sized to a few cache lines, and linked for ordered iteration.
+ *  Inner nodes only hold separator keys, so lookups touch one node per level.
+ *  Pointers to values are invalidated by any insert or remove.
+ */
+template <typename K, typename T> class ZTreeMap {
+public:
+    struct MapPair {
+        K key;
+        T value;
+    };
+
+    enum {
+        //! Number of entries in a leaf node.
+        LEAF_SIZE = (ZTREE_NODE_BYTES / (sizeof(K) + sizeof(T)) > ZTREE_MIN_NODE ? ZTREE_NODE_BYTES / (sizeof(K) + sizeof(T)) : ZTREE_MIN_NODE),
+        //! Number of separator keys in an inner node.
+        INNER_SIZE = (ZTREE_NODE_BYTES / (sizeof(K) + sizeof(void *)) > ZTREE_MIN_NODE ? ZTREE_NODE_BYTES / (sizeof(K) + sizeof(void *)) : ZTREE_MIN_NODE),
+    };
+
+private:
+    struct Node {
+        //! Number of keys.
+        zu32 count;
+        bool leaf;
+    };
+
+    struct Leaf : public Node {
+        Leaf *prev;
+        Leaf *next;
+        typename std::aligned_storage<sizeof(K), alignof(K)>::type keys[LEAF_SIZE];
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type values[LEAF_SIZE];
+        inline K *key(zu64 i){ return reinterpret_cast<K *>(keys) + i; }
+        inline T *value(zu64 i){ return reinterpret_cast<T *>(values) + i; }
+    };
+
+    //! Keys in children[i + 1] are not less than keys[i], keys in children[i] are less than keys[i].
+    struct Inner : public Node {
+        typename std::aligned_storage<sizeof(K), alignof(K)>::type keys[INNER_SIZE];
+        Node *children[INNER_SIZE + 1];
+        inline K *key(zu64 i){ return reinterpret_cast<K *>(keys) + i; }
+    };
+
+public:
+    class ZTreeMapIterator;
+
+public:
+    ZTreeMap() : _root(nullptr), _head(nullptr), _tail(nullptr), _size(0), _depth(0){}
+
+    ZTreeMap(std::initializer_list<MapPair> list) : ZTreeMap(){
+        for(auto item = list.begin(); item < list.end(); ++item){
+            add(item->key, item->value);
+        }
+    }
+
+    //! Copy constructor. Rebuilds the tree from \a other's ordered entries with full nodes.
+    ZTreeMap(const ZTreeMap &other) : ZTreeMap(){
+        _bulkLoad(IterSource(other.begin()), other._size);
+    }
+
+    //! Move constructor. Takes the nodes of \a other, leaving it empty.
+    ZTreeMap(ZTreeMap &&other) : _root(other._root), _head(other._head), _tail(other._tail), _size(other._size), _depth(other._depth){
+        other._root = nullptr;
+        other._head = nullptr;
+        other._tail = nullptr;
+        other._size = 0;
+        other._depth = 0;
+    }
+
+    ~ZTreeMap(){
+        clear();
+    }
+
+    ZTreeMap &operator=(const ZTreeMap &other){
+        if(this != &other){
+            clear();
+            _bulkLoad(IterSource(other.begin()), other._size);
+        }
+        return *this;
+    }
+
+    //! Move assignment, swaps contents with \a other.
+    ZTreeMap &operator=(ZTreeMap &&other){
+        _swap(_root, other._root);
+        _swap(_head, other._head);
+        _swap(_tail, other._tail);
+        _swap(_size, other._size);
+        _swap(_depth, other._depth);
+        return *this;
+    }
+
+    //! Add entry with \a key and \a value to map, or change value of existing entry with \a key.
+    T &add(const K &key, const T &value){
+        bool added;
+        T *val = _insert(key, added);
+        if(added)
+            ZDefaultAllocator<T>::construct(val, value);
+        else
+            *val = value;
+        return *val;
+    }
+    inline T &push(const K &key, const T &value){ return add(key, value); }
+
+    //! Remove entry with \a key from map, if it exists.
+    void remove(const K &key){
+        erase(key);
+    }
+
+    /*! Remove entry with \a key from map.
+     *  \return True if an entry was removed.
+     */
+    bool erase(const K &key){
+        if(_root == nullptr)
+            return false;
+        if(!_erase(_root, key))
+            return false;
+        --_size;
+        // Shrink the tree when the root runs out of keys
+        if(_root->count == 0){
+            Node *old = _root;
+            if(_root->leaf){
+                _root = nullptr;
+                _head = nullptr;
+                _tail = nullptr;
+                _depth = 0;
+                _deallocLeaf((Leaf *)old);
+            } else {
+                _root = ((Inner *)old)->children[0];
+                --_depth;
+                _deallocInner((Inner *)old);
+            }
+        }
+        return true;
+    }
+
+    //! Get a reference to the entry with \a key, create entry if it doesn't exist.
+    T &get(const K &key){
+        bool added;
+        T *val = _insert(key, added);
+        if(added)
+            ZDefaultAllocator<T>::emplace(val);
+        return *val;
+    }
+    inline T &operator[](const K &key){ return get(key); }
+
+    /*! Get a reference to the entry with \a key.
+     *  \throws Throws an exception if the entry doesn't exist
+     */
+    const T &get(const K &key) const {
+        const T *val = find(key);
+        if(val == nullptr)
+            throw ZException("ZTreeMap get: Key does not exist", __LINE__);
+        return *val;
+    }
+    inline const T &operator[](const K &key) const { return get(key); }
+
+    //! Get a pointer to the value of the entry with \a key, null if there is none.
+    T *find(const K &key){
+        Leaf *leaf = _findLeaf(key);
+        if(leaf == nullptr)
+            return nullptr;
+        zu64 i = _lowerBound(leaf, key);
+        return (i < leaf->count && !(key < *leaf->key(i))) ? leaf->value(i) : nullptr;
+    }
+    const T *find(const K &key) const {
+        return const_cast<ZTreeMap *>(this)->find(key);
+    }
+
+    //! Check if map contains \a key.
+    bool contains(const K &key) const {
+        return find(key) != nullptr;
+    }
+
+    //! Remove all entries.
+    void clear(){
+        if(_root != nullptr)
+            _destroy(_root);
+        _root = nullptr;
+        _head = nullptr;
+        _tail = nullptr;
+        _size = 0;
+        _depth = 0;
+    }
+
+    /*! Replace the contents of the map with \a keys and \a values, built bottom-up with full nodes.
+     *  Much faster than adding the entries one at a time.
+     *  \throws Throws an exception if the arrays have different sizes, or \a keys is not strictly increasing.
+     */
+    void loadSorted(const ZArray<K> &keys, const ZArray<T> &values){
+        if(keys.size() != values.size())
+            throw ZException("ZTreeMap loadSorted: Key and value counts differ");
+        for(zu64 i = 1; i < keys.size(); ++i){
+            if(!(keys[i - 1] < keys[i]))
+                throw ZException("ZTreeMap loadSorted: Keys are not sorted");
+        }
+        clear();
+        _bulkLoad(SortedSource(keys, values), keys.size());
+    }
+
+    //! Get an array of the keys in the map, in order.
+    ZArray<K> keys() const {
+        ZArray<K> keys;
+        keys.reserve(_size);
+        for(auto it = begin(); it.more(); ++it){
+            keys.push(*it);
+        }
+        return keys;
+    }
+
+    //! Get the smallest key. \throws Throws an exception if the map is empty.
+    const K &first() const {
+        if(_size == 0)
+            throw ZException("ZTreeMap first: Map is empty");
+        return *_head->key(0);
+    }
+    //! Get the largest key. \throws Throws an exception if the map is empty.
+    const K &last() const {
+        if(_size == 0)
+            throw ZException("ZTreeMap last: Map is empty");
+        return *_tail->key(_tail->count - 1);
+    }
+
+    bool isEmpty() const { return _size == 0; }
+    zu64 size() const { return _size; }
+    //! Number of levels in the tree.
+    zu64 depth() const { return _depth; }
+
+    //! Iterate all entries in key order.
+    ZTreeMapIterator begin() const {
+        return ZTreeMapIterator(_head, 0, nullptr, 0);
+    }
+    //! Iterate entries with keys not less than \a key.
+    ZTreeMapIterator lowerBound(const K &key) const {
+        return _iterFrom(_position(key, false), Position());
+    }
+    //! Iterate entries with keys greater than \a key.
+    ZTreeMapIterator upperBound(const K &key) const {
+        return _iterFrom(_position(key, true), Position());
+    }
+    //! Iterate entries with keys in [\a lower, \a upper).
+    ZTreeMapIterator range(const K &lower, const K &upper) const {
+        if(!(lower < upper))
+            return ZTreeMapIterator(nullptr, 0, nullptr, 0);
+        return _iterFrom(_position(lower, false), _position(upper, false));
+    }
+
+private:
+    //! Uninitialized storage for a separator key moving up the tree.
+    typedef typename std::aligned_storage<sizeof(K), alignof(K)>::type KeySlot;
+
+    struct Position {
+        Position(Leaf *l = nullptr, zu64 i = 0) : leaf(l), index(i){}
+        Leaf *leaf;
+        zu64 index;
+    };
+
+    //! Reads entries from sorted arrays for _bulkLoad().
+    struct SortedSource {
+        SortedSource(const ZArray<K> &k, const ZArray<T> &v) : keys(k), values(v), i(0){}
+        const K &key() const { return keys[i]; }
+        const T &value() const { return values[i]; }
+        void advance(){ ++i; }
+        const ZArray<K> &keys;
+        const ZArray<T> &values;
+        zu64 i;
+    };
+
+    //! Index of the first key in \a leaf not less than \a key.
+    static zu64 _lowerBound(Leaf *leaf, const K &key){
+        zu64 lo = 0, hi = leaf->count;
+        while(lo < hi){
+            zu64 mid = (lo + hi) / 2;
+            if(*leaf->key(mid) < key)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+    //! Index of the first key in \a leaf greater than \a key.
+    static zu64 _upperBound(Leaf *leaf, const K &key){
+        zu64 lo = 0, hi = leaf->count;
+        while(lo < hi){
+            zu64 mid = (lo + hi) / 2;
+            if(key < *leaf->key(mid))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        return lo;
+    }
+    //! Index of the child of \a inner that may contain \a key.
+    static zu64 _child(Inner *inner, const K &key){
+        zu64 lo = 0, hi = inner->count;
+        while(lo < hi){
+            zu64 mid = (lo + hi) / 2;
+            if(key < *inner->key(mid))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        return lo;
+    }
+
+    //! Find the leaf that may contain \a key.
+    Leaf *_findLeaf(const K &key) const {
+        Node *node = _root;
+        if(node == nullptr)
+            return nullptr;
+        while(!node->leaf){
+            Inner *inner = (Inner *)node;
+            node = inner->children[_child(inner, key)];
+        }
+        return (Leaf *)node;
+    }
+
+    //! Position of the first key not less than (or greater than, if \a upper) \a key.
+    Position _position(const K &key, bool upper) const {
+        Leaf *leaf = _findLeaf(key);
+        if(leaf == nullptr)
+            return Position();
+        return _normalize(Position(leaf, upper ? _upperBound(leaf, key) : _lowerBound(leaf, key)));
+    }
+    //! Move a position past the end of a leaf to the start of the next leaf.
+    static Position _normalize(Position pos){
+        if(pos.leaf != nullptr && pos.index >= pos.leaf->count)
+            return Position(pos.leaf->next, 0);
+        return pos;
+    }
+    static ZTreeMapIterator _iterFrom(Position start, Position end){
+        return ZTreeMapIterator(start.leaf, start.index, end.leaf, end.index);
+    }
+
+    /*! Find or make room for the entry with \a key.
+     *  If \a added, the returned value is unconstructed and must be constructed by the caller.
+     */
+    T *_insert(const K &key, bool &added){
+        if(_root == nullptr){
+            Leaf *leaf = _allocLeaf();
+            _root = leaf;
+            _head = leaf;
+            _tail = leaf;
+            _depth = 1;
+        }
+        KeySlot sep;
+        Node *right = nullptr;
+        T *val = _insert(_root, key, added, (K *)&sep, right);
+        if(right != nullptr){
+            // Root was split, grow the tree
+            Inner *root = _allocInner();
+            root->count = 1;
+            ZDefaultAllocator<K>::move((K *)&sep, root->key(0));
+            root->children[0] = _root;
+            root->children[1] = right;
+            _root = root;
+            ++_depth;
+        }
+        if(added)
+            ++_size;
+        return val;
+    }
+
+    /*! Insert \a key under \a node. If \a node is split, \a right is set to the new right node,
+     *  and the first key under it is constructed at \a sep.
+     */
+    T *_insert(Node *node, const K &key, bool &added, K *sep, Node *&right){
+        if(node->leaf){
+            Leaf *leaf = (Leaf *)node;
+            zu64 pos = _lowerBound(leaf, key);
+            if(pos < leaf->count && !(key < *leaf->key(pos))){
+                added = false;
+                return leaf->value(pos);
+            }
+            added = true;
+            if(leaf->count < LEAF_SIZE)
+                return _leafInsert(leaf, pos, key);
+
+            // Split the full leaf, move the upper half to a new leaf
+            Leaf *split = _allocLeaf();
+            const zu64 mid = (LEAF_SIZE + 1) / 2;
+            split->count = (zu32)(LEAF_SIZE - mid);
+            ZDefaultAllocator<K>::move(leaf->key(mid), split->key(0), split->count);
+            ZDefaultAllocator<T>::move(leaf->value(mid), split->value(0), split->count);
+            leaf->count = (zu32)mid;
+            split->prev = leaf;
+            split->next = leaf->next;
+            if(leaf->next)
+                leaf->next->prev = split;
+            else
+                _tail = split;
+            leaf->next = split;
+
+            T *val = (pos <= mid ? _leafInsert(leaf, pos, key) : _leafInsert(split, pos - mid, key));
+            ZDefaultAllocator<K>::construct(sep, *split->key(0));
+            right = split;
+            return val;
+        }
+
+        Inner *inner = (Inner *)node;
+        zu64 ci = _child(inner, key);
+        KeySlot childsep;
+        Node *childright = nullptr;
+        T *val = _insert(inner->children[ci], key, added, (K *)&childsep, childright);
+        if(childright == nullptr)
+            return val;
+
+        if(inner->count < INNER_SIZE){
+            _innerInsert(inner, ci, (K *)&childsep, childright);
+            return val;
+        }
+
+        // Split the full inner node, the middle key moves up
+        Inner *split = _allocInner();
+        const zu64 mid = INNER_SIZE / 2;
+        split->count = (zu32)(INNER_SIZE - mid - 1);
+        ZDefaultAllocator<K>::move(inner->key(mid + 1), split->key(0), split->count);
+        for(zu64 i = 0; i <= split->count; ++i)
+            split->children[i] = inner->children[mid + 1 + i];
+        ZDefaultAllocator<K>::move(inner->key(mid), sep);
+        inner->count = (zu32)mid;
+
+        if(ci <= mid)
+            _innerInsert(inner, ci, (K *)&childsep, childright);
+        else
+            _innerInsert(split, ci - mid - 1, (K *)&childsep, childright);
+        right = split;
+        return val;
+    }
+
+    //! Insert \a key at \a pos in a leaf with room, return the unconstructed value.
+    T *_leafInsert(Leaf *leaf, zu64 pos, const K &key){
+        ZDefaultAllocator<K>::move(leaf->key(pos), leaf->key(pos + 1), leaf->count - pos);
+        ZDefaultAllocator<T>::move(leaf->value(pos), leaf->value(pos + 1), leaf->count - pos);
+        ZDefaultAllocator<K>::construct(leaf->key(pos), key);
+        ++leaf->count;
+        return leaf->value(pos);
+    }
+
+    //! Move \a sep and insert the \a right child after child \a ci of an inner node with room.
+    static void _innerInsert(Inner *inner, zu64 ci, K *sep, Node *right){
+        ZDefaultAllocator<K>::move(inner->key(ci), inner->key(ci + 1), inner->count - ci);
+        for(zu64 i = inner->count + 1; i > ci + 1; --i)
+            inner->children[i] = inner->children[i - 1];
+        ZDefaultAllocator<K>::move(sep, inner->key(ci));
+        inner->children[ci + 1] = right;
+        ++inner->count;
+    }
+
+    //! Remove \a key under \a node, rebalancing children that become underfull.
+    bool _erase(Node *node, const K &key){
+        if(node->leaf){
+            Leaf *leaf = (Leaf *)node;
+            zu64 pos = _lowerBound(leaf, key);
+            if(pos >= leaf->count || key < *leaf->key(pos))
+                return false;
+            ZDefaultAllocator<K>::destroy(leaf->key(pos));
+            ZDefaultAllocator<T>::destroy(leaf->value(pos));
+            ZDefaultAllocator<K>::move(leaf->key(pos + 1), leaf->key(pos), leaf->count - pos - 1);
+            ZDefaultAllocator<T>::move(leaf->value(pos + 1), leaf->value(pos), leaf->count - pos - 1);
+            --leaf->count;
+            return true;
+        }
+
+        Inner *inner = (Inner *)node;
+        zu64 ci = _child(inner, key);
+        if(!_erase(inner->children[ci], key))
+            return false;
+        Node *child = inner->children[ci];
+        if(child->count < (child->leaf ? LEAF_SIZE / 2 : INNER_SIZE / 2))
+            _rebalance(inner, ci);
+        return true;
+    }
+
+    //! Refill underfull child \a ci of \a inner by borrowing from a sibling, or merging with one.
+    void _rebalance(Inner *inner, zu64 ci){
+        Node *child = inner->children[ci];
+        Node *left = (ci > 0 ? inner->children[ci - 1] : nullptr);
+        Node *right = (ci < inner->count ? inner->children[ci + 1] : nullptr);
+        const zu64 min = (child->leaf ? LEAF_SIZE / 2 : INNER_SIZE / 2);
+
+        if(child->leaf){
+            Leaf *leaf = (Leaf *)child;
+            if(left && left->count > min){
+                // Borrow the last entry of the left sibling
+                Leaf *from = (Leaf *)left;
+                _leafShift(leaf, 1);
+                ZDefaultAllocator<K>::move(from->key(from->count - 1), leaf->key(0));
+                ZDefaultAllocator<T>::move(from->value(from->count - 1), leaf->value(0));
+                --from->count;
+                *inner->key(ci - 1) = *leaf->key(0);
+            } else if(right && right->count > min){
+                // Borrow the first entry of the right sibling
+                Leaf *from = (Leaf *)right;
+                ZDefaultAllocator<K>::move(from->key(0), leaf->key(leaf->count));
+                ZDefaultAllocator<T>::move(from->value(0), leaf->value(leaf->count));
+                ++leaf->count;
+                ZDefaultAllocator<K>::move(from->key(1), from->key(0), from->count - 1);
+                ZDefaultAllocator<T>::move(from->value(1), from->value(0), from->count - 1);
+                --from->count;
+                *inner->key(ci) = *from->key(0);
+            } else if(right){
+                _mergeLeaves(inner, ci);
+            } else if(left){
+                _mergeLeaves(inner, ci - 1);
+            }
+        } else {
+            Inner *node = (Inner *)child;
+            if(left && left->count > min){
+                // Rotate through the parent from the left sibling
+                Inner *from = (Inner *)left;
+                ZDefaultAllocator<K>::move(node->key(0), node->key(1), node->count);
+                for(zu64 i = node->count + 1; i > 0; --i)
+                    node->children[i] = node->children[i - 1];
+                ZDefaultAllocator<K>::move(inner->key(ci - 1), node->key(0));
+                node->children[0] = from->children[from->count];
+                ++node->count;
+                ZDefaultAllocator<K>::move(from->key(from->count - 1), inner->key(ci - 1));
+                --from->count;
+            } else if(right && right->count > min){
+                // Rotate through the parent from the right sibling
+                Inner *from = (Inner *)right;
+                ZDefaultAllocator<K>::move(inner->key(ci), node->key(node->count));
+                node->children[node->count + 1] = from->children[0];
+                ++node->count;
+                ZDefaultAllocator<K>::move(from->key(0), inner->key(ci));
+                ZDefaultAllocator<K>::move(from->key(1), from->key(0), from->count - 1);
+                for(zu64 i = 0; i < from->count; ++i)
+                    from->children[i] = from->children[i + 1];
+                --from->count;
+            } else if(right){
+                _mergeInner(inner, ci);
+            } else if(left){
+                _mergeInner(inner, ci - 1);
+            }
+        }
+    }
+
+    //! Make room for \a n entries at the start of \a leaf.
+    static void _leafShift(Leaf *leaf, zu64 n){
+        ZDefaultAllocator<K>::move(leaf->key(0), leaf->key(n), leaf->count);
+        ZDefaultAllocator<T>::move(leaf->value(0), leaf->value(n), leaf->count);
+        leaf->count += (zu32)n;
+    }
+
+    //! Remove key \a i and child \a i + 1 from \a inner.
+    static void _innerRemove(Inner *inner, zu64 i){
+        ZDefaultAllocator<K>::destroy(inner->key(i));
+        ZDefaultAllocator<K>::move(inner->key(i + 1), inner->key(i), inner->count - i - 1);
+        for(zu64 j = i + 1; j < inner->count; ++j)
+            inner->children[j] = inner->children[j + 1];
+        --inner->count;
+    }
+
+    //! Merge leaf child \a i + 1 of \a inner into child \a i.
+    void _mergeLeaves(Inner *inner, zu64 i){
+        Leaf *leaf = (Leaf *)inner->children[i];
+        Leaf *from = (Leaf *)inner->children[i + 1];
+        ZDefaultAllocator<K>::move(from->key(0), leaf->key(leaf->count), from->count);
+        ZDefaultAllocator<T>::move(from->value(0), leaf->value(leaf->count), from->count);
+        leaf->count += from->count;
+        leaf->next = from->next;
+        if(from->next)
+            from->next->prev = leaf;
+        else
+            _tail = leaf;
+        _innerRemove(inner, i);
+        _deallocLeaf(from);
+    }
+
+    //! Merge inner child \a i + 1 of \a inner into child \a i, pulling down the separator.
+    void _mergeInner(Inner *inner, zu64 i){
+        Inner *node = (Inner *)inner->children[i];
+        Inner *from = (Inner *)inner->children[i + 1];
+        ZDefaultAllocator<K>::construct(node->key(node->count), *inner->key(i));
+        ZDefaultAllocator<K>::move(from->key(0), node->key(node->count + 1), from->count);
+        for(zu64 j = 0; j <= from->count; ++j)
+            node->children[node->count + 1 + j] = from->children[j];
+        node->count += from->count + 1;
+        _innerRemove(inner, i);
+        _deallocInner(from);
+    }
+
+    /*! Build the tree bottom-up from \a count ordered entries read from \a src.
+     *  Leaves are filled completely, except that the last two share their entries so neither is underfull.
+     */
+    template <typename S> void _bulkLoad(S src, zu64 count){
+        if(count == 0)
+            return;
+
+        // Fill the leaves, keeping the first key of each for the level above
+        ZArray<Node *> level;
+        ZArray<K> firsts;
+        zu64 left = count;
+        Leaf *prev = nullptr;
+        while(left > 0){
+            zu64 n = MIN(left, (zu64)LEAF_SIZE);
+            if(left > LEAF_SIZE && left - n < LEAF_SIZE / 2)
+                n = left - LEAF_SIZE / 2;
+            Leaf *leaf = _allocLeaf();
+            for(zu64 i = 0; i < n; ++i, src.advance()){
+                ZDefaultAllocator<K>::construct(leaf->key(i), src.key());
+                ZDefaultAllocator<T>::construct(leaf->value(i), src.value());
+            }
+            leaf->count = (zu32)n;
+            leaf->prev = prev;
+            if(prev)
+                prev->next = leaf;
+            else
+                _head = leaf;
+            prev = leaf;
+            level.push(leaf);
+            firsts.push(*leaf->key(0));
+            left -= n;
+        }
+        _tail = prev;
+        _size = count;
+        _depth = 1;
+
+        // Build inner levels until one node is left
+        while(level.size() > 1){
+            ZArray<Node *> parents;
+            ZArray<K> parentfirsts;
+            zu64 i = 0;
+            while(i < level.size()){
+                zu64 n = MIN(level.size() - i, (zu64)INNER_SIZE + 1);
+                if(level.size() - i > INNER_SIZE + 1 && level.size() - i - n < INNER_SIZE / 2 + 1)
+                    n = level.size() - i - (INNER_SIZE / 2 + 1);
+                Inner *inner = _allocInner();
+                inner->children[0] = level[i];
+                for(zu64 j = 1; j < n; ++j){
+                    ZDefaultAllocator<K>::construct(inner->key(j - 1), firsts[i + j]);
+                    inner->children[j] = level[i + j];
+                }
+                inner->count = (zu32)(n - 1);
+                parents.push(inner);
+                parentfirsts.push(firsts[i]);
+                i += n;
+            }
+            level = std::move(parents);
+            firsts = std::move(parentfirsts);
+            ++_depth;
+        }
+        _root = level[0];
+    }
+
+    //! Destroy \a node and everything under it.
+    void _destroy(Node *node){
+        if(node->leaf){
+            Leaf *leaf = (Leaf *)node;
+            ZDefaultAllocator<K>::destroy(leaf->key(0), leaf->count);
+            ZDefaultAllocator<T>::destroy(leaf->value(0), leaf->count);
+            _deallocLeaf(leaf);
+        } else {
+            Inner *inner = (Inner *)node;
+            for(zu64 i = 0; i <= inner->count; ++i)
+                _destroy(inner->children[i]);
+            ZDefaultAllocator<K>::destroy(inner->key(0), inner->count);
+            _deallocInner(inner);
+        }
+    }
+
+    static Leaf *_allocLeaf(){
+        Leaf *leaf = ZDefaultAllocator<Leaf>::alloc();
+        leaf->count = 0;
+        leaf->leaf = true;
+        leaf->prev = nullptr;
+        leaf->next = nullptr;
+        return leaf;
+    }
+    static Inner *_allocInner(){
+        Inner *inner = ZDefaultAllocator<Inner>::alloc();
+        inner->count = 0;
+        inner->leaf = false;
+        return inner;
+    }
+    static void _deallocLeaf(Leaf *leaf){ ZDefaultAllocator<Leaf>::dealloc(leaf); }
+    static void _deallocInner(Inner *inner){ ZDefaultAllocator<Inner>::dealloc(inner); }
+
+    template <typename V> static void _swap(V &a, V &b){
+        V tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+public:
+    class ZTreeMapIterator : public ZSimplexConstIterator<K> {
+    public:
+        ZTreeMapIterator(Leaf *leaf, zu64 index, Leaf *endleaf, zu64 endindex) :
+                _leaf(leaf), _index(index), _endleaf(endleaf), _endindex(endindex){}
+
+        const K &get() const {
+            return *_leaf->key(_index);
+        }
+        //! Get the value of the current entry.
+        const T &value() const {
+            return *_leaf->value(_index);
+        }
+
+        bool more() const {
+            return _leaf != nullptr && _leaf->count > 0 && !(_leaf == _endleaf && _index == _endindex);
+        }
+        void advance(){
+            if(++_index >= _leaf->count){
+                _leaf = _leaf->next;
+                _index = 0;
+            }
+        }
+
+    private:
+        Leaf *_leaf;
+        zu64 _index;
+        //! Position iteration stops at, null for the end of the map.
+        Leaf *_endleaf;
+        zu64 _endindex;
+    };
+
+private:
+    //! Reads entries from another map for _bulkLoad().
+    struct IterSource {
+        IterSource(const ZTreeMapIterator &i) : it(i){}
+        const K &key() const { return it.get(); }
+        const T &value() const { return it.value(); }
+        void advance(){ it.advance(); }
+        ZTreeMapIterator it;
+    };
+
+private:
+    Node *_root;
+    //! First leaf.
+    Leaf *_head;
+    //! Last leaf.
+    Leaf *_tail;
+    //! Number of entries.
+    zu64 _size;
+    //! Number of levels.
+    zu64 _depth;
+};
+
+}
+
+#endif // ZTREEMAP_H
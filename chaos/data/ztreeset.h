@@ -0,0 +1,95 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                                 ztreeset.h                                 **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZTREESET_H
+#define ZTREESET_H
+
+#include "ztreemap.h"
+
+namespace LibChaos {
+
+/*! Ordered set container, a ZTreeMap with no values.
+ *  Iterates in order.
+ *  Values must be ordered by \a operator<.
+ */
+template <typename T> class ZTreeSet {
+public:
+    typedef typename ZTreeMap<T, zbyte>::ZTreeMapIterator ZTreeSetIterator;
+
+public:
+    ZTreeSet(){}
+
+    ZTreeSet(std::initializer_list<T> list){
+        for(auto item = list.begin(); item < list.end(); ++item){
+            add(*item);
+        }
+    }
+
+    //! Add \a value to the set, if it is not already in the set.
+    void add(const T &value){
+        _map.get(value);
+    }
+    inline void push(const T &value){ add(value); }
+
+    //! Remove \a value from the set, if it is in the set.
+    void remove(const T &value){
+        _map.erase(value);
+    }
+
+    /*! Remove \a value from the set.
+     *  \return True if \a value was removed.
+     */
+    bool erase(const T &value){
+        return _map.erase(value);
+    }
+
+    //! Check if the set contains \a value.
+    bool contains(const T &value) const {
+        return _map.contains(value);
+    }
+
+    //! Remove all values.
+    void clear(){
+        _map.clear();
+    }
+
+    /*! Replace the contents of the set with \a values.
+     *  \throws Throws an exception if \a values is not strictly increasing.
+     */
+    void loadSorted(const ZArray<T> &values){
+        ZArray<zbyte> empty;
+        empty.resize(values.size(), 0);
+        _map.loadSorted(values, empty);
+    }
+
+    //! Get an array of the values in the set, in order.
+    ZArray<T> toArray() const {
+        return _map.keys();
+    }
+
+    //! Get the smallest value. \throws Throws an exception if the set is empty.
+    const T &first() const { return _map.first(); }
+    //! Get the largest value. \throws Throws an exception if the set is empty.
+    const T &last() const { return _map.last(); }
+
+    bool isEmpty() const { return _map.isEmpty(); }
+    zu64 size() const { return _map.size(); }
+
+    //! Iterate all values in order.
+    ZTreeSetIterator begin() const { return _map.begin(); }
+    //! Iterate values not less than \a value.
+    ZTreeSetIterator lowerBound(const T &value) const { return _map.lowerBound(value); }
+    //! Iterate values greater than \a value.
+    ZTreeSetIterator upperBound(const T &value) const { return _map.upperBound(value); }
+    //! Iterate values in [\a lower, \a upper).
+    ZTreeSetIterator range(const T &lower, const T &upper) const { return _map.range(lower, upper); }
+
+private:
+    ZTreeMap<T, zbyte> _map;
+};
+
+}
+
+#endif // ZTREESET_H
@@ -177,7 +177,8 @@ zbyte *ZBMP::convertBMPDatatoRGB(const zbyte *bmpbuffer, zu32 width, zu32 height
         return NULL;
 
     zu32 rowsize = (width * 3) + ((width * 3) % 4);
-    zbyte *rgbbuffer = new zbyte[width * height * 3];
+    // Owned by ZImage::takeData()
+    zbyte *rgbbuffer = (zbyte *)ZLargeAllocator::alloc(width * height * 3);
 
     zu64 bmppos = 0;
     zu64 rgbpos = 0;
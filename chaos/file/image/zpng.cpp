@@ -485,7 +485,8 @@ int readpng_get_image(PngReadData *data, double display_exponent){
     data->channels = png_get_channels(data->png_ptr, data->info_ptr);
 
     // Alloc image data
-    data->image_data = new unsigned char[rowbytes * data->height];
+    // Owned by ZImage::takeData()
+    data->image_data = (unsigned char *)ZLargeAllocator::alloc(rowbytes * data->height);
     if(!data->image_data){
         throw ZException("PNG Read: failed to alloc image data", ZPNG::PNGError::imageallocfail, false);
         return 3;
@@ -516,7 +517,7 @@ int readpng_get_image(PngReadData *data, double display_exponent){
 
 void readpng_cleanup(PngReadData *data){
     if(data->image_data){
-        delete[] data->image_data;
+        ZLargeAllocator::dealloc(data->image_data);
         data->image_data = nullptr;
     }
 
@@ -9,6 +9,7 @@
 #include "ztypes.h"
 #include "zexception.h"
 #include "zbinary.h"
+#include "zlargeallocator.h"
 #include <cstring>
 
 namespace LibChaos {
@@ -44,7 +45,7 @@ public:
     }
     ZBitmapT(zu64 width, zu64 height) : _width(width), _height(height), _buffer(nullptr){
         if(pixels()){
-            _buffer = new pixeltype[pixels()];
+            _buffer = (pixeltype *)ZLargeAllocator::alloc(bufferSize());
         }
     }
     ZBitmapT(const pixeltype *data, zu64 width, zu64 height) : ZBitmapT(width, height){
@@ -70,7 +71,7 @@ public:
             _width = width;
             _height = height;
             if(!_buffer){
-                _buffer = new pixeltype[pixels()];
+                _buffer = (pixeltype *)ZLargeAllocator::alloc(bufferSize());
             }
             if(_buffer && data)
                 memcpy(_buffer, data, bufferSize());
@@ -83,7 +84,7 @@ public:
 
     template <typename newtype>
     ZBitmapT<newtype> recast(int fill = 0) const {
-        newtype *buff = new newtype[pixels()];
+        newtype *buff = (newtype *)ZLargeAllocator::alloc(pixels() * sizeof(newtype));
         if(sizeof(newtype) > pixelSize())
             memset(buff, fill, pixels() * sizeof(newtype));
 
@@ -93,7 +94,7 @@ public:
         }
 
         ZBitmapT<newtype> out(buff, _width, _height);
-        delete[] buff;
+        ZLargeAllocator::dealloc(buff);
         return out;
     }
 
@@ -118,7 +119,7 @@ public:
     void clear(){
         _width = 0;
         _height = 0;
-        delete[] _buffer;
+        ZLargeAllocator::dealloc(_buffer);
         _buffer = nullptr;
     }
 
@@ -141,7 +142,7 @@ public:
             _width = width;
             return;
         }
-        pixeltype *tmp = new pixeltype[width * _height];
+        pixeltype *tmp = (pixeltype *)ZLargeAllocator::alloc(width * _height * pixelSize());
         if(tmp){
             if(width < _width){
                 // If new buffer smaller
@@ -170,7 +171,7 @@ public:
                 }
             }
         }
-        delete[] _buffer;
+        ZLargeAllocator::dealloc(_buffer);
         _buffer = tmp;
         _width = width;
     }
@@ -194,25 +195,12 @@ public:
             _height = height;
             return;
         }
-        pixeltype *tmp = new pixeltype[_width * height];
-        if(height < _height){
-            // If new buffer smaller
-
-            // Copy old data
-            if(_width && _height && _buffer && tmp)
-                memcpy(tmp, _buffer, _width * height * pixelSize());
-        } else if(height > _height){
-            // If new buffer larger
-
-            // Copy old data (if any)
-            if(_width && _height && _buffer && tmp)
-                memcpy(tmp, _buffer, bufferSize());
-
+        // Rows are contiguous, so the buffer is resized in place, moving pages instead of copying where possible
+        _buffer = (pixeltype *)ZLargeAllocator::realloc(_buffer, _width * height * pixelSize());
+        if(height > _height){
             // Zero new memory
-            memset((unsigned char *)tmp + (bufferSize()), 0, _width * (height - _height) * pixelSize());
+            memset((unsigned char *)_buffer + (bufferSize()), 0, _width * (height - _height) * pixelSize());
         }
-        delete[] _buffer;
-        _buffer = tmp;
         _height = height;
     }
 
@@ -86,22 +86,102 @@ int ZDatabase::Prepared::bind(ZString name, ZString value){
     return ret;
 }
 
+//! Get the table column type for the affinity of SQLite declared type \a decl, or false if it has no affinity.
+static bool affinityType(const char *decl, ZTable::ColumnType *type){
+    if(decl == NULL)
+        return false;
+    ZString upper = ZString::toUpper(decl);
+    auto contains = [&upper](const char *word){ return upper.findFirst(word) != ZString::NONE; };
+    if(contains("INT"))
+        *type = ZTable::INT64;
+    else if(contains("CHAR") || contains("CLOB") || contains("TEXT"))
+        *type = ZTable::STRING;
+    else if(upper.isEmpty() || contains("BLOB"))
+        return false;
+    else if(contains("REAL") || contains("FLOA") || contains("DOUB"))
+        *type = ZTable::DOUBLE;
+    else
+        *type = ZTable::INT64;  // Numeric affinity, promoted to DOUBLE if needed
+    return true;
+}
+
+//! Get the table column type that holds a value of SQLite fundamental type \a sqltype.
+static ZTable::ColumnType valueType(int sqltype){
+    switch(sqltype){
+        case SQLITE_INTEGER:
+            return ZTable::INT64;
+        case SQLITE_FLOAT:
+            return ZTable::DOUBLE;
+        case SQLITE_BLOB:
+            return ZTable::BLOB;
+        default:
+            return ZTable::STRING;
+    }
+}
+
 int ZDatabase::Prepared::execute(ZTable &result){
     // Step rows and get column values
     int rc;
+    ZArray<zu64> columns;
+    // Whether each column's type is settled by a declared type or a value
+    ZArray<bool> typed;
     while(true){
         rc = sqlite3_step(_stmt);
         if(rc != SQLITE_ROW)
             break;
-        int count = sqlite3_column_count(_stmt);
-        ZArray<ZString> record;
-        for(int i = 0; i < count; ++i){
-            const char *name = sqlite3_column_name(_stmt, i);
-            result.addColumn(name);
-            const unsigned char *text = sqlite3_column_text(_stmt, i);
-            record.push(text);
+        zu64 count = (zu64)sqlite3_column_count(_stmt);
+        if(columns.size() == 0){
+            // Type columns by their declared type, or by their first value
+            for(zu64 i = 0; i < count; ++i){
+                const char *name = sqlite3_column_name(_stmt, (int)i);
+                ZTable::ColumnType type = ZTable::STRING;
+                bool exists = result.columnIndex(name) != ZTable::NONE;
+                bool declared = affinityType(sqlite3_column_decltype(_stmt, (int)i), &type);
+                result.addColumn(name, type);
+                columns.push(result.columnIndex(name));
+                typed.push(exists || declared);
+            }
+        }
+        zu64 row = result.addRow();
+        for(zu64 i = 0; i < count; ++i){
+            int sqltype = sqlite3_column_type(_stmt, (int)i);
+            if(sqltype == SQLITE_NULL)
+                continue;
+            zu64 col = columns[i];
+            // SQLite values are dynamically typed, promote the column to hold this value
+            ZTable::ColumnType have = result.column(col).type();
+            ZTable::ColumnType need = valueType(sqltype);
+            if(!typed[i]){
+                result.setColumnType(col, need);
+                typed[i] = true;
+            } else if(have == ZTable::INT64 && need == ZTable::DOUBLE){
+                result.setColumnType(col, ZTable::DOUBLE);
+            } else if((have == ZTable::INT64 || have == ZTable::DOUBLE || have == ZTable::BOOL) &&
+                      (need == ZTable::STRING || need == ZTable::BLOB)){
+                result.setColumnType(col, ZTable::STRING);
+            }
+            switch(result.column(col).type()){
+                case ZTable::INT64:
+                    result.setInt(col, row, sqlite3_column_int64(_stmt, (int)i));
+                    break;
+                case ZTable::DOUBLE:
+                    result.setDouble(col, row, sqlite3_column_double(_stmt, (int)i));
+                    break;
+                case ZTable::BOOL:
+                    result.setBool(col, row, sqlite3_column_int64(_stmt, (int)i) != 0);
+                    break;
+                case ZTable::BLOB: {
+                    const void *blob = sqlite3_column_blob(_stmt, (int)i);
+                    result.setBlob(col, row, (const zbyte *)blob, (zu64)sqlite3_column_bytes(_stmt, (int)i));
+                    break;
+                }
+                default: {
+                    const unsigned char *text = sqlite3_column_text(_stmt, (int)i);
+                    result.setString(col, row, ZString((const char *)text, (zu64)sqlite3_column_bytes(_stmt, (int)i)));
+                    break;
+                }
+            }
         }
-        result.addRecord(record);
     }
     if(rc != SQLITE_DONE)
         return -3;
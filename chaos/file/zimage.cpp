@@ -58,7 +58,7 @@ ZImage::ZImage(const ZImage &other) : ZImage(other._buffer, other._width, other.
 }
 
 ZImage::~ZImage(){
-    delete[] _buffer;
+    ZLargeAllocator::dealloc(_buffer);
     _buffer = nullptr;
 }
 
@@ -67,7 +67,7 @@ void ZImage::destroy(){
     _height = 0;
     _channels = 0;
     _depth = 0;
-    delete[] _buffer;
+    ZLargeAllocator::dealloc(_buffer);
     _buffer = nullptr;
 }
 
@@ -101,27 +101,27 @@ void ZImage::setDimensions(zu64 width, zu64 height, zu8 channels, zu8 depth){
 void ZImage::newData(){
     if(validDimensions()){
         if(!_buffer)
-            _buffer = new byte[size()];
+            _buffer = (byte *)ZLargeAllocator::alloc(size());
     }
 }
 void ZImage::zeroData(){
     if(validDimensions()){
         if(!_buffer)
-            _buffer = new byte[size()];
+            _buffer = (byte *)ZLargeAllocator::alloc(size());
         memset(_buffer, 0, size());
     }
 }
 void ZImage::copyData(const byte *data){
     if(validDimensions()){
         if(!_buffer)
-            _buffer = new byte[size()];
+            _buffer = (byte *)ZLargeAllocator::alloc(size());
         memcpy(_buffer, data, size());
     }
 }
 void ZImage::takeData(byte *data){
     if(validDimensions()){
         if(_buffer)
-            delete[] _buffer;
+            ZLargeAllocator::dealloc(_buffer);
         // We totally trust the user here. Could go reeeaaalllyyy bad.
         _buffer = data;
     }
@@ -9,6 +9,7 @@
 #include "ztypes.h"
 #include "zarray.h"
 #include "zbinary.h"
+#include "zlargeallocator.h"
 #include "zmap.h"
 #include "yimagebackend.h"
 
@@ -140,6 +141,7 @@ public:
     //! Copies raw data of size() into buffer, buffer is allocated if necessary.
     void copyData(const byte *data);
     /*! Takes ownership of raw data.
+     *  \a data must be allocated with ZLargeAllocator::alloc().
      *  \warning Do not free memory passed to takeData().
      */
     void takeData(byte *data);
@@ -0,0 +1,254 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                             zmappedstorage.cpp                             **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#include "zmappedstorage.h"
+#include "zmemorystorage.h"
+#include "zlargeallocator.h"
+#include "zexception.h"
+
+#include <string.h>
+
+#if LIBCHAOS_PLATFORM == _PLATFORM_WINDOWS || LIBCHAOS_PLATFORM == _PLATFORM_CYGWIN
+    #define ZMAPPEDSTORAGE_WINAPI
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace LibChaos {
+
+//! Round \a size up to a multiple of the page size.
+static inline zu64 roundPages(zu64 size){
+    zu64 page = ZLargeAllocator::pageSize();
+    return (size + page - 1) / page * page;
+}
+
+ZMappedStorage::ZMappedStorage(ZPath path, bool readonly) : _path(path), _readonly(readonly), _size(0), _mapsize(0), _data(nullptr){
+#ifdef ZMAPPEDSTORAGE_WINAPI
+    _mapping = NULL;
+    _file = CreateFileW(path.str('\\').wstr().c_str(),
+                        GENERIC_READ | (readonly ? 0 : GENERIC_WRITE),
+                        FILE_SHARE_READ, NULL, (readonly ? OPEN_EXISTING : OPEN_ALWAYS), FILE_ATTRIBUTE_NORMAL, NULL);
+    if(_file == INVALID_HANDLE_VALUE)
+        throw ZException("ZMappedStorage: Failed to open " + path.str());
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(_file, &size)){
+        CloseHandle(_file);
+        throw ZException("ZMappedStorage: Failed to get size of " + path.str());
+    }
+    _size = (zu64)size.QuadPart;
+#else
+    _fd = ::open(path.str().cc(), (readonly ? O_RDONLY : O_RDWR | O_CREAT), 0644);
+    if(_fd < 0)
+        throw ZException("ZMappedStorage: Failed to open " + path.str());
+    struct stat st;
+    if(::fstat(_fd, &st) != 0){
+        ::close(_fd);
+        throw ZException("ZMappedStorage: Failed to get size of " + path.str());
+    }
+    _size = (zu64)st.st_size;
+#endif
+    if(_size){
+        try {
+            _map(roundPages(_size));
+        } catch(ZException &){
+#ifdef ZMAPPEDSTORAGE_WINAPI
+            CloseHandle(_file);
+#else
+            ::close(_fd);
+#endif
+            throw;
+        }
+    }
+}
+
+ZMappedStorage::~ZMappedStorage(){
+    _unmap();
+#ifdef ZMAPPEDSTORAGE_WINAPI
+    // The mapping may have extended the file
+    if(!_readonly)
+        _truncate(_size);
+    CloseHandle(_file);
+#else
+    ::close(_fd);
+#endif
+}
+
+void ZMappedStorage::copy(const ZStorage *other){
+    if(other == this)
+        return;
+    copyStorage(this, other);
+}
+
+void ZMappedStorage::copyToBlock(const zbyte *data, zu64 index, zu64 size){
+    _checkWrite("copyToBlock");
+    if(index + size > _size)
+        resize(index + size);
+    if(size)
+        ::memcpy(_data + index, data, size);
+}
+
+void ZMappedStorage::copyBlockTo(zu64 index, zu64 size, zbyte *data) const {
+    if(index + size > _size)
+        throw ZException("ZMappedStorage copyBlockTo: Block out of range");
+    if(size)
+        ::memcpy(data, _data + index, size);
+}
+
+ZStorage *ZMappedStorage::newCopy() const {
+    return new ZMemoryStorage(_data, _size);
+}
+
+zbyte ZMappedStorage::get(zu64 index) const {
+    return _data[index];
+}
+
+void ZMappedStorage::set(zu64 index, zbyte byte){
+    _data[index] = byte;
+}
+
+zbyte *ZMappedStorage::getBlock(zu64 index, zu64 size){
+    if(index + size > _size)
+        throw ZException("ZMappedStorage getBlock: Block out of range");
+    return _data + index;
+}
+
+void ZMappedStorage::freeBlock(zbyte *ptr){
+    // Blocks point into the mapping
+}
+
+void ZMappedStorage::commitBlock(zbyte *ptr){
+    // Changes in the mapping reach the file without a commit
+}
+
+bool ZMappedStorage::compare(const ZStorage *other) const {
+    return compareStorage(this, other);
+}
+
+void ZMappedStorage::resize(zu64 size){
+    _checkWrite("resize");
+    if(size > _mapsize){
+        // Grow the mapping geometrically, so appends rarely remap
+        zu64 mapsize = roundPages(MAX(size, _mapsize * 2));
+        const zu64 oldmapsize = _mapsize;
+#ifndef ZMAPPEDSTORAGE_WINAPI
+        // Extend the file while the old mapping is still in place, so a failure leaves it intact
+        if(!_truncate(size))
+            throw ZException("ZMappedStorage: Failed to resize " + _path.str());
+#endif
+        _unmap();
+        try {
+            _map(mapsize);
+        } catch(ZException &){
+            // Restore the old mapping, or leave the storage empty if that fails too
+#ifndef ZMAPPEDSTORAGE_WINAPI
+            _truncate(_size);
+#endif
+            try {
+                if(oldmapsize)
+                    _map(oldmapsize);
+            } catch(ZException &){
+            }
+            if(_data == nullptr)
+                _size = 0;
+            throw;
+        }
+    } else {
+#ifdef ZMAPPEDSTORAGE_WINAPI
+        // The file cannot be truncated while mapped, it is truncated when closed
+        if(size < _size)
+            ::memset(_data + size, 0, _size - size);
+#else
+        if(!_truncate(size))
+            throw ZException("ZMappedStorage: Failed to resize " + _path.str());
+#endif
+    }
+    _size = size;
+}
+
+void ZMappedStorage::clear(){
+    resize(0);
+}
+
+zu64 ZMappedStorage::size() const {
+    return _size;
+}
+
+zu16 ZMappedStorage::storageType() const {
+    return MAPPED;
+}
+
+const char *ZMappedStorage::storageTypeStr() const {
+    return "mapped";
+}
+
+bool ZMappedStorage::flush(){
+    if(_data == nullptr || _readonly)
+        return true;
+#ifdef ZMAPPEDSTORAGE_WINAPI
+    return FlushViewOfFile(_data, 0) != 0 && FlushFileBuffers(_file) != 0;
+#else
+    return ::msync(_data, _mapsize, MS_SYNC) == 0;
+#endif
+}
+
+void ZMappedStorage::_map(zu64 length){
+#ifdef ZMAPPEDSTORAGE_WINAPI
+    // Mapping past the end of the file extends it
+    _mapping = CreateFileMappingW(_file, NULL, (_readonly ? PAGE_READONLY : PAGE_READWRITE),
+                                  (DWORD)(length >> 32), (DWORD)(length & 0xFFFFFFFF), NULL);
+    if(_mapping == NULL)
+        throw ZException("ZMappedStorage: Failed to map " + _path.str());
+    _data = (zbyte *)MapViewOfFile(_mapping, (_readonly ? FILE_MAP_READ : FILE_MAP_WRITE), 0, 0, 0);
+    if(_data == NULL){
+        CloseHandle(_mapping);
+        _mapping = NULL;
+        throw ZException("ZMappedStorage: Failed to map " + _path.str());
+    }
+#else
+    // Pages past the end of the file are never touched
+    void *ptr = ::mmap(nullptr, length, PROT_READ | (_readonly ? 0 : PROT_WRITE), MAP_SHARED, _fd, 0);
+    if(ptr == MAP_FAILED)
+        throw ZException("ZMappedStorage: Failed to map " + _path.str());
+    _data = (zbyte *)ptr;
+#endif
+    _mapsize = length;
+}
+
+void ZMappedStorage::_unmap(){
+    if(_data == nullptr)
+        return;
+#ifdef ZMAPPEDSTORAGE_WINAPI
+    UnmapViewOfFile(_data);
+    CloseHandle(_mapping);
+    _mapping = NULL;
+#else
+    ::munmap(_data, _mapsize);
+#endif
+    _data = nullptr;
+    _mapsize = 0;
+}
+
+bool ZMappedStorage::_truncate(zu64 size){
+#ifdef ZMAPPEDSTORAGE_WINAPI
+    LARGE_INTEGER dist;
+    dist.QuadPart = (LONGLONG)size;
+    if(SetFilePointerEx(_file, dist, NULL, FILE_BEGIN) == 0)
+        return false;
+    return SetEndOfFile(_file) != 0;
+#else
+    return ::ftruncate(_fd, (off_t)size) == 0;
+#endif
+}
+
+void ZMappedStorage::_checkWrite(const char *op) const {
+    if(_readonly)
+        throw ZException(ZString("ZMappedStorage ") + op + ": Storage is read only");
+}
+
+}
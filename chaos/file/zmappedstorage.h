@@ -0,0 +1,92 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                              zmappedstorage.h                              **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZMAPPEDSTORAGE_H
+#define ZMAPPEDSTORAGE_H
+
+#include "zstorage.h"
+#include "zpath.h"
+
+namespace LibChaos {
+
+/*! ZStorage in a memory-mapped file.
+ *  The whole file is mapped, and the operating system pages it in and out, so files larger than memory
+ *  can be used as long as they fit in the address space. Blocks are pointers straight into the mapping,
+ *  and changes reach the file without commitBlock(). flush() waits for changes to be written.
+ *
+ *  The mapping is grown geometrically as the storage grows, so appending does not remap every time.
+ *  Growing or shrinking the storage invalidates pointers from getBlock().
+ *  \note Not thread safe.
+ */
+class ZMappedStorage : public ZStorage {
+public:
+    /*! Map the file at \a path, creating it if it does not exist.
+     *  If \a readonly, the file must exist and is never modified.
+     *  \throws ZException if the file cannot be opened or mapped.
+     */
+    ZMappedStorage(ZPath path, bool readonly = false);
+    ~ZMappedStorage();
+
+    ZMappedStorage(const ZMappedStorage &) = delete;
+    ZMappedStorage &operator=(const ZMappedStorage &) = delete;
+
+    void copy(const ZStorage *other) override;
+    void copyToBlock(const zbyte *data, zu64 index, zu64 size) override;
+    void copyBlockTo(zu64 index, zu64 size, zbyte *data) const override;
+    //! Get a ZMemoryStorage with a copy of the file.
+    ZStorage *newCopy() const override;
+
+    zbyte get(zu64 index) const override;
+    void set(zu64 index, zbyte byte) override;
+
+    zbyte *getBlock(zu64 index, zu64 size) override;
+    void freeBlock(zbyte *ptr) override;
+    void commitBlock(zbyte *ptr) override;
+
+    bool compare(const ZStorage *other) const override;
+
+    //! Resize the file. New bytes are zero. \throws ZException if the file cannot be resized or remapped.
+    void resize(zu64 size) override;
+    void clear() override;
+    zu64 size() const override;
+
+    zu16 storageType() const override;
+    const char *storageTypeStr() const override;
+
+    //! Write changes in the mapping to the file, and wait for them to finish.
+    bool flush();
+
+    //! Get the mapped bytes. Invalidated by resize().
+    zbyte *raw(){ return _data; }
+    const zbyte *raw() const { return _data; }
+
+    const ZPath &path() const { return _path; }
+    bool isReadOnly() const { return _readonly; }
+
+private:
+    void _map(zu64 length);
+    void _unmap();
+    bool _truncate(zu64 size);
+    void _checkWrite(const char *op) const;
+
+private:
+    ZPath _path;
+    bool _readonly;
+    //! Size of the storage.
+    zu64 _size;
+    //! Length of the mapping, at least the size.
+    zu64 _mapsize;
+    zbyte *_data;
+#if LIBCHAOS_PLATFORM == _PLATFORM_WINDOWS || LIBCHAOS_PLATFORM == _PLATFORM_CYGWIN
+    void *_file;
+    void *_mapping;
+#else
+    int _fd;
+#endif
+};
+
+}
+
+#endif // ZMAPPEDSTORAGE_H
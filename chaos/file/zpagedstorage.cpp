@@ -0,0 +1,257 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                             zpagedstorage.cpp                              **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#include "zpagedstorage.h"
+#include "zmemorystorage.h"
+#include "zexception.h"
+
+#include <string.h>
+
+namespace LibChaos {
+
+ZPagedStorage::ZPagedStorage(ZPath path, zu64 pagesize, zu64 maxpages) :
+        _pagesize(pagesize ? pagesize : 1), _maxpages(maxpages ? maxpages : 1),
+        _size(0), _filesize(0), _hand(0), _reads(0), _writes(0){
+    if(!_file.open(path, ZFile::READWRITE))
+        throw ZException("ZPagedStorage: Failed to open " + path.str());
+    _filesize = _file.fileSize();
+    _size = _filesize;
+}
+
+ZPagedStorage::~ZPagedStorage(){
+    flush();
+    for(zu64 i = 0; i < _blocks.size(); ++i){
+        if(_blocks[i].frame == NONE)
+            delete[] _blocks[i].ptr;
+    }
+    for(zu64 i = 0; i < _frames.size(); ++i)
+        delete[] _frames[i].data;
+}
+
+void ZPagedStorage::copy(const ZStorage *other){
+    if(other == this)
+        return;
+    copyStorage(this, other);
+}
+
+void ZPagedStorage::copyToBlock(const zbyte *data, zu64 index, zu64 size){
+    if(index + size > _size)
+        resize(index + size);
+    while(size){
+        zu64 offset = index % _pagesize;
+        zu64 len = MIN(size, _pagesize - offset);
+        Frame &frame = _frames[_frame(index / _pagesize)];
+        ::memcpy(frame.data + offset, data, len);
+        frame.dirty = true;
+        data += len;
+        index += len;
+        size -= len;
+    }
+}
+
+void ZPagedStorage::copyBlockTo(zu64 index, zu64 size, zbyte *data) const {
+    if(index + size > _size)
+        throw ZException("ZPagedStorage copyBlockTo: Block out of range");
+    while(size){
+        zu64 offset = index % _pagesize;
+        zu64 len = MIN(size, _pagesize - offset);
+        ::memcpy(data, _frames[_frame(index / _pagesize)].data + offset, len);
+        data += len;
+        index += len;
+        size -= len;
+    }
+}
+
+ZStorage *ZPagedStorage::newCopy() const {
+    ZMemoryStorage *copy = new ZMemoryStorage;
+    copy->resize(_size);
+    copyBlockTo(0, _size, copy->raw());
+    return copy;
+}
+
+zbyte ZPagedStorage::get(zu64 index) const {
+    return _frames[_frame(index / _pagesize)].data[index % _pagesize];
+}
+
+void ZPagedStorage::set(zu64 index, zbyte byte){
+    Frame &frame = _frames[_frame(index / _pagesize)];
+    frame.data[index % _pagesize] = byte;
+    frame.dirty = true;
+}
+
+zbyte *ZPagedStorage::getBlock(zu64 index, zu64 size){
+    if(index + size > _size)
+        throw ZException("ZPagedStorage getBlock: Block out of range");
+    Block block = { nullptr, index, size, NONE };
+    if(index % _pagesize + size <= _pagesize){
+        // Point into the page and pin it
+        block.frame = _frame(index / _pagesize);
+        ++_frames[block.frame].pins;
+        block.ptr = _frames[block.frame].data + index % _pagesize;
+    } else {
+        block.ptr = new zbyte[size];
+        copyBlockTo(index, size, block.ptr);
+    }
+    _blocks.push(block);
+    return block.ptr;
+}
+
+void ZPagedStorage::freeBlock(zbyte *ptr){
+    zu64 i = _findBlock(ptr);
+    if(_blocks[i].frame == NONE)
+        delete[] _blocks[i].ptr;
+    else
+        --_frames[_blocks[i].frame].pins;
+    _blocks.erase(i);
+}
+
+void ZPagedStorage::commitBlock(zbyte *ptr){
+    const Block &block = _blocks[_findBlock(ptr)];
+    if(block.frame == NONE)
+        copyToBlock(block.ptr, block.index, block.size);
+    else
+        _frames[block.frame].dirty = true;
+}
+
+bool ZPagedStorage::compare(const ZStorage *other) const {
+    return compareStorage(this, other);
+}
+
+void ZPagedStorage::resize(zu64 size){
+    if(size < _size){
+        // Zero cached bytes past the new size, so growing again reads zeros
+        for(zu64 i = 0; i < _frames.size(); ++i){
+            Frame &frame = _frames[i];
+            zu64 start = frame.page * _pagesize;
+            if(start >= size){
+                ::memset(frame.data, 0, _pagesize);
+                frame.dirty = false;
+            } else if(start + _pagesize > size){
+                ::memset(frame.data + (size - start), 0, start + _pagesize - size);
+            }
+        }
+        if(size < _filesize){
+            if(!_file.resizeFile(size))
+                throw ZException("ZPagedStorage: Failed to resize file");
+            _filesize = size;
+        }
+    }
+    _size = size;
+}
+
+void ZPagedStorage::clear(){
+    resize(0);
+}
+
+zu64 ZPagedStorage::size() const {
+    return _size;
+}
+
+zu16 ZPagedStorage::storageType() const {
+    return PAGED;
+}
+
+const char *ZPagedStorage::storageTypeStr() const {
+    return "paged";
+}
+
+bool ZPagedStorage::flush(){
+    bool ok = true;
+    for(zu64 i = 0; i < _frames.size(); ++i){
+        if(_frames[i].dirty)
+            ok = _writeBack(_frames[i]) && ok;
+    }
+    // Extend the file to the full size
+    if(_filesize < _size){
+        if(_file.resizeFile(_size))
+            _filesize = _size;
+        else
+            ok = false;
+    }
+    return ok;
+}
+
+zu64 ZPagedStorage::_frame(zu64 page) const {
+    const zu64 *found = _pages.find(page);
+    if(found != nullptr){
+        _frames[*found].referenced = true;
+        return *found;
+    }
+
+    zu64 index;
+    if(_frames.size() < _maxpages){
+        Frame frame = { page, new zbyte[_pagesize], 0, false, true };
+        index = _frames.size();
+        _frames.push(frame);
+    } else {
+        index = _victim();
+        Frame &frame = _frames[index];
+        if(frame.dirty && !_writeBack(frame))
+            throw ZException("ZPagedStorage: Failed to write page");
+        _pages.remove(frame.page);
+        frame.page = page;
+        frame.dirty = false;
+        frame.referenced = true;
+    }
+
+    // Read the page, bytes past the end of the file are zero
+    Frame &frame = _frames[index];
+    zu64 start = page * _pagesize;
+    zu64 len = 0;
+    if(start < _filesize){
+        zu64 want = MIN(_pagesize, _filesize - start);
+        _file.seek(start);
+        len = _file.read(frame.data, want);
+        if(len != want)
+            throw ZException("ZPagedStorage: Failed to read page");
+        ++_reads;
+    }
+    if(len < _pagesize)
+        ::memset(frame.data + len, 0, _pagesize - len);
+    _pages.add(page, index);
+    return index;
+}
+
+zu64 ZPagedStorage::_victim() const {
+    // Two sweeps clear every reference bit, so an unpinned frame is found if there is one
+    for(zu64 i = 0; i < 2 * _frames.size(); ++i){
+        Frame &frame = _frames[_hand];
+        zu64 index = _hand;
+        _hand = (_hand + 1) % _frames.size();
+        if(frame.pins)
+            continue;
+        if(frame.referenced){
+            frame.referenced = false;
+            continue;
+        }
+        return index;
+    }
+    throw ZException("ZPagedStorage: All pages are pinned");
+}
+
+bool ZPagedStorage::_writeBack(Frame &frame) const {
+    zu64 start = frame.page * _pagesize;
+    if(start < _size){
+        zu64 len = MIN(_pagesize, _size - start);
+        _file.seek(start);
+        if(_file.write(frame.data, len) != len)
+            return false;
+        _filesize = MAX(_filesize, start + len);
+        ++_writes;
+    }
+    frame.dirty = false;
+    return true;
+}
+
+zu64 ZPagedStorage::_findBlock(const zbyte *ptr) const {
+    // Most recent first, the same range may be fetched more than once
+    for(zu64 i = _blocks.size(); i > 0; --i){
+        if(_blocks[i - 1].ptr == ptr)
+            return i - 1;
+    }
+    throw ZException("ZPagedStorage: Not a block from getBlock()");
+}
+
+}
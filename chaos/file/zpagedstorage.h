@@ -0,0 +1,126 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                              zpagedstorage.h                               **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZPAGEDSTORAGE_H
+#define ZPAGEDSTORAGE_H
+
+#include "zstorage.h"
+#include "zfile.h"
+#include "zmap.h"
+#include "zarray.h"
+
+#define ZPAGEDSTORAGE_PAGE_SIZE     (64 * 1024)
+#define ZPAGEDSTORAGE_MAX_PAGES     256
+
+namespace LibChaos {
+
+/*! ZStorage in a file, accessed through a fixed-size cache of pages.
+ *  At most \a maxpages pages of \a pagesize bytes are held in memory, so memory use is bounded
+ *  no matter how large the file is, and the address space is not used like ZMappedStorage.
+ *  Pages are replaced with the clock algorithm. Changed pages are written back when they are replaced,
+ *  on flush(), and when the storage is destroyed.
+ *
+ *  Blocks from getBlock() that fit in one page point into the cached page, which is pinned until freeBlock().
+ *  Blocks that span pages are copied into a temporary buffer, and written back by commitBlock().
+ *  Changes through a block are only kept after commitBlock().
+ *  \note Not thread safe.
+ */
+class ZPagedStorage : public ZStorage {
+public:
+    /*! Open the file at \a path, creating it if it does not exist, with a cache of \a maxpages pages of \a pagesize bytes.
+     *  \throws ZException if the file cannot be opened.
+     */
+    ZPagedStorage(ZPath path, zu64 pagesize = ZPAGEDSTORAGE_PAGE_SIZE, zu64 maxpages = ZPAGEDSTORAGE_MAX_PAGES);
+    ~ZPagedStorage();
+
+    ZPagedStorage(const ZPagedStorage &) = delete;
+    ZPagedStorage &operator=(const ZPagedStorage &) = delete;
+
+    void copy(const ZStorage *other) override;
+    void copyToBlock(const zbyte *data, zu64 index, zu64 size) override;
+    void copyBlockTo(zu64 index, zu64 size, zbyte *data) const override;
+    //! Get a ZMemoryStorage with a copy of the file.
+    ZStorage *newCopy() const override;
+
+    zbyte get(zu64 index) const override;
+    void set(zu64 index, zbyte byte) override;
+
+    zbyte *getBlock(zu64 index, zu64 size) override;
+    void freeBlock(zbyte *ptr) override;
+    void commitBlock(zbyte *ptr) override;
+
+    bool compare(const ZStorage *other) const override;
+
+    //! New bytes are zero.
+    void resize(zu64 size) override;
+    void clear() override;
+    zu64 size() const override;
+
+    zu16 storageType() const override;
+    const char *storageTypeStr() const override;
+
+    //! Write changed pages to the file.
+    bool flush();
+
+    zu64 pageSize() const { return _pagesize; }
+    zu64 maxPages() const { return _maxpages; }
+    //! Number of pages in the cache.
+    zu64 cachedPages() const { return _pages.size(); }
+    //! Number of pages read from the file.
+    zu64 pageReads() const { return _reads; }
+    //! Number of pages written to the file.
+    zu64 pageWrites() const { return _writes; }
+
+private:
+    struct Frame {
+        //! Page held in the frame.
+        zu64 page;
+        zbyte *data;
+        //! Number of blocks pointing into the frame.
+        zu64 pins;
+        bool dirty;
+        //! Used since the clock hand last passed.
+        bool referenced;
+    };
+
+    struct Block {
+        zbyte *ptr;
+        zu64 index;
+        zu64 size;
+        //! Frame the block points into, NONE for a temporary buffer.
+        zu64 frame;
+    };
+
+    enum { NONE = ZU64_MAX };
+
+    //! Get the frame holding \a page, reading it into the cache if needed.
+    zu64 _frame(zu64 page) const;
+    //! Pick an unpinned frame to replace.
+    zu64 _victim() const;
+    bool _writeBack(Frame &frame) const;
+    zu64 _findBlock(const zbyte *ptr) const;
+
+private:
+    mutable ZFile _file;
+    zu64 _pagesize;
+    zu64 _maxpages;
+    //! Size of the storage.
+    zu64 _size;
+    //! Size of the file, bytes past it read as zero.
+    mutable zu64 _filesize;
+    //! Reading pages changes the cache, even for const access.
+    mutable ZArray<Frame> _frames;
+    //! Map of cached pages to frames.
+    mutable ZMap<zu64, zu64> _pages;
+    //! Clock hand, next frame to consider for replacement.
+    mutable zu64 _hand;
+    ZArray<Block> _blocks;
+    mutable zu64 _reads;
+    mutable zu64 _writes;
+};
+
+}
+
+#endif // ZPAGEDSTORAGE_H
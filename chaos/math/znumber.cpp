@@ -9,13 +9,13 @@
 
 namespace LibChaos {
 
-ZNumber::ZNumber() : _alloc(new ZAllocator<datatype>), _sign(false), _data(nullptr), _size(0){
+ZNumber::ZNumber() : _sign(false), _data(nullptr), _size(0){
 
 }
 
 ZNumber::ZNumber(zu64 num) : ZNumber(){
     _size = sizeof(zu64) / sizeof(datatype);
-    _data = _alloc->alloc(_size);
+    _data = _alloc.alloc(_size);
     for(zu8 i = 0; i < _size; ++i){
         _data[i] = (datatype)(num >> ((sizeof(datatype) * 8) * i));
     }
@@ -24,7 +24,7 @@ ZNumber::ZNumber(zu64 num) : ZNumber(){
 ZNumber::ZNumber(zs64 num) : ZNumber(){
     _size = sizeof(zu64) / sizeof(datatype);
     _sign = num < 0;
-    _data = _alloc->alloc(_size);
+    _data = _alloc.alloc(_size);
     for(zu8 i = 0; i < _size; ++i){
         _data[i] = (datatype)(num >> ((sizeof(datatype) * 8) * i));
     }
@@ -37,8 +37,8 @@ ZNumber::ZNumber(ZString str) : ZNumber(){
 ZNumber::ZNumber(const ZNumber &other) : ZNumber(){
     if(other._size > 0){
         _size = other._size;
-        _data = new datatype[_size];
-        memcpy(_data, other._data, other._size);
+        _data = _alloc.alloc(_size);
+        _alloc.rawcopy(other._data, _data, _size);
         //_sign = other._sign;
     }
 }
@@ -55,8 +55,8 @@ ZNumber &ZNumber::operator=(const ZNumber &other){
     clear();
     if(other._size > 0){
         _size = other._size;
-        _data = _alloc->alloc(_size);
-        _alloc->copy(other._data, _data, _size);
+        _data = _alloc.alloc(_size);
+        _alloc.copy(other._data, _data, _size);
         _sign = other._sign;
     }
     return *this;
@@ -150,7 +150,7 @@ ZNumber &ZNumber::operator--(){
 void ZNumber::clear(){
     _sign = true;
     _size = 0;
-    _alloc->dealloc(_data);
+    _alloc.dealloc(_data);
     _data = nullptr;
 }
 
@@ -229,9 +229,9 @@ bool ZNumber::isNegative() const {
 
 void ZNumber::pad(zu64 num){
     datatype *tmp = _data;
-    _data = _alloc->alloc(_size + num);
-    _alloc->copy(tmp, _data, _size);
-    _alloc->dealloc(tmp);
+    _data = _alloc.alloc(_size + num);
+    _alloc.copy(tmp, _data, _size);
+    _alloc.dealloc(tmp);
     for(zu64 i = _size; i < _size + num; ++i){
         _data[i] = 0;
     }
@@ -206,7 +206,7 @@ private:
     void clean();
 
 private:
-    ZAllocator<datatype> *_alloc;
+    ZAllocatorHandle<datatype> _alloc;
     bool _sign;
     datatype *_data;
     zu64 _size;
@@ -9,6 +9,7 @@
 #include "ztypes.h"
 #include "zbinary.h"
 #include "zstring.h"
+#include "zstringview.h"
 
 #include <type_traits>
 
@@ -325,6 +326,20 @@ ZHASH_USER_SPECIALIAZATION(ZBinary, (const ZBinary &bin), (bin.raw(), bin.size()
 // ZString specialization ZHash
 ZHASH_USER_SPECIALIAZATION(ZString, (const ZString &str), (str.bytes(), str.size()), {})
 
+// ZStringView specialization ZHash, hashes the same as the equal ZString
+ZHASH_USER_SPECIALIAZATION(ZStringView, (const ZStringView &str), ((const zbyte *)str.data(), str.size()), {})
+
+/*! Trait for types that can be used to look up keys of type \a K without constructing a \a K.
+ *  Must be specialized for each pair. A \a Q is converted to \a type for the lookup.
+ *  A \a type must compare equal to a \a K with \a operator==, and ZHash<type> must give the same hash as ZHash<K> for equal values.
+ */
+template <typename K, typename Q> struct ZHashEquivalent { enum { value = false }; };
+//! Strings can be looked up by view, or raw bytes through a view.
+template <> struct ZHashEquivalent<ZString, ZStringView> { enum { value = true }; typedef ZStringView type; };
+//! Strings can be looked up by C string.
+template <> struct ZHashEquivalent<ZString, const char *> { enum { value = true }; typedef ZStringView type; };
+template <> struct ZHashEquivalent<ZString, char *> { enum { value = true }; typedef ZStringView type; };
+
 }
 
 #endif // ZHASH
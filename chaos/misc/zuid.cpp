@@ -181,15 +181,15 @@ ZUID::ZUID(ZString str){
     }
 }
 
-int ZUID::compare(const ZUID &uid){
+int ZUID::compare(const ZUID &uid) const {
     return ::memcmp(_id_octets, uid._id_octets, ZUID_SIZE);
 }
 
-bool ZUID::operator==(const ZUID &uid){
+bool ZUID::operator==(const ZUID &uid) const {
     return compare(uid) == 0;
 }
 
-bool ZUID::operator<(const ZUID &uid){
+bool ZUID::operator<(const ZUID &uid) const {
     return compare(uid) < 0;
 }
 
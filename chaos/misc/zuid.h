@@ -47,13 +47,13 @@ public:
     ZUID(ZString str);
 
     //! Compare two ZUIDs, -1, 0 or 1.
-    int compare(const ZUID &uid);
+    int compare(const ZUID &uid) const;
 
     //! Compare UUIDs.
-    bool operator==(const ZUID &uid);
+    bool operator==(const ZUID &uid) const;
 
     //! Algebraic comparison for ZUID trees.
-    bool operator<(const ZUID &uid);
+    bool operator<(const ZUID &uid) const;
 
     //! Read 16 bytes into this UUID.
     ZUID &fromRaw(zbyte *bytes);
@@ -5,27 +5,49 @@
 *******************************************************************************/
 #include "zjson.h"
 #include "zlog.h"
+#include "znumberformat.h"
 
 #include <string>
 #include <cmath>
-#include <stdexcept>
 #include <assert.h>
 
 //#define ZJSON_DEBUG
 
 namespace LibChaos {
 
-ZJSON::ZJSON(jsontype type) : _type(UNDEF){
+ZJSON::ZJSON(jsontype type) : _type(UNDEF), _arena(nullptr){
     initType(type);
 }
 
-ZJSON::ZJSON(const ZJSON &other) : _type(UNDEF){
+ZJSON::ZJSON(const ZJSON &other) : _type(UNDEF), _arena(nullptr){
     operator=(other);
 }
 
+ZJSON::ZJSON(ZJSON &&other) : _type(other._type), _arena(other._arena){
+    // Take the value of other directly, other keeps an empty value
+    switch(_type){
+        case OBJECT:
+            new (&_data.object) ZMap<ZString, ZJSON>(std::move(other._data.object));
+            break;
+        case ARRAY:
+            new (&_data.array) ZArray<ZJSON>(std::move(other._data.array));
+            break;
+        case STRING:
+            new (&_data.string) ZString(std::move(other._data.string));
+            break;
+        case NUMBER:
+            _data.number = other._data.number;
+            break;
+        case BOOLEAN:
+            _data.boolean = other._data.boolean;
+            break;
+        default:
+            break;
+    }
+}
+
 ZJSON::~ZJSON(){
-    // BUG: ZJSON memory leak
-    //initType(UNDEF);
+    initType(UNDEF);
 }
 
 ZJSON &ZJSON::operator=(const ZJSON &other){
@@ -52,65 +74,35 @@ ZJSON &ZJSON::operator=(const ZJSON &other){
     return *this;
 }
 
-ZString ZJSON::encode(bool readable){
-    ZString tmp;
-    switch(_type){
+ZJSON &ZJSON::operator=(ZJSON &&other){
+    initType(other._type);
+    switch(other._type){
         case OBJECT:
-            if(_data.object.size()){
-                tmp = "{";
-                if(readable) tmp += " ";
-                bool first = true;
-                for(auto i = _data.object.begin(); i.more(); i.advance()){
-                    if(!first){
-                        tmp += (readable ? ", " : ",");
-                    }
-                    first = false;
-                    tmp += (ZString("\"") + i.get() + "\"");
-                    if(readable) tmp += " ";
-                    tmp += ":";
-                    if(readable) tmp += " ";
-                    tmp += _data.object[i.get()].encode(readable);
-                }
-                if(readable) tmp += " ";
-                tmp += "}";
-            } else {
-                return "{}";
-            }
+            _data.object = std::move(other._data.object);
             break;
         case ARRAY:
-            if(_data.array.size()){
-                tmp = "[";
-                if(readable) tmp += " ";
-                bool first = true;
-                for(zu64 i = 0; i < _data.array.size(); ++i){
-                    if(!first){
-                        tmp += (readable ? ", " : ",");
-                    }
-                    first = false;
-                    tmp += _data.array[i].encode(readable);
-                }
-                if(readable) tmp += " ";
-                tmp += "]";
-            } else {
-                return "[]";
-            }
+            _data.array = std::move(other._data.array);
             break;
         case STRING:
-            return ZString("\"") + jsonEscape(_data.string) + "\"";
+            _data.string = std::move(other._data.string);
             break;
         case NUMBER:
-            return _data.number;
+            _data.number = other._data.number;
             break;
         case BOOLEAN:
-            return (_data.boolean ? "true" : "false");
-            break;
-        case NULLVAL:
-            return "null";
+            _data.boolean = other._data.boolean;
             break;
         default:
             break;
     }
-    return tmp;
+    return *this;
+}
+
+ZString ZJSON::encode(bool readable){
+    // Encode the whole tree into one buffer
+    ZStringBuilder out;
+    jsonEncode(out, readable);
+    return out.take();
 }
 
 bool isWhitespace(char ch){
@@ -125,6 +117,12 @@ bool ZJSON::isValid(){
     return (_type != UNDEF);
 }
 
+bool ZJSON::decode(const ZString &str, ZArena *arena){
+    initType(UNDEF);
+    _arena = arena;
+    return decode(str);
+}
+
 bool ZJSON::decode(const ZString &str){
     zsize position = 0;
     JsonError err;
@@ -201,13 +199,14 @@ void ZJSON::initType(ZJSON::jsontype type){
     // Construct new value
     switch(_type){
         case OBJECT:
-            new (&_data.object) ZMap<ZString, ZJSON>;
+            new (&_data.object) ZMap<ZString, ZJSON>(ZMAP_DEFAULT_LOAD_FACTOR,
+                    (_arena ? _arena->allocator<ZMap<ZString, ZJSON>::MapElement>() : nullptr));
             break;
         case ARRAY:
-            new (&_data.array) ZArray<ZJSON>;
+            new (&_data.array) ZArray<ZJSON>(_arena ? _arena->allocator<ZJSON>() : nullptr);
             break;
         case STRING:
-            new (&_data.string) ZString;
+            new (&_data.string) ZString(_arena ? _arena->allocator<ZString::codeunit>() : nullptr);
             break;
         case NUMBER:
             _data.number = 0.0f;
@@ -220,30 +219,101 @@ void ZJSON::initType(ZJSON::jsontype type){
     }
 }
 
-ZString ZJSON::jsonEscape(ZString str){
-    str.replace("\\", "\\\\");
-    str.replace("\"", "\\\"");
-    str.replace("\b", "\\b");
-    str.replace("\f", "\\f");
-    str.replace("\n", "\\n");
-    str.replace("\r", "\\r");
-    str.replace("\t", "\\t");
-    return str;
+void ZJSON::jsonEncode(ZStringBuilder &out, bool readable){
+    switch(_type){
+        case OBJECT:
+            if(_data.object.size()){
+                out.append(readable ? "{ " : "{");
+                bool first = true;
+                for(auto i = _data.object.begin(); i.more(); i.advance()){
+                    if(!first){
+                        out.append(readable ? ", " : ",");
+                    }
+                    first = false;
+                    out.append('"').append(i.get()).append('"');
+                    out.append(readable ? " : " : ":");
+                    _data.object[i.get()].jsonEncode(out, readable);
+                }
+                out.append(readable ? " }" : "}");
+            } else {
+                out.append("{}");
+            }
+            break;
+        case ARRAY:
+            if(_data.array.size()){
+                out.append(readable ? "[ " : "[");
+                for(zu64 i = 0; i < _data.array.size(); ++i){
+                    if(i){
+                        out.append(readable ? ", " : ",");
+                    }
+                    _data.array[i].jsonEncode(out, readable);
+                }
+                out.append(readable ? " ]" : "]");
+            } else {
+                out.append("[]");
+            }
+            break;
+        case STRING:
+            out.append('"');
+            jsonEscape(out, _data.string);
+            out.append('"');
+            break;
+        case NUMBER:
+            out.append(_data.number);
+            break;
+        case BOOLEAN:
+            out.append(_data.boolean ? "true" : "false");
+            break;
+        case NULLVAL:
+            out.append("null");
+            break;
+        default:
+            break;
+    }
+}
+
+void ZJSON::jsonEscape(ZStringBuilder &out, const ZString &str){
+    // Copy runs of plain characters, escaping in the same pass
+    const char *data = str.cc();
+    zu64 start = 0;
+    for(zu64 i = 0; i < str.size(); ++i){
+        char esc;
+        switch(data[i]){
+            case '\\': esc = '\\'; break;
+            case '"':  esc = '"'; break;
+            case '\b': esc = 'b'; break;
+            case '\f': esc = 'f'; break;
+            case '\n': esc = 'n'; break;
+            case '\r': esc = 'r'; break;
+            case '\t': esc = 't'; break;
+            default: continue;
+        }
+        out.append(ZStringView(data + start, i - start));
+        out.append('\\').append(esc);
+        start = i + 1;
+    }
+    out.append(ZStringView(data + start, str.size() - start));
 }
 
 bool ZJSON::jsonDecode(const ZString &str, zsize *position, JsonError *err){
-    // Check if JSON is special value
-    ZString tstr = ZString::substr(str, *position);
-    tstr.strip(' ');
-    if(tstr == "true"){
+    // Check if JSON is special value, without copying the rest of the string
+    zsize sbeg = *position;
+    zsize send = str.size();
+    while(sbeg < send && str[sbeg] == ' ')
+        ++sbeg;
+    while(send > sbeg && str[send - 1] == ' ')
+        --send;
+    const char *tstr = str.cc() + sbeg;
+    zsize tlen = send - sbeg;
+    if(tlen == 4 && memcmp(tstr, "true", 4) == 0){
         initType(BOOLEAN);
         _data.boolean = true;
         return true;
-    } else if(tstr == "false"){
+    } else if(tlen == 5 && memcmp(tstr, "false", 5) == 0){
         initType(BOOLEAN);
         _data.boolean = false;
         return true;
-    } else if(tstr == "null"){
+    } else if(tlen == 4 && memcmp(tstr, "null", 4) == 0){
         initType(NULLVAL);
         return true;
     }
@@ -263,6 +333,8 @@ bool ZJSON::jsonDecode(const ZString &str, zsize *position, JsonError *err){
 
     ZString kbuff;
     ZString vbuff;
+    // Start of a number value
+    zsize nstart = 0;
 
 #ifdef ZJSON_DEBUG
     ZMap<location, ZString> descs = {
@@ -306,10 +378,10 @@ bool ZJSON::jsonDecode(const ZString &str, zsize *position, JsonError *err){
                 } else if(c == '"'){
                     initType(STRING);
                     loc = strv;
-                } else if(isDigit(c)){
+                } else if(isDigit(c) || c == '-'){
                     initType(NUMBER);
                     loc = num;
-                    vbuff = c;
+                    nstart = i;
                 } else {
                     err->pos = i;
                     err->desc = ZString("unexpected character '") + c + "'";
@@ -360,17 +432,18 @@ bool ZJSON::jsonDecode(const ZString &str, zsize *position, JsonError *err){
                     break;
                 } else {
                     ZJSON json;
+                    json._arena = _arena;
                     if(!json.jsonDecode(str, &i, err)){
                         return false;
                     }
                     //--i;
                     if(_type == OBJECT){
                         //DLOG("add to object: " << json.encode());
-                        _data.object.add(kbuff, json);
+                        _data.object.add(kbuff, std::move(json));
                         kbuff.clear();
                     } else if(_type == ARRAY){
                         //DLOG("add to array: " << json.encode());
-                        _data.array.push(json);
+                        _data.array.push(std::move(json));
                     } else {
                         assert(false);
                         err->pos = i;
@@ -398,18 +471,15 @@ bool ZJSON::jsonDecode(const ZString &str, zsize *position, JsonError *err){
             // Number
             case num:
                 if(c == ',' || c == '}' || c == ']' || isWhitespace(c)){
-                    try {
-                        _data.number = std::stod(vbuff.str());
-                    } catch(const std::logic_error &e){
+                    // Parse the number in place, JSON has no inf or nan
+                    if(ZNumberFormat::parseDouble(str.cc() + nstart, i - nstart, &_data.number, true) != i - nstart){
                         err->pos = i;
-                        err->desc = ZString("invalid number: ") + e.what();
+                        err->desc = ZString("invalid number: ") + ZString(str.cc() + nstart, i - nstart);
                         return false;
                     }
                     *position = i-1;
                     status = true;
                     break;
-                } else {
-                    vbuff += c;
                 }
                 break;
 
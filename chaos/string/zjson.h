@@ -7,7 +7,9 @@
 #define ZJSON_H
 
 #include "zstring.h"
+#include "zstringbuilder.h"
 #include "zmap.h"
+#include "zarena.h"
 
 namespace LibChaos {
 
@@ -48,18 +50,26 @@ public:
 
     //! Copy constructor.
     ZJSON(const ZJSON &other);
+    //! Move constructor.
+    ZJSON(ZJSON &&other);
 
     //! Destructor.
     ~ZJSON();
 
     //! Assignment operator.
     ZJSON &operator=(const ZJSON &other);
+    //! Move assignment operator. \a other keeps its type, with an unspecified value.
+    ZJSON &operator=(ZJSON &&other);
 
     //! Encode JSON string.
     ZString encode(bool readable = false);
 
     //! Decode JSON string.
     bool decode(const ZString &str);
+    /*! Decode JSON string, allocating the decoded objects, arrays and strings from \a arena.
+     *  The arena must outlive this object and every value moved out of it.
+     */
+    bool decode(const ZString &str, ZArena *arena);
 
     bool isValid();
 
@@ -94,12 +104,15 @@ public:
 
 private:
     void initType(jsontype type);
-    ZString jsonEscape(ZString str);
+    void jsonEncode(ZStringBuilder &out, bool readable);
+    static void jsonEscape(ZStringBuilder &out, const ZString &str);
     bool jsonDecode(const ZString &str, zsize *position, JsonError *err);
 
 private:
     //! JSON type.
     jsontype _type;
+    //! Arena for decoded values, null for the default allocator.
+    ZArena *_arena;
 
     //! Decoded JSON data.
 #if LIBCHAOS_COMPILER == _COMPILER_MSVC
@@ -0,0 +1,143 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                             zmultisearcher.cpp                             **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#include "zmultisearcher.h"
+#include "zexception.h"
+
+#define ZMULTISEARCHER_NONE ZU32_MAX
+
+namespace LibChaos {
+
+ZMultiSearcher::ZMultiSearcher(const ZArray<ZString> &patterns) : _patterns(patterns), _classes(1){
+    // Bytes that appear in patterns get their own classes, all other bytes are class 0
+    for(zu64 i = 0; i < 256; ++i)
+        _class[i] = 0;
+    for(zu64 p = 0; p < _patterns.size() && _classes <= 256; ++p){
+        const zbyte *bytes = _patterns[p].bytes();
+        for(zu64 i = 0; i < _patterns[p].size() && _classes <= 256; ++i){
+            if(_class[bytes[i]] == 0 && _classes++ < 256)
+                _class[bytes[i]] = (zbyte)(_classes - 1);
+        }
+    }
+    // All 256 byte values in patterns would need 257 classes, use the bytes themselves
+    if(_classes > 256){
+        for(zu64 i = 0; i < 256; ++i)
+            _class[i] = (zbyte)i;
+        _classes = 256;
+    }
+
+    // Build the trie
+    _next.resize(_classes, ZMULTISEARCHER_NONE);
+    _fail.push(0);
+    _depth.push(0);
+    _out.push(ZMULTISEARCHER_NONE);
+    for(zu64 p = 0; p < _patterns.size(); ++p){
+        const zbyte *bytes = _patterns[p].bytes();
+        zu32 state = 0;
+        for(zu64 i = 0; i < _patterns[p].size(); ++i){
+            zu64 slot = (zu64)state * _classes + _class[bytes[i]];
+            if(_next[slot] == ZMULTISEARCHER_NONE){
+                if(_fail.size() >= ZMULTISEARCHER_NONE)
+                    throw ZException("ZMultiSearcher: Too many states");
+                _next[slot] = (zu32)_fail.size();
+                _next.resize(_next.size() + _classes, ZMULTISEARCHER_NONE);
+                _fail.push(0);
+                _depth.push(_depth[state] + 1);
+                _out.push(ZMULTISEARCHER_NONE);
+            }
+            state = _next[slot];
+        }
+        _pstate.push(state);
+        if(state != 0 && _out[state] == ZMULTISEARCHER_NONE)
+            _out[state] = (zu32)p;
+    }
+
+    // Breadth first, set failure links and fill missing transitions from the failure state
+    ZArray<zu32> queue;
+    for(zu64 c = 0; c < _classes; ++c){
+        zu32 child = _next[c];
+        if(child == ZMULTISEARCHER_NONE){
+            _next[c] = 0;
+        } else {
+            _fail[child] = 0;
+            queue.push(child);
+        }
+    }
+    for(zu64 q = 0; q < queue.size(); ++q){
+        zu32 state = queue[q];
+        zu32 fail = _fail[state];
+        // A state's own pattern is longer than any from its failure state
+        if(_out[state] == ZMULTISEARCHER_NONE)
+            _out[state] = _out[fail];
+        for(zu64 c = 0; c < _classes; ++c){
+            zu64 slot = (zu64)state * _classes + c;
+            zu32 child = _next[slot];
+            if(child == ZMULTISEARCHER_NONE){
+                _next[slot] = _next[(zu64)fail * _classes + c];
+            } else {
+                _fail[child] = _next[(zu64)fail * _classes + c];
+                queue.push(child);
+            }
+        }
+    }
+}
+
+ZArray<ZMultiSearcher::Match> ZMultiSearcher::findAll(const zbyte *data, zu64 size) const {
+    ZArray<Match> matches;
+    zu32 state = 0;
+    for(zu64 i = 0; i < size; ++i){
+        state = _step(state, data[i]);
+        // Follow the chain of shorter patterns ending here
+        for(zu32 p = _out[state]; p != ZMULTISEARCHER_NONE; p = _out[_fail[_pstate[p]]]){
+            Match match = { i + 1 - _patterns[p].size(), p };
+            matches.push(match);
+        }
+    }
+    return matches;
+}
+
+ZArray<ZMultiSearcher::Match> ZMultiSearcher::findLeftmost(const zbyte *data, zu64 size, zu64 max) const {
+    ZArray<Match> matches;
+    Match pending = { NONE, NONE };
+    zu32 state = 0;
+    zu64 i = 0;
+    while(i < size){
+        state = _step(state, data[i]);
+        ++i;
+        zu32 p = _out[state];
+        if(p != ZMULTISEARCHER_NONE){
+            // The longest pattern ending here starts first
+            zu64 start = i - _patterns[p].size();
+            if(start < pending.pos || (start == pending.pos && _patterns[p].size() > _patterns[pending.pattern].size())){
+                pending.pos = start;
+                pending.pattern = p;
+            }
+        }
+        // Keep the pending match once no later match can start at or before it, or the input ends
+        if(pending.pos != NONE && (i - _depth[state] > pending.pos || i == size)){
+            matches.push(pending);
+            if(max && matches.size() >= max)
+                return matches;
+            // Scan again from the end of the match
+            i = pending.pos + _patterns[pending.pattern].size();
+            state = 0;
+            pending.pos = NONE;
+            pending.pattern = NONE;
+        }
+    }
+    return matches;
+}
+
+bool ZMultiSearcher::containsAny(const zbyte *data, zu64 size) const {
+    zu32 state = 0;
+    for(zu64 i = 0; i < size; ++i){
+        state = _step(state, data[i]);
+        if(_out[state] != ZMULTISEARCHER_NONE)
+            return true;
+    }
+    return false;
+}
+
+}
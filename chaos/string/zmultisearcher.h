@@ -0,0 +1,97 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                              zmultisearcher.h                              **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZMULTISEARCHER_H
+#define ZMULTISEARCHER_H
+
+#include "ztypes.h"
+#include "zarray.h"
+#include "zstring.h"
+#include "zstringview.h"
+
+namespace LibChaos {
+
+/*! Multi-pattern search engine, an Aho-Corasick automaton over bytes.
+ *  \ingroup String
+ *  Finds occurrences of any number of patterns in one pass over the data, independent of the number of patterns.
+ *  The automaton is compiled to a table with one transition per state and byte class,
+ *  where bytes that do not appear in any pattern share one class, so each byte of input is one table lookup.
+ *
+ *  Used by ZString::replaceAll(). Compile once to search or replace the same patterns many times.
+ */
+class ZMultiSearcher {
+public:
+    enum { NONE = ZU64_MAX };
+
+    //! One occurrence of a pattern.
+    struct Match {
+        //! Index of the first byte of the occurrence.
+        zu64 pos;
+        //! Index of the pattern.
+        zu64 pattern;
+    };
+
+public:
+    /*! Compile \a patterns. Empty patterns never match.
+     *  If a pattern is repeated, only its first index is reported.
+     */
+    ZMultiSearcher(const ZArray<ZString> &patterns);
+
+    /*! Find all occurrences of the patterns in \a size bytes at \a data, including overlapping occurrences.
+     *  Ordered by the end of the occurrence, then longest first.
+     */
+    ZArray<Match> findAll(const zbyte *data, zu64 size) const;
+    ZArray<Match> findAll(ZStringView str) const {
+        return findAll((const zbyte *)str.data(), str.size());
+    }
+
+    /*! Find non-overlapping occurrences of the patterns in \a size bytes at \a data, scanning from the start.
+     *  Where occurrences overlap, the one that starts first is chosen, and the longest of those.
+     *  Finds at most \a max occurrences, zero for unlimited.
+     */
+    ZArray<Match> findLeftmost(const zbyte *data, zu64 size, zu64 max = 0) const;
+    ZArray<Match> findLeftmost(ZStringView str, zu64 max = 0) const {
+        return findLeftmost((const zbyte *)str.data(), str.size(), max);
+    }
+
+    //! Check if any pattern occurs in \a size bytes at \a data.
+    bool containsAny(const zbyte *data, zu64 size) const;
+    bool containsAny(ZStringView str) const {
+        return containsAny((const zbyte *)str.data(), str.size());
+    }
+
+    //! Number of patterns.
+    zu64 patternCount() const { return _patterns.size(); }
+    //! Get pattern \a index.
+    const ZString &pattern(zu64 index) const { return _patterns[index]; }
+    //! Number of automaton states.
+    zu64 stateCount() const { return _fail.size(); }
+
+private:
+    inline zu32 _step(zu32 state, zbyte byte) const {
+        return _next[(zu64)state * _classes + _class[byte]];
+    }
+
+private:
+    ZArray<ZString> _patterns;
+    //! Byte class of each byte.
+    zbyte _class[256];
+    //! Number of byte classes.
+    zu64 _classes;
+    //! Transition for each state and byte class.
+    ZArray<zu32> _next;
+    //! Failure link of each state, the longest proper suffix that is also a state.
+    ZArray<zu32> _fail;
+    //! Length of the input each state matches.
+    ZArray<zu32> _depth;
+    //! Longest pattern that ends at each state, ZU32_MAX for none.
+    ZArray<zu32> _out;
+    //! State each pattern ends at.
+    ZArray<zu32> _pstate;
+};
+
+}
+
+#endif // ZMULTISEARCHER_H
@@ -0,0 +1,524 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                              znumberformat.cpp                             **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#include "znumberformat.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+namespace LibChaos {
+
+//! Decimal digit pairs "00" to "99".
+static const char digitPairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+//! Powers of ten that fit in 64 bits.
+static const zu64 pow10u[20] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+    10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+    1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL,
+    10000000000000000000ULL,
+};
+
+//! Powers of ten that are exact doubles.
+static const double pow10d[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+//! Number of decimal digits in \a value.
+static inline zu64 decimalDigits(zu64 value){
+    zu64 n = 1;
+    while(n < 20 && value >= pow10u[n])
+        ++n;
+    return n;
+}
+
+//! Write the \a count decimal digits of \a value ending at \a end, two at a time.
+static inline void writeDigits(zu64 value, char *end){
+    while(value >= 100){
+        end -= 2;
+        memcpy(end, digitPairs + (value % 100) * 2, 2);
+        value /= 100;
+    }
+    if(value >= 10){
+        end -= 2;
+        memcpy(end, digitPairs + value * 2, 2);
+    } else {
+        *--end = (char)('0' + value);
+    }
+}
+
+zu64 ZNumberFormat::formatUint(zu64 value, char *buffer){
+    const zu64 len = decimalDigits(value);
+    writeDigits(value, buffer + len);
+    return len;
+}
+
+zu64 ZNumberFormat::formatSint(zs64 value, char *buffer){
+    if(value < 0){
+        buffer[0] = '-';
+        // Negate as unsigned, so ZS64_MIN does not overflow
+        return 1 + formatUint(0 - (zu64)value, buffer + 1);
+    }
+    return formatUint((zu64)value, buffer);
+}
+
+zu64 ZNumberFormat::formatUint(zu64 value, zu8 base, char *buffer, bool upper){
+    if(base == 10)
+        return formatUint(value, buffer);
+    if(base < 2 || base > 16)
+        return 0;
+    const char *digits = (upper ? "0123456789ABCDEF" : "0123456789abcdef");
+    char tmp[64];
+    char *end = tmp + sizeof(tmp);
+    char *ptr = end;
+    if((base & (base - 1)) == 0){
+        // Powers of two by shifting
+        const zu8 shift = (base == 2 ? 1 : base == 4 ? 2 : base == 8 ? 3 : 4);
+        do {
+            *--ptr = digits[value & (base - 1)];
+            value >>= shift;
+        } while(value);
+    } else {
+        do {
+            *--ptr = digits[value % base];
+            value /= base;
+        } while(value);
+    }
+    const zu64 len = (zu64)(end - ptr);
+    memcpy(buffer, ptr, len);
+    return len;
+}
+
+// /////////////////////////////////////////////////////////////////////////////
+// Grisu2, after Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with Integers"
+// /////////////////////////////////////////////////////////////////////////////
+
+//! Significand and binary exponent, f * 2^e.
+struct DiyFp {
+    zu64 f;
+    int e;
+};
+
+//! Product of \a a and \a b, rounded to the upper 64 bits.
+static inline DiyFp diyMul(DiyFp a, DiyFp b){
+    const zu64 M32 = 0xFFFFFFFFULL;
+    const zu64 ah = a.f >> 32, al = a.f & M32;
+    const zu64 bh = b.f >> 32, bl = b.f & M32;
+    const zu64 hh = ah * bh, hl = ah * bl, lh = al * bh, ll = al * bl;
+    zu64 mid = (ll >> 32) + (hl & M32) + (lh & M32);
+    mid += 1ULL << 31;
+    DiyFp r = { hh + (hl >> 32) + (lh >> 32) + (mid >> 32), a.e + b.e + 64 };
+    return r;
+}
+
+//! Shift \a x left until its top bit is set.
+static inline DiyFp diyNormalize(DiyFp x){
+    while(!(x.f & (1ULL << 63))){
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+//! Normalized powers of ten 10^(-348 + 8i), significands.
+static const zu64 cachedPowerF[87] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL, 0xcf42894a5dce35eaULL,
+    0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL, 0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL,
+    0xbe5691ef416bd60cULL, 0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL, 0xc21094364dfb5637ULL,
+    0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL, 0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL,
+    0xb23867fb2a35b28eULL, 0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL, 0xb5b5ada8aaff80b8ULL,
+    0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL, 0x964e858c91ba2655ULL, 0xdff9772470297ebdULL,
+    0xa6dfbd9fb8e5b88fULL, 0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL, 0xaa242499697392d3ULL,
+    0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL, 0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL,
+    0x9c40000000000000ULL, 0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL, 0x9f4f2726179a2245ULL,
+    0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL, 0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL,
+    0x924d692ca61be758ULL, 0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL, 0x952ab45cfa97a0b3ULL,
+    0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL, 0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL,
+    0x88fcf317f22241e2ULL, 0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL, 0x8bab8eefb6409c1aULL,
+    0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL, 0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL,
+    0x80444b5e7aa7cf85ULL, 0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+};
+
+//! Normalized powers of ten 10^(-348 + 8i), binary exponents.
+static const zs16 cachedPowerE[87] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066
+};
+
+//! Get a cached power of ten c = 10^-k such that the binary exponent of c times a number with binary exponent \a e is in [-60, -32].
+static inline DiyFp cachedPower(int e, int *k){
+    const double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int ik = (int)dk;
+    if(dk - ik > 0.0)
+        ++ik;
+    const unsigned index = (unsigned)((ik >> 3) + 1);
+    *k = -(-348 + (int)(index << 3));
+    DiyFp c = { cachedPowerF[index], cachedPowerE[index] };
+    return c;
+}
+
+//! Move the last digit down while that brings it closer to the exact value and stays in range.
+static inline void grisuRound(char *buffer, int len, zu64 delta, zu64 rest, zu64 tenkappa, zu64 wpw){
+    while(rest < wpw && delta - rest >= tenkappa && (rest + tenkappa < wpw || wpw - rest > rest + tenkappa - wpw)){
+        buffer[len - 1]--;
+        rest += tenkappa;
+    }
+}
+
+//! Generate the shortest digits of \a w in range of \a mp and \a delta.
+static void digitGen(DiyFp w, DiyFp mp, zu64 delta, char *buffer, int *len, int *k){
+    const DiyFp one = { 1ULL << -mp.e, mp.e };
+    const zu64 wpw = mp.f - w.f;
+    zu32 p1 = (zu32)(mp.f >> -one.e);
+    zu64 p2 = mp.f & (one.f - 1);
+    int kappa = (int)decimalDigits(p1);
+    *len = 0;
+
+    // Integer part
+    while(kappa > 0){
+        const zu32 div = (zu32)pow10u[kappa - 1];
+        const zu32 d = p1 / div;
+        p1 %= div;
+        if(d || *len)
+            buffer[(*len)++] = (char)('0' + d);
+        kappa--;
+        const zu64 rest = ((zu64)p1 << -one.e) + p2;
+        if(rest <= delta){
+            *k += kappa;
+            grisuRound(buffer, *len, delta, rest, pow10u[kappa] << -one.e, wpw);
+            return;
+        }
+    }
+
+    // Fractional part
+    for(;;){
+        p2 *= 10;
+        delta *= 10;
+        const char d = (char)(p2 >> -one.e);
+        if(d || *len)
+            buffer[(*len)++] = (char)('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+        if(p2 < delta){
+            *k += kappa;
+            const int index = -kappa;
+            grisuRound(buffer, *len, delta, p2, one.f, wpw * (index < 20 ? pow10u[index] : 0));
+            return;
+        }
+    }
+}
+
+//! Get the shortest digits of positive finite \a value, where value = digits * 10^k.
+static void grisu2(double value, char *buffer, int *len, int *k){
+    zu64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const int bexp = (int)((bits >> 52) & 0x7FF);
+    const zu64 frac = bits & 0x000FFFFFFFFFFFFFULL;
+    DiyFp v;
+    if(bexp){
+        v.f = frac | 0x0010000000000000ULL;
+        v.e = bexp - 1075;
+    } else {
+        v.f = frac;
+        v.e = -1074;
+    }
+
+    // Boundaries halfway to the neighboring doubles
+    DiyFp plus = { (v.f << 1) + 1, v.e - 1 };
+    while(!(plus.f & (0x0010000000000000ULL << 1))){
+        plus.f <<= 1;
+        plus.e--;
+    }
+    plus.f <<= 10;
+    plus.e -= 10;
+    // The lower boundary is closer when the significand is a power of two
+    DiyFp minus = (v.f == 0x0010000000000000ULL) ? DiyFp{ (v.f << 2) - 1, v.e - 2 } : DiyFp{ (v.f << 1) - 1, v.e - 1 };
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    const DiyFp c = cachedPower(plus.e, k);
+    const DiyFp w = diyMul(diyNormalize(v), c);
+    DiyFp wp = diyMul(plus, c);
+    DiyFp wm = diyMul(minus, c);
+    wm.f++;
+    wp.f--;
+    digitGen(w, wp, wp.f - wm.f, buffer, len, k);
+}
+
+zu64 ZNumberFormat::formatDouble(double value, char *buffer){
+    char *out = buffer;
+    if(value != value){
+        memcpy(out, "nan", 3);
+        return 3;
+    }
+    if(signbit(value)){
+        *out++ = '-';
+        value = -value;
+    }
+    if(value == 0){
+        *out++ = '0';
+        return (zu64)(out - buffer);
+    }
+    if(isinf(value)){
+        memcpy(out, "inf", 3);
+        return (zu64)(out - buffer) + 3;
+    }
+
+    char digits[20];
+    int len;
+    int k;
+    grisu2(value, digits, &len, &k);
+    // Decimal exponent of the first digit
+    const int exp = len + k - 1;
+
+    if(exp >= 0 && exp < 21){
+        if(k >= 0){
+            // Integer, pad with zeros
+            memcpy(out, digits, (size_t)len);
+            memset(out + len, '0', (size_t)k);
+            out += len + k;
+        } else {
+            // Decimal point inside the digits
+            memcpy(out, digits, (size_t)(exp + 1));
+            out[exp + 1] = '.';
+            memcpy(out + exp + 2, digits + exp + 1, (size_t)(len - exp - 1));
+            out += len + 1;
+        }
+    } else if(exp < 0 && exp >= -6){
+        // Leading zeros after the decimal point
+        out[0] = '0';
+        out[1] = '.';
+        memset(out + 2, '0', (size_t)(-exp - 1));
+        memcpy(out + 1 - exp, digits, (size_t)len);
+        out += 1 - exp + len;
+    } else {
+        // Exponent notation
+        *out++ = digits[0];
+        if(len > 1){
+            *out++ = '.';
+            memcpy(out, digits + 1, (size_t)(len - 1));
+            out += len - 1;
+        }
+        *out++ = 'e';
+        *out++ = (exp < 0 ? '-' : '+');
+        out += formatUint((zu64)(exp < 0 ? -exp : exp), out);
+    }
+    return (zu64)(out - buffer);
+}
+
+// /////////////////////////////////////////////////////////////////////////////
+// Parsing
+// /////////////////////////////////////////////////////////////////////////////
+
+//! Get the value of digit \a ch, or 0xFF if \a ch is not a digit up to base 16.
+static inline zu8 digitValue(char ch){
+    if(ch >= '0' && ch <= '9')
+        return (zu8)(ch - '0');
+    if(ch >= 'a' && ch <= 'f')
+        return (zu8)(ch - 'a' + 10);
+    if(ch >= 'A' && ch <= 'F')
+        return (zu8)(ch - 'A' + 10);
+    return 0xFF;
+}
+
+//! Read eight characters at \a str as a little-endian word.
+static inline zu64 readWord(const char *str){
+    const zbyte *b = (const zbyte *)str;
+    return (zu64)b[0] | (zu64)b[1] << 8 | (zu64)b[2] << 16 | (zu64)b[3] << 24 |
+           (zu64)b[4] << 32 | (zu64)b[5] << 40 | (zu64)b[6] << 48 | (zu64)b[7] << 56;
+}
+
+//! Check if all eight characters in \a word are decimal digits.
+static inline bool isEightDigits(zu64 word){
+    return ((word & 0xF0F0F0F0F0F0F0F0ULL) | (((word + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL;
+}
+
+//! Get the value of eight decimal digits in \a word.
+static inline zu32 eightDigits(zu64 word){
+    word -= 0x3030303030303030ULL;
+    word = (word * 10) + (word >> 8);
+    word = (((word & 0x000000FF000000FFULL) * 0x000F424000000064ULL) + (((word >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL)) >> 32;
+    return (zu32)word;
+}
+
+zu64 ZNumberFormat::parseUint(const char *str, zu64 size, zu64 *value, zu8 base){
+    zu64 out = 0;
+    zu64 i = 0;
+    if(base < 2 || base > 16){
+        *value = 0;
+        return 0;
+    }
+    if(base == 10){
+        // Eight digits at a time, while that cannot overflow
+        while(i + 8 <= size && out < 100000000000ULL){
+            const zu64 word = readWord(str + i);
+            if(!isEightDigits(word))
+                break;
+            out = out * 100000000ULL + eightDigits(word);
+            i += 8;
+        }
+    }
+    bool overflow = false;
+    for(; i < size; ++i){
+        const zu64 digit = digitValue(str[i]);
+        if(digit >= base)
+            break;
+        if(overflow || out > (ZU64_MAX - digit) / base)
+            overflow = true;
+        else
+            out = out * base + digit;
+    }
+    *value = (overflow ? ZU64_MAX : out);
+    return i;
+}
+
+//! Check if \a size characters at \a str start with lowercase \a word.
+static inline bool startsWithWord(const char *str, zu64 size, const char *word, zu64 len){
+    if(size < len)
+        return false;
+    for(zu64 i = 0; i < len; ++i){
+        if((str[i] | 0x20) != word[i])
+            return false;
+    }
+    return true;
+}
+
+zu64 ZNumberFormat::parseDouble(const char *str, zu64 size, double *value, bool strict){
+    zu64 i = 0;
+    bool neg = false;
+    if(i < size && (str[i] == '-' || str[i] == '+')){
+        neg = (str[i] == '-');
+        ++i;
+    }
+
+    // Special values, strict parsing only takes digits
+    if(!strict){
+        if(startsWithWord(str + i, size - i, "infinity", 8) || startsWithWord(str + i, size - i, "inf", 3)){
+            *value = (neg ? -HUGE_VAL : HUGE_VAL);
+            return i + (startsWithWord(str + i, size - i, "infinity", 8) ? 8 : 3);
+        }
+        if(startsWithWord(str + i, size - i, "nan", 3)){
+            *value = NAN;
+            return i + 3;
+        }
+    }
+
+    // Up to 19 significant digits in the mantissa
+    zu64 mantissa = 0;
+    zu64 sigdigits = 0;
+    zs64 exp10 = 0;
+    bool truncated = false;
+    zu64 ndigits = 0;
+    const zu64 intstart = i;
+    for(; i < size && str[i] >= '0' && str[i] <= '9'; ++i){
+        if(mantissa == 0 && str[i] == '0')
+            continue;
+        if(sigdigits < 19){
+            mantissa = mantissa * 10 + (zu64)(str[i] - '0');
+            ++sigdigits;
+        } else {
+            // Digits past 19 only scale the value
+            ++exp10;
+            truncated |= (str[i] != '0');
+        }
+    }
+    ndigits += i - intstart;
+    if(i < size && str[i] == '.'){
+        ++i;
+        const zu64 fracstart = i;
+        for(; i < size && str[i] >= '0' && str[i] <= '9'; ++i){
+            if(mantissa == 0 && str[i] == '0'){
+                --exp10;
+                continue;
+            }
+            if(sigdigits < 19){
+                mantissa = mantissa * 10 + (zu64)(str[i] - '0');
+                ++sigdigits;
+                --exp10;
+            } else {
+                truncated |= (str[i] != '0');
+            }
+        }
+        ndigits += i - fracstart;
+    }
+    if(ndigits == 0){
+        *value = 0;
+        return 0;
+    }
+
+    // Exponent, only if it has digits
+    if(i < size && (str[i] == 'e' || str[i] == 'E')){
+        zu64 j = i + 1;
+        bool eneg = false;
+        if(j < size && (str[j] == '-' || str[j] == '+')){
+            eneg = (str[j] == '-');
+            ++j;
+        }
+        zu64 e = 0;
+        zu64 elen = parseUint(str + j, size - j, &e, 10);
+        if(elen){
+            // Far past the range of doubles either way
+            if(e > 100000)
+                e = 100000;
+            exp10 += (eneg ? -(zs64)e : (zs64)e);
+            i = j + elen;
+        }
+    }
+
+    if(mantissa == 0){
+        *value = (neg ? -0.0 : 0.0);
+        return i;
+    }
+
+    // Exact when the mantissa and the power of ten are both exact doubles
+    if(!truncated && mantissa <= (1ULL << 53)){
+        double result = (double)mantissa;
+        if(exp10 >= -22 && exp10 <= 22){
+            result = (exp10 < 0 ? result / pow10d[-exp10] : result * pow10d[exp10]);
+            *value = (neg ? -result : result);
+            return i;
+        }
+        // Move extra powers of ten into the mantissa while it stays exact
+        if(exp10 > 22 && exp10 <= 22 + 15){
+            const zu64 extra = pow10u[exp10 - 22];
+            if(mantissa <= (1ULL << 53) / extra){
+                result = (double)(mantissa * extra) * pow10d[22];
+                *value = (neg ? -result : result);
+                return i;
+            }
+        }
+    }
+
+    // Otherwise round correctly with strtod on a terminated copy
+    char small[64];
+    char *copy = (i < sizeof(small) ? small : (char *)malloc(i + 1));
+    memcpy(copy, str, i);
+    copy[i] = 0;
+    *value = strtod(copy, nullptr);
+    if(copy != small)
+        free(copy);
+    return i;
+}
+
+}
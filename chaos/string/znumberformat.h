@@ -0,0 +1,61 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                               znumberformat.h                              **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZNUMBERFORMAT_H
+#define ZNUMBERFORMAT_H
+
+#include "ztypes.h"
+
+//! Buffer size that fits any integer formatted by ZNumberFormat, in any base.
+#define ZNUMBERFORMAT_INT_SIZE 66
+//! Buffer size that fits any double formatted by ZNumberFormat.
+#define ZNUMBERFORMAT_DOUBLE_SIZE 32
+
+namespace LibChaos {
+
+/*! Number formatting and parsing into and out of caller buffers.
+ *  \ingroup String
+ *  Integers are formatted two decimal digits at a time, and parsed eight decimal digits at a time.
+ *  Doubles are formatted with the shortest digits that parse back to the same double (Grisu2),
+ *  and parsed exactly with double arithmetic when the digits and exponent allow it, falling back to strtod() otherwise.
+ *
+ *  Used by ZString and ZStringView number conversions and ZJSON numbers.
+ */
+class ZNumberFormat {
+public:
+    //! Format \a value in decimal at \a buffer, at least 20 bytes. \return Number of characters written.
+    static zu64 formatUint(zu64 value, char *buffer);
+    //! Format \a value in decimal at \a buffer, at least 20 bytes. \return Number of characters written.
+    static zu64 formatSint(zs64 value, char *buffer);
+    /*! Format \a value in \a base at \a buffer, at least ZNUMBERFORMAT_INT_SIZE bytes.
+     *  Uses uppercase letters if \a upper. Writes nothing if \a base is not 2 to 16.
+     *  \return Number of characters written.
+     */
+    static zu64 formatUint(zu64 value, zu8 base, char *buffer, bool upper = false);
+
+    /*! Format \a value at \a buffer, at least ZNUMBERFORMAT_DOUBLE_SIZE bytes.
+     *  Writes the shortest digits that parse back to \a value, in fixed notation for magnitudes from 1e-6 up to 1e21,
+     *  otherwise in exponent notation, like "1e+21" or "1.5e-7". Writes "nan", "inf" or "-inf" for non-finite values.
+     *  \return Number of characters written.
+     */
+    static zu64 formatDouble(double value, char *buffer);
+
+    /*! Parse digits in \a base from the start of \a size characters at \a str into \a value, saturating at ZU64_MAX.
+     *  Does not accept signs or prefixes. Supports up to base 16.
+     *  \return Number of characters parsed, zero if \a str does not start with a digit.
+     */
+    static zu64 parseUint(const char *str, zu64 size, zu64 *value, zu8 base = 10);
+
+    /*! Parse a decimal number from the start of \a size characters at \a str into \a value.
+     *  Accepts an optional sign, digits with an optional decimal point, and an optional exponent,
+     *  or "inf", "infinity" or "nan" unless \a strict. Rounds to the nearest double.
+     *  \return Number of characters parsed, zero if \a str does not start with a number.
+     */
+    static zu64 parseDouble(const char *str, zu64 size, double *value, bool strict = false);
+};
+
+}
+
+#endif // ZNUMBERFORMAT_H
@@ -73,7 +73,15 @@ void ZPath::fromStr(ZString path){
 #if LIBCHAOS_PLATFORM == _PLATFORM_WINDOWS
     _data = path.explodeList(2, ZPATH_DEFAULT_DELIM, '/');
 #else
-    _data = path.explode(ZPATH_DEFAULT_DELIM);
+    // Tokenize the path in place, only allocating the kept components
+    _data.clear();
+    ZStringView rest = path.view();
+    ZStringView part = rest.nextToken(ZPATH_DEFAULT_DELIM);
+    while(!part.isEmpty()){
+        if(part != ".")
+            _data.push(ZString(part));
+        part = rest.nextToken(ZPATH_DEFAULT_DELIM);
+    }
 #endif
 
     for(zu64 i = 0; i < _data.size(); ++i){
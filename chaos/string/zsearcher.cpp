@@ -0,0 +1,169 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                               zsearcher.cpp                                **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#include "zsearcher.h"
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define ZSEARCHER_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define ZSEARCHER_NEON
+    #include <arm_neon.h>
+#endif
+
+#if LIBCHAOS_COMPILER == _COMPILER_MSVC
+    // For _BitScanForward64
+    #include <intrin.h>
+#endif
+
+namespace LibChaos {
+
+//! Get the index of the lowest set bit in \a mask and clear it. \a mask must not be zero.
+static inline zu64 nextBit(zu64 &mask){
+#if LIBCHAOS_COMPILER == _COMPILER_MSVC
+    unsigned long bit;
+    _BitScanForward64(&bit, mask);
+#else
+    zu64 bit = (zu64)__builtin_ctzll(mask);
+#endif
+    mask &= mask - 1;
+    return (zu64)bit;
+}
+
+//! Find a pattern of at least two bytes by filtering positions on its first and last bytes.
+static zu64 findShort(const zbyte *data, zu64 size, const zbyte *pattern, zu64 psize, zu64 start){
+    const zu64 last = size - psize;
+    const zbyte first = pattern[0];
+    const zbyte end = pattern[psize - 1];
+    zu64 i = start;
+
+#if defined(ZSEARCHER_SSE2)
+    const __m128i vfirst = _mm_set1_epi8((char)first);
+    const __m128i vend = _mm_set1_epi8((char)end);
+    // Test 16 start positions at once, while all of them are valid
+    for(; i + 15 <= last; i += 16){
+        __m128i a = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(data + i + psize - 1));
+        zu64 mask = (zu64)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, vfirst), _mm_cmpeq_epi8(b, vend)));
+        while(mask){
+            zu64 pos = i + nextBit(mask);
+            if(memcmp(data + pos + 1, pattern + 1, psize - 2) == 0)
+                return pos;
+        }
+    }
+#elif defined(ZSEARCHER_NEON)
+    const uint8x16_t vfirst = vdupq_n_u8(first);
+    const uint8x16_t vend = vdupq_n_u8(end);
+    for(; i + 15 <= last; i += 16){
+        uint8x16_t a = vld1q_u8(data + i);
+        uint8x16_t b = vld1q_u8(data + i + psize - 1);
+        uint8x16_t eq = vandq_u8(vceqq_u8(a, vfirst), vceqq_u8(b, vend));
+        // Narrow to four bits per position
+        uint8x8_t narrow = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+        zu64 mask = vget_lane_u64(vreinterpret_u64_u8(narrow), 0) & 0x8888888888888888ULL;
+        while(mask){
+            zu64 pos = i + (nextBit(mask) >> 2);
+            if(memcmp(data + pos + 1, pattern + 1, psize - 2) == 0)
+                return pos;
+        }
+    }
+#endif
+
+    while(i <= last){
+        // Scan for the first byte, then check the last byte and the rest
+        const zbyte *ptr = (const zbyte *)memchr(data + i, first, last - i + 1);
+        if(ptr == nullptr)
+            break;
+        i = (zu64)(ptr - data);
+        if(data[i + psize - 1] == end && memcmp(data + i + 1, pattern + 1, psize - 2) == 0)
+            return i;
+        ++i;
+    }
+    return ZSearcher::NONE;
+}
+
+//! Fill \a skip with the Horspool shift of each byte for \a pattern.
+static void buildSkip(zu64 *skip, const zbyte *pattern, zu64 psize){
+    for(zu64 i = 0; i < 256; ++i)
+        skip[i] = psize;
+    for(zu64 i = 0; i + 1 < psize; ++i)
+        skip[pattern[i]] = psize - 1 - i;
+}
+
+//! Find a long pattern with Boyer-Moore-Horspool.
+static zu64 findLong(const zbyte *data, zu64 size, const zbyte *pattern, zu64 psize, const zu64 *skip, zu64 start){
+    const zu64 last = size - psize;
+    const zbyte end = pattern[psize - 1];
+    zu64 i = start;
+    while(i <= last){
+        zbyte ch = data[i + psize - 1];
+        if(ch == end && memcmp(data + i, pattern, psize - 1) == 0)
+            return i;
+        i += skip[ch];
+    }
+    return ZSearcher::NONE;
+}
+
+//! Search with a pattern of any length, \a skip is only used for long patterns.
+static zu64 search(const zbyte *data, zu64 size, const zbyte *pattern, zu64 psize, const zu64 *skip, zu64 start){
+    if(psize == 0 || psize > size || start > size - psize)
+        return ZSearcher::NONE;
+    if(psize == 1){
+        const zbyte *ptr = (const zbyte *)memchr(data + start, pattern[0], size - start);
+        return (ptr ? (zu64)(ptr - data) : ZSearcher::NONE);
+    }
+    if(psize <= ZSEARCHER_SHORT_MAX)
+        return findShort(data, size, pattern, psize, start);
+    return findLong(data, size, pattern, psize, skip, start);
+}
+
+ZSearcher::ZSearcher(const zbyte *pattern, zu64 size){
+    _pattern.resize(size);
+    if(size)
+        memcpy(_pattern.raw(), pattern, size);
+    if(size > ZSEARCHER_SHORT_MAX){
+        _skip.resize(256);
+        buildSkip(_skip.raw(), pattern, size);
+    }
+}
+
+zu64 ZSearcher::find(const zbyte *data, zu64 size, zu64 start) const {
+    return search(data, size, _pattern.raw(), _pattern.size(), _skip.raw(), start);
+}
+
+ZArray<zu64> ZSearcher::findAll(const zbyte *data, zu64 size, bool overlap) const {
+    ZArray<zu64> found;
+    const zu64 step = (overlap ? 1 : _pattern.size());
+    zu64 pos = find(data, size);
+    while(pos != NONE){
+        found.push(pos);
+        pos = find(data, size, pos + step);
+    }
+    return found;
+}
+
+zu64 ZSearcher::count(const zbyte *data, zu64 size, bool overlap) const {
+    const zu64 step = (overlap ? 1 : _pattern.size());
+    zu64 cnt = 0;
+    zu64 pos = find(data, size);
+    while(pos != NONE){
+        ++cnt;
+        pos = find(data, size, pos + step);
+    }
+    return cnt;
+}
+
+zu64 ZSearcher::find(const zbyte *data, zu64 size, const zbyte *pattern, zu64 psize, zu64 start){
+    if(psize > ZSEARCHER_SHORT_MAX && psize <= size){
+        zu64 skip[256];
+        buildSkip(skip, pattern, psize);
+        return search(data, size, pattern, psize, skip, start);
+    }
+    return search(data, size, pattern, psize, nullptr, start);
+}
+
+}
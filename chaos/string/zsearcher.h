@@ -0,0 +1,76 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                                zsearcher.h                                 **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZSEARCHER_H
+#define ZSEARCHER_H
+
+#include "ztypes.h"
+#include "zarray.h"
+#include "zstringview.h"
+
+//! Patterns longer than this are searched with Horspool, shorter ones with the first and last byte filter.
+#define ZSEARCHER_SHORT_MAX 32
+
+namespace LibChaos {
+
+/*! Substring search engine, shared by ZString, ZStringView and ZBinary.
+ *  \ingroup String
+ *  Single bytes are found with memchr. Short patterns are found by comparing the first and last bytes
+ *  of the pattern against 16 positions at once with SSE2 or NEON, and only comparing the middle
+ *  at positions where both match. Long patterns use Boyer-Moore-Horspool, which skips ahead
+ *  by up to the pattern length on each mismatch.
+ *
+ *  A ZSearcher compiles a pattern once, for searching many buffers for the same pattern.
+ *  The static find() compiles a pattern for one search.
+ */
+class ZSearcher {
+public:
+    enum { NONE = ZU64_MAX };
+
+public:
+    //! Compile a copy of \a size bytes at \a pattern.
+    ZSearcher(const zbyte *pattern, zu64 size);
+    //! Compile a copy of \a pattern.
+    ZSearcher(ZStringView pattern) : ZSearcher((const zbyte *)pattern.data(), pattern.size()){}
+
+    /*! Find the first occurrence of the pattern in \a size bytes at \a data, starting at \a start.
+     *  \return Index of the occurrence, or \ref NONE. An empty pattern is never found.
+     */
+    zu64 find(const zbyte *data, zu64 size, zu64 start = 0) const;
+    zu64 find(ZStringView str, zu64 start = 0) const {
+        return find((const zbyte *)str.data(), str.size(), start);
+    }
+
+    //! Find all occurrences of the pattern in \a size bytes at \a data. Occurrences may overlap if \a overlap.
+    ZArray<zu64> findAll(const zbyte *data, zu64 size, bool overlap = false) const;
+    ZArray<zu64> findAll(ZStringView str, bool overlap = false) const {
+        return findAll((const zbyte *)str.data(), str.size(), overlap);
+    }
+
+    //! Count occurrences of the pattern in \a size bytes at \a data. Occurrences may overlap if \a overlap.
+    zu64 count(const zbyte *data, zu64 size, bool overlap = false) const;
+    zu64 count(ZStringView str, bool overlap = false) const {
+        return count((const zbyte *)str.data(), str.size(), overlap);
+    }
+
+    //! Get the pattern.
+    const zbyte *pattern() const { return _pattern.raw(); }
+    //! Get the pattern length.
+    zu64 size() const { return _pattern.size(); }
+
+    /*! Find the first occurrence of \a psize bytes at \a pattern in \a size bytes at \a data, starting at \a start.
+     *  \return Index of the occurrence, or \ref NONE. An empty pattern is never found.
+     */
+    static zu64 find(const zbyte *data, zu64 size, const zbyte *pattern, zu64 psize, zu64 start = 0);
+
+private:
+    ZArray<zbyte> _pattern;
+    //! Horspool shift for each byte at the end of the window, only for long patterns.
+    ZArray<zu64> _skip;
+};
+
+}
+
+#endif // ZSEARCHER_H
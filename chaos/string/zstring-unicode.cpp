@@ -6,37 +6,326 @@
 #include "zstring.h"
 #include "zlog.h"
 #include <string>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define ZSTRING_SSE2
+    #include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+    #define ZSTRING_AVX2
+    #include <immintrin.h>
+#endif
+
+#if LIBCHAOS_COMPILER == _COMPILER_MSVC
+    // For _BitScanForward and __popcnt
+    #include <intrin.h>
+#endif
 
 namespace LibChaos {
 
+//! Get the index of the lowest set bit in \a mask. \a mask must not be zero.
+static inline zu64 lowBit(zu32 mask){
+#if LIBCHAOS_COMPILER == _COMPILER_MSVC
+    unsigned long bit;
+    _BitScanForward(&bit, mask);
+    return bit;
+#else
+    return (zu64)__builtin_ctz(mask);
+#endif
+}
+
+//! Get the number of set bits in \a mask.
+static inline zu64 bitCount(zu32 mask){
+#if LIBCHAOS_COMPILER == _COMPILER_MSVC
+    return __popcnt(mask);
+#else
+    return (zu64)__builtin_popcount(mask);
+#endif
+}
+
+//! Get the number of leading ASCII bytes in \a size bytes at \a data.
+static zu64 asciiRun(const zbyte *data, zu64 size){
+    zu64 i = 0;
+#if defined(ZSTRING_AVX2)
+    for(; i + 32 <= size; i += 32){
+        zu32 mask = (zu32)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *)(data + i)));
+        if(mask)
+            return i + lowBit(mask);
+    }
+#endif
+#if defined(ZSTRING_SSE2)
+    for(; i + 16 <= size; i += 16){
+        zu32 mask = (zu32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(data + i)));
+        if(mask)
+            return i + lowBit(mask);
+    }
+#endif
+    // Eight bytes at a time
+    for(; i + 8 <= size; i += 8){
+        zu64 word;
+        memcpy(&word, data + i, 8);
+        if(word & 0x8080808080808080ULL)
+            break;
+    }
+    while(i < size && data[i] < 0x80)
+        ++i;
+    return i;
+}
+
+//! Check for printable ASCII, tab, line feed or carriage return, the ASCII accepted by ZString::isUTF8().
+static inline bool isTextByte(zbyte byte){
+    return (0x20 <= byte && byte <= 0x7E) || byte == 0x09 || byte == 0x0A || byte == 0x0D;
+}
+
+//! Get the number of leading text bytes in \a size bytes at \a data, see isTextByte().
+static zu64 textRun(const zbyte *data, zu64 size){
+    zu64 i = 0;
+#if defined(ZSTRING_AVX2)
+    {
+        const __m256i lo = _mm256_set1_epi8(0x1F);
+        const __m256i hi = _mm256_set1_epi8(0x7F);
+        const __m256i tab = _mm256_set1_epi8(0x09);
+        const __m256i lf = _mm256_set1_epi8(0x0A);
+        const __m256i cr = _mm256_set1_epi8(0x0D);
+        for(; i + 32 <= size; i += 32){
+            __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+            // Signed compares, so bytes from 0x80 are below 0x1F
+            __m256i ok = _mm256_and_si256(_mm256_cmpgt_epi8(v, lo), _mm256_cmpgt_epi8(hi, v));
+            ok = _mm256_or_si256(ok, _mm256_or_si256(_mm256_cmpeq_epi8(v, tab), _mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr))));
+            zu32 mask = ~(zu32)_mm256_movemask_epi8(ok);
+            if(mask)
+                return i + lowBit(mask);
+        }
+    }
+#endif
+#if defined(ZSTRING_SSE2)
+    {
+        const __m128i lo = _mm_set1_epi8(0x1F);
+        const __m128i hi = _mm_set1_epi8(0x7F);
+        const __m128i tab = _mm_set1_epi8(0x09);
+        const __m128i lf = _mm_set1_epi8(0x0A);
+        const __m128i cr = _mm_set1_epi8(0x0D);
+        for(; i + 16 <= size; i += 16){
+            __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+            __m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v, lo), _mm_cmplt_epi8(v, hi));
+            ok = _mm_or_si128(ok, _mm_or_si128(_mm_cmpeq_epi8(v, tab), _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr))));
+            zu32 mask = ~(zu32)_mm_movemask_epi8(ok) & 0xFFFF;
+            if(mask)
+                return i + lowBit(mask);
+        }
+    }
+#endif
+    while(i < size && isTextByte(data[i]))
+        ++i;
+    return i;
+}
+
+/*! Copy the leading ASCII code units in \a size units at \a units to bytes at \a dest.
+ *  Stops at the first unit that is zero or not ASCII. \return Number of units copied.
+ */
+template <typename U> static zu64 narrowASCII(const U *units, zu64 size, zbyte *dest){
+    zu64 i = 0;
+#if defined(ZSTRING_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    if(sizeof(U) == 2){
+        const __m128i high = _mm_set1_epi16((short)0xFF80);
+        for(; i + 16 <= size; i += 16){
+            __m128i a = _mm_loadu_si128((const __m128i *)(units + i));
+            __m128i b = _mm_loadu_si128((const __m128i *)(units + i + 8));
+            __m128i bad = _mm_or_si128(_mm_and_si128(_mm_or_si128(a, b), high),
+                                       _mm_or_si128(_mm_cmpeq_epi16(a, zero), _mm_cmpeq_epi16(b, zero)));
+            if(_mm_movemask_epi8(_mm_cmpeq_epi8(bad, zero)) != 0xFFFF)
+                break;
+            _mm_storeu_si128((__m128i *)(dest + i), _mm_packus_epi16(a, b));
+        }
+    } else if(sizeof(U) == 4){
+        const __m128i high = _mm_set1_epi32((int)0xFFFFFF80);
+        for(; i + 16 <= size; i += 16){
+            __m128i a = _mm_loadu_si128((const __m128i *)(units + i));
+            __m128i b = _mm_loadu_si128((const __m128i *)(units + i + 4));
+            __m128i c = _mm_loadu_si128((const __m128i *)(units + i + 8));
+            __m128i d = _mm_loadu_si128((const __m128i *)(units + i + 12));
+            __m128i all = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+            __m128i zeros = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi32(a, zero), _mm_cmpeq_epi32(b, zero)),
+                                         _mm_or_si128(_mm_cmpeq_epi32(c, zero), _mm_cmpeq_epi32(d, zero)));
+            __m128i bad = _mm_or_si128(_mm_and_si128(all, high), zeros);
+            if(_mm_movemask_epi8(_mm_cmpeq_epi8(bad, zero)) != 0xFFFF)
+                break;
+            _mm_storeu_si128((__m128i *)(dest + i), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+        }
+    }
+#endif
+    for(; i < size && units[i] && units[i] < 0x80; ++i)
+        dest[i] = (zbyte)units[i];
+    return i;
+}
+
+//! Copy \a size ASCII bytes at \a src to wider code units at \a dest.
+template <typename U> static void widenASCII(const zbyte *src, zu64 size, U *dest){
+    zu64 i = 0;
+#if defined(ZSTRING_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for(; i + 16 <= size; i += 16){
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        if(sizeof(U) == 2){
+            _mm_storeu_si128((__m128i *)(dest + i), lo);
+            _mm_storeu_si128((__m128i *)(dest + i + 8), hi);
+        } else {
+            _mm_storeu_si128((__m128i *)(dest + i), _mm_unpacklo_epi16(lo, zero));
+            _mm_storeu_si128((__m128i *)(dest + i + 4), _mm_unpackhi_epi16(lo, zero));
+            _mm_storeu_si128((__m128i *)(dest + i + 8), _mm_unpacklo_epi16(hi, zero));
+            _mm_storeu_si128((__m128i *)(dest + i + 12), _mm_unpackhi_epi16(hi, zero));
+        }
+    }
+#endif
+    for(; i < size; ++i)
+        dest[i] = src[i];
+}
+
+//! Get the number of code units before a zero unit, up to \a max.
+template <typename U> static zu64 unitLength(const U *units, zu64 max){
+    zu64 len = 0;
+    while(len < max && units[len])
+        ++len;
+    return len;
+}
+
 void ZString::parseUTF8(const codeunit8 *units, zu64 max){
     clear();
     if(units && max){
-        // Read and add code points
-        while(max && *units){
-            _appendCodePoint(_nextUTF8(&units, &max));
+        const zu64 len = strnlen((const char *)units, max);
+        // Normalized UTF-8 is never longer than the input
+        _resize(len);
+        zu64 out = 0;
+        zu64 i = 0;
+        while(i < len){
+            // Copy runs of ASCII as they are
+            zu64 run = asciiRun(units + i, len - i);
+            memcpy(_data + out, units + i, run);
+            out += run;
+            i += run;
+            // Decode other sequences, copying those that are already the shortest encoding
+            while(i < len && units[i] >= 0x80){
+                const codeunit8 *next = units + i;
+                zu64 left = len - i;
+                codepoint cp = _nextUTF8(&next, &left);
+                zu64 used = (zu64)(next - (units + i));
+                if(cp){
+                    zu8 sz = _encodeUTF8(_data + out, cp);
+                    if(sz == used)
+                        memcpy(_data + out, units + i, used);
+                    out += sz;
+                }
+                i += used;
+            }
         }
+        _resize(out);
     }
 }
 
-void ZString::parseUTF16(const codeunit16 *units, zu64 max){
+template <typename U> void ZString::_parseUnits(const U *units, zu64 max, codepoint (*next)(const U **, zu64 *), zu64 extra){
     clear();
     if(units && max){
-        // Read and add code points
-        while(max && *units){
-            _appendCodePoint(_nextUTF16(&units, &max));
+        const zu64 len = unitLength(units, max);
+        // Enough for ASCII, grown for longer encodings
+        _resize(len);
+        zu64 out = 0;
+        zu64 i = 0;
+        while(i < len){
+            zu64 run = narrowASCII(units + i, len - i, _data + out);
+            out += run;
+            i += run;
+            // Decode up to a block of other code points before looking for ASCII again
+            const zu64 end = MIN(i + 16, len);
+            while(i < end){
+                // Keep room for the rest of the input as ASCII, plus the longest encoding of this unit
+                if(out + (len - i) + extra > size())
+                    _resize(out + (len - i) + extra);
+                const U *pos = units + i;
+                zu64 left = len - i;
+                codepoint cp = next(&pos, &left);
+                out += _encodeUTF8(_data + out, cp);
+                i = (zu64)(pos - units);
+            }
         }
+        _resize(out);
     }
 }
 
+void ZString::parseUTF16(const codeunit16 *units, zu64 max){
+    // Up to 3 bytes for one unit, or 4 bytes for a surrogate pair
+    _parseUnits(units, max, _nextUTF16, 2);
+}
+
 void ZString::parseUTF32(const codeunit32 *units, zu64 max){
-    clear();
-    if(units && max){
-        // Read and add code points
-        while(max && *units){
-            _appendCodePoint(_nextUTF32(&units, &max));
+    // Up to 6 bytes for one unit
+    _parseUnits(units, max, _nextUTF32, 5);
+}
+
+std::wstring ZString::wstr() const {
+    std::wstring str;
+    const zu64 len = strnlen(cc(), size());
+    str.reserve(len);
+    zu64 i = 0;
+    while(i < len){
+        zu64 run = asciiRun(_data + i, len - i);
+        str.append(_data + i, _data + i + run);
+        i += run;
+        if(i < len){
+            const codeunit *units = _data + i;
+            zu64 max = len - i;
+            _appendUTF16(str, _nextUTF8(&units, &max));
+            i = (zu64)(units - _data);
+        }
+    }
+    return str;
+}
+
+zu64 ZString::readUTF16(codeunit16 *dest, zu64 maxsize) const {
+    const zu64 size = strnlen(cc(), this->size());
+    zu64 len = 0;
+    zu64 i = 0;
+    // Always leave room for a surrogate pair
+    while(i < size && maxsize >= 2){
+        zu64 run = MIN(asciiRun(_data + i, size - i), maxsize - 1);
+        widenASCII(_data + i, run, dest + len);
+        i += run;
+        len += run;
+        maxsize -= run;
+        if(i < size && maxsize >= 2){
+            const codeunit *units = _data + i;
+            zu64 max = size - i;
+            zu8 sz = _encodeUTF16(dest + len, _nextUTF8(&units, &max));
+            i = (zu64)(units - _data);
+            len += sz;
+            maxsize -= sz;
+        }
+    }
+    return len;
+}
+
+zu64 ZString::readUTF32(codeunit32 *dest, zu64 maxsize) const {
+    const zu64 size = strnlen(cc(), this->size());
+    zu64 len = 0;
+    zu64 i = 0;
+    while(i < size && maxsize){
+        zu64 run = MIN(asciiRun(_data + i, size - i), maxsize);
+        widenASCII(_data + i, run, dest + len);
+        i += run;
+        len += run;
+        maxsize -= run;
+        if(i < size && maxsize){
+            const codeunit *units = _data + i;
+            zu64 max = size - i;
+            dest[len++] = _nextUTF8(&units, &max);
+            i = (zu64)(units - _data);
+            --maxsize;
         }
     }
+    return len;
 }
 
 void ZString::debugUTF8(const codeunit *bytes){
@@ -134,58 +423,65 @@ ZString ZString::codePointStr(codepoint cp){
 // ///////////////////////////////////////////////////////////////////////////////
 
 void ZString::_appendCodePoint(codepoint cp){
+    _reserve(size() + 6);
+    _resize(size() + _encodeUTF8(_data + size(), cp));
+}
+
+zu8 ZString::_encodeUTF8(codeunit8 *units, codepoint cp){
     // UTF-8: RFC-3629
 
     if(cp == 0){
         // Skip invalid code points
+        return 0;
 
     } else if(cp <= 0x7F){
         // 1 byte
-       _resize(size()+1);
-        _data[size()-1] = (zu8)(cp & 0x7F);
+        units[0] = (zu8)(cp & 0x7F);
+        return 1;
 
     } else if(cp <= 0x7FF){
         // 2 bytes
-       _resize(size()+2);
-        _data[size()-2] = (zu8)(cp >> 6 & 0x1F) | 0xC0;
-        _data[size()-1] = (zu8)(cp      & 0x3F) | 0x80;
+        units[0] = (zu8)(cp >> 6 & 0x1F) | 0xC0;
+        units[1] = (zu8)(cp      & 0x3F) | 0x80;
+        return 2;
 
     } else if(cp <= 0xFFFF){
         // 3 bytes
-       _resize(size()+3);
-        _data[size()-3] = (zu8)(cp >> 12 & 0x0F) | 0xE0;
-        _data[size()-2] = (zu8)(cp >> 6  & 0x3F) | 0x80;
-        _data[size()-1] = (zu8)(cp       & 0x3F) | 0x80;
+        units[0] = (zu8)(cp >> 12 & 0x0F) | 0xE0;
+        units[1] = (zu8)(cp >> 6  & 0x3F) | 0x80;
+        units[2] = (zu8)(cp       & 0x3F) | 0x80;
+        return 3;
 
     } else if(cp <= 0x1FFFFF){
         // 4 bytes
-       _resize(size()+4);
-        _data[size()-4] = (zu8)(cp >> 18 & 0x07) | 0xF0;
-        _data[size()-3] = (zu8)(cp >> 12 & 0x3F) | 0x80;
-        _data[size()-2] = (zu8)(cp >> 6  & 0x3F) | 0x80;
-        _data[size()-1] = (zu8)(cp       & 0x3F) | 0x80;
+        units[0] = (zu8)(cp >> 18 & 0x07) | 0xF0;
+        units[1] = (zu8)(cp >> 12 & 0x3F) | 0x80;
+        units[2] = (zu8)(cp >> 6  & 0x3F) | 0x80;
+        units[3] = (zu8)(cp       & 0x3F) | 0x80;
+        return 4;
 
     } else if(cp <= 0x3FFFFFF){
-        // 4 bytes
-       _resize(size()+5);
-        _data[size()-5] = (zu8)(cp >> 24 & 0x03) | 0xF8;
-        _data[size()-4] = (zu8)(cp >> 18 & 0x3F) | 0x80;
-        _data[size()-3] = (zu8)(cp >> 12 & 0x3F) | 0x80;
-        _data[size()-2] = (zu8)(cp >> 6  & 0x3F) | 0x80;
-        _data[size()-1] = (zu8)(cp       & 0x3F) | 0x80;
+        // 5 bytes (non-standard)
+        units[0] = (zu8)(cp >> 24 & 0x03) | 0xF8;
+        units[1] = (zu8)(cp >> 18 & 0x3F) | 0x80;
+        units[2] = (zu8)(cp >> 12 & 0x3F) | 0x80;
+        units[3] = (zu8)(cp >> 6  & 0x3F) | 0x80;
+        units[4] = (zu8)(cp       & 0x3F) | 0x80;
+        return 5;
 
     } else if(cp <= 0x7FFFFFFF){
-        // 4 bytes
-       _resize(size()+6);
-        _data[size()-6] = (zu8)(cp >> 30 & 0x01) | 0xFC;
-        _data[size()-5] = (zu8)(cp >> 24 & 0x3F) | 0x80;
-        _data[size()-4] = (zu8)(cp >> 18 & 0x3F) | 0x80;
-        _data[size()-3] = (zu8)(cp >> 12 & 0x3F) | 0x80;
-        _data[size()-2] = (zu8)(cp >> 6  & 0x3F) | 0x80;
-        _data[size()-1] = (zu8)(cp       & 0x3F) | 0x80;
+        // 6 bytes (non-standard)
+        units[0] = (zu8)(cp >> 30 & 0x01) | 0xFC;
+        units[1] = (zu8)(cp >> 24 & 0x3F) | 0x80;
+        units[2] = (zu8)(cp >> 18 & 0x3F) | 0x80;
+        units[3] = (zu8)(cp >> 12 & 0x3F) | 0x80;
+        units[4] = (zu8)(cp >> 6  & 0x3F) | 0x80;
+        units[5] = (zu8)(cp       & 0x3F) | 0x80;
+        return 6;
 
     } else {
         // Cannot encode code points larger than 31 bits with UTF-8
+        return 0;
     }
 }
 
@@ -387,62 +683,68 @@ ZString::codepoint ZString::_nextUTF32(const codeunit32 **punits, zu64 *maxunits
 }
 
 bool ZString::isUTF8(const char *str){
-    const unsigned char *bytes = (const unsigned char *)str;
-    while(*bytes){
-        if( // ASCII: use bytes[0] <= 0x7F to allow ASCII control characters
-            bytes[0] == 0x09 ||
-            bytes[0] == 0x0A ||
-            bytes[0] == 0x0D ||
-            (0x20 <= bytes[0] && bytes[0] <= 0x7E)
-        ){
-            bytes += 1;
-            continue;
+    return isUTF8(str, strlen(str));
+}
+
+bool ZString::isUTF8(const char *str, zu64 size){
+    const zbyte *bytes = (const zbyte *)str;
+    zu64 i = 0;
+    while(i < size){
+        // Skip runs of ASCII text
+        if(isTextByte(bytes[i])){
+            i += textRun(bytes + i, size - i);
+            if(i >= size)
+                break;
         }
 
+        const zbyte *seq = bytes + i;
+        const zu64 left = size - i;
+
         if( // non-overlong 2-byte
-            (0xC2 <= bytes[0] && bytes[0] <= 0xDF) &&
-            (0x80 <= bytes[1] && bytes[1] <= 0xBF)
+            left >= 2 &&
+            (0xC2 <= seq[0] && seq[0] <= 0xDF) &&
+            (0x80 <= seq[1] && seq[1] <= 0xBF)
         ){
-            bytes += 2;
+            i += 2;
             continue;
         }
 
-        if(( // excluding overlongs
-            bytes[0] == 0xE0 &&
-            (0xA0 <= bytes[1] && bytes[1] <= 0xBF) &&
-            (0x80 <= bytes[2] && bytes[2] <= 0xBF)
+        if(left >= 3 && (( // excluding overlongs
+            seq[0] == 0xE0 &&
+            (0xA0 <= seq[1] && seq[1] <= 0xBF) &&
+            (0x80 <= seq[2] && seq[2] <= 0xBF)
             ) || ( // straight 3-byte
-                ((0xE1 <= bytes[0] && bytes[0] <= 0xEC) ||
-            bytes[0] == 0xEE ||
-            bytes[0] == 0xEF) &&
-            (0x80 <= bytes[1] && bytes[1] <= 0xBF) &&
-            (0x80 <= bytes[2] && bytes[2] <= 0xBF)
+                ((0xE1 <= seq[0] && seq[0] <= 0xEC) ||
+            seq[0] == 0xEE ||
+            seq[0] == 0xEF) &&
+            (0x80 <= seq[1] && seq[1] <= 0xBF) &&
+            (0x80 <= seq[2] && seq[2] <= 0xBF)
             ) || ( // excluding surrogates
-            bytes[0] == 0xED &&
-            (0x80 <= bytes[1] && bytes[1] <= 0x9F) &&
-            (0x80 <= bytes[2] && bytes[2] <= 0xBF)
-        )){
-            bytes += 3;
+            seq[0] == 0xED &&
+            (0x80 <= seq[1] && seq[1] <= 0x9F) &&
+            (0x80 <= seq[2] && seq[2] <= 0xBF)
+        ))){
+            i += 3;
             continue;
         }
 
-        if(( // planes 1-3
-            bytes[0] == 0xF0 &&
-            (0x90 <= bytes[1] && bytes[1] <= 0xBF) &&
-            (0x80 <= bytes[2] && bytes[2] <= 0xBF) &&
-            (0x80 <= bytes[3] && bytes[3] <= 0xBF)
+        if(left >= 4 && (( // planes 1-3
+            seq[0] == 0xF0 &&
+            (0x90 <= seq[1] && seq[1] <= 0xBF) &&
+            (0x80 <= seq[2] && seq[2] <= 0xBF) &&
+            (0x80 <= seq[3] && seq[3] <= 0xBF)
         ) || ( // planes 4-15
-            (0xF1 <= bytes[0] && bytes[0] <= 0xF3) &&
-            (0x80 <= bytes[1] && bytes[1] <= 0xBF) &&
-            (0x80 <= bytes[2] && bytes[2] <= 0xBF) &&
-            (0x80 <= bytes[3] && bytes[3] <= 0xBF)
+            (0xF1 <= seq[0] && seq[0] <= 0xF3) &&
+            (0x80 <= seq[1] && seq[1] <= 0xBF) &&
+            (0x80 <= seq[2] && seq[2] <= 0xBF) &&
+            (0x80 <= seq[3] && seq[3] <= 0xBF)
         ) || ( // plane 16
-                bytes[0] == 0xF4 &&
-            (0x80 <= bytes[1] && bytes[1] <= 0x8F) &&
-            (0x80 <= bytes[2] && bytes[2] <= 0xBF) &&
-            (0x80 <= bytes[3] && bytes[3] <= 0xBF)
-        )){
-            bytes += 4;
+                seq[0] == 0xF4 &&
+            (0x80 <= seq[1] && seq[1] <= 0x8F) &&
+            (0x80 <= seq[2] && seq[2] <= 0xBF) &&
+            (0x80 <= seq[3] && seq[3] <= 0xBF)
+        ))){
+            i += 4;
             continue;
         }
         return false;
@@ -450,6 +752,36 @@ bool ZString::isUTF8(const char *str){
     return true;
 }
 
+zu64 ZString::countCodePoints(const codeunit8 *units, zu64 size){
+    // Count every byte that is not a continuation byte
+    zu64 count = 0;
+    zu64 i = 0;
+#if defined(ZSTRING_AVX2)
+    {
+        const __m256i cont = _mm256_set1_epi8((char)0xBF);
+        for(; i + 32 <= size; i += 32){
+            __m256i v = _mm256_loadu_si256((const __m256i *)(units + i));
+            // Signed compare, continuation bytes 0x80 to 0xBF are the lowest
+            count += bitCount((zu32)_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, cont)));
+        }
+    }
+#endif
+#if defined(ZSTRING_SSE2)
+    {
+        const __m128i cont = _mm_set1_epi8((char)0xBF);
+        for(; i + 16 <= size; i += 16){
+            __m128i v = _mm_loadu_si128((const __m128i *)(units + i));
+            count += bitCount((zu32)_mm_movemask_epi8(_mm_cmpgt_epi8(v, cont)));
+        }
+    }
+#endif
+    for(; i < size; ++i){
+        if((units[i] & 0xC0) != 0x80)
+            ++count;
+    }
+    return count;
+}
+
 void ZString::unicode_normalize(){
     // TODO: UTF-8 Unicode Normalization
 }
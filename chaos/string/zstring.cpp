@@ -4,36 +4,56 @@
 **                          See COPYRIGHT and LICENSE                         **
 *******************************************************************************/
 #include "zstring.h"
+#include "zsearcher.h"
+#include "zmultisearcher.h"
+#include "znumberformat.h"
+#include "zmap.h"
 #include "zarray.h"
 #include "zlist.h"
-#include "zmath.h"
 
-// std::stringstream
-#include <sstream>
+// std::string
+#include <string>
+// std::ostream
+#include <ostream>
 // std::reverse
 #include <algorithm>
 // Variable arguments lists
 #include <cstdarg>
-// pow
-#include <math.h>
+// strnlen, memcpy
+#include <string.h>
 
 #include "zlog.h"
 
 namespace LibChaos {
 
-ZString::ZString(ZAllocator<codeunit> *alloc) : _alloc(alloc), _size(0), _realsize(0), _data(nullptr){
-    clear(); // Empty string with null terminator
+ZString::ZString(ZAllocator<codeunit> *alloc) : _alloc(alloc), _size(0), _data(_sso){
+    _sso[0] = 0; // Empty string with null terminator
 }
 
 ZString::ZString(const ZString &other) : ZString(){
     _resize(other._size);
     if(other._size && other._data)
-        _alloc->rawcopy(other._data, _data, other._size);
+        _alloc.rawcopy(other._data, _data, other._size);
+}
+
+ZString::ZString(ZString &&other) : ZString(){
+    _alloc.swap(other._alloc);
+    if(other._isInline()){
+        // Copy short string and null terminator
+        ::memcpy(_sso, other._sso, other._size + 1);
+    } else {
+        _data = other._data;
+        _realsize = other._realsize;
+        other._data = other._sso;
+    }
+    _size = other._size;
+    other._size = 0;
+    other._sso[0] = 0;
 }
 
 ZString::~ZString(){
-    _alloc->dealloc(_data);
-    delete _alloc;
+    if(!_isInline())
+        _alloc.dealloc(_data);
 }
 
 //
@@ -53,6 +73,10 @@ ZString::ZString(const char *str, zu64 max) : ZString(){
     parseUTF8((const codeunit*)str, max);
 }
 
+ZString::ZString(ZStringView view) : ZString(){
+    parseUTF8((const codeunit*)view.data(), view.size());
+}
+
 ZString::ZString(const ZArray<char> &array) : ZString(array.raw()){
     // Forwarded
 }
@@ -71,12 +95,19 @@ ZString::ZString(std::string str) : ZString(str.c_str()){
 
 ZString::ZString(const wchar_t *wstr, zu64 max) : ZString(){
     if(wstr && max){
-        ZArray<codeunit16> units;
-        for(zu64 i = 0; i < max && *wstr; ++i){
-            units.push((codeunit16)(*wstr & 0xFFFF));
-            ++wstr;
+        zu64 len = 0;
+        while(len < max && wstr[len])
+            ++len;
+        if(sizeof(wchar_t) == sizeof(codeunit16)){
+            parseUTF16((const codeunit16 *)wstr, len);
+        } else {
+            // Wide strings are read as UTF-16, one unit per character
+            ZArray<codeunit16> units;
+            units.reserve(len);
+            for(zu64 i = 0; i < len; ++i)
+                units.push((codeunit16)(wstr[i] & 0xFFFF));
+            parseUTF16(units.raw(), units.size());
         }
-        parseUTF16(units.raw(), units.size());
     }
 }
 
@@ -89,14 +120,16 @@ ZString::ZString(std::wstring wstr) : ZString(wstr.c_str()){
 }
 
 ZString::ZString(double num, unsigned places) : ZString(){
-    std::stringstream stream;
-    stream << num;
+    char buffer[ZNUMBERFORMAT_DOUBLE_SIZE];
+    zu64 len = ZNumberFormat::formatDouble(num, buffer);
     if(places){
-        ArZ arr = ZString(stream.str()).split('.');
-        assign(arr[0] + '.' + arr[1].substr(0, places));
-    } else {
-        assign(stream.str());
+        // Truncate decimal places in fixed notation
+        const char *point = (const char *)memchr(buffer, '.', len);
+        if(point && !memchr(buffer, 'e', len) && len > (zu64)(point - buffer) + 1 + places)
+            len = (zu64)(point - buffer) + 1 + places;
     }
+    _resize(len);
+    ::memcpy(_data, buffer, len);
 }
 
 //
@@ -106,7 +139,7 @@ ZString::ZString(double num, unsigned places) : ZString(){
 ZString &ZString::assign(const ZString &other){
     _resize(other.size());
     if(other.size())
-        _alloc->rawcopy(other._data, _data, other.size());
+        _alloc.rawcopy(other._data, _data, other.size());
     return *this;
 }
 
@@ -118,47 +151,6 @@ std::string ZString::str() const {
     return std::string(cc(), size());
 }
 
-std::wstring ZString::wstr() const {
-    std::wstring str;
-    zu64 max = size();
-    const codeunit *units = _data;
-    // Read and add code points
-    while(max && *units){
-        _appendUTF16(str, _nextUTF8(&units, &max));
-    }
-    return str;
-}
-
-zu64 ZString::readUTF16(codeunit16 *dest, zu64 maxsize) const {
-    zu64 max = size();
-    const codeunit *units = _data;
-    zu64 len = 0;
-    // Read and add code points
-    while(max && *units && maxsize >= 2){
-        zu8 sz = _encodeUTF16(dest, _nextUTF8(&units, &max));
-        // Increment len and dest, decrement maxsize
-        len += sz;
-        maxsize -= sz;
-        dest += sz;
-    }
-    return len;
-}
-
-zu64 ZString::readUTF32(codeunit32 *dest, zu64 maxsize) const {
-    zu64 max = size();
-    const codeunit *units = _data;
-    zu64 len = 0;
-    // Read and add code points
-    while(max && *units){
-        codepoint cp = _nextUTF8(&units, &max);
-        dest[0] = cp;
-        len++;
-        maxsize--;
-        dest++;
-    }
-    return len;
-}
-
 ZString::codepoint ZString::nextCodePoint(zsize &pos) const {
     zu64 max = size() - pos;
     const codeunit *units = _data + pos;
@@ -174,45 +166,34 @@ ZString::codepoint ZString::nextCodePoint(zsize &pos) const {
 
 ZString ZString::ItoS(zu64 value, zu8 base, zu64 pad, bool upper){
     ZString buffer;
-    if(base < 2 || base > 16)
+    char digits[ZNUMBERFORMAT_INT_SIZE];
+    const zu64 len = ZNumberFormat::formatUint(value, base, digits, upper);
+    if(!len)
         return buffer;
-    buffer._reserve(35);
-    zu64 quotient = value;
-    const char *digits = (upper ? "0123456789ABCDEF" : "0123456789abcdef");
-    do {
-        buffer += digits[ZMath::abs((zs64)(quotient % base))];
-        quotient /= base;
-    } while(quotient);
-    buffer.reverse();
-    if(buffer.size() < pad)
-        buffer.prepend(ZString('0', pad - buffer.size()));
+    const zu64 zeros = (pad > len ? pad - len : 0);
+    buffer._resize(zeros + len);
+    memset(buffer._data, '0', zeros);
+    ::memcpy(buffer._data + zeros, digits, len);
     return buffer;
 }
 
 ZString ZString::ItoS(zs64 value, zu8 base){
-    return (value < 0 ? "-" : "") + ItoS((zu64)ZMath::abs(value), base);
+    if(value >= 0)
+        return ItoS((zu64)value, base);
+    ZString buffer;
+    char digits[ZNUMBERFORMAT_INT_SIZE + 1];
+    digits[0] = '-';
+    // Negate as unsigned, so ZS64_MIN does not overflow
+    const zu64 len = ZNumberFormat::formatUint(0 - (zu64)value, base, digits + 1);
+    if(!len)
+        return buffer;
+    buffer._resize(len + 1);
+    ::memcpy(buffer._data, digits, len + 1);
+    return buffer;
 }
 
 bool ZString::isInteger(zu8 base) const {
-    if(isEmpty())
-        return false;
-    // Only supports up to hexadecimal
-    if(base < 2 || base > 16)
-        return false;
-
-    zu64 i = 0;
-    // Skip hexadecimal prefix
-    if(base == 16 && beginsWith("0x"))
-        i+=2;
-
-    for(; i < size(); ++i){
-        char ch = tolower(at(i));
-        if(i == 0 && ch == '-')
-            continue;
-        if((ch < '0' || ch > '9') && (ch < 'a' || ch > 'z'))
-            return false;
-    }
-    return true;
+    return view().isInteger(base);
 }
 
 int ZString::tint() const {
@@ -220,86 +201,23 @@ int ZString::tint() const {
 }
 
 zs64 ZString::toSint(zu8 base) const {
-    zu64 unum;
-    if(beginsWith("-")){
-        unum = ZString::substr(*this, 1).toUint();
-        if((zs64)unum < 0)
-            return ZS64_MIN;
-        return -(zs64)unum;
-    } else {
-        unum = toUint();
-        if((zs64)unum < 0)
-            return ZS64_MAX;
-        return (zs64)unum;
-    }
+    return view().toSint(base);
 }
 
 zu64 ZString::toUint(zu8 base) const {
-    if(!isInteger(base))
-        return 0;
-    // Only supports up to hexadecimal
-    if(base < 2 || base > 16)
-        return false;
-
-    ZString tmp = *this;
-    // Skip hexadecimal prefix
-    if(base == 16 && tmp.beginsWith("0x"))
-        tmp.substr(2);
-    tmp.reverse();
-    zu64 out = 0;
-    for(zu64 i = 0; i < tmp.size(); ++i){
-        char ch = tolower(tmp[i]);
-        if((ch < '0' || ch > '9') && (ch < 'a' || ch > 'z'))
-            return 0;
-        char digit = (ch < 58 ? (ch - '0') : (ch - 'a' + 10));
-        zu64 add = ((zu64)(digit) * (zu64)pow(base, i));
-        if(out + add < out)
-            return ZU64_MAX;
-        out += add;
-    }
-    return out;
+    return view().toUint(base);
 }
 
 bool ZString::isFloat() const {
-    if(isEmpty())
-        return false;
-    ZString tmp = *this;
-    if(tmp[0] == '-')
-        tmp.substr(1);
-    ArZ parts = tmp.explode('.');
-    if(parts.size() < 2)
-        return tmp.isInteger();
-    if(parts.size() > 2)
-        return false;
-    if(!parts[0].isInteger() || !parts[1].isInteger())
-        return false;
-    return true;
+    return view().isFloat();
 }
 
-// TODO: Fix ZString float conversion
 float ZString::toFloat() const {
-    if(!isFloat())
-        return 0.0f;
-    float out = 0.0f;
-    ZString tmp = *this;
-    bool neg = false;
-    if(tmp[0] == '-'){
-        neg = true;
-        tmp.substr(1);
-    }
-    ArZ parts = split('.');
-    ZString whole = reverse(parts[0]);
-    for(zu64 i = 0; i < whole.size(); ++i){
-        out += ((float)(whole[i] - 48) * pow(10, i));
-    }
-    if(parts.size() > 1){
-        for(zu64 i = 0; i < parts[1].size(); ++i){
-            out += ((float)(parts[1][i] - 48) * pow(10, -(zs64)i));
-        }
-    }
-    if(neg)
-        out = -out;
-    return out;
+    return (float)view().toDouble();
+}
+
+double ZString::toDouble() const {
+    return view().toDouble();
 }
 
 //
@@ -312,7 +230,7 @@ ZString &ZString::append(const ZString &str){
         // Resize buffer
         _resize(oldsize + str.size());
         // Raw copy other string to end
-        _alloc->rawcopy(str._data, _data + oldsize, str.size());
+        _alloc.rawcopy(str._data, _data + oldsize, str.size());
     }
     return *this;
 }
@@ -329,9 +247,9 @@ ZString &ZString::prepend(const ZString &str){
         // Resize buffer
         _resize(str.size() + oldsize);
         // Raw move string to end
-        _alloc->rawmove(_data, _data + str.size(), oldsize);
+        _alloc.rawmove(_data, _data + str.size(), oldsize);
         // Raw copy other string to beginning
-        _alloc->rawcopy(str._data, _data, str.size());
+        _alloc.rawcopy(str._data, _data, str.size());
     }
     return *this;
 }
@@ -340,7 +258,7 @@ ZString &ZString::substr(zu64 pos, zu64 len){
     if(pos < size()){
         len = MIN(len, size() - pos);
         // Construct new string from range and assign
-        _alloc->rawmove(_data + pos, _data, len);
+        _alloc.rawmove(_data + pos, _data, len);
         _resize(len);
         //assign(ZString(_data + pos, len));
     } else {
@@ -423,22 +341,7 @@ ZString ZString::reverse(ZString str){
 //
 
 zu64 ZString::count(ZString test) const {
-    ZString haystack = _data;
-    zu64 cnt = 0;
-    for(zu64 i = 0; i < haystack.size(); ++i){
-        if(haystack[i] == test[0]){
-            bool good = true;
-            for(zu64 g = i, j = 0; j < test.size(); ++g, ++j){
-                if(haystack[g] != test[j]){
-                    good = false;
-                    break;
-                }
-            }
-            if(good)
-                ++cnt;
-        }
-    }
-    return cnt;
+    return ZSearcher(test.view()).count(view(), true);
 }
 
 bool ZString::beginsWith(const ZString &test, bool ignorews) const {
@@ -460,33 +363,11 @@ bool ZString::beginsWith(const ZString &str, const ZString &test, bool ignorews)
 }
 
 bool ZString::endsWith(ZString test) const {
-    if(test.size() > size())
-        return false;
-    ZString end = substr(*this, size() - test.size(), test.size());
-    return test == end;
+    return view().endsWith(test);
 }
 
 zu64 ZString::findFirst(const ZString &find, zu64 start) const {
-    if(find.size() && find.size() <= size() && start < size()){
-        zu64 startpos = 0;
-        zu64 j = 0;
-        for(zu64 i = start; i < size(); ++i){
-            if(_data[i] == find[j]){
-                if(j == 0)
-                    // Find started
-                    startpos = i;
-                ++j;
-                if(j == find.size())
-                    // Find complete
-                    return startpos;
-            } else if(j != 0){
-                // Restart find after startpos
-                i = startpos;
-                j = 0;
-            }
-        }
-    }
-    return NONE;
+    return view().findFirst(find, start);
 }
 
 zu64 ZString::findFirst(const ZString &str, const ZString &find, zu64 start){
@@ -494,17 +375,7 @@ zu64 ZString::findFirst(const ZString &str, const ZString &find, zu64 start){
 }
 
 ZArray<zu64> ZString::findAll(const ZString &findstr) const {
-    ZArray<zu64> finds;
-    zu64 next = 0;
-    do {
-        zu64 pos = findFirst(findstr, next);
-        if(pos == NONE){
-            break;
-        }
-        finds.push(pos);
-        next = pos + findstr.size();
-    } while(next < size());
-    return finds;
+    return ZSearcher(findstr.view()).findAll(view());
 }
 
 ZArray<zu64> ZString::findAll(const ZString &str, const ZString &find){
@@ -531,15 +402,27 @@ ZString &ZString::replace(const ZString &before, const ZString &after, zu64 max)
     if(before.size() > size() || before == after)
         return *this;
 
-    zu64 count = 0;
-    zu64 next = 0;
-    while(max == 0 || count < max){
-        // Replace first occurrence
-        next = _strReplace(before, after, next);
-        if(next == NONE)
-            break;
-        ++count;
-    }
+    // Find the occurrences with one compiled pattern, then build the result in one buffer
+    ZSearcher searcher(before.view());
+    ZArray<zu64> found;
+    for(zu64 pos = searcher.find(view()); pos != NONE && (max == 0 || found.size() < max); pos = searcher.find(view(), pos + before.size()))
+        found.push(pos);
+    if(found.isEmpty())
+        return *this;
+
+    ZString out;
+    out._resize(size() - found.size() * before.size() + found.size() * after.size());
+    codeunit *dest = out._data;
+    zu64 prev = 0;
+    for(zu64 i = 0; i < found.size(); ++i){
+        _alloc.rawcopy(_data + prev, dest, found[i] - prev);
+        dest += found[i] - prev;
+        _alloc.rawcopy(after._data, dest, after.size());
+        dest += after.size();
+        prev = found[i] + before.size();
+    }
+    _alloc.rawcopy(_data + prev, dest, size() - prev);
+    swap(out);
     return *this;
 }
 
@@ -547,6 +430,50 @@ ZString ZString::replace(ZString str, const ZString &before, const ZString &afte
     return str.replace(before, after, max);
 }
 
+ZString &ZString::replaceAll(const ZMap<ZString, ZString> &replacements){
+    if(replacements.isEmpty() || isEmpty())
+        return *this;
+    ZArray<ZString> keys = replacements.keys();
+    ZArray<ZString> values;
+    values.reserve(keys.size());
+    for(zu64 i = 0; i < keys.size(); ++i)
+        values.push(replacements[keys[i]]);
+    return replaceAll(ZMultiSearcher(keys), values);
+}
+
+ZString ZString::replaceAll(ZString str, const ZMap<ZString, ZString> &replacements){
+    return str.replaceAll(replacements);
+}
+
+ZString &ZString::replaceAll(const ZMultiSearcher &searcher, const ZArray<ZString> &replacements){
+    if(replacements.size() != searcher.patternCount())
+        throw ZException("ZString replaceAll: Need one replacement per pattern");
+
+    ZArray<ZMultiSearcher::Match> found = searcher.findLeftmost(view());
+    if(found.isEmpty())
+        return *this;
+
+    zu64 total = size();
+    for(zu64 i = 0; i < found.size(); ++i)
+        total = total - searcher.pattern(found[i].pattern).size() + replacements[found[i].pattern].size();
+
+    ZString out;
+    out._resize(total);
+    codeunit *dest = out._data;
+    zu64 prev = 0;
+    for(zu64 i = 0; i < found.size(); ++i){
+        const ZString &after = replacements[found[i].pattern];
+        _alloc.rawcopy(_data + prev, dest, found[i].pos - prev);
+        dest += found[i].pos - prev;
+        _alloc.rawcopy(after._data, dest, after.size());
+        dest += after.size();
+        prev = found[i].pos + searcher.pattern(found[i].pattern).size();
+    }
+    _alloc.rawcopy(_data + prev, dest, size() - prev);
+    swap(out);
+    return *this;
+}
+
 ZString &ZString::replaceRecursive(const ZString &before, const ZString &after, zu64 max){
     if(before.size() > size() || before == after)
         return *this;
@@ -566,8 +493,7 @@ ZString ZString::replaceRecursive(ZString str, const ZString &before, const ZStr
 }
 
 ZString ZString::getUntil(ZString str, const ZString &find){
-    zu64 loc = findFirst(str, find);
-    return str.substr(0, loc);
+    return ZString(str.view().getUntil(find));
 }
 
 ZString ZString::findFirstBetween(ZString pre, ZString post){
@@ -753,48 +679,25 @@ ZString ZString::strip(ZString str, char target){
     return str.strip(target);
 }
 
-ArZ ZString::split(ZString delim) const {
+//! Copy each view in \a views into a new string.
+static ArZ viewsToStrings(const ArZV &views){
     ArZ out;
-    zu64 pos = findFirst(*this, delim);
-    if(pos == NONE){
-        out.push(*this);
-        return out;
-    }
-    out.push(substr(_data, 0, pos));
-    out.push(substr(_data, pos + delim.size()));
+    out.reserve(views.size());
+    for(zu64 i = 0; i < views.size(); ++i)
+        out.push(ZString(views[i]));
     return out;
 }
 
+ArZ ZString::split(ZString delim) const {
+    return viewsToStrings(view().split(delim));
+}
+
 ArZ ZString::explode(char delim) const {
-    ArZ out;
-    zu64 counter = 0;
-    for(zu64 i = 0; i < size(); ++i){
-        if(operator[](i) == delim){
-            if(counter){
-                out.push(substr(*this, i - counter, counter));
-                counter = 0;
-            }
-            continue;
-        }
-        ++counter;
-    }
-    if(counter)
-        out.push(substr(*this, size() - counter, counter));
-    return out;
+    return viewsToStrings(view().explode(delim));
 }
 
 ArZ ZString::strExplode(const ZString &delim) const {
-    ZArray<zu64> pos = findAll(delim);
-    ArZ out;
-    zu64 startpos = 0;
-    for(zu64 i = 0; i < pos.size(); ++i){
-        if(startpos < pos[i])
-            out.push(substr(*this, startpos, pos[i] - startpos));
-        startpos = pos[i] + delim.size();
-    }
-    if(startpos < size())
-        out.push(substr(*this, startpos));
-    return out;
+    return viewsToStrings(view().strExplode(delim));
 }
 
 ArZ ZString::quotedExplode(char delim) const {
@@ -804,13 +707,13 @@ ArZ ZString::quotedExplode(char delim) const {
     for(zu64 i = 0; i < size(); ++i){
         if(operator[](i) == '\"'){
             if(counter)
-                out.push(substr(*this, i - counter, counter));
+                out.push(ZString(view(i - counter, counter)));
             inquotes = !inquotes;
             counter = 0;
             continue;
         } else if(!inquotes && operator[](i) == delim){
             if(counter){
-                out.push(substr(*this, i - counter, counter));
+                out.push(ZString(view(i - counter, counter)));
                 counter = 0;
             }
             continue;
@@ -818,7 +721,7 @@ ArZ ZString::quotedExplode(char delim) const {
         ++counter;
     }
     if(counter)
-        out.push(substr(*this, size() - counter, counter));
+        out.push(ZString(view(size() - counter, counter)));
     return out;
 }
 
@@ -828,7 +731,7 @@ ArZ ZString::escapedExplode(char delim) const {
     for(zu64 i = 0; i < size(); ++i){
         if(operator[](i) == delim && i > 0 && operator[](i - 1) != '\\'){
             if(counter){
-                out.push(substr(*this, i - counter, counter));
+                out.push(ZString(view(i - counter, counter)));
                 counter = 0;
             }
             continue;
@@ -836,7 +739,7 @@ ArZ ZString::escapedExplode(char delim) const {
         ++counter;
     }
     if(counter)
-        out.push(substr(*this, size() - counter, counter));
+        out.push(ZString(view(size() - counter, counter)));
     return out;
 }
 
@@ -868,7 +771,7 @@ ArZ ZString::explodeList(unsigned nargs, ...) const {
         }
         if(delimfound){
             if(counter){
-                out.push(substr(*this, i - counter, counter));
+                out.push(ZString(view(i - counter, counter)));
                 counter = 0;
             }
             continue;
@@ -876,7 +779,7 @@ ArZ ZString::explodeList(unsigned nargs, ...) const {
         ++counter;
     }
     if(counter)
-        out.push(substr(*this, size() - counter, counter));
+        out.push(ZString(view(size() - counter, counter)));
     return out;
 }
 #undef VAARGTYPE
@@ -985,28 +888,44 @@ bool ZString::alphaTest(ZString str1, ZString str2){
     return false;
 }
 
+ZString &ZString::operator=(ZString &&rhs){
+    swap(rhs);
+    _alloc.swap(rhs._alloc);
+    return *this;
+}
+
 void ZString::swap(ZString &other){
     zu64 size = _size;
-    zu64 realsize = _realsize;
+    zu64 realsize = 0;
     codeunit *data = _data;
+    codeunit sso[ZSTRING_SSO_SIZE + 1];
+    if(_isInline())
+        ::memcpy(sso, _sso, _size + 1);
+    else
+        realsize = _realsize;
+
+    if(other._isInline()){
+        ::memcpy(_sso, other._sso, other._size + 1);
+        _data = _sso;
+    } else {
+        _data = other._data;
+        _realsize = other._realsize;
+    }
     _size = other._size;
-    _realsize = other._realsize;
-    _data = other._data;
+
+    if(data == _sso){
+        ::memcpy(other._sso, sso, size + 1);
+        other._data = other._sso;
+    } else {
+        other._data = data;
+        other._realsize = realsize;
+    }
     other._size = size;
-    other._realsize = realsize;
-    other._data = data;
 }
 
 zu64 ZString::length() const {
-    zu64 max = size();
-    const codeunit *units = _data;
-    zu64 len = 0;
-    // Read and add code points
-    while(max && *units){
-        zassert(_nextUTF8(&units, &max), "corrupt UTF-8 in zstring");
-        len++;
-    }
-    return len;
+    // The buffer is valid UTF-8, so count the bytes that start a code point
+    return countCodePoints(_data, strnlen(cc(), size()));
 }
 
 // ///////////////////////////////////////////////////////////////////////////////
@@ -1014,15 +933,17 @@ zu64 ZString::length() const {
 // ///////////////////////////////////////////////////////////////////////////////
 
 void ZString::_reserve(zu64 size){
-    if(size > _realsize || _data == nullptr){ // Only reallocate if new size is larger than buffer
+    zu64 capacity = _capacity();
+    if(size > capacity){ // Only reallocate if new size is larger than buffer
         // TEST: newsize, but always leave extra space for null terminator, but don't count null terminator in realsize
-        zu64 newsize = MAX(_realsize * 2, size);
-        codeunit *buff = _alloc->alloc(newsize + 1); // New size + null terminator
-        _alloc->rawcopy(_data, buff, _size); // Copy data to new buffer
-        // Update new buffer size
-        _realsize = newsize;
-        _alloc->dealloc(_data); // Delete old buffer
+        zu64 newsize = MAX(capacity * 2, size);
+        codeunit *buff = _alloc.alloc(newsize + 1); // New size + null terminator
+        _alloc.rawcopy(_data, buff, _size); // Copy data to new buffer
+        if(!_isInline())
+            _alloc.dealloc(_data); // Delete old buffer
         _data = buff;
+        // Update new buffer size, the inline buffer is no longer used
+        _realsize = newsize;
     }
 }
 
@@ -11,6 +11,7 @@
 #include "zallocator.h"
 #include "zarray.h"
 #include "zlist.h"
+#include "zstringview.h"
 
 // Needed for std::ostream overload
 #include <iosfwd>
@@ -21,9 +22,15 @@
     #include <string>
 #endif
 
+//! Longest string stored in the inline buffer, without allocating.
+#define ZSTRING_SSO_SIZE 23
+
 namespace LibChaos {
 
 class ZString;
+class ZStringBuilder;
+class ZMultiSearcher;
+template <typename K, typename T> class ZMap;
 typedef ZArray<ZString> ArZ;
 
 /*! UTF-8 contiguous string container.
@@ -35,6 +42,7 @@ typedef ZArray<ZString> ArZ;
  *  Internal buffer will always be valid null-terminated UTF-8 representing a sequence of valid Unicode code points.
  */
 class ZString : public ZAccessor<char> {
+    friend class ZStringBuilder;
 public:
     typedef zu32 codepoint;
     typedef zbyte codeunit8;
@@ -45,12 +53,15 @@ public:
     enum { NONE = ZU64_MAX };
 
 public:
-    //! Default constructor with optional user allocator.
-    ZString(ZAllocator<codeunit> *alloc = new ZAllocator<codeunit>);
+    //! Default constructor with optional user allocator (ZString takes ownership).
+    ZString(ZAllocator<codeunit> *alloc = nullptr);
 
     //! Copy constructor.
     ZString(const ZString &other);
 
+    //! Move constructor. Takes the buffer and allocator of \a other, leaving it empty.
+    ZString(ZString &&other);
+
     //! Destructor.
     ~ZString();
 
@@ -72,6 +83,9 @@ public:
     //! Construct from UTF-8 STL string.
     ZString(std::string str);
 
+    //! Construct from the characters in \a view.
+    explicit ZString(ZStringView view);
+
     //! Construct from UTF-16 null-terminated wide C-string.
     ZString(const wchar_t *wstr, zu64 max = ZU64_MAX);
     //! Construct from UTF-16 wide character array.
@@ -92,7 +106,9 @@ public:
     ZString(zull num) : ZString(ItoS((zu64)num, 10)){}
     ZString(zsll num) : ZString(ItoS((zs64)num, 10)){}
 
-    // Construct from double with <places> decimal points, 0 means all
+    /*! Construct from double, with the shortest digits that parse back to the same double.
+     *  Truncated to \a places decimal places, 0 means all.
+     */
     ZString(double flt, unsigned places = 0);
 
     // Operators
@@ -100,10 +116,14 @@ public:
     // Assignment
     ZString &assign(const ZString &other);
     inline ZString &operator=(const ZString &rhs){ return assign(rhs); }
+    //! Move assignment, swaps buffers and allocators with \a rhs.
+    ZString &operator=(ZString &&rhs);
 
     // Comparison
     friend bool operator==(const ZString &lhs, const ZString &rhs);
     friend bool operator!=(const ZString &lhs, const ZString &rhs);
+    //! Byte-wise lexicographic ordering.
+    friend bool operator<(const ZString &lhs, const ZString &rhs);
 
     // String Conversions
 
@@ -122,6 +142,13 @@ public:
     //! Get constant reference to byte \a i.
     inline const zbyte &byte(zu64 i) const { return bytes()[i]; }
 
+    //! Get a view of the string, valid until the string is modified.
+    inline ZStringView view() const { return ZStringView(cc(), size()); }
+    //! Get a view of up to \a len characters after \a pos, valid until the string is modified.
+    inline ZStringView view(zu64 pos, zu64 len = NONE) const { return view().substr(pos, len); }
+    //! Implicitly view the string, so it can be passed to functions that take a ZStringView.
+    inline operator ZStringView() const { return view(); }
+
     //! Get UTF-8 STL string.
     std::string str() const;
 
@@ -160,9 +187,12 @@ public:
      */
     zu64 toUint(zu8 base = 10) const;
 
-    // To floating point
+    //! Determine if string is a decimal number, with an optional sign, decimal point and exponent. Does not accept inf or nan.
     bool isFloat() const;
+    //! Parse string as a decimal number. Returns 0 on failure.
     float toFloat() const;
+    //! Parse string as a decimal number, rounded to the nearest double. Returns 0 on failure.
+    double toDouble() const;
 
     // Clear
     inline void clear(){ _resize(0); }
@@ -180,6 +210,8 @@ public:
     ZString concat(const ZString &str) const;
     //! Concatenate \a lhs and \a rhs.
     friend ZString operator+(const ZString &lhs, const ZString &rhs);
+    //! Append \a rhs to temporary \a lhs, so chains like a + b + c reuse one growing buffer.
+    friend ZString operator+(ZString &&lhs, const ZString &rhs);
 
     //! Prepend \a str to string.
     ZString &prepend(const ZString &str);
@@ -211,7 +243,7 @@ public:
 
     // Basic String Parsing
 
-    //! Count occurrences of \a test.
+    //! Count occurrences of \a test, including overlapping occurrences.
     zu64 count(ZString test) const;
 
     //! Tests if \a str begins with \a test. Ignores whitespace at beginning of string if \a ignore_whitespace.
@@ -266,6 +298,18 @@ public:
      */
     static ZString replace(ZString str, const ZString &before, const ZString &after, zu64 max = 0);
 
+    /*! Replace each key of \a replacements in string with its value, in one pass.
+     *  Replaced text is not searched again. Where keys overlap, the one that occurs first is replaced, and the longest of those.
+     *  To replace the same keys in many strings, compile them once in a ZMultiSearcher.
+     */
+    ZString &replaceAll(const ZMap<ZString, ZString> &replacements);
+    //! Replace each key of \a replacements in \a str with its value, in one pass.
+    static ZString replaceAll(ZString str, const ZMap<ZString, ZString> &replacements);
+    /*! Replace each pattern of \a searcher in string with the string at the same index in \a replacements, in one pass.
+     *  \throws ZException if there is not one replacement per pattern.
+     */
+    ZString &replaceAll(const ZMultiSearcher &searcher, const ZArray<ZString> &replacements);
+
     /*! Replace the first occurrence of \a before in string with \a after, up to \a max times.
      *  Replaces recursively, so will search entire string each replace.
      *  \param before String to search for.
@@ -368,6 +412,13 @@ public:
     //! Parse UTF-32 string at \a units and replace this string with normalized UTF-8.
     void parseUTF32(const codeunit32 *units, zu64 max);
 
+    //! Determine if null-terminated \a str is valid UTF-8. Only tab, line feed and carriage return are accepted from the ASCII control characters.
+    static bool isUTF8(const char *str);
+    //! Determine if \a size bytes at \a str are valid UTF-8.
+    static bool isUTF8(const char *str, zu64 size);
+    //! Count the code points in \a size bytes of valid UTF-8 at \a units.
+    static zu64 countCodePoints(const codeunit8 *units, zu64 size);
+
     //! Get debug information on a UTF-8 string.
     static void debugUTF8(const codeunit *bytes);
 
@@ -437,6 +488,8 @@ private:
     void _appendCodePoint(codepoint cp);
     static void _appendUTF16(std::wstring &str, codepoint cp);
 
+    //! Encode \a cp as UTF-8 at \a units, up to 6 bytes. \return Number of bytes, zero for invalid code points.
+    static zu8 _encodeUTF8(codeunit8 *units, codepoint cp);
     static zu8 _encodeUTF16(codeunit16 *units, codepoint cp);
 
     //! Decode the next UTF-8 code point.
@@ -445,27 +498,40 @@ private:
     static codepoint _nextUTF16(const codeunit16 **units, zu64 *maxunits);
     //! Decode the next UTF-32 code point.
     static codepoint _nextUTF32(const codeunit32 **units, zu64 *maxunits);
-
-    //! Determine if \a str is valid UTF-8.
-    static bool isUTF8(const char *str);
+    //! Replace this string with code units at \a units decoded by \a next, each encoded in at most 1 + \a extra bytes.
+    template <typename U> void _parseUnits(const U *units, zu64 max, codepoint (*next)(const U **, zu64 *), zu64 extra);
 
     //! Normalize UTF-8 in this string container.
     void unicode_normalize();
 
+private:
+    //! Check if the string is in the inline buffer.
+    inline bool _isInline() const { return _data == _sso; }
+    //! Get the buffer size, not counting the null terminator.
+    inline zu64 _capacity() const { return (_isInline() ? ZSTRING_SSO_SIZE : _realsize); }
+
 private:
     //! Allocator.
-    ZAllocator<codeunit> *_alloc;
+    ZAllocatorHandle<codeunit> _alloc;
     //! Length of string in bytes.
     zu64 _size;
-    //! Size of real buffer.
-    zu64 _realsize;
-    //! String buffer.
+    //! String buffer, points to _sso until the string outgrows it.
     codeunit *_data;
+    union {
+        //! Size of heap buffer.
+        zu64 _realsize;
+        //! Inline buffer for short strings.
+        codeunit _sso[ZSTRING_SSO_SIZE + 1];
+    };
 };
 
 inline ZString operator+(const ZString &lhs, const ZString &rhs){
     return lhs.concat(rhs);
 }
+inline ZString operator+(ZString &&lhs, const ZString &rhs){
+    lhs.append(rhs);
+    return ZString(static_cast<ZString &&>(lhs));
+}
 
 inline bool operator==(const ZString &lhs, const ZString &rhs){
     if(lhs.size() != rhs.size())
@@ -475,6 +541,10 @@ inline bool operator==(const ZString &lhs, const ZString &rhs){
 inline bool operator!=(const ZString &lhs, const ZString &rhs){
     return !operator==(lhs, rhs);
 }
+inline bool operator<(const ZString &lhs, const ZString &rhs){
+    int cmp = memcmp(lhs._data, rhs._data, MIN(lhs.size(), rhs.size()));
+    return (cmp < 0 || (cmp == 0 && lhs.size() < rhs.size()));
+}
 
 } // namespace LibChaos
 
@@ -0,0 +1,152 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                             zstringbuilder.cpp                             **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#include "zstringbuilder.h"
+#include "znumberformat.h"
+
+#include <string.h>
+
+namespace LibChaos {
+
+static const char hexDigits[] = "0123456789abcdef";
+
+ZStringBuilder::ZStringBuilder(zu64 capacity) : _normalize(false){
+    reserve(capacity);
+}
+
+void ZStringBuilder::reserve(zu64 size){
+    _buffer._reserve(size);
+}
+
+ZStringBuilder &ZStringBuilder::append(const ZString &str){
+    // Already valid UTF-8
+    if(str.size())
+        ::memcpy(_extend(str.size()), str.cc(), str.size());
+    return *this;
+}
+
+ZStringBuilder &ZStringBuilder::append(ZStringView str){
+    if(str.size()){
+        _check(str.data(), str.size());
+        ::memcpy(_extend(str.size()), str.data(), str.size());
+    }
+    return *this;
+}
+
+ZStringBuilder &ZStringBuilder::append(const char *str){
+    return append(ZStringView(str));
+}
+
+ZStringBuilder &ZStringBuilder::append(const zbyte *data, zu64 size){
+    return append(ZStringView((const char *)data, size));
+}
+
+ZStringBuilder &ZStringBuilder::append(char ch){
+    _check(&ch, 1);
+    *_extend(1) = ch;
+    return *this;
+}
+
+ZStringBuilder &ZStringBuilder::append(char ch, zu64 count){
+    if(count){
+        _check(&ch, 1);
+        memset(_extend(count), ch, count);
+    }
+    return *this;
+}
+
+ZStringBuilder &ZStringBuilder::append(double num){
+    // Format straight into spare capacity at the end of the buffer
+    const zu64 old = _buffer._size;
+    _buffer._reserve(old + ZNUMBERFORMAT_DOUBLE_SIZE);
+    _buffer._resize(old + ZNumberFormat::formatDouble(num, (char *)_buffer._data + old));
+    return *this;
+}
+
+ZStringBuilder &ZStringBuilder::appendUint(zu64 num){
+    const zu64 old = _buffer._size;
+    _buffer._reserve(old + ZNUMBERFORMAT_INT_SIZE);
+    _buffer._resize(old + ZNumberFormat::formatUint(num, (char *)_buffer._data + old));
+    return *this;
+}
+
+ZStringBuilder &ZStringBuilder::appendSint(zs64 num){
+    const zu64 old = _buffer._size;
+    _buffer._reserve(old + ZNUMBERFORMAT_INT_SIZE);
+    _buffer._resize(old + ZNumberFormat::formatSint(num, (char *)_buffer._data + old));
+    return *this;
+}
+
+ZStringBuilder &ZStringBuilder::appendUint(zu64 num, zu8 base, zu64 pad, bool upper){
+    char digits[ZNUMBERFORMAT_INT_SIZE];
+    const zu64 len = ZNumberFormat::formatUint(num, base, digits, upper);
+    if(!len)
+        return *this;
+    if(pad > len)
+        append('0', pad - len);
+    ::memcpy(_extend(len), digits, len);
+    return *this;
+}
+
+ZStringBuilder &ZStringBuilder::appendHex(const zbyte *data, zu64 size){
+    char *out = _extend(size * 2);
+    for(zu64 i = 0; i < size; ++i){
+        out[i * 2] = hexDigits[data[i] >> 4];
+        out[i * 2 + 1] = hexDigits[data[i] & 0xF];
+    }
+    return *this;
+}
+
+void ZStringBuilder::clear(){
+    _buffer._resize(0);
+    _normalize = false;
+}
+
+ZString ZStringBuilder::str() const {
+    if(_normalize)
+        return ZString(view());
+    return _buffer;
+}
+
+ZString ZStringBuilder::take(){
+    ZString out;
+    if(_normalize)
+        out = ZString(view());
+    else
+        out.swap(_buffer);
+    clear();
+    return out;
+}
+
+zu64 ZStringBuilder::writeTo(ZWriter *writer) const {
+    if(_normalize){
+        ZString out = str();
+        return writer->write(out.bytes(), out.size());
+    }
+    return writer->write(_buffer.bytes(), _buffer.size());
+}
+
+char *ZStringBuilder::_extend(zu64 size){
+    const zu64 old = _buffer._size;
+    _buffer._resize(old + size);
+    return (char *)_buffer._data + old;
+}
+
+void ZStringBuilder::_check(const char *data, zu64 size){
+    if(_normalize)
+        return;
+    // Short printable ASCII fragments, like most literals, are checked inline
+    if(size <= 32){
+        zu64 i = 0;
+        while(i < size && (zu8)(data[i] - 0x20) < 0x5F)
+            ++i;
+        if(i == size)
+            return;
+    }
+    if(!ZString::isUTF8(data, size))
+        _normalize = true;
+}
+
+}
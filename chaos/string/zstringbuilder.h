@@ -0,0 +1,107 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                              zstringbuilder.h                              **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZSTRINGBUILDER_H
+#define ZSTRINGBUILDER_H
+
+#include "ztypes.h"
+#include "zstring.h"
+#include "zstringview.h"
+#include "zwriter.h"
+
+namespace LibChaos {
+
+/*! Accumulates string fragments in one geometrically grown buffer.
+ *  \ingroup String
+ *  Strings, characters and bytes are copied in place, and numbers are formatted straight into the buffer
+ *  with ZNumberFormat, so no temporary ZString is made per fragment.
+ *  reserve() plans the capacity up front when the final size is known or can be estimated.
+ *
+ *  Fragments that are not a ZString are checked as they are appended. If any was not valid UTF-8,
+ *  the result is normalized once, when materialized with str() or take(), or written with writeTo().
+ */
+class ZStringBuilder {
+public:
+    //! Construct with room for \a capacity bytes.
+    ZStringBuilder(zu64 capacity = 0);
+
+    //! Make room for at least \a size bytes in total.
+    void reserve(zu64 size);
+
+    //! Append \a str.
+    ZStringBuilder &append(const ZString &str);
+    //! Append \a str.
+    ZStringBuilder &append(ZStringView str);
+    //! Append null-terminated \a str.
+    ZStringBuilder &append(const char *str);
+    //! Append \a size bytes at \a data.
+    ZStringBuilder &append(const zbyte *data, zu64 size);
+    //! Append \a ch.
+    ZStringBuilder &append(char ch);
+    //! Append \a ch repeated \a count times.
+    ZStringBuilder &append(char ch, zu64 count);
+
+    // Numbers are appended in decimal, like the ZString number constructors
+    inline ZStringBuilder &append(zuc num){ return appendUint(num); }
+    inline ZStringBuilder &append(zsc num){ return appendSint(num); }
+    inline ZStringBuilder &append(zus num){ return appendUint(num); }
+    inline ZStringBuilder &append(zss num){ return appendSint(num); }
+    inline ZStringBuilder &append(zuint num){ return appendUint(num); }
+    inline ZStringBuilder &append(zint num){ return appendSint(num); }
+    inline ZStringBuilder &append(zul num){ return appendUint(num); }
+    inline ZStringBuilder &append(zsl num){ return appendSint(num); }
+    inline ZStringBuilder &append(zull num){ return appendUint(num); }
+    inline ZStringBuilder &append(zsll num){ return appendSint(num); }
+    //! Append \a num, formatted like ZString(double).
+    ZStringBuilder &append(double num);
+
+    //! Append \a num in decimal.
+    ZStringBuilder &appendUint(zu64 num);
+    //! Append \a num in decimal.
+    ZStringBuilder &appendSint(zs64 num);
+    //! Append \a num in \a base, zero padded to at least \a pad digits, like ZString::ItoS().
+    ZStringBuilder &appendUint(zu64 num, zu8 base, zu64 pad = 0, bool upper = false);
+    //! Append \a size bytes at \a data as pairs of lowercase hexadecimal digits.
+    ZStringBuilder &appendHex(const zbyte *data, zu64 size);
+
+    //! Operator overload for append().
+    template <typename T> inline ZStringBuilder &operator<<(const T &value){ return append(value); }
+
+    //! Remove all fragments, keeping the buffer.
+    void clear();
+
+    //! Number of bytes appended.
+    zu64 size() const { return _buffer._size; }
+    bool isEmpty() const { return _buffer._size == 0; }
+    //! Number of bytes that fit without growing the buffer.
+    zu64 capacity() const { return _buffer._capacity(); }
+
+    //! View of the appended bytes, before normalization. Only valid until the builder is modified.
+    ZStringView view() const { return ZStringView(_buffer.cc(), _buffer._size); }
+
+    //! Make a string of exactly the appended size.
+    ZString str() const;
+    //! Take the buffer as a string without copying, leaving the builder empty.
+    ZString take();
+
+    //! Write the string to \a writer. \return Number of bytes written.
+    zu64 writeTo(ZWriter *writer) const;
+
+private:
+    //! Grow the buffer by \a size bytes. \return Pointer to the new bytes.
+    char *_extend(zu64 size);
+    //! Mark the builder for normalization if \a size bytes at \a data are not valid UTF-8.
+    void _check(const char *data, zu64 size);
+
+private:
+    //! Buffer, grown through ZString's geometric reserve.
+    ZString _buffer;
+    //! Set when an appended fragment was not valid UTF-8.
+    bool _normalize;
+};
+
+}
+
+#endif // ZSTRINGBUILDER_H
@@ -0,0 +1,186 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                               zstringview.cpp                              **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#include "zstringview.h"
+#include "zsearcher.h"
+#include "znumberformat.h"
+
+#include <ostream>
+
+namespace LibChaos {
+
+zu64 ZStringView::findFirst(ZStringView find, zu64 start) const {
+    return ZSearcher::find((const zbyte *)_data, _size, (const zbyte *)find._data, find._size, start);
+}
+
+zu64 ZStringView::findFirst(char ch, zu64 start) const {
+    if(start >= _size)
+        return NONE;
+    const char *ptr = (const char *)memchr(_data + start, ch, _size - start);
+    return (ptr ? (zu64)(ptr - _data) : NONE);
+}
+
+zu64 ZStringView::count(ZStringView find) const {
+    return ZSearcher(find).count(*this);
+}
+
+ZStringView ZStringView::findFirstBetween(ZStringView pre, ZStringView post) const {
+    zu64 start = findFirst(pre);
+    if(start == NONE)
+        return ZStringView();
+    start += pre._size;
+    zu64 end = findFirst(post, start);
+    if(end == NONE)
+        return ZStringView();
+    return ZStringView(_data + start, end - start);
+}
+
+ZStringView ZStringView::stripFront(char target) const {
+    zu64 i = 0;
+    while(i < _size && _data[i] == target)
+        ++i;
+    return ZStringView(_data + i, _size - i);
+}
+
+ZStringView ZStringView::stripBack(char target) const {
+    zu64 len = _size;
+    while(len > 0 && _data[len - 1] == target)
+        --len;
+    return ZStringView(_data, len);
+}
+
+ZStringView ZStringView::nextToken(char delim){
+    // Skip leading delimiters
+    zu64 start = 0;
+    while(start < _size && _data[start] == delim)
+        ++start;
+    zu64 end = findFirst(delim, start);
+    if(end == NONE)
+        end = _size;
+    ZStringView token(_data + start, end - start);
+    // Drop the token and the delimiters after it
+    while(end < _size && _data[end] == delim)
+        ++end;
+    removePrefix(end);
+    return token;
+}
+
+ArZV ZStringView::split(ZStringView delim) const {
+    ArZV out;
+    zu64 pos = findFirst(delim);
+    if(pos == NONE){
+        out.push(*this);
+        return out;
+    }
+    out.push(substr(0, pos));
+    out.push(substr(pos + delim._size));
+    return out;
+}
+
+ArZV ZStringView::explode(char delim) const {
+    ArZV out;
+    ZStringView rest = *this;
+    while(true){
+        ZStringView token = rest.nextToken(delim);
+        if(token.isEmpty())
+            break;
+        out.push(token);
+    }
+    return out;
+}
+
+ArZV ZStringView::strExplode(ZStringView delim) const {
+    ArZV out;
+    if(delim.isEmpty()){
+        if(_size)
+            out.push(*this);
+        return out;
+    }
+    zu64 startpos = 0;
+    zu64 pos = findFirst(delim);
+    while(pos != NONE){
+        if(startpos < pos)
+            out.push(ZStringView(_data + startpos, pos - startpos));
+        startpos = pos + delim._size;
+        pos = findFirst(delim, startpos);
+    }
+    if(startpos < _size)
+        out.push(ZStringView(_data + startpos, _size - startpos));
+    return out;
+}
+
+bool ZStringView::isInteger(zu8 base) const {
+    // Only supports up to hexadecimal
+    if(base < 2 || base > 16)
+        return false;
+
+    ZStringView digits = *this;
+    if(digits.beginsWith("-"))
+        digits.removePrefix(1);
+    // Skip hexadecimal prefix
+    if(base == 16 && digits.beginsWith("0x"))
+        digits.removePrefix(2);
+    if(digits.isEmpty())
+        return false;
+
+    zu64 value;
+    return ZNumberFormat::parseUint(digits._data, digits._size, &value, base) == digits._size;
+}
+
+zs64 ZStringView::toSint(zu8 base) const {
+    if(beginsWith("-")){
+        zu64 unum = substr(1).toUint(base);
+        if(unum > (zu64)ZS64_MAX + 1)
+            return ZS64_MIN;
+        return (zs64)(0 - unum);
+    } else {
+        zu64 unum = toUint(base);
+        if(unum > (zu64)ZS64_MAX)
+            return ZS64_MAX;
+        return (zs64)unum;
+    }
+}
+
+zu64 ZStringView::toUint(zu8 base) const {
+    if(base < 2 || base > 16 || beginsWith("-"))
+        return 0;
+
+    ZStringView digits = *this;
+    // Skip hexadecimal prefix
+    if(base == 16 && digits.beginsWith("0x"))
+        digits.removePrefix(2);
+    if(digits.isEmpty())
+        return 0;
+
+    // Parse and check in one pass, saturates on overflow
+    zu64 value;
+    if(ZNumberFormat::parseUint(digits._data, digits._size, &value, base) != digits._size)
+        return 0;
+    return value;
+}
+
+bool ZStringView::isFloat() const {
+    double value;
+    return _size && ZNumberFormat::parseDouble(_data, _size, &value, true) == _size;
+}
+
+double ZStringView::toDouble() const {
+    double value;
+    if(!_size || ZNumberFormat::parseDouble(_data, _size, &value, true) != _size)
+        return 0;
+    return value;
+}
+
+bool operator<(ZStringView lhs, ZStringView rhs){
+    int cmp = memcmp(lhs._data, rhs._data, MIN(lhs._size, rhs._size));
+    return (cmp < 0 || (cmp == 0 && lhs._size < rhs._size));
+}
+
+std::ostream &operator<<(std::ostream &lhs, ZStringView rhs){
+    lhs.write(rhs._data, (std::streamsize)rhs._size);
+    return lhs;
+}
+
+}
@@ -0,0 +1,173 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                                zstringview.h                               **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZSTRINGVIEW_H
+#define ZSTRINGVIEW_H
+
+#include "ztypes.h"
+#include "zarray.h"
+
+#include <cstring>
+// Needed for std::ostream overload
+#include <iosfwd>
+
+namespace LibChaos {
+
+class ZStringView;
+typedef ZArray<ZStringView> ArZV;
+
+/*! Non-owning view of a UTF-8 string.
+ *  \ingroup String
+ *  A pointer and a length into characters owned by something else, usually a ZString or an input buffer.
+ *  Slicing, searching, comparing and tokenizing a view never allocates.
+ *  A view is only valid as long as the characters it refers to are not modified or destroyed.
+ */
+class ZStringView {
+public:
+    enum { NONE = ZU64_MAX };
+
+public:
+    //! Empty view.
+    ZStringView() : _data(""), _size(0){}
+    //! View of null-terminated C-string \a str.
+    ZStringView(const char *str) : _data(str), _size(strlen(str)){}
+    //! View of \a size characters at \a str.
+    ZStringView(const char *str, zu64 size) : _data(str), _size(size){}
+
+    //! Get pointer to the first character. Not null-terminated.
+    inline const char *data() const { return _data; }
+    //! Number of bytes (code units).
+    inline zu64 size() const { return _size; }
+    inline bool isEmpty() const { return (_size == 0); }
+
+    //! Get character at \a i.
+    inline char at(zu64 i) const {
+#if LIBCHAOS_BUILD != LIBCHAOS_RELEASE
+        if(i >= _size)
+            throw zexception("ZStringView: Index out of range");
+#endif
+        return _data[i];
+    }
+    inline char operator[](zu64 i) const { return at(i); }
+
+    //! Get view of up to \a len characters after \a pos.
+    ZStringView substr(zu64 pos, zu64 len = NONE) const {
+        if(pos > _size)
+            pos = _size;
+        if(len > _size - pos)
+            len = _size - pos;
+        return ZStringView(_data + pos, len);
+    }
+
+    //! Drop \a count characters from the front of the view.
+    void removePrefix(zu64 count){
+        if(count > _size)
+            count = _size;
+        _data += count;
+        _size -= count;
+    }
+    //! Drop \a count characters from the back of the view.
+    void removeSuffix(zu64 count){
+        _size -= (count > _size ? _size : count);
+    }
+
+    // String Parsing
+
+    //! Tests if view begins with \a test.
+    bool beginsWith(ZStringView test) const {
+        return test._size <= _size && memcmp(_data, test._data, test._size) == 0;
+    }
+    //! Tests if view ends with \a test.
+    bool endsWith(ZStringView test) const {
+        return test._size <= _size && memcmp(_data + _size - test._size, test._data, test._size) == 0;
+    }
+
+    /*! Get location of first occurrence of \a find in view after \a start.
+     *  \return Index of first character of \a find if found, else \ref NONE.
+     */
+    zu64 findFirst(ZStringView find, zu64 start = 0) const;
+    /*! Get location of first occurrence of \a ch in view after \a start.
+     *  \return Index of \a ch if found, else \ref NONE.
+     */
+    zu64 findFirst(char ch, zu64 start = 0) const;
+
+    //! Count non-overlapping occurrences of \a find.
+    zu64 count(ZStringView find) const;
+
+    //! Get view before first occurence of \a find, or the whole view if not found.
+    ZStringView getUntil(ZStringView find) const {
+        return substr(0, findFirst(find));
+    }
+    //! Get view between the first \a pre and the next \a post after it, empty if either is not found.
+    ZStringView findFirstBetween(ZStringView pre, ZStringView post) const;
+
+    //! Get view without occurences of \a target at the beginning.
+    ZStringView stripFront(char target) const;
+    //! Get view without occurences of \a target at the end.
+    ZStringView stripBack(char target) const;
+    //! Get view without occurences of \a target at the beginning and end.
+    ZStringView strip(char target) const { return stripFront(target).stripBack(target); }
+
+    // Tokenizing
+
+    /*! Get the next token before \a delim, and drop it and the delimiters after it from the view.
+     *  Like ZString::explode(), consecutive delimiters are treated as one and leading delimiters are skipped.
+     *  Returns an empty view when no tokens are left.
+     */
+    ZStringView nextToken(char delim);
+
+    //! Split view into views before and after the first occurence of \a delim.
+    ArZV split(ZStringView delim) const;
+    //! Explode view into views between \a delim, following ZString::explode() rules.
+    ArZV explode(char delim) const;
+    //! Explode view into views between occurences of \a delim, following ZString::strExplode() rules.
+    ArZV strExplode(ZStringView delim) const;
+
+    // Numerical Conversions
+
+    //! Determine if view is an integer in \a base.
+    bool isInteger(zu8 base = 10) const;
+
+    /*! Parse view as a signed integer.
+     *  Supports up to base 16.
+     *  Returns 0 on failure.
+     *  Returns ZS64_MIN or ZS64_MAX on overflow.
+     */
+    zs64 toSint(zu8 base = 10) const;
+
+    /*! Parse view as an unsigned integer.
+     *  Supports up to base 16.
+     *  Returns 0 on failure.
+     *  Returns ZU64_MAX on overflow.
+     */
+    zu64 toUint(zu8 base = 10) const;
+
+    //! Determine if view is a decimal number, with an optional sign, decimal point and exponent. Does not accept inf or nan.
+    bool isFloat() const;
+    //! Parse view as a decimal number, rounded to the nearest double. Returns 0 on failure.
+    double toDouble() const;
+
+    // Comparison
+
+    friend inline bool operator==(ZStringView lhs, ZStringView rhs){
+        return lhs._size == rhs._size && memcmp(lhs._data, rhs._data, lhs._size) == 0;
+    }
+    friend inline bool operator!=(ZStringView lhs, ZStringView rhs){
+        return !(lhs == rhs);
+    }
+    //! Lexicographical byte comparison.
+    friend bool operator<(ZStringView lhs, ZStringView rhs);
+
+    //! Allow ZStringView to be used with std streams.
+    friend std::ostream &operator<<(std::ostream &lhs, ZStringView rhs);
+
+private:
+    const char *_data;
+    zu64 _size;
+};
+
+}
+
+#endif // ZSTRINGVIEW_H
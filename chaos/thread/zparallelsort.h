@@ -0,0 +1,122 @@
+/*******************************************************************************
+**                                  LibChaos                                  **
+**                               zparallelsort.h                              **
+**                          See COPYRIGHT and LICENSE                         **
+*******************************************************************************/
+#ifndef ZPARALLELSORT_H
+#define ZPARALLELSORT_H
+
+#include "zsort.h"
+#include "zarray.h"
+#include "zthread.h"
+
+#include <thread>
+
+//! Arrays smaller than this are sorted on the calling thread.
+#define ZPARALLELSORT_MIN   ((zu64)1 << 16)
+
+namespace LibChaos {
+
+/*! Multi-threaded sorting of large arrays.
+ *  The array is split into one chunk per thread, each chunk is sorted with ZSort on its own ZThread,
+ *  then neighbouring chunks are merged in rounds, each round's merges also running in parallel.
+ *  \ingroup Thread
+ */
+class ZParallelSort {
+public:
+    /*! Sort \a size elements at \a data with \a threads threads. Not stable.
+     *  \a threads of zero uses one thread per hardware thread.
+     */
+    template <typename T, typename L = ZLess<T>> static void sort(T *data, zu64 size, L less = L(), zu64 threads = 0){
+        _sort(data, size, less, threads, false);
+    }
+    //! Sort \a size elements at \a data with \a threads threads, keeping the order of equal elements.
+    template <typename T, typename L = ZLess<T>> static void stableSort(T *data, zu64 size, L less = L(), zu64 threads = 0){
+        _sort(data, size, less, threads, true);
+    }
+
+    template <typename T, typename L = ZLess<T>> static void sort(ZArray<T> &array, L less = L(), zu64 threads = 0){
+        _sort(array.raw(), array.size(), less, threads, false);
+    }
+    template <typename T, typename L = ZLess<T>> static void stableSort(ZArray<T> &array, L less = L(), zu64 threads = 0){
+        _sort(array.raw(), array.size(), less, threads, true);
+    }
+
+private:
+    //! One chunk to sort, or two neighbouring sorted chunks to merge.
+    template <typename T, typename L> struct Task {
+        T *data;
+        zu64 mid;
+        zu64 size;
+        L *less;
+        bool stable;
+    };
+
+    template <typename T, typename L> static void *_sortTask(ZThread::ZThreadArg arg){
+        Task<T, L> *task = (Task<T, L> *)arg.arg;
+        if(task->stable)
+            ZSort::stableSort(task->data, task->size, *task->less);
+        else
+            ZSort::sort(task->data, task->size, *task->less);
+        return nullptr;
+    }
+    template <typename T, typename L> static void *_mergeTask(ZThread::ZThreadArg arg){
+        Task<T, L> *task = (Task<T, L> *)arg.arg;
+        ZSort::merge(task->data, task->mid, task->size, *task->less);
+        return nullptr;
+    }
+
+    //! Run \a count tasks, each on its own thread, and wait for all of them.
+    template <typename T, typename L> static void _run(ZThread::funcType func, Task<T, L> *tasks, zu64 count){
+        ZArray<ZThread *> running;
+        for(zu64 i = 0; i < count; ++i){
+            ZThread *thread = new ZThread(func);
+            thread->exec(tasks + i);
+            running.push(thread);
+        }
+        for(zu64 i = 0; i < running.size(); ++i){
+            running[i]->join();
+            delete running[i];
+        }
+    }
+
+    template <typename T, typename L> static void _sort(T *data, zu64 size, L &less, zu64 threads, bool stable){
+        if(threads == 0)
+            threads = std::thread::hardware_concurrency();
+        threads = MIN(threads, size / (ZPARALLELSORT_MIN / 2));
+        if(size < ZPARALLELSORT_MIN || threads < 2){
+            if(stable)
+                ZSort::stableSort(data, size, less);
+            else
+                ZSort::sort(data, size, less);
+            return;
+        }
+
+        // Sort equal chunks in parallel
+        ZArray<zu64> bounds;
+        for(zu64 i = 0; i <= threads; ++i)
+            bounds.push(size * i / threads);
+        ZArray<Task<T, L>> tasks;
+        for(zu64 i = 0; i < threads; ++i)
+            tasks.push({ data + bounds[i], 0, bounds[i + 1] - bounds[i], &less, stable });
+        _run(_sortTask<T, L>, tasks.raw(), tasks.size());
+
+        // Merge neighbouring chunks in parallel until one is left
+        while(bounds.size() > 2){
+            ZArray<zu64> merged;
+            tasks.clear();
+            for(zu64 i = 0; i + 1 < bounds.size(); i += 2){
+                merged.push(bounds[i]);
+                if(i + 2 < bounds.size())
+                    tasks.push({ data + bounds[i], bounds[i + 1] - bounds[i], bounds[i + 2] - bounds[i], &less, stable });
+            }
+            merged.push(size);
+            _run(_mergeTask<T, L>, tasks.raw(), tasks.size());
+            bounds = merged;
+        }
+    }
+};
+
+}
+
+#endif // ZPARALLELSORT_H
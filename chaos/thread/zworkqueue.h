@@ -13,6 +13,7 @@ namespace LibChaos {
  */
 template <class T> class ZWorkQueue {
 public:
+    //! The queue is a ring buffer, so adding and getting work does not allocate in steady state.
     ZWorkQueue(){}
 
     void addWork(const T &item){
@@ -1,5 +1,6 @@
 #include "tests.h"
 #include "zexception.h"
+#include "ztrackingallocator.h"
 
 #include <stdio.h>
 
@@ -89,10 +90,14 @@ int main(int argc, char **argv){
         // Command line arguments
         bool predisable = true;
         bool hideout = true;
+        bool track = false;
         for(int i = 1; i < argc; ++i){
             ZString arg = argv[i];
             if(arg == "-v"){
                 hideout = false;
+            } else if(arg == "--track"){
+                // Count allocations in each test
+                track = true;
             } else if(arg == "++"){
                 // Enable all tests
                 for(auto j = alltests.begin(); j.more(); ++j)
@@ -155,15 +160,20 @@ int main(int argc, char **argv){
             LOG("* " << ZString(i).lpad(' ', 2) << " " << ZString(test.name).pad(' ', 30) << (hideout ? ZLog::NOLN : ZLog::NEWLN));
 
             ZClock clock;
+            zu64 allocs = 0;
+            zu64 allocbytes = 0;
             if(!skip && test.func){
                 if(hideout){
                     ZLogWorker::setStdOutEnable(false);
                     ZLogWorker::setStdErrEnable(false);
                 }
                 try {
+                    ZAllocRegistry::Scope scope(track);
                     clock.start();
                     test.func();
                     clock.stop();
+                    allocs = scope.allocs();
+                    allocbytes = scope.bytes();
                     // PASS
                     teststatus[test.name] = 1;
                 } catch(int e){
@@ -202,6 +212,8 @@ int main(int argc, char **argv){
                     }
                 }
                 result = result + " [" + time + " " + unit + "]";
+                if(track)
+                    result = result + " [" + allocs + " allocs, " + allocbytes + " bytes]";
             }
 
             if(hideout)
@@ -211,6 +223,9 @@ int main(int argc, char **argv){
 
         }
 
+        if(track)
+            ZAllocRegistry::report();
+
         LOG("Result: " << tests.size() - failed << "/" << tests.size() << " passed, " << failed << " failed");
 
         // Return number of tests failed
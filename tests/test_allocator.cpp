@@ -1,6 +1,16 @@
 #include "tests.h"
 #include "zallocator.h"
 #include "zstorage.h"
+#include "zarray.h"
+#include "zlist.h"
+#include "zdeque.h"
+#include "zmap.h"
+#include "zsmallarray.h"
+#include "zarena.h"
+#include "ztrackingallocator.h"
+#include "zlargeallocator.h"
+#include "zjson.h"
+#include "zclock.h"
 
 namespace LibChaosTest {
 
@@ -16,10 +26,282 @@ void allocator_void(){
     alloc2.dealloc(test2);
 }
 
+template <typename T> class CountAllocator : public ZAllocator<T> {
+public:
+    CountAllocator(zu64 *count) : _count(count){}
+    T *alloc(zu64 count){
+        ++(*_count);
+        return ZAllocator<T>::alloc(count);
+    }
+private:
+    zu64 *_count;
+};
+
+void allocator_default(){
+    ZAllocatorHandle<int> handle;
+    TASSERT(handle.isDefault());
+    int *test = handle.alloc(4);
+    handle.construct(test, 5, 4);
+    TASSERT(test[0] == 5 && test[3] == 5);
+    handle.destroy(test, 4);
+    handle.dealloc(test);
+}
+
+void allocator_user(){
+    zu64 count = 0;
+    {
+        ZArray<int> array(new CountAllocator<int>(&count));
+        for(int i = 0; i < 100; ++i)
+            array.push(i);
+        TASSERT(array.size() == 100 && array[99] == 99);
+    }
+    TASSERT(count > 0);
+
+    zu64 ncount = 0;
+    {
+        ZList<int> list(new CountAllocator<ZList<int>::Node>(&ncount));
+        list.push(1);
+        list.push(2);
+        list.push(3);
+        TASSERT(list.size() == 3 && list[2] == 3);
+    }
+    TASSERT(ncount == 3);
+}
+
+//! Counts objects constructed and destroyed through the allocator.
+template <typename T> class LifetimeAllocator : public ZAllocator<T> {
+public:
+    LifetimeAllocator(zs64 *live, zu64 *constructs) : _live(live), _constructs(constructs){}
+    T *construct(T *ptr, const T &obj, zu64 count) override {
+        *_live += (zs64)count;
+        *_constructs += count;
+        return ZAllocator<T>::construct(ptr, obj, count);
+    }
+    T *construct(T *ptr, T &&obj) override {
+        ++(*_live);
+        ++(*_constructs);
+        return ZAllocator<T>::construct(ptr, std::move(obj));
+    }
+    void copy(const T *src, T *dest, zu64 count) override {
+        *_live += (zs64)count;
+        ZAllocator<T>::copy(src, dest, count);
+    }
+    void destroy(T *ptr, zu64 count) override {
+        *_live -= (zs64)count;
+        ZAllocator<T>::destroy(ptr, count);
+    }
+private:
+    zs64 *_live;
+    zu64 *_constructs;
+};
+
+void allocator_lifetime(){
+    zs64 live = 0;
+    zu64 constructs = 0;
+    {
+        ZArray<ZString> array(new LifetimeAllocator<ZString>(&live, &constructs));
+        ZString str = "copied";
+        array.push(str);
+        array.push(ZString("moved"));
+        array.emplace("emplaced");
+        TASSERT(constructs == 3 && live == 3 && array[2] == "emplaced");
+        array.popBack();
+        TASSERT(live == 2);
+    }
+    TASSERT(constructs == 3 && live == 0);
+
+    live = 0;
+    constructs = 0;
+    {
+        ZList<ZString> list(new LifetimeAllocator<ZList<ZString>::Node>(&live, &constructs));
+        list.push("a");
+        list.pushFront(ZString("b"));
+        list.emplaceBack("c");
+        TASSERT(constructs == 3 && live == 3 && list[0] == "b" && list[2] == "c");
+        list.popFront();
+        TASSERT(live == 2);
+    }
+    TASSERT(constructs == 3 && live == 0);
+
+    live = 0;
+    constructs = 0;
+    {
+        ZDeque<ZString> deque(new LifetimeAllocator<ZString>(&live, &constructs));
+        deque.pushBack("back");
+        deque.emplaceFront("front");
+        TASSERT(constructs == 2 && live == 2 && deque.front() == "front");
+        deque.popBack();
+        TASSERT(live == 1);
+    }
+    TASSERT(constructs == 2 && live == 0);
+
+    typedef ZMap<ZString, ZString>::MapElement MapElement;
+    live = 0;
+    constructs = 0;
+    {
+        ZMap<ZString, ZString> map(ZMAP_DEFAULT_LOAD_FACTOR, new LifetimeAllocator<MapElement>(&live, &constructs));
+        map.add("one", "1");
+        map.emplace("two", "2");
+        map.add("one", "uno");
+        TASSERT(live == 2 && constructs == 3 && map["one"] == "uno" && map["two"] == "2");
+        map.remove("two");
+        TASSERT(live == 1);
+        ZMap<ZString, ZString> copy = map;
+        TASSERT(copy["one"] == "uno");
+    }
+    TASSERT(live == 0);
+}
+
+void allocator_arena(){
+    ZArena arena(1024);
+    {
+        ZArray<ZString> array(arena.allocator<ZString>());
+        for(int i = 0; i < 100; ++i)
+            array.push(ZString(i));
+        ZList<int> list(arena.allocator<ZList<int>::Node>());
+        list.push(1);
+        list.push(2);
+        ZMap<ZString, int> map(ZMAP_DEFAULT_LOAD_FACTOR, arena.allocator<ZMap<ZString, int>::MapElement>());
+        map["one"] = 1;
+        map["two"] = 2;
+        TASSERT(array.size() == 100 && array[99] == "99" && list[1] == 2 && map["two"] == 2);
+    }
+    TASSERT(arena.blockCount() > 1);
+    zu64 cap = arena.capacity();
+
+    // Large allocations get their own block
+    void *big = arena.alloc(4096);
+    TASSERT(big != nullptr && arena.capacity() >= cap + 4096);
+    cap = arena.capacity();
+
+    // Scoped allocations are released, blocks are reused
+    arena.reset();
+    TASSERT(arena.used() == 0);
+    {
+        ZArena::Scope scope(&arena);
+        zu64 *ptr = (zu64 *)arena.alloc(sizeof(zu64) * 3, alignof(zu64));
+        TASSERT(((zu64)ptr % alignof(zu64)) == 0);
+        TASSERT(arena.used() >= sizeof(zu64) * 3);
+        ZString str(arena.allocator<ZString::codeunit>());
+        str = "arena string";
+        TASSERT(str == "arena string");
+    }
+    TASSERT(arena.used() == 0);
+    TASSERT(arena.capacity() == cap);
+
+    ZJSON json;
+    TASSERT(json.decode("{ \"array\" : [ \"val1\", 2 ], \"str\" : \"val\" }", &arena));
+    TASSERT(json["array"][0].string() == "val1" && json["str"].string() == "val");
+    TASSERT(arena.used() > 0);
+}
+
+void allocator_tracking(){
+    TASSERT(ZAllocStats::bucket(1) == 0 && ZAllocStats::bucket(16) == 0 && ZAllocStats::bucket(17) == 1);
+    TASSERT(ZAllocStats::bucket(ZU64_MAX) == ZALLOC_HISTOGRAM_SIZE - 1);
+
+    // Named tracking allocator
+    {
+        ZArray<int> array(new ZTrackingAllocator<int>("test.tracking.array"));
+        for(int i = 0; i < 100; ++i)
+            array.push(i);
+        ZAllocStats stats = ZAllocRegistry::stats("test.tracking.array");
+        TASSERT(stats.allocs > 0 && stats.liveBytes >= sizeof(int) * 100 && stats.peakBytes >= stats.liveBytes);
+    }
+    ZAllocStats stats = ZAllocRegistry::stats("test.tracking.array");
+    TASSERT(stats.deallocs == stats.allocs && stats.liveBytes == 0 && stats.peakBytes >= sizeof(int) * 100);
+    zu64 histsum = 0;
+    for(zu64 i = 0; i < ZALLOC_HISTOGRAM_SIZE; ++i)
+        histsum += stats.histogram[i];
+    TASSERT(histsum == stats.allocs);
+
+    // Allocation budgets with default allocators
+    const char *intname = typeid(int).name();
+    zu64 intallocs = ZAllocRegistry::stats(intname).allocs;
+    {
+        ZAllocRegistry::Scope scope;
+        TASSERT(ZAllocRegistry::tracking());
+        ZString str = "short string";
+        ZSmallArray<int, 4> small = { 1, 2, 3 };
+        TASSERT(scope.allocs() == 0);
+        ZArray<int> array;
+        array.push(1);
+        array.push(2);
+        TASSERT(scope.allocs() == 1 && scope.bytes() == sizeof(int) * ZARRAY_INITIAL_CAPACITY);
+    }
+    TASSERT(ZAllocRegistry::stats(intname).allocs == intallocs + 1);
+
+    ZJSON json = ZAllocRegistry::toJSON();
+    TASSERT(json["test.tracking.array"]["allocs"].number() == (double)stats.allocs);
+    TASSERT(ZAllocRegistry::total().allocs >= stats.allocs);
+}
+
+void allocator_large(){
+    // Small blocks come from the heap
+    zbyte *small = (zbyte *)ZLargeAllocator::alloc(100);
+    TASSERT(!ZLargeAllocator::isMapped(small) && ZLargeAllocator::capacity(small) >= 100);
+    memset(small, 0xAB, 100);
+
+    // Growing past the threshold maps the block and keeps the contents
+    zbyte *block = (zbyte *)ZLargeAllocator::realloc(small, ZLARGE_ALLOC_THRESHOLD);
+    TASSERT(ZLargeAllocator::isMapped(block) && ZLargeAllocator::capacity(block) >= ZLARGE_ALLOC_THRESHOLD);
+    TASSERT(((zu64)block % 64) == 0 && block[0] == 0xAB && block[99] == 0xAB);
+    block[ZLARGE_ALLOC_THRESHOLD - 1] = 0x12;
+
+    // Growing a mapped block keeps the contents
+    block = (zbyte *)ZLargeAllocator::realloc(block, ZLARGE_ALLOC_THRESHOLD * 4);
+    TASSERT(ZLargeAllocator::capacity(block) >= ZLARGE_ALLOC_THRESHOLD * 4);
+    TASSERT(block[0] == 0xAB && block[ZLARGE_ALLOC_THRESHOLD - 1] == 0x12);
+    block[ZLARGE_ALLOC_THRESHOLD * 4 - 1] = 0x34;
+    ZLargeAllocator::dealloc(block);
+    ZLargeAllocator::dealloc(nullptr);
+
+    TASSERT(ZLargeAllocator::pageSize() > 0 && (ZLargeAllocator::pageSize() & (ZLargeAllocator::pageSize() - 1)) == 0);
+}
+
+//! Compare decoding ZJSON trees with the default allocator and a ZArena.
+void bench_arena_json(){
+    ZString str = "[";
+    for(int i = 0; i < 200; ++i){
+        if(i) str += ",";
+        str += "{\"id\":";
+        str += ZString(i);
+        str += ",\"name\":\"item";
+        str += ZString(i);
+        str += "\",\"tags\":[\"a\",\"b\",\"c\"],\"child\":{\"x\":1,\"y\":2}}";
+    }
+    str += "]";
+    const int runs = 200;
+
+    ZClock clock;
+    for(int i = 0; i < runs; ++i){
+        ZJSON json;
+        TASSERT(json.decode(str));
+    }
+    clock.stop();
+    LOG("default: " << clock.getSecs() << " s");
+
+    ZArena arena;
+    clock.start();
+    for(int i = 0; i < runs; ++i){
+        ZArena::Scope scope(&arena);
+        ZJSON json;
+        TASSERT(json.decode(str, &arena));
+    }
+    clock.stop();
+    LOG("arena:   " << clock.getSecs() << " s, " << arena.capacity() << " bytes in " << arena.blockCount() << " blocks");
+}
+
 ZArray<Test> allocator_tests(){
     return {
-        { "allocator-char", allocator_char, true, { "allocator-void" } },
-        { "allocator-void", allocator_void, true, {} },
+        { "allocator-char",     allocator_char,     true, { "allocator-void" } },
+        { "allocator-void",     allocator_void,     true, {} },
+        { "allocator-default",  allocator_default,  true, {} },
+        { "allocator-user",     allocator_user,     true, { "allocator-default" } },
+        { "allocator-lifetime", allocator_lifetime, true, { "allocator-user" } },
+        { "allocator-arena",    allocator_arena,    true, { "allocator-user" } },
+        { "allocator-tracking", allocator_tracking, true, { "allocator-user" } },
+        { "allocator-large",    allocator_large,    true, {} },
+        { "bench-arena-json",   bench_arena_json,   false, {} },
     };
 }
 
@@ -1,6 +1,13 @@
 #include "tests.h"
 #include "zarray.h"
 #include "zstack.h"
+#include "zsmallarray.h"
+#include "zparallelsort.h"
+#include "zstring.h"
+#include "zclock.h"
+
+#include <algorithm>
+#include <functional>
 
 namespace LibChaosTest {
 
@@ -78,6 +85,75 @@ void array_iterator(){
     test_random_iterator(&i4n, tst4.size());
 }
 
+//! Element that points to itself, so it must be move-constructed when relocated.
+struct SelfPointer {
+    SelfPointer(int v = 0) : self(this), value(v){}
+    SelfPointer(const SelfPointer &other) : self(this), value(other.value){}
+    SelfPointer(SelfPointer &&other) : self(this), value(other.value){ other.value = -1; }
+    bool valid() const { return self == this; }
+    SelfPointer *self;
+    int value;
+};
+
+void array_move(){
+    ZArray<ZString> tst1({ "one", "two" });
+    ZString three = "three";
+    tst1.push(std::move(three));
+    tst1.emplace("four", 4);
+    TASSERT(tst1.size() == 4 && tst1[2] == "three" && tst1[3] == "four");
+
+    ZArray<ZString> tst2(std::move(tst1));
+    TASSERT(tst1.size() == 0 && tst2.size() == 4 && tst2[0] == "one");
+    tst1 = std::move(tst2);
+    TASSERT(tst1.size() == 4 && tst1[3] == "four");
+
+    ZArray<SelfPointer> tst3;
+    for(int i = 0; i < 20; ++i)
+        tst3.emplace(i);
+    tst3.insert(0, SelfPointer(100));
+    tst3.erase(5, 2);
+    TASSERT(tst3.size() == 19 && tst3[0].value == 100 && tst3[5].value == 6);
+    for(zu64 i = 0; i < tst3.size(); ++i)
+        TASSERT(tst3[i].valid());
+}
+
+void array_small(){
+    ZArray<int> empty;
+    TASSERT(empty.realsize() == 0 && empty.ptr() == nullptr);
+    empty.push(1);
+    TASSERT(empty.realsize() == ZARRAY_INITIAL_CAPACITY);
+
+    ZSmallArray<ZString, 4> tst1 = { "one", "two" };
+    TASSERT(tst1.isInline() && tst1.size() == 2 && tst1.capacity() == 4);
+    tst1.push("three");
+    tst1.push("four");
+    TASSERT(tst1.isInline());
+    tst1.push("five");
+    TASSERT(!tst1.isInline() && tst1.size() == 5 && tst1[0] == "one" && tst1[4] == "five");
+    tst1.clear();
+    TASSERT(tst1.isInline() && tst1.size() == 0 && tst1.capacity() == 4);
+
+    // Use through ZArray
+    ZArray<ZString> &ref = tst1;
+    ref.push("a");
+    ref.pushFront("b");
+    TASSERT(tst1.isInline() && tst1[0] == "b" && tst1[1] == "a");
+
+    ZArray<ZString> heap = { "x", "y", "z" };
+    heap.swap(ref);
+    TASSERT(tst1.isInline() && tst1.size() == 3 && tst1[2] == "z" && heap.size() == 2 && heap[0] == "b");
+
+    ZSmallArray<ZString, 4> tst2(std::move(tst1));
+    TASSERT(tst2.size() == 3 && tst2[0] == "x" && tst1.size() == 0);
+    ZSmallArray<ZString, 4> tst3 = tst2;
+    TASSERT(tst3 == tst2);
+
+    ZArray<ZSmallArray<ZString, 4>> nested;
+    for(int i = 0; i < 20; ++i)
+        nested.push(tst3);
+    TASSERT(nested[19] == tst3 && nested[19].isInline());
+}
+
 void stack(){
     ZStack<int> tst1;
 
@@ -86,6 +162,124 @@ void stack(){
     LOG(i);
 }
 
+//! Deterministic pseudo-random numbers for sort tests.
+static zu64 sortRandom(zu64 &state){
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state >> 16;
+}
+
+struct SortRecord {
+    zu64 key;
+    zu64 order;
+    bool operator<(const SortRecord &other) const { return key < other.key; }
+};
+
+void array_sort(){
+    zu64 state = 1;
+    // Random, sorted, reversed and constant inputs, sizes around the insertion sort cutoff
+    ZArray<zu64> sizes = { 0, 1, 2, 15, 16, 17, 100, 5000 };
+    for(zu64 s = 0; s < sizes.size(); ++s){
+        for(int kind = 0; kind < 4; ++kind){
+            ZArray<int> arr;
+            for(zu64 i = 0; i < sizes[s]; ++i)
+                arr.push(kind == 0 ? (int)(sortRandom(state) % 1000) - 500 : kind == 1 ? (int)i : kind == 2 ? -(int)i : 7);
+            ZArray<int> check = arr;
+            std::sort(check.raw(), check.raw() + check.size());
+            TASSERT(ZArray<int>(arr).sort().equals(check));
+            TASSERT(ZArray<int>(arr).stableSort().equals(check));
+            TASSERT(ZArray<int>(arr).radixSort().equals(check));
+            TASSERT(ZArray<int>(arr).sort([](int a, int b){ return a > b; }).reverse().equals(check));
+            ZArray<int> part = arr;
+            part.partialSort(10);
+            for(zu64 i = 0; i < MIN(sizes[s], (zu64)10); ++i)
+                TASSERT(part[i] == check[i]);
+            if(sizes[s]){
+                ZArray<int> nth = arr;
+                zu64 n = sizes[s] / 3;
+                nth.nthElement(n);
+                TASSERT(nth[n] == check[n]);
+                for(zu64 i = 0; i < sizes[s]; ++i)
+                    TASSERT(i < n ? nth[i] <= nth[n] : nth[i] >= nth[n]);
+            }
+        }
+    }
+
+    // Stable sorts keep the order of equal keys
+    ZArray<SortRecord> records;
+    for(zu64 i = 0; i < 3000; ++i)
+        records.push({ sortRandom(state) % 50, i });
+    ZArray<SortRecord> stable = records;
+    stable.stableSort();
+    ZArray<SortRecord> radix = records;
+    radix.radixSort([](const SortRecord &r){ return r.key; });
+    for(zu64 i = 1; i < records.size(); ++i){
+        TASSERT(stable[i - 1].key < stable[i].key || (stable[i - 1].key == stable[i].key && stable[i - 1].order < stable[i].order));
+        TASSERT(radix[i].key == stable[i].key && radix[i].order == stable[i].order);
+    }
+
+    // Floating point radix keys
+    ZArray<double> dbl = { 3.5, -0.25, 1e10, -7e-3, 0.0, -1e10, 2.0 };
+    TASSERT(dbl.radixSort().equals(ZArray<double>({ -1e10, -0.25, -7e-3, 0.0, 2.0, 3.5, 1e10 })));
+
+    // Byte strings
+    ZArray<ZString> strs;
+    for(zu64 i = 0; i < 2000; ++i)
+        strs.push(ZString("str") + (sortRandom(state) % 500) + (i % 3 ? "" : "x"));
+    strs.push("");
+    strs.push("s");
+    ZArray<ZString> scheck = strs;
+    scheck.sort();
+    TASSERT(scheck.isSorted() && strs.radixSort().equals(scheck));
+}
+
+void array_search(){
+    ZArray<int> arr = { 1, 3, 3, 3, 7, 9 };
+    TASSERT(arr.lowerBound(3) == 1 && arr.upperBound(3) == 4 && arr.lowerBound(0) == 0 && arr.lowerBound(10) == 6);
+    TASSERT(arr.binarySearch(7) == 4 && arr.binarySearch(4) == ZArray<int>::NONE && arr.binarySearch(3) < 4);
+    ZArray<ZString> strs = { "apple", "banana", "cherry" };
+    TASSERT(strs.binarySearch(ZString("banana")) == 1 && strs.lowerBound(ZString("b")) == 1);
+}
+
+void array_parallel_sort(){
+    zu64 state = 3;
+    ZArray<SortRecord> records;
+    for(zu64 i = 0; i < 500000; ++i)
+        records.push({ sortRandom(state) % 10000, i });
+    ZArray<SortRecord> check = records;
+    check.stableSort();
+
+    ZArray<SortRecord> par = records;
+    ZParallelSort::sort(par, ZLess<SortRecord>(), 4);
+    ZArray<SortRecord> spar = records;
+    ZParallelSort::stableSort(spar, ZLess<SortRecord>(), 3);
+    for(zu64 i = 0; i < records.size(); ++i){
+        TASSERT(par[i].key == check[i].key);
+        TASSERT(spar[i].key == check[i].key && spar[i].order == check[i].order);
+    }
+}
+
+//! Compare the sorts on a few million random numbers.
+void bench_sort(){
+    zu64 state = 5;
+    ZArray<zu64> arr;
+    for(zu64 i = 0; i < (1 << 23); ++i)
+        arr.push(sortRandom(state));
+
+    auto run = [&](const char *name, std::function<void(ZArray<zu64> &)> func){
+        ZArray<zu64> copy = arr;
+        ZClock clock;
+        func(copy);
+        clock.stop();
+        TASSERT(copy.isSorted());
+        LOG(name << clock.getSecs() << " s");
+    };
+    run("std::sort:     ", [](ZArray<zu64> &a){ std::sort(a.raw(), a.raw() + a.size()); });
+    run("sort:          ", [](ZArray<zu64> &a){ a.sort(); });
+    run("stableSort:    ", [](ZArray<zu64> &a){ a.stableSort(); });
+    run("radixSort:     ", [](ZArray<zu64> &a){ a.radixSort(); });
+    run("parallel sort: ", [](ZArray<zu64> &a){ ZParallelSort::sort(a); });
+}
+
 ZArray<Test> array_tests(){
     return {
         { "array-push",         array_push,         true, {} },
@@ -95,7 +289,13 @@ ZArray<Test> array_tests(){
         { "array-insert",       array_insert,       true, { "array-construct" } },
         { "array-erase",        array_erase,        true, { "array-construct" } },
         { "array-iterator",     array_iterator,     true, { "array-construct" } },
+        { "array-move",         array_move,         true, { "array-insert", "array-erase" } },
+        { "array-small",        array_small,        true, { "array-move" } },
         { "stack",              stack,              true, {} },
+        { "array-sort",         array_sort,         true, { "array-initializer" } },
+        { "array-search",       array_search,       true, { "array-initializer" } },
+        { "array-parallel-sort", array_parallel_sort, true, { "array-sort", "thread" } },
+        { "bench-sort",         bench_sort,         false, {} },
     };
 }
 
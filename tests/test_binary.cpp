@@ -1,5 +1,6 @@
 #include "tests.h"
 #include "zbinary.h"
+#include "zlargeallocator.h"
 
 namespace LibChaosTest {
 
@@ -37,11 +38,69 @@ void binary_read_write(){
     TASSERT(num2 == num2o);
 }
 
+void binary_cow(){
+    ZBinary bin1({'A','B','C','D','E','F'});
+    const ZBinary &cbin1 = bin1;
+    const zbyte *ptr = cbin1.raw();
+
+    // Copies and slices share the buffer
+    ZBinary bin2 = bin1;
+    ZBinary sub1 = bin1.getSub(2, 3);
+    TASSERT(bin1.isShared() && ((const ZBinary &)bin2).raw() == ptr);
+    TASSERT(sub1.size() == 3 && ((const ZBinary &)sub1).raw() == ptr + 2 && sub1 == ZBinary({'C','D','E'}));
+
+    // Writes unshare
+    bin2[0] = 'Z';
+    TASSERT(cbin1[0] == 'A' && bin2[0] == 'Z' && cbin1.raw() == ptr);
+    sub1.append('X');
+    TASSERT(sub1 == ZBinary({'C','D','E','X'}) && bin1 == ZBinary({'A','B','C','D','E','F'}));
+
+    // A slice outlives its parent
+    ZBinary sub2 = bin1.getSub(4, 2);
+    bin1.clear();
+    TASSERT(sub2 == ZBinary({'E','F'}) && !sub2.isShared());
+
+    // Zero-copy reads
+    ZBinary bin3({1,2,3,4,5,6,7,8});
+    ZBinary part = bin3.readSub(3);
+    TASSERT(part == ZBinary({1,2,3}) && bin3.tell() == 3 && part.isShared());
+    bin3.reverse();
+    TASSERT(bin3 == ZBinary({8,7,6,5,4,3,2,1}) && part == ZBinary({1,2,3}));
+
+    // User allocators are never shared
+    ZBinary bin4(new ZAllocator<zbyte>);
+    bin4.write((const zbyte *)"abc", 3);
+    ZBinary bin5 = bin4;
+    TASSERT(!bin4.isShared() && bin5 == bin4);
+}
+
+void binary_large(){
+    // Large binaries grow without losing data
+    ZBinary bin;
+    for(zu64 i = 0; i < 3; ++i){
+        ZBinary chunk(ZLARGE_ALLOC_THRESHOLD);
+        chunk.fill((zbyte)(i + 1));
+        bin.concat(chunk);
+    }
+    TASSERT(bin.size() == ZLARGE_ALLOC_THRESHOLD * 3 && bin.realSize() >= bin.size());
+    TASSERT(bin[0] == 1 && bin[ZLARGE_ALLOC_THRESHOLD] == 2 && bin[ZLARGE_ALLOC_THRESHOLD * 3 - 1] == 3);
+
+    // Sharing and unsharing large buffers
+    ZBinary copy = bin;
+    ZBinary sub = bin.getSub(ZLARGE_ALLOC_THRESHOLD * 2, 16);
+    TASSERT(bin.isShared() && sub[0] == 3);
+    copy[0] = 9;
+    bin.append(4);
+    TASSERT(((const ZBinary &)bin)[0] == 1 && copy[0] == 9 && bin.back() == 4 && sub[15] == 3);
+}
+
 ZArray<Test> binary_tests(){
     return {
         { "binary-construct",   binary_construct,   true, {} },
         { "binary-find",        binary_find,        true, { "binary-construct" } },
         { "binary-read-write",  binary_read_write,  true, {} },
+        { "binary-cow",         binary_cow,         true, { "binary-construct" } },
+        { "binary-large",       binary_large,       true, { "binary-cow", "allocator-large" } },
     };
 }
 
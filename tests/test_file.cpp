@@ -4,6 +4,9 @@
 #include "zexception.h"
 #include "zrandom.h"
 #include "zhash.h"
+#include "zstoragearray.h"
+#include "zmappedstorage.h"
+#include "zpagedstorage.h"
 
 namespace LibChaosTest {
 
@@ -132,6 +135,187 @@ void file_sequential_rw(){
     TASSERT(ZHash<ZBinary>(randi).hash() == ZHash<ZBinary>(rand4).hash());
 }
 
+//! Checks that hold for any empty ZStorage.
+static void storage_check(ZStorage *storage){
+    TASSERT(storage->size() == 0);
+    ZBinary data;
+    for(zu64 i = 0; i < 3000; ++i)
+        data.append((zbyte)(i * 7));
+    storage->copyToBlock(data.raw(), 0, data.size());
+    TASSERT(storage->size() == 3000);
+    TASSERT(storage->get(1000) == (zbyte)7000);
+    storage->set(1000, 1);
+    TASSERT(storage->get(1000) == 1);
+    storage->set(1000, (zbyte)7000);
+
+    ZBinary out(1500);
+    storage->copyBlockTo(1000, 1500, out.raw());
+    TASSERT(out == data.getSub(1000, 1500));
+
+    // Change through a block
+    zbyte *block = storage->getBlock(100, 2000);
+    TASSERT(block[0] == (zbyte)700);
+    ::memset(block, 0xAB, 2000);
+    storage->commitBlock(block);
+    storage->freeBlock(block);
+    TASSERT(storage->get(100) == 0xAB && storage->get(2099) == 0xAB && storage->get(2100) == (zbyte)14700);
+
+    // Copies compare equal
+    ZStorage *copy = storage->newCopy();
+    TASSERT(copy->storageType() == ZStorage::MEMORY);
+    TASSERT(storage->compare(copy) && copy->compare(storage));
+    copy->set(5, 0);
+    TASSERT(!storage->compare(copy));
+    copy->copy(storage);
+    TASSERT(storage->compare(copy));
+    delete copy;
+
+    // Shrinking then growing reads zeros
+    storage->resize(10);
+    storage->resize(3000);
+    TASSERT(storage->get(9) == (zbyte)63 && storage->get(10) == 0 && storage->get(2999) == 0);
+
+    bool thrown = false;
+    try {
+        storage->copyBlockTo(2990, 20, out.raw());
+    } catch(ZException){
+        thrown = true;
+    }
+    TASSERT(thrown);
+    storage->clear();
+    TASSERT(storage->size() == 0);
+}
+
+void storage_memory(){
+    ZMemoryStorage memory;
+    TASSERT(memory.storageType() == ZStorage::MEMORY);
+    storage_check(&memory);
+
+    ZStorageArray<zu64> array;
+    for(zu64 i = 0; i < 100000; ++i)
+        array.push(i);
+    TASSERT(array.size() == 100000 && array[777] == 777 && array.back() == 99999);
+    zu64 sum = 0;
+    array.forEach([&](zu64 value){ sum += value; });
+    TASSERT(sum == (zu64)99999 * 100000 / 2);
+    array.update([](zu64 *data, zu64 count){
+        for(zu64 i = 0; i < count; ++i)
+            data[i] *= 2;
+    });
+    TASSERT(array[50000] == 100000);
+    TASSERT(array.popBack() == 199998 && array.size() == 99999);
+    ZArray<zu64> part = array.toArray(10, 3);
+    TASSERT(part.size() == 3 && part[0] == 20 && part[2] == 24);
+    TASSERT(array.toArray(99990).size() == 9);
+    array.append({ 1, 2, 3 });
+    TASSERT(array.size() == 100002 && array.back() == 3);
+    array.clear();
+    TASSERT(array.isEmpty());
+
+    ZStorageBinary bytes;
+    bytes.append({ 'a', 'b', 'c' });
+    TASSERT(bytes.toBinary() == ZBinary(ZString("abc")));
+}
+
+void storage_mapped(){
+    ZPath path = "teststorage-mapped";
+    ZFile::remove(path);
+    {
+        ZMappedStorage mapped(path);
+        TASSERT(mapped.storageType() == ZStorage::MAPPED && !mapped.isReadOnly());
+        storage_check(&mapped);
+    }
+    {
+        ZStorageArray<zu32> array(new ZMappedStorage(path));
+        for(zu32 i = 0; i < 50000; ++i)
+            array.push(i * 3);
+        array.update([](zu32 *data, zu64 count){
+            for(zu64 i = 0; i < count; ++i)
+                data[i] += 1;
+        });
+        TASSERT(((ZMappedStorage *)array.storage())->flush());
+    }
+    TASSERT(ZFile::fileSize(path) == 50000 * sizeof(zu32));
+
+    // Reopen the file read only
+    ZStorageArray<zu32> array(new ZMappedStorage(path, true));
+    TASSERT(array.size() == 50000);
+    TASSERT(array[0] == 1 && array[49999] == 49999 * 3 + 1);
+    bool thrown = false;
+    try {
+        array.push(0);
+    } catch(ZException){
+        thrown = true;
+    }
+    TASSERT(thrown);
+}
+
+void storage_paged(){
+    ZPath path = "teststorage-paged";
+    ZFile::remove(path);
+    {
+        ZPagedStorage paged(path, 256, 4);
+        TASSERT(paged.storageType() == ZStorage::PAGED);
+        storage_check(&paged);
+        TASSERT(paged.cachedPages() == 4);
+
+        // Only four pages are cached, the rest are written back and read again
+        ZBinary data;
+        for(zu64 i = 0; i < 10000; ++i)
+            data.append((zbyte)(i % 251));
+        paged.copyToBlock(data.raw(), 0, data.size());
+        ZBinary out(data.size());
+        paged.copyBlockTo(0, data.size(), out.raw());
+        TASSERT(out == data);
+        TASSERT(paged.cachedPages() == 4 && paged.pageWrites() > 30 && paged.pageReads() > 30);
+
+        // Blocks in one page are pinned until freed
+        zbyte *blocks[4];
+        for(zu64 i = 0; i < 4; ++i){
+            blocks[i] = paged.getBlock(i * 1000, 16);
+            TASSERT(blocks[i][0] == (zbyte)((i * 1000) % 251));
+        }
+        bool thrown = false;
+        try {
+            paged.get(9000);
+        } catch(ZException){
+            thrown = true;
+        }
+        TASSERT(thrown);
+        blocks[0][0] = 0xFF;
+        paged.commitBlock(blocks[0]);
+        for(zu64 i = 0; i < 4; ++i)
+            paged.freeBlock(blocks[i]);
+        TASSERT(paged.get(9000) == (zbyte)(9000 % 251));
+        TASSERT(paged.get(0) == 0xFF);
+        paged.set(0, 0);
+        TASSERT(paged.flush());
+        TASSERT(ZFile::fileSize(path) == 10000);
+    }
+
+    // The file holds the data written through the cache
+    ZMappedStorage mapped(path, true);
+    TASSERT(mapped.size() == 10000);
+    for(zu64 i = 0; i < 10000; ++i){
+        if(mapped.get(i) != (zbyte)(i % 251))
+            TASSERT(false);
+    }
+
+    // Arrays larger than the cache
+    ZFile::remove("teststorage-paged2");
+    ZStorageArray<zu64> array(new ZPagedStorage("teststorage-paged2", 4096, 8));
+    for(zu64 i = 0; i < 100000; ++i)
+        array.push(i);
+    array.update([](zu64 *data, zu64 count){
+        for(zu64 i = 0; i < count; ++i)
+            data[i] = data[i] * 2 + 1;
+    });
+    zu64 sum = 0;
+    array.forEach([&](zu64 value){ sum += value; });
+    TASSERT(sum == (zu64)99999 * 100000 + 100000);
+    TASSERT(array[12345] == 24691);
+}
+
 ZArray<Test> file_tests(){
     return {
         { "file-create-dir",    file_create_dir,    true, {} },
@@ -140,6 +324,9 @@ ZArray<Test> file_tests(){
         { "file-read",          file_read,          true, { "file-list" } },
         { "file-list-dirs",     file_list_dirs,     true, { "file-create-dir" } },
         { "file-sequential-rw", file_create_dir,    true, {} },
+        { "storage-memory",     storage_memory,     true, { "binary-construct" } },
+        { "storage-mapped",     storage_mapped,     true, { "storage-memory" } },
+        { "storage-paged",      storage_paged,      true, { "storage-mapped" } },
     };
 }
 
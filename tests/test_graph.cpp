@@ -1,5 +1,6 @@
 #include "tests.h"
 #include "zgraph.h"
+#include "zcsrgraph.h"
 
 namespace LibChaosTest {
 
@@ -16,11 +17,102 @@ void graph(){
     graph1.connect("A", "B", 1);
     
     TASSERT(graph1.connected("A", "B"));
+    TASSERT(!graph1.connected("B", "A") && graph1.weight("A", "B", 0) == 1);
+
+    graph1.connect("B", "F", 2);
+    graph1.connect("A", "C");
+    TASSERT(graph1.vertexCount() == 6 && graph1.edgeCount() == 3 && graph1.children("A").size() == 2);
+    graph1.remove("B");
+    TASSERT(graph1.vertexCount() == 5 && graph1.edgeCount() == 1 && !graph1.connected("A", "B"));
+    graph1.disconnect("A", "C");
+    TASSERT(graph1.edgeCount() == 0);
+}
+
+void graph_csr(){
+    typedef ZCSRGraph<ZString, int> Graph;
+    ZGraph<ZString, int> graph1(ZList<ZString>({ "A", "B", "C", "D", "E", "F" }));
+    graph1.connect("A", "B", 4);
+    graph1.connect("A", "C", 1);
+    graph1.connect("C", "B", 2);
+    graph1.connect("B", "D", 1);
+    graph1.connect("C", "D", 5);
+    graph1.connect("E", "F", 1);
+
+    Graph csr(graph1);
+    TASSERT(csr.vertexCount() == 6 && csr.edgeCount() == 6);
+    zu64 a = csr.id("A"), b = csr.id("B"), c = csr.id("C"), d = csr.id("D"), e = csr.id("E");
+    TASSERT(csr.id("Z") == Graph::NONE && csr.vertex(c) == "C" && csr.degree(a) == 2);
+
+    ZArray<zu64> hops = csr.bfs(a);
+    TASSERT(hops[a] == 0 && hops[b] == 1 && hops[d] == 2 && hops[e] == Graph::NONE);
+    TASSERT(csr.parallelBfs(a, 4).equals(hops));
+
+    ZArray<zu64> parents;
+    ZArray<int> dist = csr.dijkstra(a, 1000, &parents);
+    TASSERT(dist[b] == 3 && dist[d] == 4 && dist[e] == 1000);
+    TASSERT(parents[d] == b && parents[b] == c && parents[c] == a && parents[a] == Graph::NONE);
+
+    zu64 count;
+    ZArray<zu64> comp = csr.components(&count);
+    TASSERT(count == 2 && comp[a] == 0 && comp[d] == 0 && comp[e] == 1 && comp[csr.id("F")] == 1);
+
+    ZArray<zu64> order = csr.topologicalSort();
+    ZArray<zu64> pos;
+    pos.resize(order.size(), 0);
+    for(zu64 i = 0; i < order.size(); ++i)
+        pos[order[i]] = i;
+    TASSERT(order.size() == 6 && pos[a] < pos[c] && pos[c] < pos[b] && pos[b] < pos[d]);
+
+    // Cycles have no topological order
+    Graph cyclic(ZArray<ZString>(), ZArray<Graph::Edge>({ { "X", "Y", 1 }, { "Y", "X", 1 } }));
+    bool thrown = false;
+    try {
+        cyclic.topologicalSort();
+    } catch(ZException &){
+        thrown = true;
+    }
+    TASSERT(thrown && cyclic.vertexCount() == 2);
+
+    // Sources must be vertex ids
+    Graph empty { ZArray<ZString>(), ZArray<Graph::Edge>() };
+    zu64 throws = 0;
+    for(zu64 source : { (zu64)0, (zu64)Graph::NONE }){
+        try { empty.bfs(source); } catch(ZException &){ ++throws; }
+        try { empty.parallelBfs(source); } catch(ZException &){ ++throws; }
+        try { empty.dijkstra(source, 1000); } catch(ZException &){ ++throws; }
+    }
+    try { csr.parallelBfs(Graph::NONE); } catch(ZException &){ ++throws; }
+    try { csr.dijkstra(csr.id("Z"), 1000); } catch(ZException &){ ++throws; }
+    TASSERT(throws == 8 && empty.vertexCount() == 0);
+}
+
+//! Large random graph, checks the parallel BFS against the serial one.
+void graph_csr_large(){
+    const zu64 count = 100000;
+    ZArray<zu64> verts;
+    ZArray<ZCSRGraph<zu64, zu32>::Edge> edges;
+    zu64 state = 11;
+    for(zu64 i = 0; i < count; ++i){
+        verts.push(i);
+        for(int j = 0; j < 4; ++j){
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            edges.push({ i, (state >> 20) % count, (zu32)(state >> 60) + 1 });
+        }
+    }
+    ZCSRGraph<zu64, zu32> csr(verts, edges);
+    TASSERT(csr.vertexCount() == count && csr.edgeCount() == count * 4);
+    ZArray<zu64> hops = csr.bfs(0);
+    TASSERT(csr.parallelBfs(0, 4).equals(hops));
+    ZArray<zu32> dist = csr.dijkstra(0, ZU32_MAX);
+    for(zu64 i = 0; i < count; ++i)
+        TASSERT((hops[i] == ZCSRGraph<zu64, zu32>::NONE) == (dist[i] == ZU32_MAX));
 }
 
 ZArray<Test> graph_tests(){
     return {
-        { "graph", graph, true, {} },
+        { "graph",              graph,              true, {} },
+        { "graph-csr",          graph_csr,          true, { "graph" } },
+        { "graph-csr-large",    graph_csr_large,    true, { "graph-csr", "thread" } },
     };
 }
 
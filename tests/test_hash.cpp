@@ -2,6 +2,13 @@
 #include "zhash.h"
 #include "zmap.h"
 #include "zset.h"
+#include "ztreemap.h"
+#include "ztreeset.h"
+#include "zlrucache.h"
+#include "zuid.h"
+#include "zclock.h"
+
+#include <algorithm>
 
 namespace LibChaosTest {
 
@@ -173,9 +180,8 @@ void map(){
     LOG(map1.get("test3"));
 
     LOG(map1.size() << " " << map1.realSize());
-    for(zu64 i = 0; i < map1.realSize(); ++i){
-        if(map1.position(i).flags & ZMAP_ENTRY_VALID)
-            LOG(i << " " << map1.position(i).key << " " << map1.position(i).value << " " << map1.position(i).hash);
+    for(auto it = map1.begin(); it.more(); ++it){
+        LOG(*it << " " << map1.get(*it));
     }
 
     map1["test21"] = 1001;
@@ -188,25 +194,22 @@ void map(){
     map1.remove("test:");
 
     LOG(map1.size() << " " << map1.realSize());
-    for(zu64 i = 0; i < map1.realSize(); ++i){
-        if(map1.position(i).flags & ZMAP_ENTRY_VALID)
-            LOG(i << " " << map1.position(i).key << " " << map1.position(i).value << " " << map1.position(i).hash);
+    for(auto it = map1.begin(); it.more(); ++it){
+        LOG(*it << " " << map1.get(*it));
     }
 
     map1["test8"] = 888;
 
     LOG(map1.size() << " " << map1.realSize());
-    for(zu64 i = 0; i < map1.realSize(); ++i){
-        if(map1.position(i).flags & ZMAP_ENTRY_VALID)
-            LOG(i << " " << map1.position(i).key << " " << map1.position(i).value << " " << map1.position(i).hash);
+    for(auto it = map1.begin(); it.more(); ++it){
+        LOG(*it << " " << map1.get(*it));
     }
 
     map1["test8"] = 999;
 
     LOG(map1.size() << " " << map1.realSize());
-    for(zu64 i = 0; i < map1.realSize(); ++i){
-        if(map1.position(i).flags & ZMAP_ENTRY_VALID)
-            LOG(i << " " << map1.position(i).key << " " << map1.position(i).value << " " << map1.position(i).hash);
+    for(auto it = map1.begin(); it.more(); ++it){
+        LOG(*it << " " << map1.get(*it));
     }
 
     LOG("Forward Iterator: " << map1.size());
@@ -226,6 +229,36 @@ void map(){
     TASSERT(keys.size() == map1.size());
 }
 
+void map_move(){
+    ZMap<ZString, ZArray<ZString>> map1;
+    map1.emplace("one", ZArray<ZString>({ "a", "b" }));
+    ZArray<ZString> arr = { "c" };
+    map1.add("two", std::move(arr));
+    TASSERT(arr.size() == 0);
+    // Grow the table past its initial capacity
+    for(int i = 0; i < 40; ++i)
+        map1.emplace(ZString(i)).push(ZString(i));
+    ZString strs[] = { "x", "y", "z" };
+    map1.emplace("one", strs, 3);
+    TASSERT(map1.size() == 42 && map1["one"].size() == 3 && map1["two"][0] == "c" && map1["39"][0] == "39");
+
+    ZMap<ZString, ZArray<ZString>> map2(std::move(map1));
+    TASSERT(map1.size() == 0 && map2.size() == 42);
+    map1 = map2;
+    map2.clear();
+    TASSERT(map1.size() == 42 && map2.size() == 0 && map1["one"][2] == "z");
+
+    ZSet<ZString> set1;
+    for(int i = 0; i < 40; ++i)
+        set1.add(ZString(i));
+    ZSet<ZString> set2(std::move(set1));
+    TASSERT(set1.size() == 0 && set2.size() == 40 && set2.contains("25"));
+    set1 = set2;
+    TASSERT(set1.size() == 40 && set1.contains("0") && set1.contains("39"));
+    auto it = set1.begin();
+    test_forward_iterator(&it, set1.size());
+}
+
 void set(){
     ZString str1 = "one";
     ZString str2 = "two";
@@ -256,6 +289,388 @@ void set(){
     test_forward_iterator(&i2f, set2.size());
 }
 
+void map_table(){
+    // Integer keys with trivial hashes, through several rehashes
+    ZMap<int, int> map1;
+    TASSERT(map1.realSize() == 0);
+    for(int i = 0; i < 1000; ++i)
+        map1[i * 16] = i;
+    TASSERT(map1.size() == 1000 && map1.realSize() >= 1000 && map1.realSize() * ZMAP_DEFAULT_LOAD_FACTOR >= 1000);
+    for(int i = 0; i < 1000; ++i)
+        TASSERT(map1.contains(i * 16) && map1.get(i * 16) == i && !map1.contains(i * 16 + 1));
+
+    // Removed keys leave iteration order alone, re-added keys go to the end
+    for(int i = 0; i < 1000; i += 2)
+        map1.remove(i * 16);
+    map1.remove(-1);
+    map1.add(0, 5);
+    map1.add(16, 7);
+    TASSERT(map1.size() == 501 && map1[0] == 5 && map1[16] == 7);
+    zu64 n = 0;
+    int last = 0;
+    for(auto it = map1.begin(); it.more(); ++it, ++n){
+        if(n < 500)
+            TASSERT(*it == 16 * (2 * (int)n + 1) && *it > last);
+        last = *it;
+    }
+    TASSERT(n == 501 && last == 0);
+
+    // Churn through deleted slots without growing or duplicating keys
+    zu64 slots = map1.realSize();
+    for(int j = 0; j < 20; ++j){
+        for(int i = 0; i < 100; ++i)
+            map1[100000 + i] = j;
+        for(int i = 0; i < 100; ++i)
+            map1.remove(100000 + i);
+    }
+    TASSERT(map1.size() == 501 && map1.realSize() == slots && map1.keys().size() == 501);
+
+    // Views look up string keys
+    ZMap<ZString, int> map2;
+    for(int i = 0; i < 100; ++i)
+        map2.add(ZString("key") + i, i);
+    TASSERT(map2.get(ZStringView("key42")) == 42 && !map2.contains(ZStringView("key100")));
+    map2.clear();
+    TASSERT(map2.isEmpty() && map2.realSize() == 0 && !map2.contains("key1"));
+
+    ZSet<int> set1;
+    for(int i = 0; i < 300; ++i)
+        set1.add(i % 100);
+    set1.remove(50);
+    TASSERT(set1.size() == 99 && !set1.contains(50) && set1.contains(99));
+    set1.add(50);
+    ZArray<int> order;
+    for(auto it = set1.begin(); it.more(); ++it)
+        order.push(*it);
+    TASSERT(order.size() == 100 && order[49] == 49 && order[50] == 51 && order[99] == 50);
+}
+
+void map_lookup(){
+    typedef ZMap<ZString, int> StrMap;
+    StrMap map1;
+    for(int i = 0; i < 200; ++i)
+        map1.add(ZString("key") + i, i);
+
+    // C strings, views and raw bytes look up string keys without building a ZString
+    const char *cstr = "key7";
+    char buf[] = { 'k', 'e', 'y', '1', '2', 'x' };
+    TASSERT(map1.contains("key199") && map1.get(cstr) == 7 && map1.contains(ZStringView(buf, 5)));
+    TASSERT(!map1.contains("key200") && map1.find("key200") == nullptr && *map1.find("key3") == 3);
+    map1["key200"] = 200;
+    TASSERT(map1.size() == 201 && map1.get(ZString("key200")) == 200);
+
+    // New keys are stored by the constructed key, which stops at a NUL and drops invalid UTF-8
+    StrMap map2;
+    map2[ZStringView("a\0b", 3)] = 1;
+    map2[ZStringView("a\0b", 3)] += 1;
+    map2["\xC0x"] = 3;
+    map2["\xC0x"] += 1;
+    TASSERT(map2.size() == 2 && map2.get(ZString("a")) == 2 && map2.get(ZString("x")) == 4);
+
+    // Precomputed hashes match for equal keys of any lookup type
+    StrMap::maphash hash = StrMap::hashKey("key42");
+    TASSERT(hash == StrMap::hashKey(ZString("key42")) && hash == StrMap::hashKey(ZStringView("key42")));
+    TASSERT(map1.contains(hash, "key42") && *map1.find(hash, ZString("key42")) == 42);
+    map1.add(StrMap::hashKey("new"), "new", 1);
+    TASSERT(map1.get("new") == 1);
+
+    // Erase
+    TASSERT(map1.erase("key42") && !map1.erase("key42") && !map1.contains(hash, "key42"));
+    TASSERT(map1.erase(ZString("key43")) && map1.erase(StrMap::hashKey("new"), "new"));
+    TASSERT(map1.size() == 199);
+
+    // Batch lookups
+    ZArray<ZString> keys;
+    for(int i = 0; i < 100; ++i)
+        keys.push(ZString("key") + (i * 3));
+    ZArray<int *> values = map1.getMany(keys);
+    ZArray<bool> found = map1.containsMany(keys);
+    TASSERT(values.size() == 100 && found.size() == 100);
+    for(int i = 0; i < 100; ++i){
+        bool exists = (i * 3 <= 200 && i * 3 != 42);
+        TASSERT(found[i] == exists && (values[i] != nullptr) == exists);
+        if(exists)
+            TASSERT(*values[i] == i * 3);
+    }
+    const StrMap &cmap = map1;
+    ZArray<const char *> ckeys = { "key0", "nope", "key5" };
+    ZArray<const int *> cvalues = cmap.getMany(ckeys);
+    TASSERT(*cvalues[0] == 0 && cvalues[1] == nullptr && *cvalues[2] == 5);
+
+    ZSet<ZString> set1 = { "one", "two", "three" };
+    TASSERT(set1.contains("two") && !set1.contains(ZStringView("four")));
+    TASSERT(set1.contains(ZSet<ZString>::hashKey("three"), "three"));
+    ZArray<bool> sfound = set1.containsMany(ZArray<ZStringView>({ "one", "four" }));
+    TASSERT(sfound[0] && !sfound[1]);
+}
+
+//! Random inserts and removes, checked against a ZMap. Small nodes force deep trees and every rebalancing case.
+void tree_map(){
+    ZTreeMap<zu64, zu64> tree;
+    ZMap<zu64, zu64> check;
+    zu64 state = 99;
+    for(zu64 i = 0; i < 20000; ++i){
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        zu64 key = (state >> 33) % 4000;
+        if((state >> 20) % 3 == 0){
+            TASSERT(tree.erase(key) == check.contains(key));
+            check.remove(key);
+        } else {
+            tree.add(key, i);
+            check.add(key, i);
+        }
+    }
+    TASSERT(tree.size() == check.size() && tree.depth() > 1);
+    zu64 count = 0;
+    zu64 prev = 0;
+    for(auto it = tree.begin(); it.more(); ++it, ++count){
+        TASSERT(count == 0 || prev < *it);
+        TASSERT(check.get(*it) == it.value());
+        prev = *it;
+    }
+    TASSERT(count == check.size());
+    for(auto it = check.begin(); it.more(); ++it)
+        TASSERT(tree.find(*it) != nullptr && *tree.find(*it) == check.get(*it));
+
+    // Empty the tree
+    ZArray<zu64> keys = tree.keys();
+    for(zu64 i = 0; i < keys.size(); ++i)
+        TASSERT(tree.erase(keys[i]));
+    TASSERT(tree.isEmpty() && tree.depth() == 0 && !tree.begin().more());
+
+    // Bounds and ranges
+    for(zu64 i = 0; i < 1000; ++i)
+        tree[i * 2] = i;
+    TASSERT(*tree.lowerBound(100) == 100 && *tree.lowerBound(101) == 102 && *tree.upperBound(100) == 102);
+    TASSERT(!tree.lowerBound(1999).more() && tree.first() == 0 && tree.last() == 1998);
+    ZArray<zu64> range;
+    for(auto it = tree.range(10, 20); it.more(); ++it)
+        range.push(it.value());
+    TASSERT(range.size() == 5 && range[0] == 5 && range[4] == 9);
+    TASSERT(!tree.range(20, 10).more() && !tree.range(11, 12).more());
+
+    // Copies are independent
+    ZTreeMap<zu64, zu64> copy = tree;
+    copy.remove(0);
+    TASSERT(copy.size() == 999 && tree.size() == 1000 && tree.contains(0) && copy.get(2) == 1);
+    const ZTreeMap<zu64, zu64> &ctree = tree;
+    try {
+        ctree.get(1);
+        TASSERT(false);
+    } catch(ZException &){
+    }
+
+    // Bulk load
+    ZArray<ZString> skeys;
+    ZArray<int> svalues;
+    for(int i = 0; i < 3000; ++i){
+        skeys.push(ZString("key") + (10000 + i));
+        svalues.push(i);
+    }
+    ZTreeMap<ZString, int> smap;
+    smap.add("stale", -1);
+    smap.loadSorted(skeys, svalues);
+    TASSERT(smap.size() == 3000 && !smap.contains("stale") && smap.get("key12999") == 2999);
+    TASSERT(smap.keys().equals(skeys) && *smap.lowerBound("key11") == "key11000");
+    smap.add("key", -1);
+    TASSERT(smap.first() == "key" && smap.erase("key10500") && !smap.contains("key10500"));
+    ZArray<ZString> unsorted = { "b", "a" };
+    try {
+        smap.loadSorted(unsorted, ZArray<int>({ 1, 2 }));
+        TASSERT(false);
+    } catch(ZException &){
+    }
+}
+
+void tree_set(){
+    ZTreeSet<ZUID> set1;
+    ZArray<ZUID> uids;
+    for(int i = 0; i < 500; ++i){
+        ZUID uid(ZUID::RANDOM);
+        uids.push(uid);
+        set1.add(uid);
+        set1.add(uid);
+    }
+    TASSERT(set1.size() == 500);
+    ZArray<ZUID> ordered = set1.toArray();
+    for(zu64 i = 1; i < ordered.size(); ++i)
+        TASSERT(ordered[i - 1] < ordered[i]);
+    for(int i = 0; i < 250; ++i)
+        TASSERT(set1.erase(uids[i]));
+    TASSERT(set1.size() == 250 && !set1.contains(uids[0]) && set1.contains(uids[499]));
+
+    ZTreeSet<int> set2 = { 5, 3, 9, 1 };
+    TASSERT(set2.first() == 1 && set2.last() == 9 && *set2.upperBound(3) == 5);
+    set2.loadSorted({ 2, 4, 6, 8 });
+    TASSERT(set2.size() == 4 && !set2.contains(5) && *set2.lowerBound(5) == 6);
+}
+
+//! Compare ordered iteration of a ZTreeMap with sorting the keys of a ZMap.
+static void lru_evicted(const ZString &key, zu64 &value, void *user){
+    ((ZArray<ZString> *)user)->push(key);
+}
+
+void lru_cache(){
+    ZLRUCache<ZString, zu64> cache(3);
+    ZArray<ZString> evicted;
+    cache.setEvictCallback(lru_evicted, &evicted);
+    cache.put("a", 1);
+    cache.put("b", 2);
+    cache.put("c", 3);
+    TASSERT(cache.size() == 3);
+
+    // Touch a, so b is least recently used
+    TASSERT(cache.get("a") != nullptr && *cache.get("a") == 1);
+    TASSERT(cache.get(ZStringView("nope")) == nullptr);
+    cache.put("d", 4);
+    TASSERT(evicted.size() == 1 && evicted[0] == "b");
+    TASSERT(!cache.contains("b") && cache.contains("a") && cache.contains("c"));
+    TASSERT(cache.hits() == 2 && cache.misses() == 1 && cache.evictions() == 1);
+
+    // peek does not touch
+    TASSERT(*cache.peek("c") == 3);
+    cache.put("e", 5);
+    TASSERT(evicted.size() == 2 && evicted[1] == "c");
+
+    ZArray<ZString> order;
+    cache.forEach([&](const ZString &key, const zu64 &){ order.push(key); });
+    TASSERT(order.size() == 3 && order[0] == "e" && order[1] == "d" && order[2] == "a");
+
+    // Replacing updates the value and touches
+    cache.put("a", 10);
+    TASSERT(*cache.peek("a") == 10 && cache.size() == 3);
+    TASSERT(cache.remove("d") && !cache.remove("d"));
+    TASSERT(cache.size() == 2 && evicted.size() == 2);
+
+    // Bounded by cost
+    ZLRUCache<ZString, zu64> sized(0, 100);
+    sized.put("x", 1, 40);
+    sized.put("y", 2, 40);
+    TASSERT(sized.cost() == 80);
+    sized.put("z", 3, 30);
+    TASSERT(!sized.contains("x") && sized.cost() == 70 && sized.evictions() == 1);
+    TASSERT(sized.put("big", 4, 101) == nullptr && !sized.contains("big"));
+    TASSERT(sized.put("y", 5, 90) != nullptr && sized.size() == 1 && sized.cost() == 90);
+    sized.setCapacity(0, 50);
+    TASSERT(sized.isEmpty() && sized.cost() == 0);
+
+    // Nodes are reused through many evictions
+    ZLRUCache<zu64, ZString> many(64);
+    for(zu64 i = 0; i < 10000; ++i){
+        many.put(i, ZString::ItoS(i));
+        if(i % 2)
+            TASSERT(*many.get(i - 1) == ZString::ItoS(i - 1));
+    }
+    TASSERT(many.size() == 64 && many.evictions() == 10000 - 64);
+    TASSERT(many.contains((zu64)9999) && !many.contains((zu64)0));
+    many.clear();
+    TASSERT(many.isEmpty());
+}
+
+//! Compare an LRU cache with moving entries to the end of a ZMap by remove and add.
+void bench_lru_cache(){
+    const zu64 count = 1 << 20;
+    const zu64 capacity = 1 << 14;
+    ZArray<zu64> keys;
+    zu64 state = 4242;
+    for(zu64 i = 0; i < count; ++i){
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        keys.push((state >> 33) % (capacity * 2));
+    }
+
+    ZClock clock;
+    ZLRUCache<zu64, zu64> cache(capacity);
+    zu64 hits = 0;
+    for(zu64 i = 0; i < count; ++i){
+        if(cache.get(keys[i]) != nullptr)
+            ++hits;
+        else
+            cache.put(keys[i], i);
+    }
+    clock.stop();
+    LOG("lru cache:  " << clock.getSecs() << " s, " << hits);
+
+    clock.start();
+    ZMap<zu64, zu64> map1;
+    hits = 0;
+    for(zu64 i = 0; i < count; ++i){
+        zu64 *found = map1.find(keys[i]);
+        if(found != nullptr){
+            ++hits;
+            zu64 value = *found;
+            map1.remove(keys[i]);
+            map1.add(keys[i], value);
+        } else {
+            if(map1.size() >= capacity)
+                map1.remove(*map1.begin());
+            map1.add(keys[i], i);
+        }
+    }
+    clock.stop();
+    LOG("map reorder: " << clock.getSecs() << " s, " << hits);
+}
+
+void bench_tree_map(){
+    const zu64 count = 1 << 20;
+    ZArray<zu64> keys;
+    zu64 state = 777;
+    for(zu64 i = 0; i < count; ++i){
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        keys.push(state >> 16);
+    }
+    ZMap<zu64, zu64> map1;
+    ZTreeMap<zu64, zu64> tree;
+    for(zu64 i = 0; i < count; ++i){
+        map1.add(keys[i], i);
+        tree.add(keys[i], i);
+    }
+
+    ZClock clock;
+    zu64 sum = 0;
+    ZArray<zu64> sorted = map1.keys();
+    std::sort(sorted.raw(), sorted.raw() + sorted.size());
+    for(zu64 i = 0; i < sorted.size(); ++i)
+        sum += map1.get(sorted[i]);
+    clock.stop();
+    LOG("sorted map: " << clock.getSecs() << " s, " << sum);
+
+    clock.start();
+    sum = 0;
+    for(auto it = tree.begin(); it.more(); ++it)
+        sum += it.value();
+    clock.stop();
+    LOG("tree:       " << clock.getSecs() << " s, " << sum);
+}
+
+//! Compare single and batched lookups of random keys in a large map.
+void bench_map_batch(){
+    const zu64 count = 1 << 20;
+    ZMap<zu64, zu64> map1;
+    for(zu64 i = 0; i < count; ++i)
+        map1.add(i * 7, i);
+    ZArray<zu64> keys;
+    zu64 state = 12345;
+    for(zu64 i = 0; i < count; ++i){
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        keys.push((state >> 20) % (count * 7));
+    }
+
+    ZClock clock;
+    zu64 hits = 0;
+    for(zu64 i = 0; i < keys.size(); ++i)
+        hits += map1.contains(keys[i]);
+    clock.stop();
+    LOG("single:  " << clock.getSecs() << " s, " << hits << " hits");
+
+    clock.start();
+    ZArray<bool> found = map1.containsMany(keys);
+    hits = 0;
+    for(zu64 i = 0; i < found.size(); ++i)
+        hits += found[i];
+    clock.stop();
+    LOG("batched: " << clock.getSecs() << " s, " << hits << " hits");
+}
+
 ZArray<Test> hash_tests(){
     return {
         { "hash",       hash,       true, {} },
@@ -269,6 +684,15 @@ ZArray<Test> hash_tests(){
 #endif
         { "map",        map,        true, { "hash" } },
         { "set",        set,        true, { "hash" } },
+        { "map-move",   map_move,   true, { "map", "set" } },
+        { "map-table",  map_table,  true, { "map", "set" } },
+        { "map-lookup", map_lookup, true, { "map-table", "string-view" } },
+        { "tree-map",   tree_map,   true, { "map-table" } },
+        { "tree-set",   tree_set,   true, { "tree-map", "uid_str" } },
+        { "lru-cache",  lru_cache,  true, { "map-lookup" } },
+        { "bench-map-batch", bench_map_batch, false, {} },
+        { "bench-tree-map", bench_tree_map, false, {} },
+        { "bench-lru-cache", bench_lru_cache, false, {} },
     };
 }
 
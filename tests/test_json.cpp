@@ -64,6 +64,19 @@ void json_decode(){
     checkType(json, "");
 }
 
+void json_number(){
+    ZString str = "{\"a\":-1.5,\"b\":[0.1,1e+21,-0.000001],\"c\":12345678901234567890}";
+    ZJSON json;
+    TASSERT(json.decode(str));
+    TASSERT(json["a"].number() == -1.5 && json["b"][(zu64)0].number() == 0.1 && json["b"][(zu64)1].number() == 1e21);
+    TASSERT(json["c"].number() == 12345678901234567890.0);
+    TASSERT(json.encode(false) == "{\"a\":-1.5,\"b\":[0.1,1e+21,-0.000001],\"c\":12345678901234567000}");
+
+    ZJSON bad;
+    TASSERT(!bad.decode("[1.2.3]"));
+    TASSERT(!bad.decode("[-nan]") && !bad.decode("[-inf]") && !bad.decode("{\"a\":infinity}"));
+}
+
 void json_empty(){
     ZString str = "{}";
     ZJSON json;
@@ -88,6 +101,7 @@ ZArray<Test> json_tests(){
         { "json_encode", json_encode, true, {} },
         { "json_decode", json_decode, true, { "json_encode" } },
         { "json_empty", json_empty, true, { "json_encode" } },
+        { "json_number", json_number, true, { "json_decode" } },
         { "json_empty_elem", json_empty_elem, true, { "json_encode" } },
     };
 }
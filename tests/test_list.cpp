@@ -1,6 +1,10 @@
 #include "tests.h"
 #include "zlist.h"
 #include "zqueue.h"
+#include "zdeque.h"
+#include "zstack.h"
+#include "zpoolallocator.h"
+#include "zclock.h"
 
 namespace LibChaosTest {
 
@@ -56,6 +60,21 @@ void list_push_obj(){
     LOG(list4.size() << " " << list4[0] << "." << list4[1] << "." << list4[2] << "." << list4[3] << "." << list4[4] << " OK");
 }
 
+void list_move(){
+    ZList<ZString> list5;
+    ZString two = "two";
+    list5.pushBack(std::move(two));
+    list5.emplaceBack("three");
+    list5.emplaceFront('1', 3);
+    TASSERT(list5.size() == 3 && list5[0] == "111" && list5[1] == "two" && list5[2] == "three");
+
+    ZList<ZString> list6(std::move(list5));
+    TASSERT(list5.size() == 0 && list6.size() == 3 && list6[2] == "three");
+    list5 = list6;
+    list6.clear();
+    TASSERT(list5.size() == 3 && list6.size() == 0 && list5[1] == "two");
+}
+
 void list_iterator(){
     ZList<ZString> list4;
     list4.push("three");
@@ -87,8 +106,148 @@ void list_empty(){
     test_reverse_iterator(&itr, 0);
 }
 
+void deque(){
+    ZDeque<ZString> deq1;
+    TASSERT(deq1.isEmpty() && deq1.capacity() == 0);
+    // Push at both ends across several wraps and growths
+    for(int i = 0; i < 100; ++i){
+        deq1.pushBack(ZString(i));
+        deq1.pushFront(ZString(-i - 1));
+    }
+    TASSERT(deq1.size() == 200 && deq1.capacity() == 256);
+    TASSERT(deq1.front() == "-100" && deq1.back() == "99" && deq1[100] == "0" && deq1.at(199) == "99");
+    for(int i = 0; i < 50; ++i){
+        deq1.popFront();
+        deq1.popBack();
+    }
+    TASSERT(deq1.size() == 100 && deq1.front() == "-50" && deq1.back() == "49");
+    int expect = -50;
+    for(auto it = deq1.begin(); it.more(); ++it, ++expect)
+        TASSERT(*it == ZString(expect));
+
+    // Steady push and pop reuses the buffer
+    ZDeque<int> deq2;
+    for(int i = 0; i < 1000; ++i){
+        deq2.push(i);
+        deq2.push(i);
+        deq2.pop();
+    }
+    TASSERT(deq2.size() == 1000 && deq2.peek() == 500 && deq2.capacity() == 1024);
+
+    ZDeque<ZString> deq3 = deq1;
+    deq3.emplaceFront("first");
+    TASSERT(deq3.size() == 101 && deq1.size() == 100 && deq3[1] == "-50");
+    ZDeque<ZString> deq4(std::move(deq3));
+    TASSERT(deq3.isEmpty() && deq4.front() == "first");
+    deq4.clear();
+    bool thrown = false;
+    try {
+        deq4.front();
+    } catch(ZException &){
+        thrown = true;
+    }
+    TASSERT(thrown && deq4.isEmpty());
+}
+
 void queue(){
     ZQueue<int> tst1;
+    for(int i = 0; i < 10; ++i)
+        tst1.push(i);
+    TASSERT(tst1.size() == 10 && tst1.peek() == 0);
+    tst1.pop();
+    TASSERT(tst1.peek() == 1);
+
+    ZStack<int, ZDeque<int>> tst2;
+    for(int i = 0; i < 10; ++i)
+        tst2.push(i);
+    tst2.pop();
+    TASSERT(tst2.size() == 9 && tst2.peek() == 8);
+}
+
+void queue_pool(){
+    // A ZList backed queue can pool its nodes
+    typedef ZQueue<ZString, ZList<ZString>> ListQueue;
+    ZPoolAllocator<ListQueue::Container::Node> *pool = new ZPoolAllocator<ListQueue::Container::Node>(4, 8);
+    ListQueue queue1(pool);
+    for(int i = 0; i < 100; ++i){
+        queue1.push(ZString(i));
+        queue1.push(ZString(i + 1));
+        TASSERT(queue1.peek() == ZString(i));
+        queue1.pop();
+        queue1.pop();
+    }
+    // Freed nodes are reused
+    TASSERT(queue1.isEmpty() && pool->count() == 0 && pool->capacity() == 4);
+
+    // Bounded capacity
+    for(int i = 0; i < 8; ++i)
+        queue1.push(ZString(i));
+    TASSERT(pool->capacity() == 8);
+    bool full = false;
+    try {
+        queue1.push("overflow");
+    } catch(zallocator_exception){
+        full = true;
+    }
+    TASSERT(full && queue1.size() == 8 && queue1.peek() == "0");
+
+    // Pool moves with the nodes
+    ListQueue queue2;
+    queue2.swap(queue1);
+    TASSERT(queue1.isEmpty() && queue2.size() == 8 && pool->count() == 8);
+    queue2.pop();
+    TASSERT(pool->count() == 7);
+}
+
+void list_move_pool(){
+    // Move assignment takes the other list's pool with its nodes
+    typedef ZList<ZString>::Node Node;
+    ZPoolAllocator<Node> *pool1 = new ZPoolAllocator<Node>(4);
+    ZPoolAllocator<Node> *pool2 = new ZPoolAllocator<Node>(4);
+    ZList<ZString> list2(pool2);
+    list2.push("x");
+    {
+        ZList<ZString> list1(pool1);
+        for(int i = 0; i < 3; ++i)
+            list1.push(ZString(i));
+        list2 = std::move(list1);
+        TASSERT(list2.size() == 3 && list2[2] == "2" && list1.size() == 1 && list1[0] == "x");
+        TASSERT(pool1->count() == 3 && pool2->count() == 1);
+        list1.popFront();
+        TASSERT(pool2->count() == 0);
+    }
+    // pool2 is gone with list1, the nodes in list2 are still in pool1
+    list2.popBack();
+    list2.push("3");
+    TASSERT(pool1->count() == 3 && list2.size() == 3 && list2.peekBack() == "3");
+}
+
+//! Compare a ZDeque backed queue with a ZList backed queue.
+void bench_queue(){
+    const int count = 1 << 22;
+    ZClock clock;
+    ZQueue<int> queue1;
+    zu64 sum = 0;
+    for(int i = 0; i < count; ++i){
+        queue1.push(i);
+        queue1.push(i);
+        sum += queue1.peek();
+        queue1.pop();
+    }
+    clock.stop();
+    LOG("deque: " << clock.getSecs() << " s, " << sum);
+
+    clock.start();
+    ZQueue<int, ZList<int>> queue2;
+    sum = 0;
+    for(int i = 0; i < count; ++i){
+        queue2.push(i);
+        queue2.push(i);
+        sum += queue2.peek();
+        queue2.pop();
+    }
+    clock.stop();
+    LOG("list:  " << clock.getSecs() << " s, " << sum);
 }
 
 ZArray<Test> list_tests(){
@@ -96,9 +255,14 @@ ZArray<Test> list_tests(){
         { "list-push-pop",  list_push_pop,  true, {} },
         { "list-construct", list_construct, true, {} },
         { "list-push-obj",  list_push_obj,  true, {} },
+        { "list-move",      list_move,      true, { "list-push-obj" } },
         { "list-iterator",  list_iterator,  true, {} },
         { "list-empty",     list_empty,     true, {} },
-        { "queue",          queue,          true, {} },
+        { "deque",          deque,          true, {} },
+        { "queue",          queue,          true, { "deque" } },
+        { "queue-pool",     queue_pool,     true, { "queue" } },
+        { "list-move-pool", list_move_pool, true, { "list-move" } },
+        { "bench-queue",    bench_queue,    false, {} },
     };
 }
 
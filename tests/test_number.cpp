@@ -1,6 +1,14 @@
 #include "tests.h"
 #include "znumber.h"
+#include "znumberformat.h"
 #include "zbinary.h"
+#include "zclock.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <sstream>
 
 namespace LibChaosTest {
 
@@ -38,9 +46,161 @@ void number(){
     // 3227 / 555 = 5.8[144] = 5.8144144144...
 }
 
+//! Format \a value with ZNumberFormat.
+static ZString formatDouble(double value){
+    char buffer[ZNUMBERFORMAT_DOUBLE_SIZE];
+    return ZString(buffer, ZNumberFormat::formatDouble(value, buffer));
+}
+
+//! Parse \a str with ZNumberFormat, checking that all of it is parsed.
+static bool parsesTo(const char *str, double expect){
+    double value;
+    zu64 len = strlen(str);
+    if(ZNumberFormat::parseDouble(str, len, &value) != len)
+        return false;
+    return memcmp(&value, &expect, sizeof(double)) == 0;
+}
+
+void number_format(){
+    // Integers
+    char buffer[ZNUMBERFORMAT_INT_SIZE];
+    const zu64 uints[] = { 0, 9, 10, 99, 100, 101, 12345678, 1000000000000ULL, ZU64_MAX };
+    for(zu64 i = 0; i < sizeof(uints) / sizeof(zu64); ++i){
+        char expect[32];
+        snprintf(expect, sizeof(expect), "%llu", (unsigned long long)uints[i]);
+        TASSERT(ZString(buffer, ZNumberFormat::formatUint(uints[i], buffer)) == expect);
+    }
+    TASSERT(ZString(buffer, ZNumberFormat::formatSint(ZS64_MIN, buffer)) == "-9223372036854775808");
+    TASSERT(ZString::ItoS(ZS64_MIN, 16) == "-8000000000000000");
+    TASSERT(ZString::ItoS((zu64)0xBEEF, 16, 8, true) == "0000BEEF");
+    TASSERT(ZString::ItoS((zu64)5, 2, 4) == "0101" && ZString::ItoS((zu64)80, 3) == "2222");
+    TASSERT(ZString::ItoS((zu64)1, 17).isEmpty());
+    TASSERT(ZString((zs64)-42) == "-42" && ZString((zu64)ZU64_MAX) == "18446744073709551615");
+
+    zu64 value;
+    TASSERT(ZNumberFormat::parseUint("12345678901234567890x", 21, &value) == 20 && value == 12345678901234567890ULL);
+    TASSERT(ZNumberFormat::parseUint("123456789012345678901", 21, &value) == 21 && value == ZU64_MAX);
+    TASSERT(ZNumberFormat::parseUint("fFz", 3, &value, 16) == 2 && value == 0xFF);
+    TASSERT(ZString("0012345678").toUint() == 12345678 && !ZString("1234567a").isInteger());
+
+    // Shortest digits in fixed or exponent notation
+    TASSERT(formatDouble(0.1) == "0.1");
+    TASSERT(formatDouble(123.456) == "123.456");
+    TASSERT(formatDouble(-2.5) == "-2.5");
+    TASSERT(formatDouble(1e20) == "100000000000000000000");
+    TASSERT(formatDouble(1e21) == "1e+21");
+    TASSERT(formatDouble(0.000001) == "0.000001");
+    TASSERT(formatDouble(1.5e-7) == "1.5e-7");
+    TASSERT(formatDouble(5e-324) == "5e-324");
+    TASSERT(formatDouble(1.7976931348623157e308) == "1.7976931348623157e+308");
+    TASSERT(formatDouble(0.0) == "0" && formatDouble(-0.0) == "-0");
+    TASSERT(formatDouble(HUGE_VAL) == "inf" && formatDouble(-HUGE_VAL) == "-inf" && formatDouble(NAN) == "nan");
+    TASSERT(ZString(3.14159, 2) == "3.14" && ZString(2.0, 2) == "2" && ZString(0.5) == "0.5");
+
+    // Parsing
+    TASSERT(parsesTo("0.1", 0.1) && parsesTo("-0", -0.0) && parsesTo("1e-400", 0.0) && parsesTo("1e400", HUGE_VAL));
+    TASSERT(parsesTo(".5", 0.5) && parsesTo("5.", 5.0) && parsesTo("+1E3", 1000.0) && parsesTo("-inf", -HUGE_VAL));
+    TASSERT(parsesTo("123456789012345678901234567890", 1.2345678901234568e29));
+    TASSERT(parsesTo("0.000000000000000000000000000001", 1e-30));
+    TASSERT(parsesTo("2.2250738585072011e-308", 2.2250738585072011e-308));
+    TASSERT(parsesTo("9007199254740993", 9007199254740992.0));
+    double dvalue;
+    TASSERT(ZNumberFormat::parseDouble("1e", 2, &dvalue) == 1 && ZNumberFormat::parseDouble("-.e5", 4, &dvalue) == 0);
+    TASSERT(ZString("-1.25e2").isFloat() && ZString("-1.25e2").toDouble() == -125.0);
+    TASSERT(!ZString("1.2.3").isFloat() && !ZString("").isFloat() && ZString("abc").toFloat() == 0.0f);
+    TASSERT(ZNumberFormat::parseDouble("-inf", 4, &dvalue, true) == 0 && ZNumberFormat::parseDouble("nan", 3, &dvalue, true) == 0);
+    TASSERT(!ZString("-inf").isFloat() && !ZString("nan").isFloat() && ZString("infinity").toDouble() == 0.0);
+
+    // Every format round trips, and parsing matches strtod
+    zu64 state = 1234;
+    for(zu64 i = 0; i < 20000; ++i){
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        double num;
+        zu64 bits = state;
+        memcpy(&num, &bits, sizeof(num));
+        if(num != num || num - num != 0)
+            continue;
+        ZString str = formatDouble(num);
+        TASSERT(str.size() < ZNUMBERFORMAT_DOUBLE_SIZE);
+        TASSERT(strtod(str.cc(), nullptr) == num);
+        TASSERT(parsesTo(str.cc(), num));
+
+        // Decimal strings with a few digits, exact and not
+        char dec[64];
+        snprintf(dec, sizeof(dec), "%llu.%llue%d", (unsigned long long)(state >> 40), (unsigned long long)(state & 0xFFFF), (int)(state % 80) - 40);
+        TASSERT(parsesTo(dec, strtod(dec, nullptr)));
+    }
+}
+
+//! Compare number formatting and parsing with the standard library.
+void bench_number_format(){
+    const zu64 count = 1000000;
+    ZArray<double> doubles;
+    zu64 state = 99;
+    for(zu64 i = 0; i < count; ++i){
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        doubles.push((double)(state >> 11) / (double)(1ULL << (state % 60)));
+    }
+
+    ZClock clock;
+    zu64 total = 0;
+    for(zu64 i = 0; i < count / 10; ++i){
+        std::stringstream stream;
+        stream << doubles[i];
+        total += stream.str().size();
+    }
+    clock.stop();
+    LOG("stringstream (1/10): " << clock.getSecs() << " s " << total);
+
+    char buffer[32];
+    clock.start();
+    total = 0;
+    for(zu64 i = 0; i < count; ++i)
+        total += (zu64)snprintf(buffer, sizeof(buffer), "%.17g", doubles[i]);
+    clock.stop();
+    LOG("snprintf %.17g:      " << clock.getSecs() << " s " << total);
+
+    clock.start();
+    total = 0;
+    for(zu64 i = 0; i < count; ++i)
+        total += ZNumberFormat::formatDouble(doubles[i], buffer);
+    clock.stop();
+    LOG("formatDouble:        " << clock.getSecs() << " s " << total);
+
+    ZArray<ZString> strs;
+    for(zu64 i = 0; i < count; ++i)
+        strs.push(ZString(doubles[i]));
+
+    double sum = 0;
+    clock.start();
+    for(zu64 i = 0; i < count; ++i)
+        sum += strtod(strs[i].cc(), nullptr);
+    clock.stop();
+    LOG("strtod:              " << clock.getSecs() << " s " << sum);
+
+    sum = 0;
+    clock.start();
+    for(zu64 i = 0; i < count; ++i){
+        double value;
+        ZNumberFormat::parseDouble(strs[i].cc(), strs[i].size(), &value);
+        sum += value;
+    }
+    clock.stop();
+    LOG("parseDouble:         " << clock.getSecs() << " s " << sum);
+
+    clock.start();
+    total = 0;
+    for(zu64 i = 0; i < count; ++i)
+        total += ZString::ItoS((zu64)(doubles[i] * 1000)).size();
+    clock.stop();
+    LOG("ItoS:                " << clock.getSecs() << " s " << total);
+}
+
 ZArray<Test> number_tests(){
     return {
         { "number", number, true, {} },
+        { "number-format", number_format, true, {} },
+        { "bench-number-format", bench_number_format, false, {} },
     };
 }
 
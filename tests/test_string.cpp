@@ -2,6 +2,14 @@
 
 #include "zstring.h"
 #include "zpath.h"
+#include "zstringview.h"
+#include "zsearcher.h"
+#include "zmultisearcher.h"
+#include "zstringbuilder.h"
+#include "zbinary.h"
+#include "zjson.h"
+#include "zclock.h"
+#include "zmap.h"
 #include <cmath>
 #include <iostream>
 
@@ -90,6 +98,196 @@ void string_find(){
     TASSERT(pos5 == 3);
 }
 
+//! Reference search, comparing at every position.
+static zu64 naive_find(const ZBinary &data, const ZBinary &find, zu64 start){
+    if(find.size() == 0 || find.size() > data.size())
+        return ZSearcher::NONE;
+    for(zu64 i = start; i + find.size() <= data.size(); ++i){
+        if(::memcmp(data.raw() + i, find.raw(), find.size()) == 0)
+            return i;
+    }
+    return ZSearcher::NONE;
+}
+
+void string_search(){
+    // Every pattern length class on data with many partial matches
+    zu64 state = 99;
+    ZBinary data;
+    for(zu64 i = 0; i < 5000; ++i){
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        data.append((zbyte)('a' + (state >> 60) % 3));
+    }
+    for(zu64 len = 1; len < 80; len += (len < 40 ? 1 : 7)){
+        for(zu64 at = 0; at < 4900; at += 613){
+            ZBinary find = data.getSub(at, len);
+            ZSearcher searcher(find.raw(), find.size());
+            for(zu64 start = 0; start < 5000; start += 997){
+                zu64 expect = naive_find(data, find, start);
+                TASSERT(searcher.find(data.raw(), data.size(), start) == expect);
+                TASSERT(ZSearcher::find(data.raw(), data.size(), find.raw(), find.size(), start) == expect);
+                TASSERT(data.findFirst(find, start) == expect);
+            }
+        }
+        // Not present
+        ZBinary none(len);
+        none.fill('z');
+        TASSERT(ZSearcher(none.raw(), none.size()).find(data.raw(), data.size()) == ZSearcher::NONE);
+    }
+
+    // Matches at the very end, and patterns longer than the data
+    ZString str = "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz!";
+    TASSERT(str.findFirst("yz!") == str.size() - 3);
+    TASSERT(str.findFirst("0123456789abcdefghijklmnopqrstuvwxyz!") == 36);
+    TASSERT(str.findFirst(str + "?") == ZString::NONE);
+    TASSERT(str.findFirst("") == ZString::NONE);
+    TASSERT(str.findFirst("0", 37) == ZString::NONE);
+
+    // Compiled searcher
+    ZSearcher abab("abab");
+    TASSERT(abab.size() == 4);
+    TASSERT(abab.count("abababab") == 2 && abab.count("abababab", true) == 3);
+    ZArray<zu64> all = abab.findAll("xxababxabababab", true);
+    TASSERT(all.size() == 4 && all[0] == 2 && all[1] == 7 && all[3] == 11);
+    TASSERT(ZString("aaaa").count("aa") == 3);
+    TASSERT(ZString("aaaa").view().count("aa") == 2);
+
+    // ZBinary search
+    ZBinary bin({ 'A', '0', 'B', '2', 'C', 'D', '2', '2', 'E' });
+    TASSERT(bin.findFirst({ '2', '2' }) == 6);
+    TASSERT(bin.findFirst({ '2' }) == 3);
+    TASSERT(bin.findFirst({ '2' }, 4) == 6);
+    TASSERT(bin.findFirst({ 'E', 'F' }) == ZBinary::NONE);
+
+    // Replace in one pass
+    ZString big;
+    for(zu64 i = 0; i < 10000; ++i)
+        big += "key=value;";
+    big.replace("value", "v");
+    TASSERT(big.size() == 10000 * 6 && big.findFirst("value") == ZString::NONE);
+    TASSERT(big.count("key=v;") == 10000);
+    big.replace("key=v;", "", 9999);
+    TASSERT(big == "key=v;");
+}
+
+//! Compare the search engine with a byte-by-byte search on a large buffer.
+void bench_search(){
+    ZBinary data;
+    zu64 state = 7;
+    for(zu64 i = 0; i < (1 << 24); ++i){
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        data.append((zbyte)('a' + (state >> 59) % 26));
+    }
+    ZBinary shortp = ZBinary(ZString("needle!"));
+    ZBinary longp = ZBinary(ZString("a considerably longer needle that is not in the data"));
+
+    ZClock clock;
+    zu64 found = naive_find(data, shortp, 0) + naive_find(data, longp, 0);
+    clock.stop();
+    LOG("naive:    " << clock.getSecs() << " s " << found);
+
+    clock.start();
+    found = data.findFirst(shortp) + data.findFirst(longp);
+    clock.stop();
+    LOG("searcher: " << clock.getSecs() << " s " << found);
+}
+
+void string_replace_all(){
+    // Overlapping patterns, where one is a suffix or prefix of another
+    ZMultiSearcher searcher({ "he", "she", "his", "hers", "", "he" });
+    TASSERT(searcher.patternCount() == 6);
+    ZArray<ZMultiSearcher::Match> all = searcher.findAll("ushers");
+    TASSERT(all.size() == 3);
+    TASSERT(all[0].pos == 1 && all[0].pattern == 1);
+    TASSERT(all[1].pos == 2 && all[1].pattern == 0);
+    TASSERT(all[2].pos == 2 && all[2].pattern == 3);
+    TASSERT(searcher.containsAny("this") && !searcher.containsAny("shy"));
+
+    // Leftmost, then longest
+    ZArray<ZMultiSearcher::Match> left = searcher.findLeftmost("ushers his");
+    TASSERT(left.size() == 2);
+    TASSERT(left[0].pos == 1 && left[0].pattern == 1);
+    TASSERT(left[1].pos == 7 && left[1].pattern == 2);
+    ZMultiSearcher nested({ "b", "abcd", "bc", "abc" });
+    left = nested.findLeftmost("xabcabcdbc");
+    TASSERT(left.size() == 3);
+    TASSERT(left[0].pos == 1 && left[0].pattern == 3);
+    TASSERT(left[1].pos == 4 && left[1].pattern == 1);
+    TASSERT(left[2].pos == 8 && left[2].pattern == 2);
+    TASSERT(nested.findLeftmost("xabcabcdbc", 1).size() == 1);
+    // A match still pending when the input ends is kept, and scanning resumes after it
+    ZMultiSearcher tail({ "abcde", "ab", "cd" });
+    left = tail.findLeftmost("abcd");
+    TASSERT(left.size() == 2);
+    TASSERT(left[0].pos == 0 && left[0].pattern == 1);
+    TASSERT(left[1].pos == 2 && left[1].pattern == 2);
+    TASSERT(ZString("abcd").replaceAll(tail, { "X", "1", "2" }) == "12");
+
+    // Compare overlapping matches with a search for each pattern
+    zu64 state = 5;
+    ZString text;
+    for(zu64 i = 0; i < 3000; ++i){
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        text += (char)('a' + (state >> 60) % 3);
+    }
+    ZArray<ZString> patterns = { "a", "ab", "abc", "cab", "bb", "cccc", "abcabc", "bcab" };
+    ZMultiSearcher multi(patterns);
+    all = multi.findAll(text);
+    zu64 total = 0;
+    for(zu64 p = 0; p < patterns.size(); ++p)
+        total += ZSearcher(patterns[p].view()).count(text.view(), true);
+    TASSERT(all.size() == total);
+    for(zu64 i = 0; i < all.size(); ++i)
+        TASSERT(text.view(all[i].pos, patterns[all[i].pattern].size()) == patterns[all[i].pattern].view());
+
+    // Replaced text is not searched again
+    ZMap<ZString, ZString> map;
+    map["%a%"] = "%b%";
+    map["%b%"] = "%a%";
+    map["%ab%"] = "X";
+    TASSERT(ZString::replaceAll("%a%-%b%-%ab%-%a", map) == "%b%-%a%-X-%a");
+    ZString str = "no placeholders";
+    TASSERT(str.replaceAll(map) == "no placeholders");
+    TASSERT(ZString("aaaa").replaceAll(ZMultiSearcher({ "a", "aa" }), { "1", "2" }) == "22");
+    TASSERT(ZString("abc").replaceAll(ZMultiSearcher({ "b", "c" }), { "", "CCC" }) == "aCCC");
+
+    bool thrown = false;
+    try {
+        str.replaceAll(multi, { "x" });
+    } catch(ZException &e){
+        thrown = true;
+    }
+    TASSERT(thrown);
+}
+
+//! Compare chained replace calls with one replaceAll pass over a log-like format.
+void bench_replace_all(){
+    ZArray<ZString> keys = { "%log%", "%clock%", "%date%", "%time%", "%datetime%", "%thread%", "%file%", "%line%", "%function%" };
+    ZArray<ZString> values = { "message text", "0.001", "2000-01-01", "00:00:00", "2000-01-01 00:00:00", "1", "file.cpp", "42", "func" };
+    ZString fmt = "%datetime% %thread% %file%:%line% %function%: %log%\n";
+    const zu64 count = 200000;
+
+    ZClock clock;
+    zu64 size = 0;
+    for(zu64 i = 0; i < count; ++i){
+        ZString out = fmt;
+        for(zu64 k = 0; k < keys.size(); ++k)
+            out.replace(keys[k], values[k]);
+        size += out.size();
+    }
+    clock.stop();
+    LOG("replace:    " << clock.getSecs() << " s " << size);
+
+    ZMultiSearcher searcher(keys);
+    clock.start();
+    size = 0;
+    for(zu64 i = 0; i < count; ++i){
+        ZString out = fmt;
+        size += out.replaceAll(searcher, values).size();
+    }
+    clock.stop();
+    LOG("replaceAll: " << clock.getSecs() << " s " << size);
+}
+
 void string_substitute(){
     ZString replace1 = "anotherInterestingStringWithInterestingThings";
     ZString rep1 = ZString::substitute(replace1, 5, 20, "!!!!!");
@@ -225,6 +423,40 @@ void string_number(){
     LOG(floatstr4 << " " << float4);
 }
 
+//! Check if the string buffer is inside the ZString object.
+static bool isInline(const ZString &str){
+    const char *ptr = str.cc();
+    return ptr >= (const char *)&str && ptr < (const char *)(&str + 1);
+}
+
+void string_sso(){
+    ZString short1 = "short string";
+    ZString long1 = "a string that is too long for the inline buffer";
+    TASSERT(isInline(short1) && !isInline(long1));
+    TASSERT(isInline(ZString('x')));
+
+    // Grow out of the inline buffer
+    ZString str1 = short1;
+    str1 += " made longer";
+    TASSERT(!isInline(str1) && str1 == "short string made longer");
+
+    // Move and swap between inline and heap strings
+    ZString str2(std::move(short1));
+    TASSERT(isInline(str2) && str2 == "short string" && short1.isEmpty());
+    str2.swap(long1);
+    TASSERT(!isInline(str2) && isInline(long1) && long1 == "short string");
+    TASSERT(str2 == "a string that is too long for the inline buffer");
+    long1 = std::move(str2);
+    TASSERT(long1 == "a string that is too long for the inline buffer" && str2 == "short string");
+
+    // Relocate short strings in a container
+    ZArray<ZString> arr;
+    for(int i = 0; i < 100; ++i)
+        arr.push(ZString(i));
+    arr.insert(0, "first");
+    TASSERT(arr[0] == "first" && arr[100] == "99" && isInline(arr[100]) && arr[100].cc()[2] == 0);
+}
+
 void string_format(){
     ZString fmtstr1 = "%s - %s";
     ZString fmt1 = ZString::format(fmtstr1, { "test1", "test2" });
@@ -256,6 +488,281 @@ void string_utf32(){
     TASSERT(utf32b == "b \U00010437");
 }
 
+//! Build a string of \a count code points cycling through \a cps.
+static ZString cycleString(const zu32 *cps, zu64 ncps, zu64 count){
+    ZArray<zu32> units;
+    for(zu64 i = 0; i < count; ++i)
+        units.push(cps[i % ncps]);
+    ZString str;
+    str.parseUTF32(units.raw(), units.size());
+    return str;
+}
+
+void string_unicode_convert(){
+    // Mixed ASCII, Latin, CJK and astral code points, with runs of ASCII across block boundaries
+    const zu32 cps[] = { 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's',
+                         0xE9, 0x4E2D, 'x', 0x10437, 0x6587, ' ', 0xFC };
+    const zu64 ncps = sizeof(cps) / sizeof(cps[0]);
+    for(zu64 count = 0; count < 300; count += 37){
+        ZString str = cycleString(cps, ncps, count);
+        TASSERT(str.length() == count);
+        TASSERT(ZString::isUTF8(str.cc(), str.size()));
+        TASSERT(ZString(str.cc(), str.size()) == str);
+
+        ZArray<zu32> utf32(count + 1);
+        TASSERT(str.readUTF32(utf32.raw(), utf32.size()) == count);
+        for(zu64 i = 0; i < count; ++i)
+            TASSERT(utf32[i] == cps[i % ncps]);
+
+        ZArray<zu16> utf16(count * 2 + 2);
+        zu64 len16 = str.readUTF16(utf16.raw(), utf16.size());
+        ZString back;
+        back.parseUTF16(utf16.raw(), len16);
+        TASSERT(back == str);
+        TASSERT(ZString(str.wstr()) == str);
+    }
+
+    // Output is limited to the destination size
+    ZString ascii(ZString('z', 100));
+    ZArray<zu16> small(40);
+    TASSERT(ascii.readUTF16(small.raw(), 40) == 39);
+    ZArray<zu32> small32(40);
+    TASSERT(ascii.readUTF32(small32.raw(), 40) == 40);
+
+    // Invalid bytes are dropped and overlong sequences are shortened, anywhere in long input
+    ZString plain = ZString('.', 70);
+    for(zu64 at = 0; at <= 70; at += 5){
+        ZString bad = ZString(plain.cc(), at) + "\xFF" + "\xC1\x81" + ZString(plain.cc() + at, 70 - at);
+        ZString parsed;
+        parsed.parseUTF8(bad.bytes(), ZU64_MAX);
+        TASSERT(parsed == ZString(plain.cc(), at) + "A" + ZString(plain.cc() + at, 70 - at));
+
+        const zbyte raw[] = { '.', 0xE4, 0xB8, '.' };
+        ZString broken = ZString(plain.cc(), at) + ZString(plain.cc(), 1);
+        TASSERT(ZString::isUTF8(broken.cc(), broken.size()));
+        ZBinary bin(broken.bytes(), broken.size());
+        bin.concat(ZBinary(raw, sizeof(raw)));
+        TASSERT(!ZString::isUTF8((const char *)bin.raw(), bin.size()));
+        bin.resize(bin.size() - 2);
+        TASSERT(!ZString::isUTF8((const char *)bin.raw(), bin.size()));
+
+        // Lone surrogates and zero units in wide input
+        ZArray<zu16> wide;
+        for(zu64 i = 0; i < 70; ++i)
+            wide.push(i == at ? 0xD800 : 'w');
+        ZString fromwide;
+        fromwide.parseUTF16(wide.raw(), wide.size());
+        TASSERT(fromwide == ZString('w', at < 70 ? 69 : 70));
+        wide[MIN(at, (zu64)69)] = 0;
+        fromwide.parseUTF16(wide.raw(), wide.size());
+        TASSERT(fromwide == ZString('w', MIN(at, (zu64)69)));
+    }
+    TASSERT(!ZString::isUTF8("tab\tis text, bell\a is not"));
+    TASSERT(ZString::isUTF8("line\r\nfeed \xE6\x96\x87 \xF0\x90\x90\xB7"));
+    TASSERT(!ZString::isUTF8("surrogate \xED\xA0\x80"));
+}
+
+//! Time UTF-8 validation, counting and transcoding on ASCII, Latin and CJK text.
+void bench_unicode(){
+    const zu32 ascii[] = { 'T', 'h', 'e', ' ', 'q', 'u', 'i', 'c', 'k', ' ', 'f', 'o', 'x', '.' };
+    const zu32 latin[] = { 'c', 'a', 'f', 0xE9, ' ', 'n', 'a', 0xEF, 'v', 'e', ' ', 0xFC, 'b', 'e', 'r', ' ' };
+    const zu32 cjk[] = { 0x4E2D, 0x6587, 0x6F22, 0x5B57, 0x3002, 0x65E5, 0x672C, 0x8A9E };
+    struct { const char *name; const zu32 *cps; zu64 ncps; } inputs[] = {
+        { "ascii", ascii, sizeof(ascii) / sizeof(zu32) },
+        { "latin", latin, sizeof(latin) / sizeof(zu32) },
+        { "cjk",   cjk,   sizeof(cjk) / sizeof(zu32) },
+    };
+    const zu64 count = 1 << 22;
+    for(zu64 n = 0; n < 3; ++n){
+        ZString str = cycleString(inputs[n].cps, inputs[n].ncps, count);
+        ZClock clock;
+        bool valid = ZString::isUTF8(str.cc(), str.size());
+        clock.stop();
+        LOG(inputs[n].name << " validate:  " << clock.getSecs() << " s " << valid);
+
+        clock.start();
+        zu64 len = str.length();
+        clock.stop();
+        LOG(inputs[n].name << " length:    " << clock.getSecs() << " s " << len);
+
+        clock.start();
+        ZString copy;
+        copy.parseUTF8(str.bytes(), str.size());
+        clock.stop();
+        LOG(inputs[n].name << " parseUTF8: " << clock.getSecs() << " s " << copy.size());
+
+        ZArray<zu16> utf16(count * 2);
+        clock.start();
+        zu64 len16 = str.readUTF16(utf16.raw(), utf16.size());
+        clock.stop();
+        LOG(inputs[n].name << " to UTF-16: " << clock.getSecs() << " s " << len16);
+
+        clock.start();
+        copy.parseUTF16(utf16.raw(), len16);
+        clock.stop();
+        LOG(inputs[n].name << " UTF-16 to: " << clock.getSecs() << " s " << copy.size());
+    }
+}
+
+void string_view(){
+    ZString str = "key1=value1; key2 = 42;;key3=-17";
+    ZStringView view = str;
+    TASSERT(view.data() == str.cc() && view.size() == str.size());
+    TASSERT(view.beginsWith("key1") && view.endsWith("-17") && view.findFirst("key2") == 13);
+    TASSERT(str.view(5, 6) == "value1" && view.substr(29) == "-17" && view.count("key") == 3);
+    TASSERT(view.findFirstBetween("key2", ";") == " = 42" && view.getUntil("=") == "key1");
+
+    // Tokenize without allocating
+    ZMap<ZString, zs64> nums;
+    ZStringView rest = view;
+    ZStringView tok = rest.nextToken(';');
+    zu64 count = 0;
+    while(!tok.isEmpty()){
+        ArZV kv = tok.split("=");
+        TASSERT(kv.size() == 2);
+        ZStringView val = kv[1].strip(' ');
+        if(val.isInteger())
+            nums[ZString(kv[0].strip(' '))] = val.toSint();
+        ++count;
+        tok = rest.nextToken(';');
+    }
+    TASSERT(count == 3 && rest.isEmpty());
+
+    // Look up string keys by view
+    TASSERT(nums.size() == 2 && nums.contains(ZStringView("key2")) && !nums.contains(ZStringView("key1")));
+    const ZMap<ZString, zs64> &cnums = nums;
+    TASSERT(cnums[ZStringView("key2")] == 42 && cnums[ZStringView(str.cc() + 24, 4)] == -17);
+
+    // Number parsing
+    TASSERT(ZStringView("0x1F").toUint(16) == 31 && ZStringView("777").toUint(8) == 511);
+    TASSERT(!ZStringView("19").isInteger(8) && !ZStringView("-").isInteger() && ZStringView("12a").toUint() == 0);
+    TASSERT(ZStringView("99999999999999999999").toUint() == ZU64_MAX);
+    TASSERT(ZStringView("-9223372036854775808").toSint() == ZS64_MIN);
+
+    ArZV parts = ZStringView("/usr//local/./lib/").explode('/');
+    TASSERT(parts.size() == 4 && parts[3] == "lib" && ZStringView("a").stripFront('a').isEmpty());
+    TASSERT(ZStringView("abc") < ZStringView("abd") && ZStringView("ab") < ZStringView("abc"));
+    TASSERT(ZString(view.substr(0, 4)) == "key1");
+}
+
+void string_builder(){
+    ZStringBuilder builder;
+    TASSERT(builder.isEmpty() && builder.str() == "");
+    builder << "id=" << 42 << ", delta=" << -7 << ", big=" << ZU64_MAX << ", min=" << ZS64_MIN;
+    builder << ", ratio=" << 0.1 << ", " << ZString("name") << ' ' << (unsigned char)200;
+    TASSERT(builder.str() == "id=42, delta=-7, big=18446744073709551615, min=-9223372036854775808, ratio=0.1, name 200");
+    TASSERT(builder.size() == builder.view().size() && builder.view().beginsWith("id=42"));
+
+    // Numbers match the ZString conversions
+    builder.clear();
+    builder.append(1e21).append(' ').append(-0.0).append(' ').append(3.14159);
+    TASSERT(builder.str() == ZString(1e21) + " " + ZString(-0.0) + " " + ZString(3.14159));
+    builder.clear();
+    builder.appendUint(255, 16, 4).appendUint(5, 2).appendUint(0xAB, 16, 0, true).append('-', 3);
+    TASSERT(builder.str() == ZString::ItoS((zu64)255, 16, 4) + ZString::ItoS((zu64)5, 2) + "AB---");
+    const zbyte bytes[] = { 0x00, 0x7F, 0xA5, 0xFF };
+    builder.clear();
+    builder.appendHex(bytes, sizeof(bytes));
+    TASSERT(builder.str() == "007fa5ff");
+
+    // Capacity planning
+    ZStringBuilder planned(1000);
+    TASSERT(planned.capacity() >= 1000);
+    for(zu64 i = 0; i < 100; ++i)
+        planned << "0123456789";
+    TASSERT(planned.size() == 1000 && planned.capacity() >= 1000);
+
+    // Invalid UTF-8 fragments are normalized like ZString, even when split across fragments
+    const char euro[] = "\xE2\x82\xAC";
+    builder.clear();
+    builder.append((const zbyte *)euro, 1).append((const zbyte *)euro + 1, 2).append("!");
+    TASSERT(builder.str() == ZString(euro) + "!");
+    builder.clear();
+    builder << "a\xC0\xAF" << "b" << ZString("\xC3\xA9");
+    TASSERT(builder.str() == ZString("a\xC0\xAF" "b\xC3\xA9") && ZString::isUTF8(builder.str().cc()));
+
+    // Take the buffer, leaving the builder empty
+    builder.clear();
+    builder << "long enough to leave the inline buffer of the string " << 12345;
+    ZString taken = builder.take();
+    TASSERT(taken == "long enough to leave the inline buffer of the string 12345" && builder.isEmpty());
+    builder << "reused";
+    TASSERT(builder.str() == "reused");
+
+    // Write to a writer
+    ZBinary bin;
+    builder.clear();
+    builder << "data " << 7;
+    TASSERT(builder.writeTo(&bin) == 6 && bin == ZBinary("data 7", 6));
+
+    // Chained concatenation of temporaries
+    ZString a = "alpha", b = "beta";
+    ZString chain = a + "-" + b + "-" + ZString(3) + "-" + a;
+    TASSERT(chain == "alpha-beta-3-alpha" && a == "alpha" && b == "beta");
+
+    // Log fragments go through the builder
+    ZLog log;
+    log << "n=" << 5 << " x=" << 2.5 << ' ' << true << ' ' << ZBinary("\x01\xFF", 2);
+    TASSERT(log.pullBuffer() == "n=5 x=2.5 true 01ff");
+}
+
+//! Compare concatenating fragments into ZString with appending them to a ZStringBuilder.
+void bench_string_builder(){
+    const zu64 count = 200000;
+
+    ZClock clock;
+    zu64 size = 0;
+    for(zu64 i = 0; i < count; ++i){
+        ZString out;
+        out += "record ";
+        out += ZString(i);
+        out += ": value=";
+        out += ZString(i * 0.25);
+        out += ", name=";
+        out += "entry";
+        out += ", flags=";
+        out += ZString::ItoS(i, 16, 8);
+        size += out.size();
+    }
+    clock.stop();
+    LOG("ZString +=:     " << clock.getSecs() << " s " << size);
+
+    clock.start();
+    size = 0;
+    for(zu64 i = 0; i < count; ++i){
+        ZString out = ZString("record ") + ZString(i) + ": value=" + ZString(i * 0.25) + ", name=" + "entry" + ", flags=" + ZString::ItoS(i, 16, 8);
+        size += out.size();
+    }
+    clock.stop();
+    LOG("ZString +:      " << clock.getSecs() << " s " << size);
+
+    clock.start();
+    size = 0;
+    for(zu64 i = 0; i < count; ++i){
+        ZStringBuilder out;
+        out << "record " << i << ": value=" << i * 0.25 << ", name=" << "entry" << ", flags=";
+        out.appendUint(i, 16, 8);
+        size += out.str().size();
+    }
+    clock.stop();
+    LOG("ZStringBuilder: " << clock.getSecs() << " s " << size);
+
+    ZJSON json;
+    for(zu64 i = 0; i < 2000; ++i){
+        ZJSON item;
+        item["id"] = ZJSON((double)i);
+        item["name"] = ZJSON(ZString("item \"") + ZString(i) + "\"\n");
+        item["ok"] = ZJSON(i % 2 == 0);
+        json << item;
+    }
+    clock.start();
+    size = 0;
+    for(zu64 i = 0; i < 50; ++i)
+        size += json.encode().size();
+    clock.stop();
+    LOG("ZJSON encode:   " << clock.getSecs() << " s " << size);
+}
+
 ZArray<Test> string_tests(){
     return {
         { "string-assign-compare",      string_assign_compare,      true, { "allocator-char" } },
@@ -265,6 +772,8 @@ ZArray<Test> string_tests(){
         { "string-find",                string_find,                true, { "string-assign-compare" } },
         { "string-substitute",          string_substitute,          true, { "string-assign-compare" } },
         { "string-replace",             string_replace,             true, { "string-find" } },
+        { "string-search",              string_search,              true, { "string-replace", "binary-find" } },
+        { "string-replace-all",         string_replace_all,         true, { "string-search" } },
         { "string-explode-compound",    string_explode_compound,    true, { "string-find" } },
         { "string-iterator",            string_iterator,            true, { "string-assign-compare" } },
         { "string-number",              string_number,              true, { "string-assign-compare" } },
@@ -272,6 +781,14 @@ ZArray<Test> string_tests(){
         { "string-utf8",                string_utf8,                true, { "string-assign-compare" } },
         { "string-utf16",               string_utf16,               true, { "string-utf8" } },
         { "string-utf32",               string_utf32,               true, { "string-utf8" } },
+        { "string-sso",                 string_sso,                 true, { "string-concat-append" } },
+        { "string-unicode-convert",     string_unicode_convert,     true, { "string-utf16", "string-utf32" } },
+        { "string-view",                string_view,                true, { "string-find", "string-number" } },
+        { "string-builder",             string_builder,             true, { "string-concat-append", "string-number", "string-utf8" } },
+        { "bench-search",               bench_search,               false, {} },
+        { "bench-replace-all",          bench_replace_all,          false, {} },
+        { "bench-unicode",              bench_unicode,              false, {} },
+        { "bench-string-builder",       bench_string_builder,       false, {} },
     };
 }
 
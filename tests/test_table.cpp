@@ -1,6 +1,9 @@
 #include "tests.h"
 
 #include "ztable.h"
+#ifdef LIBCHAOS_HAS_SQLITE3
+    #include "zdatabase.h"
+#endif
 
 namespace LibChaosTest {
 
@@ -32,9 +35,176 @@ void table(){
     TASSERT(table.field("col4", 3) == "val44");
 }
 
+void table_typed(){
+    ZTable table;
+    table.addColumn("name");
+    table.addColumn("age", ZTable::INT64);
+    table.addColumn("score", ZTable::DOUBLE);
+    table.addColumn("active", ZTable::BOOL);
+    table.addRecord({ "alice", "34", "7.5", "true" });
+    table.addRecord({ "bob", "27", "x", "0" });
+    table.addRecord({ "carol", "", "9.25", "1" });
+    table.addRecord({ "alice", "41", "2", "false" });
+    TASSERT(table.rowCount() == 4);
+    TASSERT(table.colCount() == 4);
+
+    zu64 name = table.columnIndex("name");
+    zu64 age = table.columnIndex("age");
+    zu64 score = table.columnIndex("score");
+    zu64 active = table.columnIndex("active");
+    TASSERT(table.columnIndex("none") == ZTable::NONE);
+
+    // Parsed values and nulls
+    TASSERT(table.getInt(age, 0) == 34);
+    TASSERT(table.isNull(age, 2));
+    TASSERT(table.isNull(score, 1));
+    TASSERT(table.getDouble(score, 2) == 9.25);
+    TASSERT(table.getDouble(age, 1) == 27);
+    TASSERT(table.getBool(active, 2) == true);
+    TASSERT(table.getBool(active, 3) == false);
+    TASSERT(table.field("age", 1) == "27");
+    TASSERT(table.field("age", 2) == "");
+
+    // Doubles follow the ZString number grammar, without inf, nan or hex
+    ZTable nums;
+    nums.addColumn("value", ZTable::DOUBLE);
+    nums.addRecord({ "-1.5e2" });
+    nums.addRecord({ "inf" });
+    nums.addRecord({ "nan" });
+    nums.addRecord({ "0x10" });
+    TASSERT(nums.getDouble(0, 0) == -150 && nums.isNull(0, 1) && nums.isNull(0, 2) && nums.isNull(0, 3));
+
+    // Strings are stored once
+    TASSERT(table.column(name).dictionary().size() == 3);
+    TASSERT(table.column(name).codes()[0] == table.column(name).codes()[3]);
+
+    // Row views
+    ZTable::Row row = table.row(1);
+    TASSERT(row.getString(name) == "bob");
+    TASSERT(row["name"] == "bob");
+    TASSERT(row.getInt(age) == 27);
+    TASSERT(row.isNull(score));
+
+    // Filters
+    ZArray<zu64> rows = table.filterInt(age, [](zs64 v){ return v > 30; });
+    TASSERT(rows.size() == 2 && rows[0] == 0 && rows[1] == 3);
+    rows = table.filterString(name, [](const ZString &s){ return s == "alice"; });
+    TASSERT(rows.size() == 2 && rows[0] == 0 && rows[1] == 3);
+    rows = table.filterDouble(score, [](double v){ return v > 5; });
+    TASSERT(rows.size() == 2 && rows[0] == 0 && rows[1] == 2);
+    rows = table.filterBool(active, true);
+    TASSERT(rows.size() == 2 && rows[0] == 0 && rows[1] == 2);
+    rows = table.filterNull(age);
+    TASSERT(rows.size() == 1 && rows[0] == 2);
+
+    // Aggregates
+    ZTable::Stats stats = table.aggregate(age);
+    TASSERT(stats.count == 3);
+    TASSERT(stats.nulls == 1);
+    TASSERT(stats.sum == 102);
+    TASSERT(stats.min == 27);
+    TASSERT(stats.max == 41);
+    TASSERT(stats.mean() == 34);
+    stats = table.aggregate(score, table.filterString(name, [](const ZString &s){ return s == "alice"; }));
+    TASSERT(stats.count == 2);
+    TASSERT(stats.sum == 9.5);
+
+    // Setters and nulls
+    table.setInt(age, 2, 50);
+    TASSERT(!table.isNull(age, 2));
+    TASSERT(table.getInt(age, 2) == 50);
+    table.setNull(age, 2);
+    TASSERT(table.isNull(age, 2));
+
+    // Wrong types
+    bool thrown = false;
+    try {
+        table.setInt(name, 0, 1);
+    } catch(ZException){
+        thrown = true;
+    }
+    TASSERT(thrown);
+    thrown = false;
+    try {
+        table.aggregate(name);
+    } catch(ZException){
+        thrown = true;
+    }
+    TASSERT(thrown);
+
+    // Blobs and columns added later
+    table.addColumn("data", ZTable::BLOB);
+    zu64 data = table.columnIndex("data");
+    TASSERT(table.isNull(data, 0));
+    const zbyte bytes[] = { 0, 1, 2, 3 };
+    table.setBlob(data, 1, bytes, 4);
+    zu64 r = table.addRow();
+    TASSERT(r == 4);
+    TASSERT(table.isNull(name, 4));
+    TASSERT(table.getBlob(data, 1) == ZBinary(bytes, 4));
+    TASSERT(table.getBlob(data, 0).size() == 0);
+
+    // Many rows cross bitmap words
+    ZTable big;
+    big.addColumn("n", ZTable::INT64);
+    for(zu64 i = 0; i < 200; ++i){
+        zu64 b = big.addRow();
+        if(i % 3)
+            big.setInt(0, b, i);
+    }
+    TASSERT(big.filterNull(0).size() == 67);
+    TASSERT(big.aggregate(0).count == 133);
+}
+
+void table_column_type(){
+    ZTable table({ "n" });
+    table.addColumn("i", ZTable::INT64);
+    table.addRecord({ "a", "3" });
+    table.addRecord({ "b", "" });
+    table.addRecord({ "c", "-9007199254740993" });
+    table.setColumnType(1, ZTable::DOUBLE);
+    TASSERT(table.column(1).type() == ZTable::DOUBLE && table.getDouble(1, 0) == 3 && table.isNull(1, 1));
+    TASSERT(table.getDouble(1, 2) == (double)-9007199254740993LL);
+    table.setColumnType(1, ZTable::STRING);
+    TASSERT(table.getString(1, 0) == "3" && table.isNull(1, 1));
+    table.setColumnType(0, ZTable::INT64);
+    TASSERT(table.isNull(0, 0) && table.rowCount() == 3);
+}
+
+#ifdef LIBCHAOS_HAS_SQLITE3
+void table_database(){
+    ZDatabase db;
+    TASSERT(db.open(ZPath(":memory:")));
+    const char *sql =
+        "CREATE TABLE t (a INTEGER, b, c REAL, d TEXT);"
+        "INSERT INTO t VALUES (1, NULL, 1.5, 'x');"
+        "INSERT INTO t VALUES (2.5, 7, 2, 3);"
+        "INSERT INTO t VALUES ('text', 8, NULL, NULL);"
+        "INSERT INTO t VALUES (NULL, 9.5, 4, 'z');";
+    TASSERT(sqlite3_exec(db.handle(), sql, NULL, NULL, NULL) == SQLITE_OK);
+
+    ZTable result;
+    TASSERT(db.execute("SELECT a, b, c, d FROM t", result) == 0);
+    TASSERT(result.rowCount() == 4 && result.colCount() == 4);
+    // INTEGER column with a REAL and TEXT is promoted to strings
+    TASSERT(result.column(0).type() == ZTable::STRING);
+    TASSERT(result.getString(0, 0) == "1" && result.getString(0, 1) == "2.5" && result.getString(0, 2) == "text" && result.isNull(0, 3));
+    // Untyped column with a leading NULL takes the type of its values
+    TASSERT(result.column(1).type() == ZTable::DOUBLE && result.isNull(1, 0));
+    TASSERT(result.getDouble(1, 1) == 7 && result.getDouble(1, 3) == 9.5);
+    TASSERT(result.column(2).type() == ZTable::DOUBLE && result.getDouble(2, 1) == 2 && result.isNull(2, 2));
+    TASSERT(result.column(3).type() == ZTable::STRING && result.getString(3, 1) == "3");
+}
+#endif
+
 ZArray<Test> table_tests(){
     return {
         { "table", table, true, { "array-initializer", "map" } },
+        { "table-typed", table_typed, true, { "table" } },
+        { "table-column-type", table_column_type, true, { "table-typed" } },
+#ifdef LIBCHAOS_HAS_SQLITE3
+        { "table-database", table_database, true, { "table-column-type" } },
+#endif
     };
 }
 
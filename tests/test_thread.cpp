@@ -3,6 +3,8 @@
 #include "zthread.h"
 #include "zmutex.h"
 #include "zlock.h"
+#include "zconcurrentmap.h"
+#include "zlrucache.h"
 
 #if LIBCHAOS_PLATFORM == _PLATFORM_WINDOWS
     #include <windows.h>
@@ -17,6 +19,9 @@
 #define MUTEX_TEST_NTHREAD  1000
 #define MUTEX_TEST_NLOCK    1000
 
+#define CMAP_TEST_NTHREAD   8
+#define CMAP_TEST_NKEY      2000
+
 namespace LibChaosTest {
 
 void *thread_func2(ZThread::ZThreadArg zarg){
@@ -77,10 +82,126 @@ void mutex(){
     TASSERT(test.count == MUTEX_TEST_NTHREAD * MUTEX_TEST_NLOCK);
 }
 
+struct CMapTest {
+    ZConcurrentMap<ZString, zu64> map;
+    zu64 id;
+    ZMutex mutex;
+};
+
+void *cmap_thread_func(ZThread::ZThreadArg zarg){
+    CMapTest *test = (CMapTest *)zarg.arg;
+    test->mutex.lock();
+    zu64 id = test->id++;
+    test->mutex.unlock();
+    for(zu64 i = 0; i < CMAP_TEST_NKEY; ++i){
+        // Shared counters, and keys owned by this thread
+        test->map.update("count" + ZString(i % 16), [](zu64 &value){ ++value; });
+        ZString key = ZString("t") + id + "-" + i;
+        test->map.insert(key, i);
+        zu64 value = 0;
+        if(!test->map.get(key, value) || value != i)
+            return (void *)1;
+        if(i % 2)
+            test->map.remove(key);
+        test->map.getOrInsert("shared", 5);
+    }
+    return nullptr;
+}
+
+void shard_array(){
+    struct Padded {
+        zu64 count;
+        char name[70];
+    };
+    ZShardArray<Padded> shards(5);
+    TASSERT(shards.size() == 8);
+    for(zu64 i = 0; i < shards.size(); ++i){
+        // Each shard starts on its own cache line
+        TASSERT((zu64)&shards[i] % ZSHARDARRAY_LINE_SIZE == 0);
+        if(i)
+            TASSERT((zu64)&shards[i] - (zu64)&shards[i - 1] >= sizeof(Padded));
+    }
+    TASSERT(&shards.forHash(0) == &shards[0] && &shards.forHash(ZU64_MAX) == &shards[7]);
+}
+
+void concurrent_map(){
+    CMapTest test;
+    test.id = 0;
+    ZList<ZPointer<ZThread>> threads;
+    for(int i = 0; i < CMAP_TEST_NTHREAD; ++i)
+        threads.push(new ZThread(cmap_thread_func));
+    for(auto it = threads.begin(); it.more(); ++it)
+        it.get()->exec(&test);
+    for(auto it = threads.begin(); it.more(); ++it)
+        TASSERT(it.get()->join() == nullptr);
+
+    ZConcurrentMap<ZString, zu64> &map = test.map;
+    TASSERT(map.size() == 16 + 1 + CMAP_TEST_NTHREAD * CMAP_TEST_NKEY / 2);
+    zu64 total = 0;
+    for(int i = 0; i < 16; ++i)
+        total += map.get("count" + ZString(i), (zu64)0);
+    TASSERT(total == CMAP_TEST_NTHREAD * CMAP_TEST_NKEY);
+    TASSERT(map.contains("t0-0") && !map.contains("t0-1") && map.get("shared", (zu64)0) == 5);
+
+    TASSERT(!map.insert("shared", 6) && !map.upsert("shared", 7) && map.upsert("new", 1));
+    TASSERT(map.get(ZStringView("shared"), (zu64)0) == 7 && map.remove("new") && !map.remove("new"));
+
+    ZMap<ZString, zu64> snap = map.snapshot();
+    TASSERT(snap.size() == map.size() && snap["count3"] == CMAP_TEST_NTHREAD * CMAP_TEST_NKEY / 16);
+    map.clear();
+    TASSERT(map.isEmpty() && map.shardCount() == ZCONCURRENTMAP_DEFAULT_SHARDS);
+}
+
+#define CLRU_TEST_NTHREAD   8
+#define CLRU_TEST_NKEY      5000
+
+void *clru_thread_func(ZThread::ZThreadArg zarg){
+    ZConcurrentLRUCache<zu64, zu64> *cache = (ZConcurrentLRUCache<zu64, zu64> *)zarg.arg;
+    for(zu64 i = 0; i < CLRU_TEST_NKEY; ++i){
+        zu64 key = i % 1000;
+        zu64 value = 0;
+        if(cache->get(key, value)){
+            if(value != key * 3)
+                return (void *)1;
+        } else {
+            cache->put(key, key * 3, 8);
+        }
+    }
+    return nullptr;
+}
+
+void concurrent_lru_cache(){
+    ZConcurrentLRUCache<zu64, zu64> cache(256, 0, 8);
+    TASSERT(cache.shardCount() == 8);
+    ZList<ZPointer<ZThread>> threads;
+    for(int i = 0; i < CLRU_TEST_NTHREAD; ++i)
+        threads.push(new ZThread(clru_thread_func));
+    for(auto it = threads.begin(); it.more(); ++it)
+        it.get()->exec(&cache);
+    for(auto it = threads.begin(); it.more(); ++it)
+        TASSERT(it.get()->join() == nullptr);
+
+    TASSERT(cache.size() <= 256);
+    TASSERT(cache.cost() == cache.size() * 8);
+    TASSERT(cache.hits() + cache.misses() == CLRU_TEST_NTHREAD * CLRU_TEST_NKEY);
+    TASSERT(cache.evictions() > 0);
+
+    TASSERT(cache.put(5000, 1) && cache.get(5000, (zu64)0) == 1 && cache.contains(5000));
+    TASSERT(cache.remove(5000) && !cache.remove(5000));
+    cache.setCapacity(0, 64);
+    TASSERT(!cache.put(6000, 1, 9) && cache.put(6000, 1, 8));
+    TASSERT(cache.cost() <= 64);
+    cache.clear();
+    TASSERT(cache.size() == 0);
+}
+
 ZArray<Test> thread_tests(){
     return {
         { "thread", thread, true, {} },
         { "mutex",  mutex,  true, {} },
+        { "shard-array",    shard_array,    true, {} },
+        { "concurrent-map", concurrent_map, true, { "mutex", "map-lookup", "shard-array" } },
+        { "concurrent-lru-cache", concurrent_lru_cache, true, { "concurrent-map", "lru-cache" } },
     };
 }
 